@@ -0,0 +1,376 @@
+//*****************************************************************************
+//
+// bench.c - On-target benchmarks.
+//
+// BenchClockProfiles() runs a fixed workload at every clock profile and
+// prints the cycles and time it takes.  The workload is the sensor response
+// parser over a recorded exchange followed by a 256 byte image, the command
+// encoder over every command, a CRC-32 of the image and the lossless encoding
+// of one image row.  Cycle counts differ between profiles only through flash
+// wait states.
+//
+// BenchCrc() times Crc16() and Crc32() at several sizes and alignments and
+// checks each result against a bit at a time CRC.
+//
+//*****************************************************************************
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "inc/hw_types.h"
+#include "inc/hw_nvic.h"
+#include "driverlib/sw_crc.h"
+#include "clock_profile.h"
+#include "console.h"
+#include "fp_command.h"
+#include "fp_parser.h"
+#include "img_pipe.h"
+#include "img_lossless.h"
+#include "bench.h"
+
+//*****************************************************************************
+//
+// The size of the image used by the workload, and the width it is treated as
+// when it is encoded.
+//
+//*****************************************************************************
+#define BENCH_IMAGE_SIZE        256
+#define BENCH_IMAGE_WIDTH       128
+
+//*****************************************************************************
+//
+// The recorded sensor responses that precede the image.  The INFO response
+// gives the size of the workload image, so that the image ends within it.
+//
+//*****************************************************************************
+static const char g_pcBenchResponses[] =
+    "<R>OK</R>Please put finger<R>PASS_3</R><R>FAIL</R><R>W=128,H=2</R>"
+    "<R>DS=2A</R><R>KEY=bn888999</R><R>0123</R><R>OK</R><I>";
+
+//*****************************************************************************
+//
+// The image used by the workload.
+//
+//*****************************************************************************
+static uint8_t g_pui8BenchImage[BENCH_IMAGE_SIZE];
+
+//*****************************************************************************
+//
+// The output of the lossless encoder.
+//
+//*****************************************************************************
+static uint8_t g_pui8BenchCode[BENCH_IMAGE_WIDTH];
+
+//*****************************************************************************
+//
+// The parser used by the workload.  It is kept off the stack.
+//
+//*****************************************************************************
+static tFpParser g_sBenchParser;
+
+//*****************************************************************************
+//
+// The sizes that BenchCrc() computes CRCs over, up to that of an image.
+//
+//*****************************************************************************
+static const uint32_t g_pui32BenchCrcSizes[] =
+{
+    16, 256, 4096, 30976
+};
+
+//*****************************************************************************
+//
+// The data that BenchCrc() computes CRCs over.  Larger sizes go over it
+// again, BENCH_CRC_CHUNK bytes at a time, and the spare word lets each chunk
+// start at any alignment.
+//
+//*****************************************************************************
+#define BENCH_CRC_CHUNK         1024
+
+static uint32_t g_pui32BenchCrcData[(BENCH_CRC_CHUNK / 4) + 1];
+
+//*****************************************************************************
+//
+// Counts parser events so that the callback is not optimized away.
+//
+//*****************************************************************************
+static void
+BenchParserEvent(void *pvCBData, const tFpEvent *psEvent)
+{
+    (*(uint32_t *)pvCBData)++;
+}
+
+//*****************************************************************************
+//
+// Prints one measurement as "name cycles (microseconds us)".
+//
+//*****************************************************************************
+static void
+BenchReport(const char *pcName, uint32_t ui32Cycles, uint32_t ui32MHz)
+{
+    ConsoleWrite(pcName);
+    ConsoleWriteNum(ui32Cycles);
+    ConsoleWrite(" (");
+    ConsoleWriteNum(ui32Cycles / ui32MHz);
+    ConsoleWrite(" us)");
+}
+
+//*****************************************************************************
+//
+// Computes the CRC-16 and CRC-32 one bit at a time, as the reference that the
+// table driven functions are checked against.
+//
+//*****************************************************************************
+static uint16_t
+BenchCrc16Bitwise(uint16_t ui16Crc, const uint8_t *pui8Data,
+                  uint32_t ui32Count)
+{
+    uint32_t ui32Bit;
+
+    while(ui32Count--)
+    {
+        ui16Crc ^= *pui8Data++;
+        for(ui32Bit = 0; ui32Bit < 8; ui32Bit++)
+        {
+            ui16Crc = (ui16Crc >> 1) ^ ((ui16Crc & 1) ? 0xA001 : 0);
+        }
+    }
+
+    return(ui16Crc);
+}
+
+static uint32_t
+BenchCrc32Bitwise(uint32_t ui32Crc, const uint8_t *pui8Data,
+                  uint32_t ui32Count)
+{
+    uint32_t ui32Bit;
+
+    while(ui32Count--)
+    {
+        ui32Crc ^= *pui8Data++;
+        for(ui32Bit = 0; ui32Bit < 8; ui32Bit++)
+        {
+            ui32Crc = (ui32Crc >> 1) ^ ((ui32Crc & 1) ? 0xEDB88320 : 0);
+        }
+    }
+
+    return(ui32Crc);
+}
+
+//*****************************************************************************
+//
+// Computes a CRC-32 (from 0xFFFFFFFF) or a CRC-16 (from 0) over a number of
+// bytes, repeating the chunk at pui8Data, with Crc16() and Crc32() or with
+// the bit at a time reference.
+//
+//*****************************************************************************
+static uint32_t
+BenchCrcRun(bool bCrc32, bool bBitwise, const uint8_t *pui8Data,
+            uint32_t ui32Size)
+{
+    uint32_t ui32Crc, ui32Count;
+
+    ui32Crc = bCrc32 ? 0xFFFFFFFF : 0;
+
+    while(ui32Size)
+    {
+        ui32Count = (ui32Size < BENCH_CRC_CHUNK) ? ui32Size : BENCH_CRC_CHUNK;
+
+        if(bCrc32)
+        {
+            ui32Crc = (bBitwise ? BenchCrc32Bitwise(ui32Crc, pui8Data,
+                                                    ui32Count) :
+                                  Crc32(ui32Crc, pui8Data, ui32Count));
+        }
+        else
+        {
+            ui32Crc = (bBitwise ? BenchCrc16Bitwise(ui32Crc, pui8Data,
+                                                    ui32Count) :
+                                  Crc16(ui32Crc, pui8Data, ui32Count));
+        }
+
+        ui32Size -= ui32Count;
+    }
+
+    return(ui32Crc);
+}
+
+//*****************************************************************************
+//
+// Prints the throughput of one CRC as "name bytes/100 cycles", and flags a
+// result that differs from the reference.
+//
+//*****************************************************************************
+static void
+BenchCrcReport(const char *pcName, uint32_t ui32Size, uint32_t ui32Cycles,
+               bool bMatch)
+{
+    ConsoleWrite(pcName);
+    ConsoleWriteNum((ui32Size * 100) / (ui32Cycles ? ui32Cycles : 1));
+    ConsoleWrite(bMatch ? "" : " MISMATCH");
+}
+
+//*****************************************************************************
+//
+//! Enables the DWT cycle counter.
+//!
+//! \return None.
+//
+//*****************************************************************************
+void
+BenchInit(void)
+{
+    HWREG(NVIC_DBG_INT) |= BENCH_DBG_INT_TRCENA;
+    HWREG(BENCH_DWT_CYCCNT) = 0;
+    HWREG(BENCH_DWT_CTRL) |= BENCH_DWT_CTRL_CYCCNTENA;
+}
+
+//*****************************************************************************
+//
+//! Runs the workload at every clock profile and prints the results.
+//!
+//! The profile that was selected on entry is restored before returning.  This
+//! must not be called while the uDMA bridge is enabled.
+//!
+//! \return None.
+//
+//*****************************************************************************
+void
+BenchClockProfiles(void)
+{
+    uint8_t pui8Frame[FP_COMMAND_BUF_SIZE];
+    uint32_t ui32Profile, ui32Saved, ui32MHz, ui32Cmd, ui32Start, ui32Events;
+    uint32_t ui32Parse, ui32Encode, ui32Crc, ui32Lossless;
+
+    //
+    // Two rows of diagonal ridges, roughly like a fingerprint.
+    //
+    for(ui32Start = 0; ui32Start < BENCH_IMAGE_SIZE; ui32Start++)
+    {
+        ui32Cmd = ((ui32Start % BENCH_IMAGE_WIDTH) +
+                   (ui32Start / BENCH_IMAGE_WIDTH)) & 15;
+        g_pui8BenchImage[ui32Start] =
+            (uint8_t)(64 + ((ui32Cmd < 8) ? ui32Cmd : (15 - ui32Cmd)) * 20);
+    }
+
+    ui32Saved = ClockProfileGet();
+
+    for(ui32Profile = 0; ui32Profile < CLOCK_PROFILE_COUNT; ui32Profile++)
+    {
+        ClockProfileSet(ui32Profile);
+        ui32MHz = ClockFreqGet() / 1000000;
+
+        //
+        // Parse the responses and the image.
+        //
+        ui32Events = 0;
+        FpParserInit(&g_sBenchParser, BenchParserEvent, &ui32Events);
+        FpParserImageSizeSet(&g_sBenchParser, BENCH_IMAGE_SIZE);
+        ui32Start = BenchCycles();
+        FpParserFeed(&g_sBenchParser, (const uint8_t *)g_pcBenchResponses,
+                     sizeof(g_pcBenchResponses) - 1);
+        FpParserFeed(&g_sBenchParser, g_pui8BenchImage, BENCH_IMAGE_SIZE);
+        ui32Parse = BenchCycles() - ui32Start;
+
+        //
+        // Encode every command, giving the text commands a short argument.
+        //
+        ui32Start = BenchCycles();
+        for(ui32Cmd = 0; ui32Cmd < FP_CMD_COUNT; ui32Cmd++)
+        {
+            if(!FpCommandEncode(ui32Cmd, pui8Frame, sizeof(pui8Frame)) &&
+               !FpCommandEncodeNum(ui32Cmd, 23, pui8Frame, sizeof(pui8Frame)))
+            {
+                FpCommandEncodeText(ui32Cmd, "2,1", 3, pui8Frame,
+                                    sizeof(pui8Frame));
+            }
+        }
+        ui32Encode = BenchCycles() - ui32Start;
+
+        //
+        // Check the image.
+        //
+        ui32Start = BenchCycles();
+        Crc32(0xFFFFFFFF, g_pui8BenchImage, BENCH_IMAGE_SIZE);
+        ui32Crc = BenchCycles() - ui32Start;
+
+        //
+        // Compress the second row.
+        //
+        ui32Start = BenchCycles();
+        ImgLosslessEncodeRow(g_pui8BenchImage + BENCH_IMAGE_WIDTH,
+                             g_pui8BenchImage, BENCH_IMAGE_WIDTH,
+                             g_pui8BenchCode, sizeof(g_pui8BenchCode));
+        ui32Lossless = BenchCycles() - ui32Start;
+
+        ConsoleWriteNum(ui32MHz);
+        BenchReport(" MHz: parse ", ui32Parse, ui32MHz);
+        BenchReport(", encode ", ui32Encode, ui32MHz);
+        BenchReport(", crc32 ", ui32Crc, ui32MHz);
+        BenchReport(", lossless ", ui32Lossless, ui32MHz);
+        ConsoleWrite(" ");
+        ConsoleWriteNum(ui32Lossless / BENCH_IMAGE_WIDTH);
+        ConsoleWrite("/px");
+        ConsoleWrite("\r\n");
+    }
+
+    ClockProfileSet(ui32Saved);
+}
+
+//*****************************************************************************
+//
+//! Times the CRC functions and checks their results.
+//!
+//! Crc16() and Crc32() are run over a block of pseudo-random data at each
+//! size and at each alignment from 0 to 3 bytes, at the current clock
+//! profile; sizes above BENCH_CRC_CHUNK go over the block again.  The
+//! throughput is printed in bytes per 100 cycles, and a result that differs
+//! from the bit at a time reference is flagged.
+//!
+//! \return None.
+//
+//*****************************************************************************
+void
+BenchCrc(void)
+{
+    const uint8_t *pui8Data;
+    uint32_t ui32Size, ui32Align, ui32Start, ui32Cycles, ui32Crc;
+    uint32_t ui32Idx, ui32Seed;
+
+    ui32Seed = 1;
+    for(ui32Idx = 0; ui32Idx < (sizeof(g_pui32BenchCrcData) / 4); ui32Idx++)
+    {
+        ui32Seed = (ui32Seed * 1664525) + 1013904223;
+        g_pui32BenchCrcData[ui32Idx] = ui32Seed;
+    }
+
+    for(ui32Idx = 0; ui32Idx < (sizeof(g_pui32BenchCrcSizes) /
+                                sizeof(g_pui32BenchCrcSizes[0])); ui32Idx++)
+    {
+        ui32Size = g_pui32BenchCrcSizes[ui32Idx];
+
+        for(ui32Align = 0; ui32Align < 4; ui32Align++)
+        {
+            pui8Data = (const uint8_t *)g_pui32BenchCrcData + ui32Align;
+
+            ConsoleWriteNum(ui32Size);
+            ConsoleWrite(" bytes +");
+            ConsoleWriteNum(ui32Align);
+
+            ui32Start = BenchCycles();
+            ui32Crc = BenchCrcRun(false, false, pui8Data, ui32Size);
+            ui32Cycles = BenchCycles() - ui32Start;
+            BenchCrcReport(": crc16 ", ui32Size, ui32Cycles,
+                           ui32Crc == BenchCrcRun(false, true, pui8Data,
+                                                  ui32Size));
+
+            ui32Start = BenchCycles();
+            ui32Crc = BenchCrcRun(true, false, pui8Data, ui32Size);
+            ui32Cycles = BenchCycles() - ui32Start;
+            BenchCrcReport(", crc32 ", ui32Size, ui32Cycles,
+                           ui32Crc == BenchCrcRun(true, true, pui8Data,
+                                                  ui32Size));
+
+            ConsoleWrite(" bytes/100 cycles\r\n");
+        }
+    }
+}
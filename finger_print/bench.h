@@ -0,0 +1,47 @@
+//*****************************************************************************
+//
+// bench.h - Prototypes and macros for the on-target benchmarks.
+//
+//*****************************************************************************
+
+#ifndef __BENCH_H__
+#define __BENCH_H__
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+//*****************************************************************************
+//
+// The Cortex-M4 DWT cycle counter.  NVIC_DBG_INT in hw_nvic.h is the Debug
+// Exception and Monitor Control register, whose TRCENA bit powers the DWT.
+//
+//*****************************************************************************
+#define BENCH_DWT_CTRL          0xE0001000  // DWT Control
+#define BENCH_DWT_CYCCNT        0xE0001004  // DWT Cycle Count
+#define BENCH_DWT_CTRL_CYCCNTENA                                              \
+                                0x00000001  // Cycle counter enable
+#define BENCH_DBG_INT_TRCENA    0x01000000  // Trace enable
+
+//*****************************************************************************
+//
+// Reads the free running cycle counter.  BenchInit() must have been called.
+//
+//*****************************************************************************
+#define BenchCycles()           HWREG(BENCH_DWT_CYCCNT)
+
+//*****************************************************************************
+//
+// Prototypes for the APIs.
+//
+//*****************************************************************************
+extern void BenchInit(void);
+extern void BenchClockProfiles(void);
+extern void BenchCrc(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __BENCH_H__
@@ -0,0 +1,322 @@
+//*****************************************************************************
+//
+// clock_profile.c - System clock profiles selectable at run time.
+//
+// Changing the system clock changes the rate every UART and timer counts at.
+// ClockProfileSet() therefore waits for every UART in use to finish sending,
+// reads back the baud rate each one is programmed for, switches the clock and
+// programs the same rates against the new frequency.  Timer and SysTick
+// owners register a notification so they can do the same for their periods.
+//
+// A UART can also be moved to the precision internal oscillator, which keeps
+// running in deep sleep.  Its rate then no longer depends on the system
+// clock, so profile changes leave it alone.
+//
+//*****************************************************************************
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "inc/hw_memmap.h"
+#include "inc/hw_types.h"
+#include "inc/hw_uart.h"
+#include "driverlib/rom.h"
+#include "driverlib/rom_map.h"
+#include "driverlib/sysctl.h"
+#include "driverlib/uart.h"
+#include "uart_tx.h"
+#include "clock_profile.h"
+
+//*****************************************************************************
+//
+// The settings of each profile.  On TM4C123 the SysCtlClockSet() divider is
+// used; TM4C129 parts ask SysCtlClockFreqSet() for the frequency.
+//
+//*****************************************************************************
+typedef struct
+{
+    uint32_t ui32Freq;
+    uint32_t ui32Config;
+}
+tClockProfile;
+
+static const tClockProfile g_psClockProfiles[CLOCK_PROFILE_COUNT] =
+{
+#if defined(TARGET_IS_TM4C129_RA0) ||                                         \
+    defined(TARGET_IS_TM4C129_RA1) ||                                         \
+    defined(TARGET_IS_TM4C129_RA2)
+    { 16000000, SYSCTL_XTAL_25MHZ | SYSCTL_OSC_INT | SYSCTL_USE_OSC },
+    { 40000000, SYSCTL_XTAL_25MHZ | SYSCTL_OSC_MAIN | SYSCTL_USE_PLL |
+                SYSCTL_CFG_VCO_480 },
+    { 50000000, SYSCTL_XTAL_25MHZ | SYSCTL_OSC_MAIN | SYSCTL_USE_PLL |
+                SYSCTL_CFG_VCO_480 },
+    { 80000000, SYSCTL_XTAL_25MHZ | SYSCTL_OSC_MAIN | SYSCTL_USE_PLL |
+                SYSCTL_CFG_VCO_480 }
+#else
+    { 16000000, SYSCTL_SYSDIV_1 | SYSCTL_USE_OSC | SYSCTL_OSC_MAIN |
+                SYSCTL_XTAL_16MHZ },
+    { 40000000, SYSCTL_SYSDIV_5 | SYSCTL_USE_PLL | SYSCTL_OSC_MAIN |
+                SYSCTL_XTAL_16MHZ },
+    { 50000000, SYSCTL_SYSDIV_4 | SYSCTL_USE_PLL | SYSCTL_OSC_MAIN |
+                SYSCTL_XTAL_16MHZ },
+    { 80000000, SYSCTL_SYSDIV_2_5 | SYSCTL_USE_PLL | SYSCTL_OSC_MAIN |
+                SYSCTL_XTAL_16MHZ }
+#endif
+};
+
+//*****************************************************************************
+//
+// The UARTs whose divisors are kept in step with the clock.
+//
+//*****************************************************************************
+static const uint32_t g_pui32ClockUARTs[][2] =
+{
+    { UART0_BASE, SYSCTL_PERIPH_UART0 },
+    { UART5_BASE, SYSCTL_PERIPH_UART5 },
+    { UART1_BASE, SYSCTL_PERIPH_UART1 },
+    { UART2_BASE, SYSCTL_PERIPH_UART2 },
+    { UART3_BASE, SYSCTL_PERIPH_UART3 },
+    { UART4_BASE, SYSCTL_PERIPH_UART4 },
+    { UART6_BASE, SYSCTL_PERIPH_UART6 },
+    { UART7_BASE, SYSCTL_PERIPH_UART7 }
+};
+
+#define NUM_CLOCK_UARTS         (sizeof(g_pui32ClockUARTs) /                  \
+                                 sizeof(g_pui32ClockUARTs[0]))
+
+//*****************************************************************************
+//
+// The current profile and frequency, and the registered notifications.
+//
+//*****************************************************************************
+static uint32_t g_ui32ClockProfile = CLOCK_PROFILE_COUNT;
+static uint32_t g_ui32ClockFreq;
+static tClockNotify g_ppfnClockNotify[CLOCK_MAX_NOTIFY];
+
+//*****************************************************************************
+//
+// Waits for a UART to finish sending and reads back its rate and line
+// settings.  Returns false if the UART is not running.
+//
+//*****************************************************************************
+static bool
+ClockUARTRead(uint32_t ui32Idx, uint32_t *pui32Baud, uint32_t *pui32Config)
+{
+    uint32_t ui32Base;
+
+    ui32Base = g_pui32ClockUARTs[ui32Idx][0];
+    if(!g_ui32ClockFreq ||
+       !MAP_SysCtlPeripheralReady(g_pui32ClockUARTs[ui32Idx][1]) ||
+       !(HWREG(ui32Base + UART_O_CTL) & UART_CTL_UARTEN))
+    {
+        return(false);
+    }
+
+    //
+    // The rate computed from the divisor is a few baud off, and every rate in
+    // use is a multiple of 100, so round it to that.
+    //
+    UARTTxFlush(ui32Base);
+    MAP_UARTConfigGetExpClk(ui32Base, ClockUARTFreq(ui32Base), pui32Baud,
+                            pui32Config);
+    *pui32Baud = ((*pui32Baud + 50) / 100) * 100;
+
+    return(true);
+}
+
+//*****************************************************************************
+//
+//! Switches the system clock to a profile.
+//!
+//! \param ui32Profile is one of the CLOCK_PROFILE_* values.
+//!
+//! Any UART that is enabled keeps its baud rate and line settings;
+//! anything queued on it is sent at the old rate first.  This must not be
+//! called while the uDMA bridge is enabled.
+//!
+//! \return None.
+//
+//*****************************************************************************
+void
+ClockProfileSet(uint32_t ui32Profile)
+{
+    uint32_t pui32Baud[NUM_CLOCK_UARTS], pui32Config[NUM_CLOCK_UARTS];
+    bool pbActive[NUM_CLOCK_UARTS];
+    uint32_t ui32Idx, ui32Old;
+
+    if((ui32Profile >= CLOCK_PROFILE_COUNT) ||
+       (ui32Profile == g_ui32ClockProfile))
+    {
+        return;
+    }
+
+    //
+    // Read back the rate of every running UART that is clocked from the
+    // system clock.
+    //
+    ui32Old = g_ui32ClockFreq;
+    for(ui32Idx = 0; ui32Idx < NUM_CLOCK_UARTS; ui32Idx++)
+    {
+        pbActive[ui32Idx] =
+            ClockUARTRead(ui32Idx, &pui32Baud[ui32Idx],
+                          &pui32Config[ui32Idx]) &&
+            (UARTClockSourceGet(g_pui32ClockUARTs[ui32Idx][0]) ==
+             UART_CLOCK_SYSTEM);
+    }
+
+#if defined(TARGET_IS_TM4C129_RA0) ||                                         \
+    defined(TARGET_IS_TM4C129_RA1) ||                                         \
+    defined(TARGET_IS_TM4C129_RA2)
+    g_ui32ClockFreq =
+        MAP_SysCtlClockFreqSet(g_psClockProfiles[ui32Profile].ui32Config,
+                               g_psClockProfiles[ui32Profile].ui32Freq);
+#else
+    MAP_SysCtlClockSet(g_psClockProfiles[ui32Profile].ui32Config);
+    g_ui32ClockFreq = MAP_SysCtlClockGet();
+#endif
+    g_ui32ClockProfile = ui32Profile;
+
+    for(ui32Idx = 0; ui32Idx < NUM_CLOCK_UARTS; ui32Idx++)
+    {
+        if(pbActive[ui32Idx])
+        {
+            MAP_UARTConfigSetExpClk(g_pui32ClockUARTs[ui32Idx][0],
+                                    g_ui32ClockFreq, pui32Baud[ui32Idx],
+                                    pui32Config[ui32Idx]);
+        }
+    }
+
+    for(ui32Idx = 0; ui32Idx < CLOCK_MAX_NOTIFY; ui32Idx++)
+    {
+        if(g_ppfnClockNotify[ui32Idx])
+        {
+            g_ppfnClockNotify[ui32Idx](ui32Old, g_ui32ClockFreq);
+        }
+    }
+}
+
+//*****************************************************************************
+//
+//! Returns the current clock profile.
+//!
+//! \return Returns one of the CLOCK_PROFILE_* values.
+//
+//*****************************************************************************
+uint32_t
+ClockProfileGet(void)
+{
+    return(g_ui32ClockProfile);
+}
+
+//*****************************************************************************
+//
+//! Returns the current system clock frequency.
+//!
+//! \return Returns the frequency in Hz.
+//
+//*****************************************************************************
+uint32_t
+ClockFreqGet(void)
+{
+    return(g_ui32ClockFreq);
+}
+
+//*****************************************************************************
+//
+//! Returns the nominal frequency of a clock profile.
+//!
+//! \param ui32Profile is one of the CLOCK_PROFILE_* values.
+//!
+//! \return Returns the frequency in Hz, or 0 for an unknown profile.
+//
+//*****************************************************************************
+uint32_t
+ClockProfileFreq(uint32_t ui32Profile)
+{
+    if(ui32Profile >= CLOCK_PROFILE_COUNT)
+    {
+        return(0);
+    }
+
+    return(g_psClockProfiles[ui32Profile].ui32Freq);
+}
+
+//*****************************************************************************
+//
+//! Registers a function to be called after every clock change.
+//!
+//! \param pfnNotify is the function.  It is called with the old and the new
+//! system clock frequency.
+//!
+//! \return Returns \b false if all notification slots are in use.
+//
+//*****************************************************************************
+bool
+ClockNotifyRegister(tClockNotify pfnNotify)
+{
+    uint32_t ui32Idx;
+
+    for(ui32Idx = 0; ui32Idx < CLOCK_MAX_NOTIFY; ui32Idx++)
+    {
+        if(!g_ppfnClockNotify[ui32Idx])
+        {
+            g_ppfnClockNotify[ui32Idx] = pfnNotify;
+            return(true);
+        }
+    }
+
+    return(false);
+}
+
+//*****************************************************************************
+//
+//! Selects the clock the UARTs in use run from.
+//!
+//! \param ui32Source is \b UART_CLOCK_SYSTEM or \b UART_CLOCK_PIOSC.
+//!
+//! Each UART that is enabled keeps its baud rate and line settings; anything
+//! queued on it is sent first.  This must not be called while the uDMA bridge
+//! is enabled.
+//!
+//! \return None.
+//
+//*****************************************************************************
+void
+ClockUARTSourceSet(uint32_t ui32Source)
+{
+    uint32_t ui32Idx, ui32Base, ui32Baud, ui32Config;
+
+    for(ui32Idx = 0; ui32Idx < NUM_CLOCK_UARTS; ui32Idx++)
+    {
+        ui32Base = g_pui32ClockUARTs[ui32Idx][0];
+        if(!ClockUARTRead(ui32Idx, &ui32Baud, &ui32Config) ||
+           (UARTClockSourceGet(ui32Base) == ui32Source))
+        {
+            continue;
+        }
+
+        MAP_UARTClockSourceSet(ui32Base, ui32Source);
+        MAP_UARTConfigSetExpClk(ui32Base, ClockUARTFreq(ui32Base), ui32Baud,
+                                ui32Config);
+    }
+}
+
+//*****************************************************************************
+//
+//! Returns the frequency a UART is clocked at.
+//!
+//! \param ui32Base is the base address of the UART.
+//!
+//! \return Returns CLOCK_PIOSC_FREQ if the UART runs from the precision
+//! internal oscillator, or else the system clock frequency.
+//
+//*****************************************************************************
+uint32_t
+ClockUARTFreq(uint32_t ui32Base)
+{
+    if(UARTClockSourceGet(ui32Base) == UART_CLOCK_PIOSC)
+    {
+        return(CLOCK_PIOSC_FREQ);
+    }
+
+    return(g_ui32ClockFreq);
+}
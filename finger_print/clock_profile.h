@@ -0,0 +1,74 @@
+//*****************************************************************************
+//
+// clock_profile.h - Prototypes for the system clock profiles.
+//
+//*****************************************************************************
+
+#ifndef __CLOCK_PROFILE_H__
+#define __CLOCK_PROFILE_H__
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+//*****************************************************************************
+//
+// The available clock profiles.  16 MHz runs straight from the crystal; the
+// others run from the PLL.
+//
+//*****************************************************************************
+#define CLOCK_PROFILE_16MHZ     0
+#define CLOCK_PROFILE_40MHZ     1
+#define CLOCK_PROFILE_50MHZ     2
+#define CLOCK_PROFILE_80MHZ     3
+#define CLOCK_PROFILE_COUNT     4
+
+//*****************************************************************************
+//
+// The profile selected at boot.
+//
+//*****************************************************************************
+#define CLOCK_PROFILE_DEFAULT   CLOCK_PROFILE_80MHZ
+
+//*****************************************************************************
+//
+// The frequency of the precision internal oscillator, which a UART can run
+// from instead of the system clock.
+//
+//*****************************************************************************
+#define CLOCK_PIOSC_FREQ        16000000
+
+//*****************************************************************************
+//
+// The number of functions that can ask to be told about clock changes.
+//
+//*****************************************************************************
+#define CLOCK_MAX_NOTIFY        4
+
+//*****************************************************************************
+//
+// A function called after every clock change, so that timer and SysTick
+// periods can be recomputed.
+//
+//*****************************************************************************
+typedef void (*tClockNotify)(uint32_t ui32OldClock, uint32_t ui32NewClock);
+
+//*****************************************************************************
+//
+// Prototypes for the APIs.
+//
+//*****************************************************************************
+extern void ClockProfileSet(uint32_t ui32Profile);
+extern uint32_t ClockProfileGet(void);
+extern uint32_t ClockFreqGet(void);
+extern uint32_t ClockProfileFreq(uint32_t ui32Profile);
+extern bool ClockNotifyRegister(tClockNotify pfnNotify);
+extern void ClockUARTSourceSet(uint32_t ui32Source);
+extern uint32_t ClockUARTFreq(uint32_t ui32Base);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __CLOCK_PROFILE_H__
@@ -0,0 +1,115 @@
+//*****************************************************************************
+//
+// cobs.c - Consistent Overhead Byte Stuffing.
+//
+// COBS removes every zero byte from a block, at a cost of one byte in 254,
+// so that a zero can mark the end of a frame on a byte stream.  Each run of
+// non-zero bytes is preceded by a code byte one larger than its length; a
+// code below 0xFF also stands for the zero that followed the run.  A
+// receiver that loses bytes is back in step at the next zero.
+//
+//*****************************************************************************
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "cobs.h"
+
+//*****************************************************************************
+//
+//! Encodes a block.
+//!
+//! \param pui8In is the block.
+//! \param ui32Len is the length of the block.
+//! \param pui8Out is the buffer the encoded block is written to, which must
+//! hold COBS_ENCODED_SIZE(ui32Len) bytes.  It holds no zero byte, and the
+//! frame delimiter is not added.
+//!
+//! \return Returns the length of the encoded block.
+//
+//*****************************************************************************
+uint32_t
+CobsEncode(const uint8_t *pui8In, uint32_t ui32Len, uint8_t *pui8Out)
+{
+    uint32_t ui32Code, ui32Out;
+    uint8_t *pui8Code;
+
+    pui8Code = pui8Out;
+    ui32Out = 1;
+    ui32Code = 1;
+
+    while(ui32Len--)
+    {
+        if(*pui8In)
+        {
+            pui8Out[ui32Out++] = *pui8In;
+            ui32Code++;
+        }
+
+        //
+        // Close the run at a zero or when it is as long as a code allows.
+        //
+        if(!*pui8In++ || (ui32Code == 0xFF))
+        {
+            *pui8Code = ui32Code;
+            pui8Code = &pui8Out[ui32Out++];
+            ui32Code = 1;
+        }
+    }
+
+    *pui8Code = ui32Code;
+
+    return(ui32Out);
+}
+
+//*****************************************************************************
+//
+//! Decodes a block.
+//!
+//! \param pui8In is the encoded block, without the frame delimiter.
+//! \param ui32Len is the length of the encoded block.
+//! \param pui8Out is the buffer the block is written to.  It may be the same
+//! as \e pui8In.
+//! \param ui32Size is the size of the buffer.
+//!
+//! \return Returns the length of the block, or 0 if the encoding is not
+//! valid or the block does not fit.
+//
+//*****************************************************************************
+uint32_t
+CobsDecode(const uint8_t *pui8In, uint32_t ui32Len, uint8_t *pui8Out,
+           uint32_t ui32Size)
+{
+    uint32_t ui32In, ui32Out, ui32Code, ui32Idx;
+
+    ui32In = 0;
+    ui32Out = 0;
+
+    while(ui32In < ui32Len)
+    {
+        ui32Code = pui8In[ui32In++];
+        if(!ui32Code || ((ui32In + ui32Code - 1) > ui32Len) ||
+           ((ui32Out + ui32Code - 1) > ui32Size))
+        {
+            return(0);
+        }
+
+        for(ui32Idx = 1; ui32Idx < ui32Code; ui32Idx++)
+        {
+            pui8Out[ui32Out++] = pui8In[ui32In++];
+        }
+
+        //
+        // A short run stands for a zero, except at the end of the block.
+        //
+        if((ui32Code < 0xFF) && (ui32In < ui32Len))
+        {
+            if(ui32Out >= ui32Size)
+            {
+                return(0);
+            }
+            pui8Out[ui32Out++] = 0;
+        }
+    }
+
+    return(ui32Out);
+}
@@ -0,0 +1,36 @@
+//*****************************************************************************
+//
+// cobs.h - Prototypes for Consistent Overhead Byte Stuffing.
+//
+//*****************************************************************************
+
+#ifndef __COBS_H__
+#define __COBS_H__
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+//*****************************************************************************
+//
+// The largest size a block of the given size can be encoded to.
+//
+//*****************************************************************************
+#define COBS_ENCODED_SIZE(n)    ((n) + ((n) / 254) + 1)
+
+//*****************************************************************************
+//
+// Prototypes for the APIs.
+//
+//*****************************************************************************
+extern uint32_t CobsEncode(const uint8_t *pui8In, uint32_t ui32Len,
+                           uint8_t *pui8Out);
+extern uint32_t CobsDecode(const uint8_t *pui8In, uint32_t ui32Len,
+                           uint8_t *pui8Out, uint32_t ui32Size);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __COBS_H__
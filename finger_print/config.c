@@ -0,0 +1,640 @@
+//*****************************************************************************
+//
+// config.c - Configuration store.
+//
+// The settings are kept in a shadow in RAM, so reading one costs nothing,
+// and written to EEPROM behind the caller's back.  A change only marks the
+// shadow dirty; once the settings have been left alone for
+// CONFIG_COMMIT_DELAY_MS the whole shadow is copied into a record and
+// written, so a burst of changes costs a single write.  The record is
+// written one word at a time with EEPROMProgramNonBlocking(), each word
+// started from the EEPROM interrupt when the one before has finished, and
+// words that already hold the value are not written at all.  The processor
+// never waits for the EEPROM except in ConfigFlush().
+//
+// The EEPROM programs one word at a time, so other modules that keep records
+// in it, such as the ID map of fp_shard.c, hand them to ConfigBlockWrite().
+// A block is copied and written by the same interrupt, in turn with the
+// settings.
+//
+// There are two banks, written in turn.  A record holds a header with the
+// layout version and length, a sequence number, the settings and a CRC-32
+// of the lot.  On boot the valid bank with the highest sequence number is
+// loaded, so a write cut short by a reset leaves the previous settings in
+// place.  Settings are only ever added at the end of the layout, so a record
+// written by older firmware is loaded as far as it goes and the settings it
+// does not have keep their defaults.
+//
+//*****************************************************************************
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include "inc/hw_ints.h"
+#include "driverlib/eeprom.h"
+#include "driverlib/interrupt.h"
+#include "driverlib/rom.h"
+#include "driverlib/rom_map.h"
+#include "driverlib/sysctl.h"
+#include "config.h"
+#include "crc_ctx.h"
+
+//*****************************************************************************
+//
+// The marker and the layout version in the record header.  The version
+// goes up whenever settings are added.
+//
+//*****************************************************************************
+#define CONFIG_MARKER           0x4346
+#define CONFIG_VERSION          1
+
+//*****************************************************************************
+//
+// The types of setting.
+//
+//*****************************************************************************
+#define CONFIG_TYPE_NUM         0
+#define CONFIG_TYPE_TEXT        1
+
+#define CONFIG_TEXT_WORDS       (CONFIG_TEXT_SIZE / 4)
+
+//*****************************************************************************
+//
+// The type of each setting, the first word it takes in the shadow and its
+// default.
+//
+//*****************************************************************************
+typedef struct
+{
+    uint8_t ui8Type;
+    uint8_t ui8Word;
+    uint32_t ui32Default;
+}
+tConfigKey;
+
+static const tConfigKey g_psConfigKeys[CONFIG_NUM_KEYS] =
+{
+    { CONFIG_TYPE_NUM, 0, 0 },              // LinkBaud
+    { CONFIG_TYPE_NUM, 1, 0 },              // Slots
+    { CONFIG_TYPE_NUM, 2, 80 },             // LossyRate, 0.8 bpp is ~10:1
+    { CONFIG_TYPE_NUM, 3, 0 },              // UnlockTimeout
+    { CONFIG_TYPE_NUM, 4, 0 },              // ConsoleMode
+    { CONFIG_TYPE_TEXT, 5, 0 },             // SuccStr
+    { CONFIG_TYPE_TEXT, 5 + CONFIG_TEXT_WORDS, 0 }
+                                            // FailStr
+};
+
+#define CONFIG_DATA_WORDS       (5 + (2 * CONFIG_TEXT_WORDS))
+
+//*****************************************************************************
+//
+// A record is the header, the sequence number, the settings and the CRC.
+//
+//*****************************************************************************
+#define CONFIG_RECORD_WORDS     (CONFIG_DATA_WORDS + 3)
+#define CONFIG_BANK_WORDS       (CONFIG_BANK_SIZE / 4)
+
+#define ConfigBankAddr(b)       (CONFIG_EEPROM_ADDR + ((b) * CONFIG_BANK_SIZE))
+
+//*****************************************************************************
+//
+// The shadow, whether it has changed since it was last written and for how
+// many milliseconds it has been left alone.
+//
+//*****************************************************************************
+static uint32_t g_pui32ConfigShadow[CONFIG_DATA_WORDS];
+static bool g_bConfigDirty;
+static uint32_t g_ui32ConfigQuietMs;
+
+//*****************************************************************************
+//
+// The bank holding the newest record and its sequence number.
+//
+//*****************************************************************************
+static uint32_t g_ui32ConfigBank;
+static uint32_t g_ui32ConfigSeq;
+
+//*****************************************************************************
+//
+// The settings record, and a block handed over by another module with its
+// address and length.  The block is pending from when it is handed
+// over until it has been written.
+//
+//*****************************************************************************
+static uint32_t g_pui32ConfigRecord[CONFIG_BANK_WORDS];
+static uint32_t g_pui32ConfigBlock[CONFIG_BLOCK_WORDS];
+static uint32_t g_ui32ConfigBlockAddr;
+static uint32_t g_ui32ConfigBlockWords;
+static volatile bool g_bConfigBlockPending;
+
+//*****************************************************************************
+//
+// The write in progress: the words, where they go, how many there are, the
+// next one, and whether they are the block rather than the settings.  They
+// are only touched by the EEPROM interrupt while a write is in progress.
+//
+//*****************************************************************************
+static const uint32_t *g_pui32ConfigSrc;
+static uint32_t g_ui32ConfigAddr;
+static uint32_t g_ui32ConfigWords;
+static uint32_t g_ui32ConfigWord;
+static bool g_bConfigWriteBlock;
+static volatile bool g_bConfigBusy;
+
+static tConfigStats g_sConfigStats;
+
+//*****************************************************************************
+//
+// Returns the CRC of the words of a record in front of its CRC.  Records hold
+// the CRC-32 without its final inversion, as they always have.
+//
+//*****************************************************************************
+static uint32_t
+ConfigCrc(const uint32_t *pui32Record, uint32_t ui32Words)
+{
+    return(CrcCtxBlock(CRC_CTX_CRC32, (const uint8_t *)pui32Record,
+                       ui32Words * 4) ^ 0xFFFFFFFF);
+}
+
+//*****************************************************************************
+//
+// Reads a bank into the record buffer.  Returns the number of settings
+// words in it, or 0 if it does not hold a valid record.
+//
+//*****************************************************************************
+static uint32_t
+ConfigBankRead(uint32_t ui32Bank)
+{
+    uint32_t ui32Words;
+
+    MAP_EEPROMRead(g_pui32ConfigRecord, ConfigBankAddr(ui32Bank),
+                   CONFIG_BANK_SIZE);
+
+    ui32Words = g_pui32ConfigRecord[0] & 0xFF;
+    if(((g_pui32ConfigRecord[0] >> 16) != CONFIG_MARKER) || !ui32Words ||
+       (ui32Words > (CONFIG_BANK_WORDS - 3)) ||
+       (ConfigCrc(g_pui32ConfigRecord, ui32Words + 2) !=
+        g_pui32ConfigRecord[ui32Words + 2]))
+    {
+        return(0);
+    }
+
+    return(ui32Words);
+}
+
+//*****************************************************************************
+//
+// Starts the next word that needs writing, or ends the write.  This runs in
+// the EEPROM interrupt once the write has started.
+//
+//*****************************************************************************
+static void
+ConfigWriteNext(void)
+{
+    uint32_t ui32Addr, ui32Stored;
+
+    while(g_ui32ConfigWord < g_ui32ConfigWords)
+    {
+        ui32Addr = g_ui32ConfigAddr + (g_ui32ConfigWord * 4);
+        MAP_EEPROMRead(&ui32Stored, ui32Addr, 4);
+        if(ui32Stored != g_pui32ConfigSrc[g_ui32ConfigWord])
+        {
+            g_sConfigStats.ui32Words++;
+            MAP_EEPROMProgramNonBlocking(g_pui32ConfigSrc[g_ui32ConfigWord++],
+                                         ui32Addr);
+            return;
+        }
+
+        g_sConfigStats.ui32Skipped++;
+        g_ui32ConfigWord++;
+    }
+
+    if(g_bConfigWriteBlock)
+    {
+        g_bConfigBlockPending = false;
+    }
+    else
+    {
+        //
+        // The last word has been written, so the other bank is now the
+        // newest.
+        //
+        g_ui32ConfigBank ^= 1;
+        g_ui32ConfigSeq++;
+    }
+    g_bConfigBusy = false;
+}
+
+//*****************************************************************************
+//
+// Starts writing words to EEPROM.
+//
+//*****************************************************************************
+static void
+ConfigWriteStart(const uint32_t *pui32Src, uint32_t ui32Addr,
+                 uint32_t ui32Words, bool bBlock)
+{
+    g_pui32ConfigSrc = pui32Src;
+    g_ui32ConfigAddr = ui32Addr;
+    g_ui32ConfigWords = ui32Words;
+    g_ui32ConfigWord = 0;
+    g_bConfigWriteBlock = bBlock;
+    g_bConfigBusy = true;
+    ConfigWriteNext();
+}
+
+//*****************************************************************************
+//
+// Starts writing the block handed over, if there is one.  Returns false if
+// there is none.
+//
+//*****************************************************************************
+static bool
+ConfigBlockStart(void)
+{
+    if(!g_bConfigBlockPending)
+    {
+        return(false);
+    }
+
+    ConfigWriteStart(g_pui32ConfigBlock, g_ui32ConfigBlockAddr,
+                     g_ui32ConfigBlockWords, true);
+
+    return(true);
+}
+
+//*****************************************************************************
+//
+// Copies the shadow into a record and starts writing it to the older bank.
+//
+//*****************************************************************************
+static void
+ConfigCommit(void)
+{
+    g_pui32ConfigRecord[0] = ((CONFIG_MARKER << 16) | (CONFIG_VERSION << 8) |
+                              CONFIG_DATA_WORDS);
+    g_pui32ConfigRecord[1] = g_ui32ConfigSeq + 1;
+    memcpy(&g_pui32ConfigRecord[2], g_pui32ConfigShadow,
+           sizeof(g_pui32ConfigShadow));
+    g_pui32ConfigRecord[CONFIG_RECORD_WORDS - 1] =
+        ConfigCrc(g_pui32ConfigRecord, CONFIG_RECORD_WORDS - 1);
+
+    g_bConfigDirty = false;
+    g_sConfigStats.ui32Commits++;
+
+    ConfigWriteStart(g_pui32ConfigRecord, ConfigBankAddr(g_ui32ConfigBank ^ 1),
+                     CONFIG_RECORD_WORDS, false);
+}
+
+//*****************************************************************************
+//
+// Marks the shadow changed.
+//
+//*****************************************************************************
+static void
+ConfigChanged(void)
+{
+    g_bConfigDirty = true;
+    g_ui32ConfigQuietMs = 0;
+    g_sConfigStats.ui32Changes++;
+}
+
+//*****************************************************************************
+//
+//! Loads the settings from EEPROM.
+//!
+//! This enables the EEPROM and its interrupt, which ConfigIntHandler() must
+//! handle.  Settings that were never stored take their defaults.
+//!
+//! \return None.
+//
+//*****************************************************************************
+void
+ConfigInit(void)
+{
+    uint32_t ui32Bank, ui32Words, ui32Seq, ui32Key;
+    bool bFound;
+
+    MAP_SysCtlPeripheralEnable(SYSCTL_PERIPH_EEPROM0);
+    MAP_EEPROMInit();
+
+    for(ui32Key = 0; ui32Key < CONFIG_NUM_KEYS; ui32Key++)
+    {
+        if(g_psConfigKeys[ui32Key].ui8Type == CONFIG_TYPE_NUM)
+        {
+            g_pui32ConfigShadow[g_psConfigKeys[ui32Key].ui8Word] =
+                g_psConfigKeys[ui32Key].ui32Default;
+        }
+    }
+
+    //
+    // With no record, the first write goes to bank 0.
+    //
+    g_ui32ConfigBank = 1;
+    g_ui32ConfigSeq = 0;
+    g_bConfigDirty = false;
+    g_bConfigBusy = false;
+    g_bConfigBlockPending = false;
+    g_sConfigStats.ui32Version = 0;
+    bFound = false;
+
+    for(ui32Bank = 0; ui32Bank < 2; ui32Bank++)
+    {
+        ui32Words = ConfigBankRead(ui32Bank);
+        ui32Seq = g_pui32ConfigRecord[1];
+        if(!ui32Words || (bFound && (ui32Seq <= g_ui32ConfigSeq)))
+        {
+            continue;
+        }
+
+        if(ui32Words > CONFIG_DATA_WORDS)
+        {
+            ui32Words = CONFIG_DATA_WORDS;
+        }
+        memcpy(g_pui32ConfigShadow, &g_pui32ConfigRecord[2], ui32Words * 4);
+
+        bFound = true;
+        g_ui32ConfigBank = ui32Bank;
+        g_ui32ConfigSeq = ui32Seq;
+        g_sConfigStats.ui32Version = (g_pui32ConfigRecord[0] >> 8) & 0xFF;
+    }
+
+    //
+    // A record from older firmware is written again in the current layout.
+    //
+    if(bFound && (g_sConfigStats.ui32Version != CONFIG_VERSION))
+    {
+        g_bConfigDirty = true;
+    }
+
+    //
+    // Make sure every text setting ends.
+    //
+    for(ui32Key = 0; ui32Key < CONFIG_NUM_KEYS; ui32Key++)
+    {
+        if(g_psConfigKeys[ui32Key].ui8Type == CONFIG_TYPE_TEXT)
+        {
+            ((char *)&g_pui32ConfigShadow[
+                g_psConfigKeys[ui32Key].ui8Word])[CONFIG_TEXT_SIZE - 1] = 0;
+        }
+    }
+
+    MAP_EEPROMIntEnable(EEPROM_INT_PROGRAM);
+    MAP_IntEnable(INT_FLASH);
+}
+
+//*****************************************************************************
+//
+//! Returns a number setting.
+//!
+//! \param ui32Key is one of the CONFIG_* number settings.
+//!
+//! \return Returns the value, or 0 if the key is not a number setting.
+//
+//*****************************************************************************
+uint32_t
+ConfigNumGet(uint32_t ui32Key)
+{
+    if((ui32Key >= CONFIG_NUM_KEYS) ||
+       (g_psConfigKeys[ui32Key].ui8Type != CONFIG_TYPE_NUM))
+    {
+        return(0);
+    }
+
+    return(g_pui32ConfigShadow[g_psConfigKeys[ui32Key].ui8Word]);
+}
+
+//*****************************************************************************
+//
+//! Changes a number setting.
+//!
+//! \param ui32Key is one of the CONFIG_* number settings.
+//! \param ui32Value is the new value.
+//!
+//! The change is written to EEPROM later.
+//!
+//! \return Returns \b false if the key is not a number setting.
+//
+//*****************************************************************************
+bool
+ConfigNumSet(uint32_t ui32Key, uint32_t ui32Value)
+{
+    uint32_t *pui32Value;
+
+    if((ui32Key >= CONFIG_NUM_KEYS) ||
+       (g_psConfigKeys[ui32Key].ui8Type != CONFIG_TYPE_NUM))
+    {
+        return(false);
+    }
+
+    pui32Value = &g_pui32ConfigShadow[g_psConfigKeys[ui32Key].ui8Word];
+    if(*pui32Value != ui32Value)
+    {
+        *pui32Value = ui32Value;
+        ConfigChanged();
+    }
+
+    return(true);
+}
+
+//*****************************************************************************
+//
+//! Returns a text setting.
+//!
+//! \param ui32Key is one of the CONFIG_* text settings.
+//!
+//! \return Returns the text, which stays valid until the setting is changed,
+//! or an empty string if the key is not a text setting.
+//
+//*****************************************************************************
+const char *
+ConfigTextGet(uint32_t ui32Key)
+{
+    if((ui32Key >= CONFIG_NUM_KEYS) ||
+       (g_psConfigKeys[ui32Key].ui8Type != CONFIG_TYPE_TEXT))
+    {
+        return("");
+    }
+
+    return((const char *)&g_pui32ConfigShadow[g_psConfigKeys[ui32Key].ui8Word]);
+}
+
+//*****************************************************************************
+//
+//! Changes a text setting.
+//!
+//! \param ui32Key is one of the CONFIG_* text settings.
+//! \param pcText is the new text, which is copied.
+//!
+//! The change is written to EEPROM later.
+//!
+//! \return Returns \b false if the key is not a text setting or the text is
+//! not shorter than CONFIG_TEXT_SIZE.
+//
+//*****************************************************************************
+bool
+ConfigTextSet(uint32_t ui32Key, const char *pcText)
+{
+    char pcPadded[CONFIG_TEXT_SIZE];
+    uint32_t ui32Len;
+    char *pcValue;
+
+    ui32Len = strlen(pcText);
+    if((ui32Key >= CONFIG_NUM_KEYS) ||
+       (g_psConfigKeys[ui32Key].ui8Type != CONFIG_TYPE_TEXT) ||
+       (ui32Len >= CONFIG_TEXT_SIZE))
+    {
+        return(false);
+    }
+
+    //
+    // Unused bytes are kept zero so the record only changes with the text.
+    //
+    memset(pcPadded, 0, sizeof(pcPadded));
+    memcpy(pcPadded, pcText, ui32Len);
+
+    pcValue = (char *)&g_pui32ConfigShadow[g_psConfigKeys[ui32Key].ui8Word];
+    if(memcmp(pcValue, pcPadded, sizeof(pcPadded)))
+    {
+        memcpy(pcValue, pcPadded, sizeof(pcPadded));
+        ConfigChanged();
+    }
+
+    return(true);
+}
+
+//*****************************************************************************
+//
+//! Writes a block of words to EEPROM behind the caller's back.
+//!
+//! \param pui32Data is the block, which is copied.
+//! \param ui32Addr is the EEPROM address to write it to, outside the store.
+//! \param ui32Words is the number of words, at most CONFIG_BLOCK_WORDS.
+//!
+//! The block is written by the EEPROM interrupt, after the settings if they
+//! are being written, and only one block can wait at a time.  Words that
+//! already hold the value are not written.
+//!
+//! \return Returns \b false if the block is too long or the one handed over
+//! before has not been written yet, in which case the caller tries again
+//! later.
+//
+//*****************************************************************************
+bool
+ConfigBlockWrite(const uint32_t *pui32Data, uint32_t ui32Addr,
+                 uint32_t ui32Words)
+{
+    if(g_bConfigBlockPending || (ui32Words > CONFIG_BLOCK_WORDS))
+    {
+        return(false);
+    }
+
+    memcpy(g_pui32ConfigBlock, pui32Data, ui32Words * 4);
+    g_ui32ConfigBlockAddr = ui32Addr;
+    g_ui32ConfigBlockWords = ui32Words;
+    g_bConfigBlockPending = true;
+
+    if(!g_bConfigBusy)
+    {
+        ConfigBlockStart();
+    }
+
+    return(true);
+}
+
+//*****************************************************************************
+//
+//! Starts writing the settings once they have been left alone long enough.
+//!
+//! This must be called every CONFIG_TICK_MS.  A block handed to
+//! ConfigBlockWrite() while the settings were being written is started
+//! first.
+//!
+//! \return None.
+//
+//*****************************************************************************
+void
+ConfigTick(void)
+{
+    if(g_bConfigBusy || ConfigBlockStart() || !g_bConfigDirty)
+    {
+        return;
+    }
+
+    g_ui32ConfigQuietMs += CONFIG_TICK_MS;
+    if(g_ui32ConfigQuietMs >= CONFIG_COMMIT_DELAY_MS)
+    {
+        ConfigCommit();
+    }
+}
+
+//*****************************************************************************
+//
+//! Writes any changed settings and any block handed over to EEPROM now and
+//! waits until they are written.
+//!
+//! Interrupts must be enabled, since the write is driven by the EEPROM
+//! interrupt.
+//!
+//! \return None.
+//
+//*****************************************************************************
+void
+ConfigFlush(void)
+{
+    while(g_bConfigBusy)
+    {
+    }
+
+    if(ConfigBlockStart())
+    {
+        while(g_bConfigBusy)
+        {
+        }
+    }
+
+    if(g_bConfigDirty)
+    {
+        ConfigCommit();
+        while(g_bConfigBusy)
+        {
+        }
+    }
+}
+
+//*****************************************************************************
+//
+//! Handles the EEPROM interrupt.
+//!
+//! The EEPROM shares the flash controller interrupt, INT_FLASH.
+//!
+//! \return None.
+//
+//*****************************************************************************
+void
+ConfigIntHandler(void)
+{
+    MAP_EEPROMIntClear(EEPROM_INT_PROGRAM);
+
+    if(g_bConfigBusy)
+    {
+        ConfigWriteNext();
+    }
+}
+
+//*****************************************************************************
+//
+//! Returns the configuration store statistics.
+//!
+//! \param psStats is a pointer to the structure that is filled in.
+//!
+//! \return None.
+//
+//*****************************************************************************
+void
+ConfigStatsGet(tConfigStats *psStats)
+{
+    MAP_IntMasterDisable();
+    *psStats = g_sConfigStats;
+    MAP_IntMasterEnable();
+}
@@ -0,0 +1,112 @@
+//*****************************************************************************
+//
+// config.h - Prototypes for the configuration store.
+//
+//*****************************************************************************
+
+#ifndef __CONFIG_H__
+#define __CONFIG_H__
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+//*****************************************************************************
+//
+// The settings.  New ones must be added at the end, so that the settings
+// stored by older firmware are still found where they were.
+//
+//*****************************************************************************
+#define CONFIG_LINK_BAUD        0   // Sensor link rate, 0 if not known
+#define CONFIG_SLOTS            1   // Slot occupancy cache word
+#define CONFIG_LOSSY_RATE       2   // Lossy upload rate, 1/100 bit per pixel
+#define CONFIG_UNLOCK_TIMEOUT   3   // Sensor unlock timeout, seconds
+#define CONFIG_CONSOLE_MODE     4   // Console protocol
+#define CONFIG_SUCC_STR         5   // Sensor success string
+#define CONFIG_FAIL_STR         6   // Sensor failure string
+#define CONFIG_NUM_KEYS         7
+
+//*****************************************************************************
+//
+// The size of a text setting, including the terminating zero.
+//
+//*****************************************************************************
+#define CONFIG_TEXT_SIZE        32
+
+//*****************************************************************************
+//
+// The period ConfigTick() must be called at, and how long the settings must
+// be left alone before changes are written, in milliseconds.
+//
+//*****************************************************************************
+#define CONFIG_TICK_MS          100
+#define CONFIG_COMMIT_DELAY_MS  500
+
+//*****************************************************************************
+//
+// The EEPROM location of the store.  It takes two 128 byte banks; the ID map
+// of fp_shard.c follows them.
+//
+//*****************************************************************************
+#define CONFIG_EEPROM_ADDR      0x0000
+#define CONFIG_BANK_SIZE        0x0080
+
+//*****************************************************************************
+//
+// The most words ConfigBlockWrite() takes at once.
+//
+//*****************************************************************************
+#define CONFIG_BLOCK_WORDS      64
+
+//*****************************************************************************
+//
+// Statistics kept by the store.
+//
+//*****************************************************************************
+typedef struct
+{
+    //
+    // The number of changes made to the settings, and the number of times
+    // they were written to EEPROM.
+    //
+    uint32_t ui32Changes;
+    uint32_t ui32Commits;
+
+    //
+    // The number of words written, and the number left alone because they
+    // already held the value.
+    //
+    uint32_t ui32Words;
+    uint32_t ui32Skipped;
+
+    //
+    // The layout version the settings were loaded from, or 0 if the defaults
+    // were used.
+    //
+    uint32_t ui32Version;
+}
+tConfigStats;
+
+//*****************************************************************************
+//
+// Prototypes for the APIs.
+//
+//*****************************************************************************
+extern void ConfigInit(void);
+extern uint32_t ConfigNumGet(uint32_t ui32Key);
+extern bool ConfigNumSet(uint32_t ui32Key, uint32_t ui32Value);
+extern const char *ConfigTextGet(uint32_t ui32Key);
+extern bool ConfigTextSet(uint32_t ui32Key, const char *pcText);
+extern bool ConfigBlockWrite(const uint32_t *pui32Data, uint32_t ui32Addr,
+                             uint32_t ui32Words);
+extern void ConfigTick(void);
+extern void ConfigFlush(void);
+extern void ConfigIntHandler(void);
+extern void ConfigStatsGet(tConfigStats *psStats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __CONFIG_H__
@@ -0,0 +1,121 @@
+//*****************************************************************************
+//
+// console.c - Formatted output to the console (UART0).
+//
+// These helpers queue on the UART0 transmit ring and only wait when the ring
+// is full, in the same way as UARTSend() in main.c.
+//
+//*****************************************************************************
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "inc/hw_memmap.h"
+#include "uart_tx.h"
+#include "console.h"
+
+//*****************************************************************************
+//
+//! Writes a number of characters to the console.
+//!
+//! \param pcData is a pointer to the characters.
+//! \param ui32Len is the number of characters.
+//!
+//! \return None.
+//
+//*****************************************************************************
+void
+ConsoleWriteLen(const char *pcData, uint32_t ui32Len)
+{
+    uint32_t ui32Queued;
+
+    while(ui32Len)
+    {
+        ui32Queued = UARTTxSpaceAvail(UART0_BASE);
+        if(ui32Queued > ui32Len)
+        {
+            ui32Queued = ui32Len;
+        }
+
+        ui32Queued = UARTTxQueue(UART0_BASE, (const uint8_t *)pcData,
+                                 ui32Queued);
+        pcData += ui32Queued;
+        ui32Len -= ui32Queued;
+    }
+}
+
+//*****************************************************************************
+//
+//! Writes a NUL terminated string to the console.
+//!
+//! \param pcString is the string.
+//!
+//! \return None.
+//
+//*****************************************************************************
+void
+ConsoleWrite(const char *pcString)
+{
+    uint32_t ui32Len;
+
+    for(ui32Len = 0; pcString[ui32Len]; ui32Len++)
+    {
+    }
+
+    ConsoleWriteLen(pcString, ui32Len);
+}
+
+//*****************************************************************************
+//
+//! Writes an unsigned number to the console in decimal.
+//!
+//! \param ui32Value is the number.
+//!
+//! \return None.
+//
+//*****************************************************************************
+void
+ConsoleWriteNum(uint32_t ui32Value)
+{
+    char pcDigits[10];
+    uint32_t ui32Pos;
+
+    ui32Pos = sizeof(pcDigits);
+    do
+    {
+        pcDigits[--ui32Pos] = '0' + (ui32Value % 10);
+        ui32Value /= 10;
+    }
+    while(ui32Value);
+
+    ConsoleWriteLen(pcDigits + ui32Pos, sizeof(pcDigits) - ui32Pos);
+}
+
+//*****************************************************************************
+//
+//! Writes an unsigned number to the console in hexadecimal.
+//!
+//! \param ui32Value is the number.
+//! \param ui32Digits is the number of digits to write, from 1 to 8.
+//!
+//! \return None.
+//
+//*****************************************************************************
+void
+ConsoleWriteHex(uint32_t ui32Value, uint32_t ui32Digits)
+{
+    char pcDigits[8];
+    uint32_t ui32Pos;
+
+    if((ui32Digits < 1) || (ui32Digits > 8))
+    {
+        ui32Digits = 8;
+    }
+
+    for(ui32Pos = ui32Digits; ui32Pos; ui32Pos--)
+    {
+        pcDigits[ui32Pos - 1] = "0123456789ABCDEF"[ui32Value & 0xF];
+        ui32Value >>= 4;
+    }
+
+    ConsoleWriteLen(pcDigits, ui32Digits);
+}
@@ -0,0 +1,29 @@
+//*****************************************************************************
+//
+// console.h - Prototypes for the formatted console output helpers.
+//
+//*****************************************************************************
+
+#ifndef __CONSOLE_H__
+#define __CONSOLE_H__
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+//*****************************************************************************
+//
+// Prototypes for the APIs.
+//
+//*****************************************************************************
+extern void ConsoleWriteLen(const char *pcData, uint32_t ui32Len);
+extern void ConsoleWrite(const char *pcString);
+extern void ConsoleWriteNum(uint32_t ui32Value);
+extern void ConsoleWriteHex(uint32_t ui32Value, uint32_t ui32Digits);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __CONSOLE_H__
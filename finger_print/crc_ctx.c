@@ -0,0 +1,235 @@
+//*****************************************************************************
+//
+// crc_ctx.c - Streaming CRC contexts.
+//
+// A context computes one CRC over data that is supplied in pieces, without
+// the caller knowing how it is computed.  TM4C129 parts have a CRC engine in
+// the CCM, which takes a word per write; there the CRC-16 and CRC-32 of
+// blocks of CRC_CTX_HW_MIN bytes or more are computed by the engine, and
+// everything else by the tables in sw_crc.c.  Other parts use the tables
+// only.  The engine has no polynomial for the CRC-8-CCITT.
+//
+// The engine holds the state of one CRC, so each update loads the state of
+// its context into the engine and reads it back.  Contexts can therefore be
+// interleaved, but updates must only be made from the event loop.
+//
+// The engine is written by the CPU rather than by uDMA: the calls return the
+// CRC, so the CPU would only wait for the transfer, and a store per word
+// already keeps up with the engine.
+//
+//*****************************************************************************
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "driverlib/sw_crc.h"
+#include "crc_ctx.h"
+
+#if defined(TARGET_IS_TM4C129_RA0) ||                                         \
+    defined(TARGET_IS_TM4C129_RA1) ||                                         \
+    defined(TARGET_IS_TM4C129_RA2)
+#define CRC_CTX_HW
+#include "inc/hw_memmap.h"
+#include "driverlib/crc.h"
+#include "driverlib/sysctl.h"
+#include "driverlib/rom.h"
+#include "driverlib/rom_map.h"
+#endif
+
+#ifdef CRC_CTX_HW
+//*****************************************************************************
+//
+// The shortest block that is worth the cost of loading the engine.
+//
+//*****************************************************************************
+#define CRC_CTX_HW_MIN          16
+
+//*****************************************************************************
+//
+// Whether the engine has been enabled.
+//
+//*****************************************************************************
+static bool g_bCrcCtxHwReady;
+
+//*****************************************************************************
+//
+// Reverses the bits of a word.  The tables compute the CRCs bit-reflected,
+// while the engine holds its state the other way round.
+//
+//*****************************************************************************
+static uint32_t
+CrcCtxReverse(uint32_t ui32Value)
+{
+    ui32Value = (((ui32Value >> 1) & 0x55555555) |
+                 ((ui32Value & 0x55555555) << 1));
+    ui32Value = (((ui32Value >> 2) & 0x33333333) |
+                 ((ui32Value & 0x33333333) << 2));
+    ui32Value = (((ui32Value >> 4) & 0x0F0F0F0F) |
+                 ((ui32Value & 0x0F0F0F0F) << 4));
+    ui32Value = (((ui32Value >> 8) & 0x00FF00FF) |
+                 ((ui32Value & 0x00FF00FF) << 8));
+
+    return((ui32Value >> 16) | (ui32Value << 16));
+}
+
+//*****************************************************************************
+//
+// Runs a block through the engine.  The input bits are reversed, so that with
+// the state reversed the engine computes the reflected CRC; reversing a whole
+// word also puts its first byte in memory at the top, where the engine starts.
+// Bytes before the first word and after the last are written one at a time.
+//
+//*****************************************************************************
+static uint32_t
+CrcCtxHwUpdate(uint32_t ui32Type, uint32_t ui32Crc, const uint8_t *pui8Data,
+               uint32_t ui32Count)
+{
+    uint32_t ui32Config, ui32Head, ui32Words;
+
+    if(!g_bCrcCtxHwReady)
+    {
+        MAP_SysCtlPeripheralEnable(SYSCTL_PERIPH_CCM0);
+        while(!MAP_SysCtlPeripheralReady(SYSCTL_PERIPH_CCM0))
+        {
+        }
+        g_bCrcCtxHwReady = true;
+    }
+
+    if(ui32Type == CRC_CTX_CRC32)
+    {
+        ui32Config = CRC_CFG_INIT_SEED | CRC_CFG_IBR | CRC_CFG_TYPE_P4C11DB7;
+        CRCSeedSet(CCM0_BASE, CrcCtxReverse(ui32Crc));
+    }
+    else
+    {
+        ui32Config = CRC_CFG_INIT_SEED | CRC_CFG_IBR | CRC_CFG_TYPE_P8005;
+        CRCSeedSet(CCM0_BASE, CrcCtxReverse(ui32Crc) >> 16);
+    }
+
+    ui32Head = (4 - ((uint32_t)pui8Data & 3)) & 3;
+    ui32Words = (ui32Count - ui32Head) / 4;
+
+    if(ui32Head)
+    {
+        CRCConfigSet(CCM0_BASE, ui32Config | CRC_CFG_SIZE_8BIT);
+        CRCDataProcess(CCM0_BASE, (uint32_t *)pui8Data, ui32Head, false);
+        pui8Data += ui32Head;
+        ui32Count -= ui32Head;
+    }
+
+    CRCConfigSet(CCM0_BASE, ui32Config | CRC_CFG_SIZE_32BIT);
+    CRCDataProcess(CCM0_BASE, (uint32_t *)pui8Data, ui32Words, false);
+    pui8Data += ui32Words * 4;
+    ui32Count -= ui32Words * 4;
+
+    if(ui32Count)
+    {
+        CRCConfigSet(CCM0_BASE, ui32Config | CRC_CFG_SIZE_8BIT);
+        CRCDataProcess(CCM0_BASE, (uint32_t *)pui8Data, ui32Count, false);
+    }
+
+    ui32Crc = CrcCtxReverse(CRCResultRead(CCM0_BASE, false));
+
+    return((ui32Type == CRC_CTX_CRC32) ? ui32Crc : (ui32Crc >> 16));
+}
+#endif
+
+//*****************************************************************************
+//
+//! Starts a CRC.
+//!
+//! \param psCtx is the context.
+//! \param ui32Type is the CRC, one of the \b CRC_CTX_* values.
+//!
+//! \return None.
+//
+//*****************************************************************************
+void
+CrcCtxInit(tCrcCtx *psCtx, uint32_t ui32Type)
+{
+    psCtx->ui32Type = ui32Type;
+    psCtx->ui32Crc = (ui32Type == CRC_CTX_CRC32) ? 0xFFFFFFFF : 0;
+}
+
+//*****************************************************************************
+//
+//! Adds data to a CRC.
+//!
+//! \param psCtx is the context.
+//! \param pui8Data is the data.  It need not be aligned.
+//! \param ui32Count is the number of bytes of data.
+//!
+//! \return None.
+//
+//*****************************************************************************
+void
+CrcCtxUpdate(tCrcCtx *psCtx, const uint8_t *pui8Data, uint32_t ui32Count)
+{
+#ifdef CRC_CTX_HW
+    if((psCtx->ui32Type != CRC_CTX_CRC8_CCITT) &&
+       (ui32Count >= CRC_CTX_HW_MIN))
+    {
+        psCtx->ui32Crc = CrcCtxHwUpdate(psCtx->ui32Type, psCtx->ui32Crc,
+                                        pui8Data, ui32Count);
+        return;
+    }
+#endif
+
+    switch(psCtx->ui32Type)
+    {
+    case CRC_CTX_CRC8_CCITT:
+        psCtx->ui32Crc = Crc8CCITT(psCtx->ui32Crc, pui8Data, ui32Count);
+        break;
+    case CRC_CTX_CRC16:
+        psCtx->ui32Crc = Crc16(psCtx->ui32Crc, pui8Data, ui32Count);
+        break;
+    case CRC_CTX_CRC32:
+        psCtx->ui32Crc = Crc32(psCtx->ui32Crc, pui8Data, ui32Count);
+        break;
+    default:
+        break;
+    }
+}
+
+//*****************************************************************************
+//
+//! Returns a CRC.
+//!
+//! \param psCtx is the context.
+//!
+//! The context is left as it is, so more data can still be added to it.
+//!
+//! \return Returns the CRC of all the data added since CrcCtxInit().
+//
+//*****************************************************************************
+uint32_t
+CrcCtxFinal(const tCrcCtx *psCtx)
+{
+    if(psCtx->ui32Type == CRC_CTX_CRC32)
+    {
+        return(psCtx->ui32Crc ^ 0xFFFFFFFF);
+    }
+
+    return(psCtx->ui32Crc);
+}
+
+//*****************************************************************************
+//
+//! Returns the CRC of a block.
+//!
+//! \param ui32Type is the CRC, one of the \b CRC_CTX_* values.
+//! \param pui8Data is the block.
+//! \param ui32Count is the number of bytes in the block.
+//!
+//! \return Returns the CRC, as CrcCtxFinal() would.
+//
+//*****************************************************************************
+uint32_t
+CrcCtxBlock(uint32_t ui32Type, const uint8_t *pui8Data, uint32_t ui32Count)
+{
+    tCrcCtx sCtx;
+
+    CrcCtxInit(&sCtx, ui32Type);
+    CrcCtxUpdate(&sCtx, pui8Data, ui32Count);
+
+    return(CrcCtxFinal(&sCtx));
+}
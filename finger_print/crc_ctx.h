@@ -0,0 +1,54 @@
+//*****************************************************************************
+//
+// crc_ctx.h - Prototypes for the streaming CRC contexts.
+//
+//*****************************************************************************
+
+#ifndef __CRC_CTX_H__
+#define __CRC_CTX_H__
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+//*****************************************************************************
+//
+// The CRCs a context computes.  Each gives the same value as the function in
+// sw_crc.c named after it, started as its documentation describes; the
+// CRC-32 is also inverted at the end, so it is the standard CRC-32.
+//
+//*****************************************************************************
+#define CRC_CTX_CRC8_CCITT      0       // Crc8CCITT() from 0
+#define CRC_CTX_CRC16           1       // Crc16() from 0
+#define CRC_CTX_CRC32           2       // Crc32() from 0xFFFFFFFF, inverted
+
+//*****************************************************************************
+//
+// A CRC being computed.  The members are private to crc_ctx.c.
+//
+//*****************************************************************************
+typedef struct
+{
+    uint32_t ui32Type;
+    uint32_t ui32Crc;
+}
+tCrcCtx;
+
+//*****************************************************************************
+//
+// Prototypes for the APIs.
+//
+//*****************************************************************************
+extern void CrcCtxInit(tCrcCtx *psCtx, uint32_t ui32Type);
+extern void CrcCtxUpdate(tCrcCtx *psCtx, const uint8_t *pui8Data,
+                         uint32_t ui32Count);
+extern uint32_t CrcCtxFinal(const tCrcCtx *psCtx);
+extern uint32_t CrcCtxBlock(uint32_t ui32Type, const uint8_t *pui8Data,
+                            uint32_t ui32Count);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __CRC_CTX_H__
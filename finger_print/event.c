@@ -0,0 +1,446 @@
+//*****************************************************************************
+//
+// event.c - Event loop.
+//
+// Interrupt handlers do no more than post an event describing what happened;
+// the main loop takes events off the queue one at a time and calls the
+// handler registered for their type, which runs to completion before the next
+// event is looked at.  When the queue is empty the idle hooks are called
+// instead.  Nothing in the main context blocks waiting for input, so a key
+// typed on the console, a sensor response and a timer all get a turn in the
+// order they happened.
+//
+// Every event is stamped with the cycle counter when it is posted, and the
+// time it waited before its handler was called is kept for each type.
+//
+// A timer that expires again while its last expiry is still queued does not
+// post another one; the expiries are merged.  A periodic timer therefore
+// takes at most one slot however long the main context blocks, and cannot
+// crowd the interrupts that post input out of the queue.
+//
+// The queue is filled from interrupts of any priority and emptied by the main
+// loop only, so posting masks interrupts for the few instructions it takes to
+// claim a slot and dispatching needs no lock at all.
+//
+// The loop does not touch any peripheral.  A host build, which simulates the
+// interrupts to measure dispatch latency, defines EVENT_HOST and provides
+// EventHostIntMask(), EventHostIntRestore() and EventHostTimestamp() in place
+// of the interrupt mask and the cycle counter; tests/test_event.c is one.
+//
+//*****************************************************************************
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#ifndef EVENT_HOST
+#include "inc/hw_types.h"
+#include "driverlib/interrupt.h"
+#include "driverlib/rom.h"
+#include "driverlib/rom_map.h"
+#include "bench.h"
+#endif
+#include "event.h"
+
+//*****************************************************************************
+//
+// Masks interrupts, returning whether they were masked already, restores the
+// mask and reads the time stamp.
+//
+//*****************************************************************************
+#ifdef EVENT_HOST
+extern bool EventHostIntMask(void);
+extern void EventHostIntRestore(bool bMasked);
+extern uint32_t EventHostTimestamp(void);
+#define EventIntMask()          EventHostIntMask()
+#define EventIntRestore(b)      EventHostIntRestore(b)
+#define EventTimestamp()        EventHostTimestamp()
+#else
+#define EventIntMask()          MAP_IntMasterDisable()
+#define EventIntRestore(b)      do { if(!(b)) MAP_IntMasterEnable(); } while(0)
+#define EventTimestamp()        BenchCycles()
+#endif
+
+//*****************************************************************************
+//
+// The event queue.  The head is only advanced with interrupts masked and the
+// tail only by the main loop; both count freely and are masked on use.
+//
+//*****************************************************************************
+static tEvent g_psEventQueue[EVENT_QUEUE_SIZE];
+static volatile uint32_t g_ui32EventHead;
+static volatile uint32_t g_ui32EventTail;
+
+//*****************************************************************************
+//
+// The handler of each event type, and the idle hooks.
+//
+//*****************************************************************************
+static tEventHandler g_ppfnEventHandlers[EVENT_NUM_TYPES];
+static tEventIdleHook g_ppfnEventIdleHooks[EVENT_MAX_IDLE_HOOKS];
+
+//*****************************************************************************
+//
+// A software timer.  ui32Left counts down once per tick and the timer expires
+// when it reaches zero; a periodic timer is then reloaded from ui32Period.
+// bQueued is set while an expiry of the timer waits in the queue.
+//
+//*****************************************************************************
+typedef struct
+{
+    uint32_t ui32Left;
+    uint32_t ui32Period;
+    volatile bool bQueued;
+}
+tEventTimer;
+
+static tEventTimer g_psEventTimers[EVENT_MAX_TIMERS];
+
+//*****************************************************************************
+//
+// The dispatch statistics of each event type.
+//
+//*****************************************************************************
+static tEventStats g_psEventStats[EVENT_NUM_TYPES];
+
+//*****************************************************************************
+//
+//! Initializes the event loop.
+//!
+//! The queue is emptied, every handler, idle hook and timer is removed and
+//! the statistics are cleared.
+//!
+//! \return None.
+//
+//*****************************************************************************
+void
+EventInit(void)
+{
+    bool bMasked;
+
+    bMasked = EventIntMask();
+    g_ui32EventHead = 0;
+    g_ui32EventTail = 0;
+    memset(g_ppfnEventHandlers, 0, sizeof(g_ppfnEventHandlers));
+    memset(g_ppfnEventIdleHooks, 0, sizeof(g_ppfnEventIdleHooks));
+    memset(g_psEventTimers, 0, sizeof(g_psEventTimers));
+    memset(g_psEventStats, 0, sizeof(g_psEventStats));
+    EventIntRestore(bMasked);
+}
+
+//*****************************************************************************
+//
+//! Sets the function an event type is dispatched to.
+//!
+//! \param ui32Type is one of the EVENT_* types.
+//! \param pfnHandler is the function, or 0 to discard events of the type.
+//!
+//! \return None.
+//
+//*****************************************************************************
+void
+EventHandlerSet(uint32_t ui32Type, tEventHandler pfnHandler)
+{
+    if(ui32Type < EVENT_NUM_TYPES)
+    {
+        g_ppfnEventHandlers[ui32Type] = pfnHandler;
+    }
+}
+
+//*****************************************************************************
+//
+//! Adds a function to be called whenever the event queue is found empty.
+//!
+//! \param pfnHook is the function.
+//!
+//! The hooks are called in the order they were added, on every pass of the
+//! loop that finds nothing to dispatch.
+//!
+//! \return Returns \b false if EVENT_MAX_IDLE_HOOKS hooks are added already.
+//
+//*****************************************************************************
+bool
+EventIdleHookAdd(tEventIdleHook pfnHook)
+{
+    uint32_t ui32Idx;
+
+    for(ui32Idx = 0; ui32Idx < EVENT_MAX_IDLE_HOOKS; ui32Idx++)
+    {
+        if(!g_ppfnEventIdleHooks[ui32Idx])
+        {
+            g_ppfnEventIdleHooks[ui32Idx] = pfnHook;
+            return(true);
+        }
+    }
+
+    return(false);
+}
+
+//*****************************************************************************
+//
+//! Posts an event to be dispatched from the main loop.
+//!
+//! \param ui32Type is one of the EVENT_* types.
+//! \param ui32Param is the parameter of the event.
+//! \param ui32Value is the value of the event.
+//!
+//! This may be called from any context, including interrupt handlers of any
+//! priority.
+//!
+//! \return Returns \b false if the queue is full, in which case the event is
+//! counted as dropped.
+//
+//*****************************************************************************
+bool
+EventPost(uint32_t ui32Type, uint32_t ui32Param, uint32_t ui32Value)
+{
+    tEvent *psEvent;
+    bool bMasked;
+
+    if(ui32Type >= EVENT_NUM_TYPES)
+    {
+        return(false);
+    }
+
+    bMasked = EventIntMask();
+
+    if((g_ui32EventHead - g_ui32EventTail) == EVENT_QUEUE_SIZE)
+    {
+        g_psEventStats[ui32Type].ui32Dropped++;
+        EventIntRestore(bMasked);
+        return(false);
+    }
+
+    psEvent = &g_psEventQueue[g_ui32EventHead & (EVENT_QUEUE_SIZE - 1)];
+    psEvent->ui32Type = ui32Type;
+    psEvent->ui32Param = ui32Param;
+    psEvent->ui32Value = ui32Value;
+    psEvent->ui32Time = EventTimestamp();
+    g_ui32EventHead++;
+
+    EventIntRestore(bMasked);
+
+    return(true);
+}
+
+//*****************************************************************************
+//
+//! Dispatches the oldest event, or calls the idle hooks if there is none.
+//!
+//! This must only be called from the main context.
+//!
+//! \return Returns \b true if an event was dispatched and \b false if the
+//! idle hooks were called.
+//
+//*****************************************************************************
+bool
+EventDispatch(void)
+{
+    tEventStats *psStats;
+    tEvent sEvent;
+    uint32_t ui32Idx, ui32Latency;
+
+    if(g_ui32EventTail == g_ui32EventHead)
+    {
+        for(ui32Idx = 0; ui32Idx < EVENT_MAX_IDLE_HOOKS; ui32Idx++)
+        {
+            if(g_ppfnEventIdleHooks[ui32Idx])
+            {
+                g_ppfnEventIdleHooks[ui32Idx]();
+            }
+        }
+
+        return(false);
+    }
+
+    //
+    // Copy the event out so that its slot can be reused while the handler
+    // runs.
+    //
+    sEvent = g_psEventQueue[g_ui32EventTail & (EVENT_QUEUE_SIZE - 1)];
+    g_ui32EventTail++;
+
+    //
+    // The timer can post again from here on, even while its handler runs.
+    //
+    if((sEvent.ui32Type == EVENT_TIMER) &&
+       (sEvent.ui32Param < EVENT_MAX_TIMERS))
+    {
+        g_psEventTimers[sEvent.ui32Param].bQueued = false;
+    }
+
+    ui32Latency = EventTimestamp() - sEvent.ui32Time;
+    psStats = &g_psEventStats[sEvent.ui32Type];
+    psStats->ui32Count++;
+    psStats->ui64TotalLatency += ui32Latency;
+    if(ui32Latency > psStats->ui32MaxLatency)
+    {
+        psStats->ui32MaxLatency = ui32Latency;
+    }
+
+    if(g_ppfnEventHandlers[sEvent.ui32Type])
+    {
+        g_ppfnEventHandlers[sEvent.ui32Type](&sEvent);
+    }
+
+    return(true);
+}
+
+//*****************************************************************************
+//
+//! Returns whether any event is waiting to be dispatched.
+//!
+//! An idle hook that stops the processor calls this with interrupts masked,
+//! so that an event posted just before it stops is not left waiting.
+//!
+//! \return Returns \b true if the queue is not empty.
+//
+//*****************************************************************************
+bool
+EventIsPending(void)
+{
+    return(g_ui32EventTail != g_ui32EventHead);
+}
+
+//*****************************************************************************
+//
+//! Runs the event loop.
+//!
+//! \return This function does not return.
+//
+//*****************************************************************************
+void
+EventLoop(void)
+{
+    while(1)
+    {
+        EventDispatch();
+    }
+}
+
+//*****************************************************************************
+//
+//! Advances the software timers by one tick.
+//!
+//! This must be called EVENT_TICKS_PER_SECOND times a second, normally from
+//! a timer interrupt.  Every timer that expires posts an EVENT_TIMER event,
+//! unless its last one has not been dispatched yet.
+//!
+//! \return None.
+//
+//*****************************************************************************
+void
+EventTick(void)
+{
+    tEventTimer *psTimer;
+    uint32_t ui32Timer;
+
+    for(ui32Timer = 0; ui32Timer < EVENT_MAX_TIMERS; ui32Timer++)
+    {
+        psTimer = &g_psEventTimers[ui32Timer];
+        if(psTimer->ui32Left && !--psTimer->ui32Left)
+        {
+            psTimer->ui32Left = psTimer->ui32Period;
+            if(!psTimer->bQueued && EventPost(EVENT_TIMER, ui32Timer, 0))
+            {
+                psTimer->bQueued = true;
+            }
+        }
+    }
+}
+
+//*****************************************************************************
+//
+//! Starts a software timer.
+//!
+//! \param ui32Timer is the number of the timer, less than EVENT_MAX_TIMERS.
+//! \param ui32Ticks is the number of ticks until the timer expires.
+//! \param bPeriodic is \b true to restart the timer each time it expires.
+//!
+//! A timer that is running already is restarted.
+//!
+//! \return None.
+//
+//*****************************************************************************
+void
+EventTimerStart(uint32_t ui32Timer, uint32_t ui32Ticks, bool bPeriodic)
+{
+    bool bMasked;
+
+    if((ui32Timer >= EVENT_MAX_TIMERS) || !ui32Ticks)
+    {
+        return;
+    }
+
+    bMasked = EventIntMask();
+    g_psEventTimers[ui32Timer].ui32Left = ui32Ticks;
+    g_psEventTimers[ui32Timer].ui32Period = bPeriodic ? ui32Ticks : 0;
+    EventIntRestore(bMasked);
+}
+
+//*****************************************************************************
+//
+//! Stops a software timer.
+//!
+//! \param ui32Timer is the number of the timer.
+//!
+//! An expiry that has already been posted is still dispatched.
+//!
+//! \return None.
+//
+//*****************************************************************************
+void
+EventTimerStop(uint32_t ui32Timer)
+{
+    bool bMasked;
+
+    if(ui32Timer < EVENT_MAX_TIMERS)
+    {
+        bMasked = EventIntMask();
+        g_psEventTimers[ui32Timer].ui32Left = 0;
+        g_psEventTimers[ui32Timer].ui32Period = 0;
+        EventIntRestore(bMasked);
+    }
+}
+
+//*****************************************************************************
+//
+//! Returns the dispatch statistics of an event type.
+//!
+//! \param ui32Type is one of the EVENT_* types.
+//! \param psStats is a pointer to the structure that is filled in.
+//!
+//! \return None.
+//
+//*****************************************************************************
+void
+EventStatsGet(uint32_t ui32Type, tEventStats *psStats)
+{
+    bool bMasked;
+
+    if(ui32Type >= EVENT_NUM_TYPES)
+    {
+        memset(psStats, 0, sizeof(*psStats));
+        return;
+    }
+
+    bMasked = EventIntMask();
+    *psStats = g_psEventStats[ui32Type];
+    EventIntRestore(bMasked);
+}
+
+//*****************************************************************************
+//
+//! Clears the dispatch statistics of every event type.
+//!
+//! \return None.
+//
+//*****************************************************************************
+void
+EventStatsReset(void)
+{
+    bool bMasked;
+
+    bMasked = EventIntMask();
+    memset(g_psEventStats, 0, sizeof(g_psEventStats));
+    EventIntRestore(bMasked);
+}
@@ -0,0 +1,123 @@
+//*****************************************************************************
+//
+// event.h - Prototypes for the event loop.
+//
+//*****************************************************************************
+
+#ifndef __EVENT_H__
+#define __EVENT_H__
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+//*****************************************************************************
+//
+// The event types.  Interrupt handlers post EVENT_CONSOLE with a byte typed on
+// the console in ui32Value, EVENT_SENSOR with the FP_EVENT_* type of a
+// decoded response in ui32Param and its value in ui32Value, EVENT_TIMER
+// with the number of the timer that expired in ui32Param, EVENT_FRAME
+// when a frame from the host has been received, and EVENT_READER with the
+// number of a further sensor that has sent data in ui32Param.
+//
+//*****************************************************************************
+#define EVENT_CONSOLE           0
+#define EVENT_SENSOR            1
+#define EVENT_TIMER             2
+#define EVENT_FRAME             3
+#define EVENT_READER            4
+#define EVENT_NUM_TYPES         8
+
+//*****************************************************************************
+//
+// The number of events that can wait to be dispatched, which must be a power
+// of two, the number of software timers and the number of idle hooks.
+//
+//*****************************************************************************
+#define EVENT_QUEUE_SIZE        32
+#define EVENT_MAX_TIMERS        8
+#define EVENT_MAX_IDLE_HOOKS    4
+
+//*****************************************************************************
+//
+// The rate EventTick() must be called at.
+//
+//*****************************************************************************
+#define EVENT_TICKS_PER_SECOND  1000
+
+//*****************************************************************************
+//
+// An event.  ui32Time is the cycle count when it was posted.
+//
+//*****************************************************************************
+typedef struct
+{
+    uint32_t ui32Type;
+    uint32_t ui32Param;
+    uint32_t ui32Value;
+    uint32_t ui32Time;
+}
+tEvent;
+
+//*****************************************************************************
+//
+// The function an event type is dispatched to, and a function called each
+// time the loop finds the queue empty.  Both run in the main context and run
+// to completion; nothing else is dispatched until they return.
+//
+//*****************************************************************************
+typedef void (*tEventHandler)(const tEvent *psEvent);
+typedef void (*tEventIdleHook)(void);
+
+//*****************************************************************************
+//
+// Statistics kept for each event type.  Latencies are in system clock cycles
+// from the post of an event to the call of its handler.
+//
+//*****************************************************************************
+typedef struct
+{
+    //
+    // The number of events dispatched.
+    //
+    uint32_t ui32Count;
+
+    //
+    // The number of events lost because the queue was full.
+    //
+    uint32_t ui32Dropped;
+
+    //
+    // The longest and the total dispatch latency.
+    //
+    uint32_t ui32MaxLatency;
+    uint64_t ui64TotalLatency;
+}
+tEventStats;
+
+//*****************************************************************************
+//
+// Prototypes for the APIs.
+//
+//*****************************************************************************
+extern void EventInit(void);
+extern void EventHandlerSet(uint32_t ui32Type, tEventHandler pfnHandler);
+extern bool EventIdleHookAdd(tEventIdleHook pfnHook);
+extern bool EventPost(uint32_t ui32Type, uint32_t ui32Param,
+                      uint32_t ui32Value);
+extern bool EventDispatch(void);
+extern bool EventIsPending(void);
+extern void EventLoop(void);
+extern void EventTick(void);
+extern void EventTimerStart(uint32_t ui32Timer, uint32_t ui32Ticks,
+                            bool bPeriodic);
+extern void EventTimerStop(uint32_t ui32Timer);
+extern void EventStatsGet(uint32_t ui32Type, tEventStats *psStats);
+extern void EventStatsReset(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __EVENT_H__
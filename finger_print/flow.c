@@ -0,0 +1,234 @@
+//*****************************************************************************
+//
+// flow.c - Stackless protocol flows.
+//
+// Most sensor operations are more than one command and one answer: a
+// registration is acknowledged, then guides the user through three touches
+// and only then reports FINISHED or FAIL.  A flow lets such an exchange be
+// written as straight line code that waits for sensor events and timeouts.
+//
+// Flows are protothreads.  A flow function keeps the line it stopped at in
+// its tFlow, and a switch on that line at the top of the function jumps back
+// to it on the next call.  A waiting flow therefore costs a few words, not a
+// stack, and any number of flows up to FLOW_MAX_FLOWS can wait at once.
+//
+// Flows run from the event loop.  Every sensor response is passed to every
+// running flow through FlowSensorEvent(), and FlowTick() counts down their
+// timeouts.
+//
+//*****************************************************************************
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "flow.h"
+
+//*****************************************************************************
+//
+// The running flows.
+//
+//*****************************************************************************
+static tFlow *g_ppsFlows[FLOW_MAX_FLOWS];
+
+//*****************************************************************************
+//
+// Wakes a flow with an event and forgets it once it has finished.
+//
+//*****************************************************************************
+static void
+FlowResume(uint32_t ui32Idx, uint32_t ui32Event, uint32_t ui32Value)
+{
+    tFlow *psFlow;
+
+    psFlow = g_ppsFlows[ui32Idx];
+    psFlow->ui32Event = ui32Event;
+    psFlow->ui32Value = ui32Value;
+    psFlow->ui32Timeout = 0;
+
+    if(psFlow->pfnFlow(psFlow) == FLOW_DONE)
+    {
+        //
+        // The flow may have been stopped and its slot reused while it ran.
+        //
+        if(g_ppsFlows[ui32Idx] == psFlow)
+        {
+            g_ppsFlows[ui32Idx] = 0;
+        }
+    }
+}
+
+//*****************************************************************************
+//
+//! Stops every flow.
+//!
+//! \return None.
+//
+//*****************************************************************************
+void
+FlowInit(void)
+{
+    uint32_t ui32Idx;
+
+    for(ui32Idx = 0; ui32Idx < FLOW_MAX_FLOWS; ui32Idx++)
+    {
+        g_ppsFlows[ui32Idx] = 0;
+    }
+}
+
+//*****************************************************************************
+//
+//! Starts a flow.
+//!
+//! \param psFlow is the flow.  It is referenced, not copied, so it must stay
+//! valid until the flow has finished.
+//! \param pfnFlow is the flow function.
+//! \param pvData is the data of the flow, which it finds in psFlow->pvData.
+//!
+//! The flow function is called straight away with FLOW_EVENT_NONE and runs up
+//! to its first wait.  This must only be called from the event loop.
+//!
+//! \return Returns \b false if the flow is running already or FLOW_MAX_FLOWS
+//! flows are running.
+//
+//*****************************************************************************
+bool
+FlowStart(tFlow *psFlow, tFlowFunc pfnFlow, void *pvData)
+{
+    uint32_t ui32Idx, ui32Free;
+
+    ui32Free = FLOW_MAX_FLOWS;
+    for(ui32Idx = 0; ui32Idx < FLOW_MAX_FLOWS; ui32Idx++)
+    {
+        if(g_ppsFlows[ui32Idx] == psFlow)
+        {
+            return(false);
+        }
+        if(!g_ppsFlows[ui32Idx] && (ui32Free == FLOW_MAX_FLOWS))
+        {
+            ui32Free = ui32Idx;
+        }
+    }
+
+    if(ui32Free == FLOW_MAX_FLOWS)
+    {
+        return(false);
+    }
+
+    psFlow->ui16Line = 0;
+    psFlow->pfnFlow = pfnFlow;
+    psFlow->pvData = pvData;
+    g_ppsFlows[ui32Free] = psFlow;
+
+    FlowResume(ui32Free, FLOW_EVENT_NONE, 0);
+
+    return(true);
+}
+
+//*****************************************************************************
+//
+//! Stops a flow wherever it is waiting.
+//!
+//! \param psFlow is the flow.
+//!
+//! \return None.
+//
+//*****************************************************************************
+void
+FlowStop(tFlow *psFlow)
+{
+    uint32_t ui32Idx;
+
+    for(ui32Idx = 0; ui32Idx < FLOW_MAX_FLOWS; ui32Idx++)
+    {
+        if(g_ppsFlows[ui32Idx] == psFlow)
+        {
+            g_ppsFlows[ui32Idx] = 0;
+        }
+    }
+}
+
+//*****************************************************************************
+//
+//! Returns whether a flow is running.
+//!
+//! \param psFlow is the flow.
+//!
+//! \return Returns \b true from the start of the flow until it finishes or
+//! is stopped.
+//
+//*****************************************************************************
+bool
+FlowIsRunning(const tFlow *psFlow)
+{
+    uint32_t ui32Idx;
+
+    for(ui32Idx = 0; ui32Idx < FLOW_MAX_FLOWS; ui32Idx++)
+    {
+        if(g_ppsFlows[ui32Idx] == psFlow)
+        {
+            return(true);
+        }
+    }
+
+    return(false);
+}
+
+//*****************************************************************************
+//
+//! Passes a sensor response to every running flow.
+//!
+//! \param ui32Event is the FP_EVENT_* type of the response.
+//! \param ui32Value is its value.
+//!
+//! This must only be called from the event loop.
+//!
+//! \return None.
+//
+//*****************************************************************************
+void
+FlowSensorEvent(uint32_t ui32Event, uint32_t ui32Value)
+{
+    uint32_t ui32Idx;
+
+    for(ui32Idx = 0; ui32Idx < FLOW_MAX_FLOWS; ui32Idx++)
+    {
+        if(g_ppsFlows[ui32Idx])
+        {
+            FlowResume(ui32Idx, ui32Event, ui32Value);
+        }
+    }
+}
+
+//*****************************************************************************
+//
+//! Counts down the timeouts of the running flows.
+//!
+//! This must be called every FLOW_TICK_MS milliseconds from the event loop.
+//! A flow whose wait times out is woken with FLOW_EVENT_TIMEOUT.
+//!
+//! \return None.
+//
+//*****************************************************************************
+void
+FlowTick(void)
+{
+    uint32_t ui32Idx;
+    tFlow *psFlow;
+
+    for(ui32Idx = 0; ui32Idx < FLOW_MAX_FLOWS; ui32Idx++)
+    {
+        psFlow = g_ppsFlows[ui32Idx];
+        if(!psFlow || !psFlow->ui32Timeout)
+        {
+            continue;
+        }
+
+        if(psFlow->ui32Timeout > FLOW_TICK_MS)
+        {
+            psFlow->ui32Timeout -= FLOW_TICK_MS;
+        }
+        else
+        {
+            FlowResume(ui32Idx, FLOW_EVENT_TIMEOUT, 0);
+        }
+    }
+}
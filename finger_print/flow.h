@@ -0,0 +1,161 @@
+//*****************************************************************************
+//
+// flow.h - Prototypes and macros for the stackless protocol flows.
+//
+//*****************************************************************************
+
+#ifndef __FLOW_H__
+#define __FLOW_H__
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+//*****************************************************************************
+//
+// The number of flows that can run at once, and the period FlowTick() must be
+// called at in milliseconds.
+//
+//*****************************************************************************
+#define FLOW_MAX_FLOWS          4
+#define FLOW_TICK_MS            10
+
+//*****************************************************************************
+//
+// The values a flow function returns.
+//
+//*****************************************************************************
+#define FLOW_WAITING            0
+#define FLOW_DONE               1
+
+//*****************************************************************************
+//
+// The event a flow is woken with when it is started, and when it waited with
+// FLOW_WAIT_EVENT() for longer than it allowed.  Any other event is one of
+// the FP_EVENT_* types.
+//
+//*****************************************************************************
+#define FLOW_EVENT_NONE         0xFFFFFFFF
+#define FLOW_EVENT_TIMEOUT      0xFFFFFFFE
+
+//*****************************************************************************
+//
+// A flow.  The function is written as straight line code between
+// FLOW_BEGIN() and FLOW_END() and returns to its caller at every wait; the
+// next call resumes it at the line it stopped on.  Local variables are not
+// kept across a wait, so anything a flow needs to remember goes in the
+// structure pvData points to.
+//
+//*****************************************************************************
+typedef struct tFlow tFlow;
+
+typedef uint32_t (*tFlowFunc)(tFlow *psFlow);
+
+struct tFlow
+{
+    //
+    // The line the flow resumes at, or 0 to start from the beginning.
+    //
+    uint16_t ui16Line;
+
+    //
+    // The event the flow was woken with and its value.
+    //
+    uint32_t ui32Event;
+    uint32_t ui32Value;
+
+    //
+    // The milliseconds left before the current wait times out, or 0 if it
+    // does not.
+    //
+    uint32_t ui32Timeout;
+
+    //
+    // The flow function and its data.
+    //
+    tFlowFunc pfnFlow;
+    void *pvData;
+};
+
+//*****************************************************************************
+//
+// Marks the start and the end of the body of a flow function.
+//
+//*****************************************************************************
+#define FLOW_BEGIN(psFlow)                                                    \
+        switch((psFlow)->ui16Line)                                            \
+        {                                                                     \
+        case 0:
+
+#define FLOW_END(psFlow)                                                      \
+        }                                                                     \
+        (psFlow)->ui16Line = 0;                                               \
+        return(FLOW_DONE)
+
+//*****************************************************************************
+//
+// Ends a flow early.
+//
+//*****************************************************************************
+#define FLOW_EXIT(psFlow)                                                     \
+        do                                                                    \
+        {                                                                     \
+            (psFlow)->ui16Line = 0;                                           \
+            return(FLOW_DONE);                                                \
+        }                                                                     \
+        while(0)
+
+//*****************************************************************************
+//
+// Waits until a condition is true.  The condition is checked straight away
+// and then each time the flow is woken.  Only one wait may be written on a
+// source line, and a flow function must not contain a switch statement of
+// its own around a wait.
+//
+//*****************************************************************************
+#define FLOW_WAIT_UNTIL(psFlow, bCondition)                                   \
+        do                                                                    \
+        {                                                                     \
+            (psFlow)->ui16Line = __LINE__;                                    \
+        case __LINE__:                                                        \
+            if(!(bCondition))                                                 \
+            {                                                                 \
+                return(FLOW_WAITING);                                         \
+            }                                                                 \
+        }                                                                     \
+        while(0)
+
+//*****************************************************************************
+//
+// Waits for the next sensor event, or for ui32Ms milliseconds to pass.
+// Afterwards ui32Event holds the event or FLOW_EVENT_TIMEOUT.  A ui32Ms of 0
+// waits for ever.
+//
+//*****************************************************************************
+#define FLOW_WAIT_EVENT(psFlow, ui32Ms)                                       \
+        do                                                                    \
+        {                                                                     \
+            (psFlow)->ui32Timeout = (ui32Ms);                                 \
+            (psFlow)->ui32Event = FLOW_EVENT_NONE;                            \
+            FLOW_WAIT_UNTIL(psFlow, (psFlow)->ui32Event != FLOW_EVENT_NONE);  \
+        }                                                                     \
+        while(0)
+
+//*****************************************************************************
+//
+// Prototypes for the APIs.
+//
+//*****************************************************************************
+extern void FlowInit(void);
+extern bool FlowStart(tFlow *psFlow, tFlowFunc pfnFlow, void *pvData);
+extern void FlowStop(tFlow *psFlow);
+extern bool FlowIsRunning(const tFlow *psFlow);
+extern void FlowSensorEvent(uint32_t ui32Event, uint32_t ui32Value);
+extern void FlowTick(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __FLOW_H__
@@ -0,0 +1,236 @@
+//*****************************************************************************
+//
+// fp_batch.c - Queue of commands run back to back.
+//
+// Host software that provisions a sensor sends many commands in a row, for
+// example clearing every slot and then checking the count.  Sent one at a
+// time, each of them costs a round trip to the host.  Instead they are
+// queued here and each one is sent as soon as the one before it has ended,
+// from the same event that ended it, so the sensor is never left idle and
+// nothing else can slip in between them.
+//
+// The commands go through fp_request.c like any other, so they get its
+// deadlines and retries.  The event loop passes the end of every command to
+// FpBatchRequestEnded(), which reports those that came from the queue.
+//
+//*****************************************************************************
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include "fp_command.h"
+#include "fp_request.h"
+#include "fp_batch.h"
+
+//*****************************************************************************
+//
+// A queued command.
+//
+//*****************************************************************************
+typedef struct
+{
+    uint32_t ui32Tag;
+    uint8_t ui8Cmd;
+    uint8_t ui8ArgLen;
+    uint8_t pui8Arg[FP_BATCH_ARG_SIZE];
+}
+tFpBatchEntry;
+
+//*****************************************************************************
+//
+// The queue.  Commands are added at the head and run from the tail; both
+// count freely.  The command at the tail stays queued while it runs.
+//
+//*****************************************************************************
+static tFpBatchEntry g_psFpBatch[FP_BATCH_SIZE];
+static uint32_t g_ui32FpBatchHead;
+static uint32_t g_ui32FpBatchTail;
+static bool g_bFpBatchRunning;
+static tFpBatchCallback g_pfnFpBatchCallback;
+
+//*****************************************************************************
+//
+// The frame of the command being sent.  It is not on the stack because the
+// queue runs from deep inside the event handlers.
+//
+//*****************************************************************************
+static uint8_t g_pui8FpBatchFrame[FP_COMMAND_BUF_SIZE];
+
+//*****************************************************************************
+//
+// Reports the end of the command at the tail and removes it.
+//
+//*****************************************************************************
+static void
+FpBatchDone(uint32_t ui32Result)
+{
+    tFpBatchEntry *psEntry;
+
+    psEntry = &g_psFpBatch[g_ui32FpBatchTail % FP_BATCH_SIZE];
+    g_ui32FpBatchTail++;
+
+    if(g_pfnFpBatchCallback)
+    {
+        g_pfnFpBatchCallback(psEntry->ui32Tag, psEntry->ui8Cmd,
+                             psEntry->pui8Arg, psEntry->ui8ArgLen,
+                             ui32Result);
+    }
+}
+
+//*****************************************************************************
+//
+//! Empties the queue and sets the function told when a command ends.
+//!
+//! \param pfnCallback is the function.  It is called from the event loop.
+//!
+//! \return None.
+//
+//*****************************************************************************
+void
+FpBatchInit(tFpBatchCallback pfnCallback)
+{
+    g_pfnFpBatchCallback = pfnCallback;
+    g_ui32FpBatchHead = 0;
+    g_ui32FpBatchTail = 0;
+    g_bFpBatchRunning = false;
+}
+
+//*****************************************************************************
+//
+//! Queues a command.
+//!
+//! \param ui32Tag is a value passed back when the command ends.
+//! \param ui32Cmd is one of the FP_CMD_* values.
+//! \param pui8Arg is the argument, as FpCommandEncodeArg() takes it.
+//! \param ui32ArgLen is the length of the argument.
+//!
+//! FpBatchRun() must be called to start the queue.
+//!
+//! \return Returns \b false if the queue is full or the argument is too
+//! long.
+//
+//*****************************************************************************
+bool
+FpBatchAdd(uint32_t ui32Tag, uint32_t ui32Cmd, const uint8_t *pui8Arg,
+           uint32_t ui32ArgLen)
+{
+    tFpBatchEntry *psEntry;
+
+    if(!FpBatchSpaceAvail() || (ui32Cmd >= FP_CMD_COUNT) ||
+       (ui32ArgLen > FP_BATCH_ARG_SIZE))
+    {
+        return(false);
+    }
+
+    psEntry = &g_psFpBatch[g_ui32FpBatchHead % FP_BATCH_SIZE];
+    psEntry->ui32Tag = ui32Tag;
+    psEntry->ui8Cmd = ui32Cmd;
+    psEntry->ui8ArgLen = ui32ArgLen;
+    memcpy(psEntry->pui8Arg, pui8Arg, ui32ArgLen);
+    g_ui32FpBatchHead++;
+
+    return(true);
+}
+
+//*****************************************************************************
+//
+//! Returns the number of commands that can still be queued.
+//!
+//! \return Returns the number of free entries.
+//
+//*****************************************************************************
+uint32_t
+FpBatchSpaceAvail(void)
+{
+    return(FP_BATCH_SIZE - (g_ui32FpBatchHead - g_ui32FpBatchTail));
+}
+
+//*****************************************************************************
+//
+//! Returns whether any command is queued or running.
+//!
+//! \return Returns \b true until the queue is empty.
+//
+//*****************************************************************************
+bool
+FpBatchIsBusy(void)
+{
+    return(g_ui32FpBatchHead != g_ui32FpBatchTail);
+}
+
+//*****************************************************************************
+//
+//! Sends the next queued command if the sensor is free.
+//!
+//! This is called after commands are queued, and from the request timer in
+//! case the sensor was busy with something else then.
+//!
+//! \return None.
+//
+//*****************************************************************************
+void
+FpBatchRun(void)
+{
+    tFpBatchEntry *psEntry;
+    uint32_t ui32Len;
+
+    while(!g_bFpBatchRunning && FpBatchIsBusy() && !FpRequestIsBusy())
+    {
+        psEntry = &g_psFpBatch[g_ui32FpBatchTail % FP_BATCH_SIZE];
+        ui32Len = FpCommandEncodeArg(psEntry->ui8Cmd, psEntry->pui8Arg,
+                                     psEntry->ui8ArgLen, g_pui8FpBatchFrame,
+                                     sizeof(g_pui8FpBatchFrame));
+        if(!ui32Len)
+        {
+            FpBatchDone(FP_BATCH_RESULT_INVALID);
+            continue;
+        }
+
+        if(!FpRequestSend(psEntry->ui8Cmd, g_pui8FpBatchFrame, ui32Len))
+        {
+            break;
+        }
+        g_bFpBatchRunning = true;
+    }
+}
+
+//*****************************************************************************
+//
+//! Takes the end of a command and sends the next queued one.
+//!
+//! \param ui32Cmd is the command that ended.
+//! \param ui32Result is one of FP_REQUEST_RESULT_*.
+//!
+//! This is called with the end of every command.
+//!
+//! \return Returns \b true if the command came from the queue; it has been
+//! reported to the callback.
+//
+//*****************************************************************************
+bool
+FpBatchRequestEnded(uint32_t ui32Cmd, uint32_t ui32Result)
+{
+    if(!g_bFpBatchRunning)
+    {
+        return(false);
+    }
+
+    g_bFpBatchRunning = false;
+    FpBatchDone(ui32Result);
+    FpBatchRun();
+
+    return(true);
+}
+
+//*****************************************************************************
+//
+//! Drops the queued commands.  One already sent still ends and is reported.
+//!
+//! \return None.
+//
+//*****************************************************************************
+void
+FpBatchCancel(void)
+{
+    g_ui32FpBatchHead = g_ui32FpBatchTail + (g_bFpBatchRunning ? 1 : 0);
+}
@@ -0,0 +1,55 @@
+//*****************************************************************************
+//
+// fp_batch.h - Prototypes for the queue of commands run back to back.
+//
+//*****************************************************************************
+
+#ifndef __FP_BATCH_H__
+#define __FP_BATCH_H__
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+//*****************************************************************************
+//
+// The number of commands that can be queued, and the longest argument one
+// can carry, in the form FpCommandEncodeArg() takes.
+//
+//*****************************************************************************
+#define FP_BATCH_SIZE           32
+#define FP_BATCH_ARG_SIZE       20
+
+//*****************************************************************************
+//
+// The function called when a queued command ends.  ui32Tag is the value it
+// was queued with and ui32Result is one of FP_REQUEST_RESULT_*, or
+// FP_BATCH_RESULT_INVALID if the command could not be encoded.
+//
+//*****************************************************************************
+#define FP_BATCH_RESULT_INVALID 0xFF
+
+typedef void (*tFpBatchCallback)(uint32_t ui32Tag, uint32_t ui32Cmd,
+                                 const uint8_t *pui8Arg, uint32_t ui32ArgLen,
+                                 uint32_t ui32Result);
+
+//*****************************************************************************
+//
+// Prototypes for the APIs.
+//
+//*****************************************************************************
+extern void FpBatchInit(tFpBatchCallback pfnCallback);
+extern bool FpBatchAdd(uint32_t ui32Tag, uint32_t ui32Cmd,
+                       const uint8_t *pui8Arg, uint32_t ui32ArgLen);
+extern uint32_t FpBatchSpaceAvail(void);
+extern bool FpBatchIsBusy(void);
+extern void FpBatchRun(void);
+extern bool FpBatchRequestEnded(uint32_t ui32Cmd, uint32_t ui32Result);
+extern void FpBatchCancel(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __FP_BATCH_H__
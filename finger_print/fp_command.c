@@ -0,0 +1,321 @@
+//*****************************************************************************
+//
+// fp_command.c - Encoder for Fingerprint 2 Click command frames.
+//
+// Every command is sent as "<C>name</C>", "<C>name=argument</C>" or, for
+// GetUnlockGPIO, "<C>name(argument)</C>".  The names live in a single table
+// whose lengths are taken with sizeof at compile time, so a frame is built
+// with a few copies and no strlen of the command text.
+//
+//*****************************************************************************
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include "inc/hw_types.h"
+#include "bench.h"
+#include "fp_command.h"
+#include "probe.h"
+
+//*****************************************************************************
+//
+// The kinds of argument a command takes.
+//
+//*****************************************************************************
+#define FP_ARG_NONE             0   // name
+#define FP_ARG_NUM              1   // name=decimal
+#define FP_ARG_TEXT             2   // name=text
+#define FP_ARG_PAREN            3   // name(text)
+
+//*****************************************************************************
+//
+// The frame delimiters.
+//
+//*****************************************************************************
+#define FP_FRAME_OPEN           "<C>"
+#define FP_FRAME_CLOSE          "</C>"
+#define FP_FRAME_OPEN_LEN       (sizeof(FP_FRAME_OPEN) - 1)
+#define FP_FRAME_CLOSE_LEN      (sizeof(FP_FRAME_CLOSE) - 1)
+
+//*****************************************************************************
+//
+// A command table entry: the command name including any '=' or '(' that
+// introduces the argument, its length and the kind of argument.
+//
+//*****************************************************************************
+typedef struct
+{
+    const char *pcName;
+    uint8_t ui8Len;
+    uint8_t ui8Arg;
+}
+tFpCommand;
+
+#define FP_COMMAND(pcName, ui8Arg)                                            \
+        { pcName, sizeof(pcName) - 1, ui8Arg }
+
+//*****************************************************************************
+//
+// The command table, indexed by FP_CMD_*.
+//
+//*****************************************************************************
+static const tFpCommand g_psFpCommands[FP_CMD_COUNT] =
+{
+    FP_COMMAND("RegisterFingerprint", FP_ARG_NONE),
+    FP_COMMAND("RegisterOneFp=", FP_ARG_NUM),
+    FP_COMMAND("CompareFingerprint", FP_ARG_NONE),
+    FP_COMMAND("FpImageInformation", FP_ARG_NONE),
+    FP_COMMAND("ScanFpImage", FP_ARG_NONE),
+    FP_COMMAND("CheckRegisteredNo", FP_ARG_NONE),
+    FP_COMMAND("Baudrate=", FP_ARG_NUM),
+    FP_COMMAND("GetFWVer", FP_ARG_NONE),
+    FP_COMMAND("ClearRegisteredFp", FP_ARG_NONE),
+    FP_COMMAND("ClearOneFp=", FP_ARG_NUM),
+    FP_COMMAND("GetDS", FP_ARG_NONE),
+    FP_COMMAND("GetSuccStr", FP_ARG_NONE),
+    FP_COMMAND("GetFailStr", FP_ARG_NONE),
+    FP_COMMAND("SetSuccStr=", FP_ARG_TEXT),
+    FP_COMMAND("SetFailStr=", FP_ARG_TEXT),
+    FP_COMMAND("UnlockCompareFp", FP_ARG_NONE),
+    FP_COMMAND("UnlockComparePWD=", FP_ARG_TEXT),
+    FP_COMMAND("GetPWD", FP_ARG_NONE),
+    FP_COMMAND("SetPWD=", FP_ARG_TEXT),
+    FP_COMMAND("ClearPWD", FP_ARG_NONE),
+    FP_COMMAND("LockDevice", FP_ARG_NONE),
+    FP_COMMAND("SearchKeyByID=", FP_ARG_TEXT),
+    FP_COMMAND("SetKey=", FP_ARG_TEXT),
+    FP_COMMAND("DeleteCurrentKey", FP_ARG_NONE),
+    FP_COMMAND("DeleteKeyByID=", FP_ARG_TEXT),
+    FP_COMMAND("DeleteAllKey", FP_ARG_NONE),
+    FP_COMMAND("ListAllKey", FP_ARG_NONE),
+    FP_COMMAND("UnlockTimeout=", FP_ARG_NUM),
+    FP_COMMAND("GetUnlockTimeout", FP_ARG_NONE),
+    FP_COMMAND("SetUnlockGPIO=", FP_ARG_TEXT),
+    FP_COMMAND("GetUnlockGPIO(", FP_ARG_PAREN),
+    FP_COMMAND("EnableSysMsg", FP_ARG_NONE),
+    FP_COMMAND("DisableSysMsg", FP_ARG_NONE),
+    FP_COMMAND("EnableErrRegFpInAuto", FP_ARG_NONE),
+    FP_COMMAND("DisableErrRegFpInAuto", FP_ARG_NONE),
+    FP_COMMAND("SetCommCh=", FP_ARG_TEXT)
+};
+
+//*****************************************************************************
+//
+// Builds a frame.  Returns the frame length, or 0 if the command is unknown,
+// takes a different kind of argument, or the frame does not fit.
+//
+//*****************************************************************************
+static uint32_t
+FpCommandBuild(uint32_t ui32Cmd, uint32_t ui32Arg, const char *pcArg,
+               uint32_t ui32ArgLen, uint8_t *pui8Buf, uint32_t ui32Size)
+{
+    const tFpCommand *psCmd;
+    uint32_t ui32Len, ui32Tail;
+
+    if(ui32Cmd >= FP_CMD_COUNT)
+    {
+        return(0);
+    }
+
+    psCmd = &g_psFpCommands[ui32Cmd];
+    if((psCmd->ui8Arg != ui32Arg) &&
+       !((psCmd->ui8Arg == FP_ARG_PAREN) && (ui32Arg == FP_ARG_TEXT)))
+    {
+        return(0);
+    }
+
+    ui32Tail = (psCmd->ui8Arg == FP_ARG_PAREN) ? 1 : 0;
+    ui32Len = FP_FRAME_OPEN_LEN + psCmd->ui8Len + ui32ArgLen + ui32Tail +
+              FP_FRAME_CLOSE_LEN;
+    if(ui32Len > ui32Size)
+    {
+        return(0);
+    }
+
+    memcpy(pui8Buf, FP_FRAME_OPEN, FP_FRAME_OPEN_LEN);
+    pui8Buf += FP_FRAME_OPEN_LEN;
+    memcpy(pui8Buf, psCmd->pcName, psCmd->ui8Len);
+    pui8Buf += psCmd->ui8Len;
+    memcpy(pui8Buf, pcArg, ui32ArgLen);
+    pui8Buf += ui32ArgLen;
+    if(ui32Tail)
+    {
+        *pui8Buf++ = ')';
+    }
+    memcpy(pui8Buf, FP_FRAME_CLOSE, FP_FRAME_CLOSE_LEN);
+
+    return(ui32Len);
+}
+
+//*****************************************************************************
+//
+//! Encodes a command that takes no argument.
+//!
+//! \param ui32Cmd is one of the FP_CMD_* values.
+//! \param pui8Buf is the buffer that receives the frame.
+//! \param ui32Size is the size of the buffer.
+//!
+//! \return Returns the length of the frame, or 0 if \e ui32Cmd is unknown,
+//! requires an argument, or the frame does not fit in the buffer.
+//
+//*****************************************************************************
+uint32_t
+FpCommandEncode(uint32_t ui32Cmd, uint8_t *pui8Buf, uint32_t ui32Size)
+{
+    uint32_t ui32Start, ui32Len;
+
+    ui32Start = ProbeStart();
+    ui32Len = FpCommandBuild(ui32Cmd, FP_ARG_NONE, 0, 0, pui8Buf, ui32Size);
+    ProbeRecord(PROBE_ENCODE, ui32Start);
+
+    return(ui32Len);
+}
+
+//*****************************************************************************
+//
+//! Encodes a command that takes a decimal argument.
+//!
+//! \param ui32Cmd is one of FP_CMD_REGISTER_ONE_FP, FP_CMD_CLEAR_ONE_FP,
+//! FP_CMD_BAUDRATE or FP_CMD_UNLOCK_TIMEOUT.
+//! \param ui32Value is the argument.
+//! \param pui8Buf is the buffer that receives the frame.
+//! \param ui32Size is the size of the buffer.
+//!
+//! \return Returns the length of the frame, or 0 if \e ui32Cmd is unknown,
+//! does not take a number, or the frame does not fit in the buffer.
+//
+//*****************************************************************************
+uint32_t
+FpCommandEncodeNum(uint32_t ui32Cmd, uint32_t ui32Value, uint8_t *pui8Buf,
+                   uint32_t ui32Size)
+{
+    char pcDigits[10];
+    uint32_t ui32Pos, ui32Start, ui32Len;
+
+    ui32Start = ProbeStart();
+
+    //
+    // Convert the value from the least significant digit backwards.
+    //
+    ui32Pos = sizeof(pcDigits);
+    do
+    {
+        pcDigits[--ui32Pos] = '0' + (ui32Value % 10);
+        ui32Value /= 10;
+    }
+    while(ui32Value);
+
+    ui32Len = FpCommandBuild(ui32Cmd, FP_ARG_NUM, pcDigits + ui32Pos,
+                             sizeof(pcDigits) - ui32Pos, pui8Buf, ui32Size);
+    ProbeRecord(PROBE_ENCODE, ui32Start);
+
+    return(ui32Len);
+}
+
+//*****************************************************************************
+//
+//! Encodes a command that takes a text argument.
+//!
+//! \param ui32Cmd is one of the FP_CMD_* values that take text, such as
+//! FP_CMD_SET_KEY, FP_CMD_SEARCH_KEY_BY_ID or FP_CMD_GET_UNLOCK_GPIO.
+//! \param pcText is the argument text.
+//! \param ui32TextLen is the length of the text.
+//! \param pui8Buf is the buffer that receives the frame.
+//! \param ui32Size is the size of the buffer.
+//!
+//! \return Returns the length of the frame, or 0 if \e ui32Cmd is unknown,
+//! does not take text, or the frame does not fit in the buffer.
+//
+//*****************************************************************************
+uint32_t
+FpCommandEncodeText(uint32_t ui32Cmd, const char *pcText,
+                    uint32_t ui32TextLen, uint8_t *pui8Buf, uint32_t ui32Size)
+{
+    uint32_t ui32Start, ui32Len;
+
+    ui32Start = ProbeStart();
+    ui32Len = FpCommandBuild(ui32Cmd, FP_ARG_TEXT, pcText, ui32TextLen,
+                             pui8Buf, ui32Size);
+    ProbeRecord(PROBE_ENCODE, ui32Start);
+
+    return(ui32Len);
+}
+
+//*****************************************************************************
+//
+//! Encodes a command with its argument in binary form, as host software
+//! sends it.
+//!
+//! \param ui32Cmd is one of the FP_CMD_* values.
+//! \param pui8Arg is the argument: nothing for a command that takes none,
+//! four bytes holding the number least significant byte first for one that
+//! takes a decimal argument, and the text otherwise.
+//! \param ui32ArgLen is the length of the argument.
+//! \param pui8Buf is the buffer that receives the frame.
+//! \param ui32Size is the size of the buffer.
+//!
+//! \return Returns the length of the frame, or 0 if \e ui32Cmd is unknown,
+//! the argument does not suit it, or the frame does not fit in the buffer.
+//
+//*****************************************************************************
+uint32_t
+FpCommandEncodeArg(uint32_t ui32Cmd, const uint8_t *pui8Arg,
+                   uint32_t ui32ArgLen, uint8_t *pui8Buf, uint32_t ui32Size)
+{
+    if(ui32Cmd >= FP_CMD_COUNT)
+    {
+        return(0);
+    }
+
+    if(g_psFpCommands[ui32Cmd].ui8Arg == FP_ARG_NUM)
+    {
+        if(ui32ArgLen != 4)
+        {
+            return(0);
+        }
+        return(FpCommandEncodeNum(ui32Cmd,
+                                  (pui8Arg[0] | (pui8Arg[1] << 8) |
+                                   (pui8Arg[2] << 16) |
+                                   ((uint32_t)pui8Arg[3] << 24)),
+                                  pui8Buf, ui32Size));
+    }
+
+    if(!ui32ArgLen)
+    {
+        return(FpCommandEncode(ui32Cmd, pui8Buf, ui32Size));
+    }
+
+    return(FpCommandEncodeText(ui32Cmd, (const char *)pui8Arg, ui32ArgLen,
+                               pui8Buf, ui32Size));
+}
+
+//*****************************************************************************
+//
+//! Returns the name of a command.
+//!
+//! \param ui32Cmd is one of the FP_CMD_* values.
+//! \param pui32Len receives the length of the name.
+//!
+//! The name is not terminated and does not include the '=' or '(' that
+//! introduces the argument.
+//!
+//! \return Returns the name, or 0 with a length of 0 if \e ui32Cmd is
+//! unknown.
+//
+//*****************************************************************************
+const char *
+FpCommandName(uint32_t ui32Cmd, uint32_t *pui32Len)
+{
+    const tFpCommand *psCmd;
+
+    if(ui32Cmd >= FP_CMD_COUNT)
+    {
+        *pui32Len = 0;
+        return(0);
+    }
+
+    psCmd = &g_psFpCommands[ui32Cmd];
+    *pui32Len = psCmd->ui8Len - ((psCmd->ui8Arg == FP_ARG_NONE) ? 0 : 1);
+
+    return(psCmd->pcName);
+}
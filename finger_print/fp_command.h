@@ -0,0 +1,99 @@
+//*****************************************************************************
+//
+// fp_command.h - Prototypes for the Fingerprint 2 Click command encoder.
+//
+//*****************************************************************************
+
+#ifndef __FP_COMMAND_H__
+#define __FP_COMMAND_H__
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+//*****************************************************************************
+//
+// The commands of the Fingerprint 2 Click protocol.  The comment shows the
+// argument each one takes, if any.
+//
+//*****************************************************************************
+#define FP_CMD_REGISTER_FINGERPRINT                                           \
+                                0
+#define FP_CMD_REGISTER_ONE_FP  1   // Slot index
+#define FP_CMD_COMPARE_FINGERPRINT                                            \
+                                2
+#define FP_CMD_FP_IMAGE_INFORMATION                                           \
+                                3
+#define FP_CMD_SCAN_FP_IMAGE    4
+#define FP_CMD_CHECK_REGISTERED_NO                                            \
+                                5
+#define FP_CMD_BAUDRATE         6   // Baud rate
+#define FP_CMD_GET_FW_VER       7
+#define FP_CMD_CLEAR_REGISTERED_FP                                            \
+                                8
+#define FP_CMD_CLEAR_ONE_FP     9   // Slot index
+#define FP_CMD_GET_DS           10
+#define FP_CMD_GET_SUCC_STR     11
+#define FP_CMD_GET_FAIL_STR     12
+#define FP_CMD_SET_SUCC_STR     13  // Text
+#define FP_CMD_SET_FAIL_STR     14  // Text
+#define FP_CMD_UNLOCK_COMPARE_FP                                              \
+                                15
+#define FP_CMD_UNLOCK_COMPARE_PWD                                             \
+                                16  // Password
+#define FP_CMD_GET_PWD          17
+#define FP_CMD_SET_PWD          18  // Password
+#define FP_CMD_CLEAR_PWD        19
+#define FP_CMD_LOCK_DEVICE      20
+#define FP_CMD_SEARCH_KEY_BY_ID 21  // ID
+#define FP_CMD_SET_KEY          22  // KEY
+#define FP_CMD_DELETE_CURRENT_KEY                                             \
+                                23
+#define FP_CMD_DELETE_KEY_BY_ID 24  // ID
+#define FP_CMD_DELETE_ALL_KEY   25
+#define FP_CMD_LIST_ALL_KEY     26
+#define FP_CMD_UNLOCK_TIMEOUT   27  // Seconds
+#define FP_CMD_GET_UNLOCK_TIMEOUT                                             \
+                                28
+#define FP_CMD_SET_UNLOCK_GPIO  29  // "p,h,HHHHHHHH"
+#define FP_CMD_GET_UNLOCK_GPIO  30  // "p,h"
+#define FP_CMD_ENABLE_SYS_MSG   31
+#define FP_CMD_DISABLE_SYS_MSG  32
+#define FP_CMD_ENABLE_ERR_REG_FP_IN_AUTO                                      \
+                                33
+#define FP_CMD_DISABLE_ERR_REG_FP_IN_AUTO                                     \
+                                34
+#define FP_CMD_SET_COMM_CH      35  // "UART" or "USB"
+#define FP_CMD_COUNT            36
+
+//*****************************************************************************
+//
+// A buffer of this size holds any command with a numeric argument and any
+// text argument of up to 32 characters.
+//
+//*****************************************************************************
+#define FP_COMMAND_BUF_SIZE     64
+
+//*****************************************************************************
+//
+// Prototypes for the APIs.
+//
+//*****************************************************************************
+extern uint32_t FpCommandEncode(uint32_t ui32Cmd, uint8_t *pui8Buf,
+                                uint32_t ui32Size);
+extern uint32_t FpCommandEncodeNum(uint32_t ui32Cmd, uint32_t ui32Value,
+                                   uint8_t *pui8Buf, uint32_t ui32Size);
+extern uint32_t FpCommandEncodeText(uint32_t ui32Cmd, const char *pcText,
+                                    uint32_t ui32TextLen, uint8_t *pui8Buf,
+                                    uint32_t ui32Size);
+extern uint32_t FpCommandEncodeArg(uint32_t ui32Cmd, const uint8_t *pui8Arg,
+                                   uint32_t ui32ArgLen, uint8_t *pui8Buf,
+                                   uint32_t ui32Size);
+extern const char *FpCommandName(uint32_t ui32Cmd, uint32_t *pui32Len);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __FP_COMMAND_H__
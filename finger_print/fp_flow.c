@@ -0,0 +1,366 @@
+//*****************************************************************************
+//
+// fp_flow.c - Multi-step sensor operations.
+//
+// Registration, compare and KEY storage each take several exchanges with the
+// sensor.  They are written here as flows that send a command, wait for the
+// responses that belong to it and report the outcome once, so that nobody
+// has to follow the raw responses on the console.
+//
+// The sensor works on one command at a time, so only one operation runs at
+// once; the others are refused until it has ended.  Commands are sent through
+// fp_request.c, which times them out; the event loop passes the timeout on to
+// the flows as FLOW_EVENT_TIMEOUT.
+//
+//*****************************************************************************
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include "inc/hw_types.h"
+#include "bench.h"
+#include "fp_command.h"
+#include "fp_parser.h"
+#include "fp_request.h"
+#include "flow.h"
+#include "fp_flow.h"
+#include "probe.h"
+
+//*****************************************************************************
+//
+// What the running operation needs to remember across waits.
+//
+//*****************************************************************************
+typedef struct
+{
+    //
+    // The operation, its slot and the cycle count when it started.
+    //
+    uint32_t ui32Flow;
+    uint32_t ui32Slot;
+    uint32_t ui32Start;
+
+    //
+    // The ID and KEY of FpFlowKeySet(), and their lengths.
+    //
+    char pcID[FP_FLOW_TEXT_SIZE];
+    char pcKey[FP_FLOW_TEXT_SIZE];
+    uint32_t ui32IDLen;
+    uint32_t ui32KeyLen;
+}
+tFpFlowData;
+
+//*****************************************************************************
+//
+// The running operation and the function told when it ends.
+//
+//*****************************************************************************
+static tFlow g_sFpFlow;
+static tFpFlowData g_sFpFlowData;
+static tFpFlowCallback g_pfnFpFlowCallback;
+
+//*****************************************************************************
+//
+// Reports the end of the operation.
+//
+//*****************************************************************************
+static void
+FpFlowDone(tFpFlowData *psData, uint32_t ui32Result)
+{
+    ProbeRecord(PROBE_FLOW_REGISTER + psData->ui32Flow, psData->ui32Start);
+
+    if(g_pfnFpFlowCallback)
+    {
+        g_pfnFpFlowCallback(psData->ui32Flow, ui32Result, psData->ui32Slot);
+    }
+}
+
+//*****************************************************************************
+//
+// Maps the event that ended a wait to a failure result.
+//
+//*****************************************************************************
+static uint32_t
+FpFlowFailure(const tFlow *psFlow)
+{
+    if(psFlow->ui32Event == FLOW_EVENT_TIMEOUT)
+    {
+        return(FP_FLOW_RESULT_TIMEOUT);
+    }
+
+    return((psFlow->ui32Event == FP_EVENT_NG) ? FP_FLOW_RESULT_NG :
+                                                FP_FLOW_RESULT_FAIL);
+}
+
+//*****************************************************************************
+//
+// Registers a fingerprint.  The sensor guides the user through three touches
+// with instruction messages and ends with FINISHED, or FAIL if the touches
+// were not good enough.
+//
+//*****************************************************************************
+static uint32_t
+FpFlowRegisterRun(tFlow *psFlow)
+{
+    tFpFlowData *psData = psFlow->pvData;
+    uint8_t pui8Frame[FP_COMMAND_BUF_SIZE];
+
+    FLOW_BEGIN(psFlow);
+
+    if(!FpRequestSend(FP_CMD_REGISTER_ONE_FP, pui8Frame,
+                      FpCommandEncodeNum(FP_CMD_REGISTER_ONE_FP,
+                                         psData->ui32Slot, pui8Frame,
+                                         sizeof(pui8Frame))))
+    {
+        FpFlowDone(psData, FP_FLOW_RESULT_NG);
+        FLOW_EXIT(psFlow);
+    }
+
+    //
+    // Follow the instructions until the sensor reports the outcome.
+    //
+    do
+    {
+        FLOW_WAIT_EVENT(psFlow, 0);
+    }
+    while((psFlow->ui32Event == FP_EVENT_OK) ||
+          (psFlow->ui32Event == FP_EVENT_TEXT));
+
+    FpFlowDone(psData, (psFlow->ui32Event == FP_EVENT_FINISHED) ?
+                       FP_FLOW_RESULT_OK : FpFlowFailure(psFlow));
+
+    FLOW_END(psFlow);
+}
+
+//*****************************************************************************
+//
+// Compares a fingerprint with the registered ones.  The sensor answers OK,
+// or NG if nothing is registered, then guides the user and ends with PASS_n
+// or FAIL.
+//
+//*****************************************************************************
+static uint32_t
+FpFlowCompareRun(tFlow *psFlow)
+{
+    tFpFlowData *psData = psFlow->pvData;
+    uint8_t pui8Frame[FP_COMMAND_BUF_SIZE];
+
+    FLOW_BEGIN(psFlow);
+
+    if(!FpRequestSend(FP_CMD_COMPARE_FINGERPRINT, pui8Frame,
+                      FpCommandEncode(FP_CMD_COMPARE_FINGERPRINT, pui8Frame,
+                                      sizeof(pui8Frame))))
+    {
+        FpFlowDone(psData, FP_FLOW_RESULT_NG);
+        FLOW_EXIT(psFlow);
+    }
+
+    FLOW_WAIT_EVENT(psFlow, 0);
+    if(psFlow->ui32Event != FP_EVENT_OK)
+    {
+        FpFlowDone(psData, FpFlowFailure(psFlow));
+        FLOW_EXIT(psFlow);
+    }
+
+    do
+    {
+        FLOW_WAIT_EVENT(psFlow, 0);
+    }
+    while(psFlow->ui32Event == FP_EVENT_TEXT);
+
+    if(psFlow->ui32Event == FP_EVENT_PASS)
+    {
+        psData->ui32Slot = psFlow->ui32Value;
+        FpFlowDone(psData, FP_FLOW_RESULT_OK);
+    }
+    else
+    {
+        FpFlowDone(psData, FpFlowFailure(psFlow));
+    }
+
+    FLOW_END(psFlow);
+}
+
+//*****************************************************************************
+//
+// Stores a KEY under an ID.  SetKey stores to the ID named by the last
+// SearchKeyByID, which answers with the KEY stored so far or NG for a new ID.
+//
+//*****************************************************************************
+static uint32_t
+FpFlowKeySetRun(tFlow *psFlow)
+{
+    tFpFlowData *psData = psFlow->pvData;
+    uint8_t pui8Frame[FP_COMMAND_BUF_SIZE];
+
+    FLOW_BEGIN(psFlow);
+
+    if(!FpRequestSend(FP_CMD_SEARCH_KEY_BY_ID, pui8Frame,
+                      FpCommandEncodeText(FP_CMD_SEARCH_KEY_BY_ID,
+                                          psData->pcID, psData->ui32IDLen,
+                                          pui8Frame, sizeof(pui8Frame))))
+    {
+        FpFlowDone(psData, FP_FLOW_RESULT_NG);
+        FLOW_EXIT(psFlow);
+    }
+
+    FLOW_WAIT_EVENT(psFlow, 0);
+    if((psFlow->ui32Event != FP_EVENT_KEY) &&
+       (psFlow->ui32Event != FP_EVENT_NG))
+    {
+        FpFlowDone(psData, FpFlowFailure(psFlow));
+        FLOW_EXIT(psFlow);
+    }
+
+    if(!FpRequestSend(FP_CMD_SET_KEY, pui8Frame,
+                      FpCommandEncodeText(FP_CMD_SET_KEY, psData->pcKey,
+                                          psData->ui32KeyLen, pui8Frame,
+                                          sizeof(pui8Frame))))
+    {
+        FpFlowDone(psData, FP_FLOW_RESULT_NG);
+        FLOW_EXIT(psFlow);
+    }
+
+    FLOW_WAIT_EVENT(psFlow, 0);
+    FpFlowDone(psData, (psFlow->ui32Event == FP_EVENT_OK) ?
+                       FP_FLOW_RESULT_OK : FpFlowFailure(psFlow));
+
+    FLOW_END(psFlow);
+}
+
+//*****************************************************************************
+//
+// Starts an operation unless one is running.
+//
+//*****************************************************************************
+static bool
+FpFlowStart(uint32_t ui32Flow, tFlowFunc pfnFlow)
+{
+    g_sFpFlowData.ui32Flow = ui32Flow;
+    g_sFpFlowData.ui32Start = ProbeStart();
+
+    return(FlowStart(&g_sFpFlow, pfnFlow, &g_sFpFlowData));
+}
+
+//*****************************************************************************
+//
+//! Sets the function told when an operation ends.
+//!
+//! \param pfnCallback is the function, or 0.  It is called from the event
+//! loop.
+//!
+//! \return None.
+//
+//*****************************************************************************
+void
+FpFlowInit(tFpFlowCallback pfnCallback)
+{
+    g_pfnFpFlowCallback = pfnCallback;
+}
+
+//*****************************************************************************
+//
+//! Registers a fingerprint in a slot.
+//!
+//! \param ui32Slot is the slot, which is overwritten.
+//!
+//! \return Returns \b false if another operation is running.
+//
+//*****************************************************************************
+bool
+FpFlowRegister(uint32_t ui32Slot)
+{
+    if(FpFlowIsBusy())
+    {
+        return(false);
+    }
+
+    g_sFpFlowData.ui32Slot = ui32Slot;
+
+    return(FpFlowStart(FP_FLOW_REGISTER, FpFlowRegisterRun));
+}
+
+//*****************************************************************************
+//
+//! Compares a fingerprint with the registered ones.
+//!
+//! On success the callback is given the slot that matched, or
+//! FP_PASS_NO_INDEX if the sensor did not say.
+//!
+//! \return Returns \b false if another operation is running.
+//
+//*****************************************************************************
+bool
+FpFlowCompare(void)
+{
+    if(FpFlowIsBusy())
+    {
+        return(false);
+    }
+
+    g_sFpFlowData.ui32Slot = FP_PASS_NO_INDEX;
+
+    return(FpFlowStart(FP_FLOW_COMPARE, FpFlowCompareRun));
+}
+
+//*****************************************************************************
+//
+//! Stores a KEY under an ID, replacing any KEY stored there.
+//!
+//! \param pcID is the ID.
+//! \param pcKey is the KEY.
+//!
+//! Both strings are copied and may be at most FP_FLOW_TEXT_SIZE characters.
+//!
+//! \return Returns \b false if another operation is running or a string is
+//! too long.
+//
+//*****************************************************************************
+bool
+FpFlowKeySet(const char *pcID, const char *pcKey)
+{
+    uint32_t ui32IDLen, ui32KeyLen;
+
+    ui32IDLen = strlen(pcID);
+    ui32KeyLen = strlen(pcKey);
+    if(FpFlowIsBusy() || (ui32IDLen > FP_FLOW_TEXT_SIZE) ||
+       (ui32KeyLen > FP_FLOW_TEXT_SIZE))
+    {
+        return(false);
+    }
+
+    memcpy(g_sFpFlowData.pcID, pcID, ui32IDLen);
+    memcpy(g_sFpFlowData.pcKey, pcKey, ui32KeyLen);
+    g_sFpFlowData.ui32IDLen = ui32IDLen;
+    g_sFpFlowData.ui32KeyLen = ui32KeyLen;
+    g_sFpFlowData.ui32Slot = 0;
+
+    return(FpFlowStart(FP_FLOW_KEY_SET, FpFlowKeySetRun));
+}
+
+//*****************************************************************************
+//
+//! Returns whether an operation is running.
+//!
+//! \return Returns \b true from the start of an operation until it has ended,
+//! including while its callback runs.
+//
+//*****************************************************************************
+bool
+FpFlowIsBusy(void)
+{
+    return(FlowIsRunning(&g_sFpFlow) || FpRequestIsBusy());
+}
+
+//*****************************************************************************
+//
+//! Abandons the running operation without calling the callback.
+//!
+//! \return None.
+//
+//*****************************************************************************
+void
+FpFlowCancel(void)
+{
+    FlowStop(&g_sFpFlow);
+}
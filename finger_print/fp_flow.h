@@ -0,0 +1,69 @@
+//*****************************************************************************
+//
+// fp_flow.h - Prototypes for the multi-step sensor operations.
+//
+//*****************************************************************************
+
+#ifndef __FP_FLOW_H__
+#define __FP_FLOW_H__
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+//*****************************************************************************
+//
+// The operations.
+//
+//*****************************************************************************
+#define FP_FLOW_REGISTER        0
+#define FP_FLOW_COMPARE         1
+#define FP_FLOW_KEY_SET         2
+
+//*****************************************************************************
+//
+// The results an operation ends with.  FP_FLOW_RESULT_NG is reported when the
+// sensor refuses the command outright, for example a compare with nothing
+// registered, and FP_FLOW_RESULT_TIMEOUT when a command misses the deadline
+// fp_request.c gives it.
+//
+//*****************************************************************************
+#define FP_FLOW_RESULT_OK       0
+#define FP_FLOW_RESULT_FAIL     1
+#define FP_FLOW_RESULT_NG       2
+#define FP_FLOW_RESULT_TIMEOUT  3
+
+//*****************************************************************************
+//
+// The longest ID or KEY accepted by FpFlowKeySet().
+//
+//*****************************************************************************
+#define FP_FLOW_TEXT_SIZE       32
+
+//*****************************************************************************
+//
+// The function called when an operation ends.  ui32Value is the slot that
+// was registered, or the slot a compare matched.
+//
+//*****************************************************************************
+typedef void (*tFpFlowCallback)(uint32_t ui32Flow, uint32_t ui32Result,
+                                uint32_t ui32Value);
+
+//*****************************************************************************
+//
+// Prototypes for the APIs.
+//
+//*****************************************************************************
+extern void FpFlowInit(tFpFlowCallback pfnCallback);
+extern bool FpFlowRegister(uint32_t ui32Slot);
+extern bool FpFlowCompare(void);
+extern bool FpFlowKeySet(const char *pcID, const char *pcKey);
+extern bool FpFlowIsBusy(void);
+extern void FpFlowCancel(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __FP_FLOW_H__
@@ -0,0 +1,376 @@
+//*****************************************************************************
+//
+// fp_link.c - Sensor link speed negotiation.
+//
+// The sensor powers up at the baud rate it was last told to use.  On boot the
+// rate remembered in EEPROM is tried first and confirmed with GetFWVer.  If
+// that fails every rate the sensor supports is probed.  Once the current rate
+// is known and it is not already the fast rate, the sensor is sent
+// Baudrate=115200; it answers OK at the old rate and then resets at the new
+// one, after which UART5 follows and the link is confirmed again.  Whatever
+// rate is finally confirmed is stored back to EEPROM through the
+// configuration store.
+//
+// Responses are recognised through FpLinkEventHandler(), which must be fed
+// every event the sensor parser reports.  While FpLinkBusy() is true the
+// responses belong to the negotiation and must not be handled elsewhere, or
+// the answers to GetFWVer would be taken for those of the next command.
+//
+//*****************************************************************************
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "inc/hw_memmap.h"
+#include "driverlib/rom.h"
+#include "driverlib/rom_map.h"
+#include "driverlib/sysctl.h"
+#include "driverlib/uart.h"
+#include "uart_tx.h"
+#include "clock_profile.h"
+#include "config.h"
+#include "fp_command.h"
+#include "fp_parser.h"
+#include "fp_link.h"
+
+//*****************************************************************************
+//
+// How long to wait for a GetFWVer answer, for the OK to Baudrate=, and for
+// the sensor to come back after it resets.
+//
+//*****************************************************************************
+#define FP_LINK_VERSION_MS      200
+#define FP_LINK_OK_MS           500
+#define FP_LINK_RESET_MS        1000
+
+//*****************************************************************************
+//
+// The number of GetFWVer attempts made at each rate.
+//
+//*****************************************************************************
+#define FP_LINK_ATTEMPTS        2
+
+//*****************************************************************************
+//
+// The rates probed when the remembered one does not answer, fastest first
+// since that is where a previous negotiation will have left the sensor.
+//
+//*****************************************************************************
+static const uint32_t g_pui32LinkRates[] =
+{
+    115200, 57600, 38400, 19200, 9600
+};
+
+#define NUM_LINK_RATES          (sizeof(g_pui32LinkRates) /                   \
+                                 sizeof(g_pui32LinkRates[0]))
+
+//*****************************************************************************
+//
+// The current link rate and the responses seen since the last command.
+//
+//*****************************************************************************
+static uint32_t g_ui32LinkBaud;
+static volatile bool g_bLinkBusy;
+static volatile bool g_bLinkVersion;
+static volatile bool g_bLinkOK;
+
+//*****************************************************************************
+//
+// Waits for the given number of milliseconds.
+//
+//*****************************************************************************
+static void
+FpLinkDelay(uint32_t ui32Ms)
+{
+    //
+    // SysCtlDelay() takes three cycles per loop.
+    //
+    while(ui32Ms--)
+    {
+        MAP_SysCtlDelay(ClockFreqGet() / 3000);
+    }
+}
+
+//*****************************************************************************
+//
+// Waits up to the given number of milliseconds for a flag to be set.
+//
+//*****************************************************************************
+static bool
+FpLinkWait(volatile bool *pbFlag, uint32_t ui32Ms)
+{
+    while(!*pbFlag && ui32Ms--)
+    {
+        MAP_SysCtlDelay(ClockFreqGet() / 3000);
+    }
+
+    return(*pbFlag);
+}
+
+//*****************************************************************************
+//
+// Moves UART5 to a new baud rate once everything queued has been sent.
+//
+//*****************************************************************************
+static void
+FpLinkBaudSet(uint32_t ui32Baud)
+{
+    UARTTxFlush(UART5_BASE);
+    MAP_UARTConfigSetExpClk(UART5_BASE, ClockUARTFreq(UART5_BASE), ui32Baud,
+                            (UART_CONFIG_WLEN_8 | UART_CONFIG_STOP_ONE |
+                             UART_CONFIG_PAR_NONE));
+    g_ui32LinkBaud = ui32Baud;
+}
+
+//*****************************************************************************
+//
+// Asks for the firmware version at the current rate and returns true if the
+// sensor answers.
+//
+//*****************************************************************************
+static bool
+FpLinkConfirm(void)
+{
+    uint8_t pui8Frame[FP_COMMAND_BUF_SIZE];
+    uint32_t ui32Attempt, ui32Len;
+
+    ui32Len = FpCommandEncode(FP_CMD_GET_FW_VER, pui8Frame, sizeof(pui8Frame));
+
+    for(ui32Attempt = 0; ui32Attempt < FP_LINK_ATTEMPTS; ui32Attempt++)
+    {
+        g_bLinkVersion = false;
+        UARTTxQueue(UART5_BASE, pui8Frame, ui32Len);
+        if(FpLinkWait(&g_bLinkVersion, FP_LINK_VERSION_MS))
+        {
+            return(true);
+        }
+    }
+
+    return(false);
+}
+
+//*****************************************************************************
+//
+// Tries every supported rate and returns the one the sensor answers at, or 0
+// if it does not answer at all.
+//
+//*****************************************************************************
+static uint32_t
+FpLinkProbe(void)
+{
+    uint32_t ui32Idx;
+
+    for(ui32Idx = 0; ui32Idx < NUM_LINK_RATES; ui32Idx++)
+    {
+        FpLinkBaudSet(g_pui32LinkRates[ui32Idx]);
+        if(FpLinkConfirm())
+        {
+            return(g_pui32LinkRates[ui32Idx]);
+        }
+    }
+
+    return(0);
+}
+
+//*****************************************************************************
+//
+// Tells the sensor to switch to the fast rate, follows it and confirms the
+// link.  Returns true on success; on failure UART5 is left at the fast rate.
+//
+//*****************************************************************************
+static bool
+FpLinkSpeedUp(void)
+{
+    uint8_t pui8Frame[FP_COMMAND_BUF_SIZE];
+    uint32_t ui32Len;
+
+    ui32Len = FpCommandEncodeNum(FP_CMD_BAUDRATE, FP_LINK_FAST_BAUD,
+                                 pui8Frame, sizeof(pui8Frame));
+
+    g_bLinkOK = false;
+    UARTTxQueue(UART5_BASE, pui8Frame, ui32Len);
+    if(!FpLinkWait(&g_bLinkOK, FP_LINK_OK_MS))
+    {
+        return(false);
+    }
+
+    //
+    // The sensor resets itself after answering.
+    //
+    FpLinkBaudSet(FP_LINK_FAST_BAUD);
+    FpLinkDelay(FP_LINK_RESET_MS);
+
+    return(FpLinkConfirm());
+}
+
+//*****************************************************************************
+//
+// Finds the sensor and moves it to the fast rate.  If the sensor cannot be
+// found, UART5 is put back at the rate it was at.
+//
+//*****************************************************************************
+static uint32_t
+FpLinkFind(void)
+{
+    uint32_t ui32Baud, ui32Prev;
+
+    ui32Prev = g_ui32LinkBaud;
+
+    //
+    // A reboot normally finds the sensor where it was left.
+    //
+    ui32Baud = ConfigNumGet(CONFIG_LINK_BAUD);
+    if(ui32Baud)
+    {
+        FpLinkBaudSet(ui32Baud);
+        if(!FpLinkConfirm())
+        {
+            ui32Baud = 0;
+        }
+    }
+
+    if(!ui32Baud)
+    {
+        ui32Baud = FpLinkProbe();
+    }
+
+    if(!ui32Baud)
+    {
+        FpLinkBaudSet(ui32Prev);
+        return(0);
+    }
+
+    //
+    // Move to the fast rate, falling back to whatever the sensor is left at
+    // if that cannot be confirmed.
+    //
+    if((ui32Baud != FP_LINK_FAST_BAUD) && !FpLinkSpeedUp())
+    {
+        ui32Baud = FpLinkProbe();
+        if(!ui32Baud)
+        {
+            FpLinkBaudSet(ui32Prev);
+            return(0);
+        }
+    }
+
+    ui32Baud = g_ui32LinkBaud;
+    ConfigNumSet(CONFIG_LINK_BAUD, ui32Baud);
+
+    return(ui32Baud);
+}
+
+//*****************************************************************************
+//
+//! Prepares the link for negotiation.
+//!
+//! The configuration store, which remembers the link rate, must have been
+//! initialized.
+//!
+//! \return None.
+//
+//*****************************************************************************
+void
+FpLinkInit(void)
+{
+    g_ui32LinkBaud = FP_LINK_DEFAULT_BAUD;
+}
+
+//*****************************************************************************
+//
+//! Brings the sensor link up at the fastest rate that works.
+//!
+//! UART5 must be configured, its receive interrupt enabled and every parser
+//! event passed to FpLinkEventHandler() before this is called.  It blocks for
+//! tens of milliseconds when the remembered rate answers and for a few
+//! seconds when the sensor has to be probed and switched.
+//!
+//! \return Returns the confirmed baud rate, or 0 if the sensor did not answer
+//! at any rate, in which case UART5 is put back at the rate it was at: the
+//! default rate on boot, or the rate of a link that was working before.
+//
+//*****************************************************************************
+uint32_t
+FpLinkNegotiate(void)
+{
+    uint32_t ui32Baud;
+
+    g_bLinkBusy = true;
+    ui32Baud = FpLinkFind();
+    g_bLinkBusy = false;
+
+    return(ui32Baud);
+}
+
+//*****************************************************************************
+//
+//! Returns whether the link is being negotiated.
+//!
+//! \return Returns \b true while FpLinkNegotiate() runs, when the sensor
+//! responses are its own.
+//
+//*****************************************************************************
+bool
+FpLinkBusy(void)
+{
+    return(g_bLinkBusy);
+}
+
+//*****************************************************************************
+//
+//! Puts the sensor link back at a rate confirmed before a standby.
+//!
+//! \param ui32Baud is the rate the link was at.
+//!
+//! The sensor keeps its rate over a power cycle, so after the processor
+//! wakes from standby UART5 is simply set to the rate the link was left at,
+//! without waiting for the sensor.  A sensor that has since been moved to
+//! another rate shows up as retried commands that still time out; after
+//! FP_LINK_TIMEOUTS of them in a row the application calls FpLinkNegotiate()
+//! to find it again.
+//!
+//! \return None.
+//
+//*****************************************************************************
+void
+FpLinkResume(uint32_t ui32Baud)
+{
+    FpLinkBaudSet(ui32Baud);
+}
+
+//*****************************************************************************
+//
+//! Returns the baud rate UART5 is currently set to.
+//!
+//! \return Returns the link baud rate.
+//
+//*****************************************************************************
+uint32_t
+FpLinkBaudGet(void)
+{
+    return(g_ui32LinkBaud);
+}
+
+//*****************************************************************************
+//
+//! Handles an event from the sensor parser.
+//!
+//! \param psEvent is the event.
+//!
+//! \return None.
+//
+//*****************************************************************************
+void
+FpLinkEventHandler(const tFpEvent *psEvent)
+{
+    //
+    // GetFWVer is answered with a plain number such as <R>0123</R>.
+    //
+    if(psEvent->ui32Type == FP_EVENT_NUMBER)
+    {
+        g_bLinkVersion = true;
+    }
+    else if(psEvent->ui32Type == FP_EVENT_OK)
+    {
+        g_bLinkOK = true;
+    }
+}
@@ -0,0 +1,48 @@
+//*****************************************************************************
+//
+// fp_link.h - Prototypes for the sensor link speed negotiation.
+//
+//*****************************************************************************
+
+#ifndef __FP_LINK_H__
+#define __FP_LINK_H__
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+//*****************************************************************************
+//
+// The baud rate the sensor is moved to, and the rate it uses out of the box.
+//
+//*****************************************************************************
+#define FP_LINK_FAST_BAUD       115200
+#define FP_LINK_DEFAULT_BAUD    9600
+
+//*****************************************************************************
+//
+// The number of commands in a row that must time out before the link is
+// negotiated again.  Only commands that are retried count; those that wait
+// for the user, and so are not, time out whenever nobody comes.
+//
+//*****************************************************************************
+#define FP_LINK_TIMEOUTS        3
+
+//*****************************************************************************
+//
+// Prototypes for the APIs.
+//
+//*****************************************************************************
+extern void FpLinkInit(void);
+extern uint32_t FpLinkNegotiate(void);
+extern bool FpLinkBusy(void);
+extern void FpLinkResume(uint32_t ui32Baud);
+extern uint32_t FpLinkBaudGet(void);
+extern void FpLinkEventHandler(const tFpEvent *psEvent);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __FP_LINK_H__
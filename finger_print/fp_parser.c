@@ -0,0 +1,479 @@
+//*****************************************************************************
+//
+// fp_parser.c - Incremental parser for Fingerprint 2 Click responses.
+//
+// The sensor answers with text enclosed in <R> and </R>, sends an image as
+// binary data enclosed in <I> and </I>, and prints free form instructions
+// outside of any tag.  The parser is a byte at a time state machine, so the
+// input may be split anywhere.  It keeps at most FP_PARSER_TEXT_SIZE bytes of
+// response text and never copies image payload: image chunks are reported as
+// pointers into the buffer that was fed in.
+//
+// Because image data is binary and may contain "</I>", the end of an image is
+// found by counting payload bytes rather than by searching for the tag.
+//
+//*****************************************************************************
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "fp_parser.h"
+
+//*****************************************************************************
+//
+// The parser states.
+//
+//*****************************************************************************
+#define PARSER_IDLE             0   // Outside of any tag
+#define PARSER_TAG              1   // Reading a tag name after '<'
+#define PARSER_RESPONSE         2   // Reading response text after <R>
+#define PARSER_CLOSE            3   // Skipping the tag that ends a response
+#define PARSER_IMAGE            4   // Passing image payload through
+
+//*****************************************************************************
+//
+// The longest tag name that is of interest ("/R", "/I").
+//
+//*****************************************************************************
+#define PARSER_TAG_SIZE         2
+
+//*****************************************************************************
+//
+// Reports an event with no payload.
+//
+//*****************************************************************************
+static void
+FpParserEmit(tFpParser *psParser, uint32_t ui32Type, uint32_t ui32Value)
+{
+    tFpEvent sEvent;
+
+    sEvent.ui32Type = ui32Type;
+    sEvent.ui32Value = ui32Value;
+    sEvent.ui32Width = 0;
+    sEvent.ui32Height = 0;
+    sEvent.pui8Data = 0;
+    sEvent.ui32Len = 0;
+
+    psParser->pfnCallback(psParser->pvCBData, &sEvent);
+}
+
+//*****************************************************************************
+//
+// Reports an event that carries data.
+//
+//*****************************************************************************
+static void
+FpParserEmitData(tFpParser *psParser, uint32_t ui32Type,
+                 const uint8_t *pui8Data, uint32_t ui32Len)
+{
+    tFpEvent sEvent;
+
+    sEvent.ui32Type = ui32Type;
+    sEvent.ui32Value = 0;
+    sEvent.ui32Width = 0;
+    sEvent.ui32Height = 0;
+    sEvent.pui8Data = pui8Data;
+    sEvent.ui32Len = ui32Len;
+
+    psParser->pfnCallback(psParser->pvCBData, &sEvent);
+}
+
+//*****************************************************************************
+//
+// Returns the length of pcPrefix if the response text starts with it, or 0
+// otherwise.  When bExact is set, the text must match pcPrefix completely.
+//
+//*****************************************************************************
+static uint32_t
+FpParserMatch(const tFpParser *psParser, const char *pcPrefix, bool bExact)
+{
+    uint32_t ui32Idx;
+
+    for(ui32Idx = 0; pcPrefix[ui32Idx]; ui32Idx++)
+    {
+        if((ui32Idx >= psParser->ui32Len) ||
+           (psParser->pui8Text[ui32Idx] != (uint8_t)pcPrefix[ui32Idx]))
+        {
+            return(0);
+        }
+    }
+
+    if(bExact && (ui32Idx != psParser->ui32Len))
+    {
+        return(0);
+    }
+
+    return(ui32Idx);
+}
+
+//*****************************************************************************
+//
+// Converts the decimal (ui32Base 10) or hexadecimal (ui32Base 16) digits at
+// the given position of the response text.  Returns the position after the
+// last digit, which equals ui32Pos when there is no digit.
+//
+//*****************************************************************************
+static uint32_t
+FpParserNumber(const tFpParser *psParser, uint32_t ui32Pos,
+               uint32_t ui32Base, uint32_t *pui32Value)
+{
+    uint32_t ui32Value, ui32Digit;
+    uint8_t ui8Char;
+
+    ui32Value = 0;
+
+    for(; ui32Pos < psParser->ui32Len; ui32Pos++)
+    {
+        ui8Char = psParser->pui8Text[ui32Pos];
+
+        if((ui8Char >= '0') && (ui8Char <= '9'))
+        {
+            ui32Digit = ui8Char - '0';
+        }
+        else if((ui32Base == 16) && (ui8Char >= 'A') && (ui8Char <= 'F'))
+        {
+            ui32Digit = ui8Char - 'A' + 10;
+        }
+        else if((ui32Base == 16) && (ui8Char >= 'a') && (ui8Char <= 'f'))
+        {
+            ui32Digit = ui8Char - 'a' + 10;
+        }
+        else
+        {
+            break;
+        }
+
+        ui32Value = (ui32Value * ui32Base) + ui32Digit;
+    }
+
+    *pui32Value = ui32Value;
+
+    return(ui32Pos);
+}
+
+//*****************************************************************************
+//
+// Decodes an INFO response, "W=(width),H=(height)", which the sensor may also
+// send with a space after the comma.  Returns false if the text does not have
+// that form.
+//
+//*****************************************************************************
+static bool
+FpParserInfo(tFpParser *psParser)
+{
+    tFpEvent sEvent;
+    uint32_t ui32Pos, ui32End;
+
+    ui32Pos = FpParserMatch(psParser, "W=", false);
+    if(!ui32Pos)
+    {
+        return(false);
+    }
+
+    ui32End = FpParserNumber(psParser, ui32Pos, 10, &sEvent.ui32Width);
+    if((ui32End == ui32Pos) || (ui32End >= psParser->ui32Len) ||
+       (psParser->pui8Text[ui32End] != ','))
+    {
+        return(false);
+    }
+
+    for(ui32Pos = ui32End + 1;
+        (ui32Pos < psParser->ui32Len) && (psParser->pui8Text[ui32Pos] == ' ');
+        ui32Pos++)
+    {
+    }
+
+    if(((ui32Pos + 2) > psParser->ui32Len) ||
+       (psParser->pui8Text[ui32Pos] != 'H') ||
+       (psParser->pui8Text[ui32Pos + 1] != '='))
+    {
+        return(false);
+    }
+
+    ui32Pos += 2;
+    ui32End = FpParserNumber(psParser, ui32Pos, 10, &sEvent.ui32Height);
+    if((ui32End == ui32Pos) || (ui32End != psParser->ui32Len))
+    {
+        return(false);
+    }
+
+    //
+    // Size the next image from the reported dimensions.
+    //
+    psParser->ui32ImageSize = sEvent.ui32Width * sEvent.ui32Height;
+
+    sEvent.ui32Type = FP_EVENT_INFO;
+    sEvent.ui32Value = psParser->ui32ImageSize;
+    sEvent.pui8Data = 0;
+    sEvent.ui32Len = 0;
+    psParser->pfnCallback(psParser->pvCBData, &sEvent);
+
+    return(true);
+}
+
+//*****************************************************************************
+//
+// Decodes the text of a complete response and reports it.
+//
+//*****************************************************************************
+static void
+FpParserResponse(tFpParser *psParser)
+{
+    uint32_t ui32Pos, ui32Value;
+
+    if(FpParserMatch(psParser, "OK", true))
+    {
+        FpParserEmit(psParser, FP_EVENT_OK, 0);
+    }
+    else if(FpParserMatch(psParser, "NG", true))
+    {
+        FpParserEmit(psParser, FP_EVENT_NG, 0);
+    }
+    else if(FpParserMatch(psParser, "FINISHED", true))
+    {
+        FpParserEmit(psParser, FP_EVENT_FINISHED, 0);
+    }
+    else if(FpParserMatch(psParser, "FAIL", true))
+    {
+        FpParserEmit(psParser, FP_EVENT_FAIL, 0);
+    }
+    else if(FpParserMatch(psParser, "PASS", true))
+    {
+        FpParserEmit(psParser, FP_EVENT_PASS, FP_PASS_NO_INDEX);
+    }
+    else if(((ui32Pos = FpParserMatch(psParser, "PASS_", false)) != 0) &&
+            (FpParserNumber(psParser, ui32Pos, 10, &ui32Value) ==
+             psParser->ui32Len) && (ui32Pos != psParser->ui32Len))
+    {
+        FpParserEmit(psParser, FP_EVENT_PASS, ui32Value);
+    }
+    else if(((ui32Pos = FpParserMatch(psParser, "DS=", false)) != 0) &&
+            (FpParserNumber(psParser, ui32Pos, 16, &ui32Value) ==
+             psParser->ui32Len) && (ui32Pos != psParser->ui32Len))
+    {
+        FpParserEmit(psParser, FP_EVENT_DS, ui32Value);
+    }
+    else if((ui32Pos = FpParserMatch(psParser, "KEY=", false)) != 0)
+    {
+        FpParserEmitData(psParser, FP_EVENT_KEY, psParser->pui8Text + ui32Pos,
+                         psParser->ui32Len - ui32Pos);
+    }
+    else if(psParser->ui32Len &&
+            (FpParserNumber(psParser, 0, 10, &ui32Value) ==
+             psParser->ui32Len))
+    {
+        FpParserEmit(psParser, FP_EVENT_NUMBER, ui32Value);
+    }
+    else if(!FpParserInfo(psParser))
+    {
+        FpParserEmitData(psParser, FP_EVENT_TEXT, psParser->pui8Text,
+                         psParser->ui32Len);
+    }
+}
+
+//*****************************************************************************
+//
+// Advances the state machine by one byte outside of image payload.
+//
+//*****************************************************************************
+static void
+FpParserByte(tFpParser *psParser, uint8_t ui8Char)
+{
+    switch(psParser->ui32State)
+    {
+        case PARSER_IDLE:
+        {
+            if(ui8Char == '<')
+            {
+                psParser->ui32Len = 0;
+                psParser->ui32State = PARSER_TAG;
+            }
+            break;
+        }
+
+        case PARSER_TAG:
+        {
+            if(ui8Char == '<')
+            {
+                psParser->ui32Len = 0;
+            }
+            else if(ui8Char != '>')
+            {
+                if(psParser->ui32Len < PARSER_TAG_SIZE)
+                {
+                    psParser->pui8Text[psParser->ui32Len++] = ui8Char;
+                }
+                else
+                {
+                    psParser->ui32State = PARSER_IDLE;
+                }
+            }
+            else if((psParser->ui32Len == 1) && (psParser->pui8Text[0] == 'R'))
+            {
+                psParser->ui32Len = 0;
+                psParser->ui32State = PARSER_RESPONSE;
+            }
+            else if((psParser->ui32Len == 1) &&
+                    (psParser->pui8Text[0] == 'I') &&
+                    psParser->ui32ImageSize)
+            {
+                psParser->ui32ImageLeft = psParser->ui32ImageSize;
+                psParser->ui32State = PARSER_IMAGE;
+                FpParserEmit(psParser, FP_EVENT_IMAGE_START,
+                             psParser->ui32ImageSize);
+            }
+            else
+            {
+                psParser->ui32State = PARSER_IDLE;
+            }
+            break;
+        }
+
+        case PARSER_RESPONSE:
+        {
+            //
+            // The response ends at the next tag, which is normally </R> but
+            // is shown as <R> for some responses in the protocol document.
+            //
+            if(ui8Char == '<')
+            {
+                FpParserResponse(psParser);
+                psParser->ui32Len = 0;
+                psParser->ui32State = PARSER_CLOSE;
+            }
+            else if(psParser->ui32Len < FP_PARSER_TEXT_SIZE)
+            {
+                psParser->pui8Text[psParser->ui32Len++] = ui8Char;
+            }
+            break;
+        }
+
+        case PARSER_CLOSE:
+        {
+            if((ui8Char == '>') || (++psParser->ui32Len > PARSER_TAG_SIZE))
+            {
+                psParser->ui32State = PARSER_IDLE;
+            }
+            break;
+        }
+
+        default:
+        {
+            psParser->ui32State = PARSER_IDLE;
+            break;
+        }
+    }
+}
+
+//*****************************************************************************
+//
+//! Initializes a parser.
+//!
+//! \param psParser is a pointer to the parser state.
+//! \param pfnCallback is the function that is called for every event.
+//! \param pvCBData is passed through to the callback.
+//!
+//! The callback runs in the context of FpParserFeed(), which is normally the
+//! UART5 interrupt.
+//!
+//! \return None.
+//
+//*****************************************************************************
+void
+FpParserInit(tFpParser *psParser, tFpEventCallback pfnCallback,
+             void *pvCBData)
+{
+    psParser->pfnCallback = pfnCallback;
+    psParser->pvCBData = pvCBData;
+    psParser->ui32ImageSize = FP_IMAGE_WIDTH * FP_IMAGE_HEIGHT;
+    FpParserReset(psParser);
+}
+
+//*****************************************************************************
+//
+//! Discards any partly parsed response or image.
+//!
+//! \param psParser is a pointer to the parser state.
+//!
+//! \return None.
+//
+//*****************************************************************************
+void
+FpParserReset(tFpParser *psParser)
+{
+    psParser->ui32State = PARSER_IDLE;
+    psParser->ui32ImageLeft = 0;
+    psParser->ui32Len = 0;
+}
+
+//*****************************************************************************
+//
+//! Sets the number of payload bytes expected between <I> and </I>.
+//!
+//! \param psParser is a pointer to the parser state.
+//! \param ui32Size is the image size in bytes.
+//!
+//! The size is also updated automatically by every INFO response.
+//!
+//! \return None.
+//
+//*****************************************************************************
+void
+FpParserImageSizeSet(tFpParser *psParser, uint32_t ui32Size)
+{
+    psParser->ui32ImageSize = ui32Size;
+}
+
+//*****************************************************************************
+//
+//! Feeds received bytes to a parser.
+//!
+//! \param psParser is a pointer to the parser state.
+//! \param pui8Data is a pointer to the received bytes.
+//! \param ui32Len is the number of bytes.
+//!
+//! Any number of bytes may be fed at a time.  Image payload inside the buffer
+//! is reported as FP_EVENT_IMAGE_CHUNK events that point into it, so the
+//! buffer must stay valid until this returns.
+//!
+//! \return None.
+//
+//*****************************************************************************
+void
+FpParserFeed(tFpParser *psParser, const uint8_t *pui8Data, uint32_t ui32Len)
+{
+    uint32_t ui32Chunk;
+
+    while(ui32Len)
+    {
+        if(psParser->ui32State != PARSER_IMAGE)
+        {
+            FpParserByte(psParser, *pui8Data++);
+            ui32Len--;
+            continue;
+        }
+
+        //
+        // Pass as much of the payload through as this buffer holds.
+        //
+        ui32Chunk = psParser->ui32ImageLeft;
+        if(ui32Chunk > ui32Len)
+        {
+            ui32Chunk = ui32Len;
+        }
+
+        FpParserEmitData(psParser, FP_EVENT_IMAGE_CHUNK, pui8Data, ui32Chunk);
+        pui8Data += ui32Chunk;
+        ui32Len -= ui32Chunk;
+        psParser->ui32ImageLeft -= ui32Chunk;
+
+        if(!psParser->ui32ImageLeft)
+        {
+            //
+            // The </I> that follows is skipped as an unknown tag.
+            //
+            psParser->ui32State = PARSER_IDLE;
+            FpParserEmit(psParser, FP_EVENT_IMAGE_END,
+                         psParser->ui32ImageSize);
+        }
+    }
+}
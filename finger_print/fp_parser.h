@@ -0,0 +1,133 @@
+//*****************************************************************************
+//
+// fp_parser.h - Prototypes for the incremental Fingerprint 2 Click response
+//               parser.
+//
+//*****************************************************************************
+
+#ifndef __FP_PARSER_H__
+#define __FP_PARSER_H__
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+//*****************************************************************************
+//
+// The events reported by the parser.
+//
+//*****************************************************************************
+#define FP_EVENT_OK             0   // <R>OK</R>
+#define FP_EVENT_NG             1   // <R>NG</R>
+#define FP_EVENT_FINISHED       2   // <R>FINISHED</R>
+#define FP_EVENT_PASS           3   // <R>PASS</R> or <R>PASS_n</R>
+#define FP_EVENT_FAIL           4   // <R>FAIL</R>
+#define FP_EVENT_INFO           5   // <R>W=w,H=h</R>
+#define FP_EVENT_DS             6   // <R>DS=HH</R>
+#define FP_EVENT_KEY            7   // <R>KEY=sss</R>
+#define FP_EVENT_NUMBER         8   // <R>ddd</R> (count or FW version)
+#define FP_EVENT_TEXT           9   // Any other <R> response
+#define FP_EVENT_IMAGE_START    10  // <I>
+#define FP_EVENT_IMAGE_CHUNK    11  // Image payload bytes
+#define FP_EVENT_IMAGE_END      12  // The last payload byte was received
+
+//*****************************************************************************
+//
+// The value reported with FP_EVENT_PASS when the sensor did not append an
+// index.
+//
+//*****************************************************************************
+#define FP_PASS_NO_INDEX        0xFFFFFFFF
+
+//*****************************************************************************
+//
+// The default image size, 176 x 176, used until an INFO response reports
+// another one.
+//
+//*****************************************************************************
+#define FP_IMAGE_WIDTH          176
+#define FP_IMAGE_HEIGHT         176
+
+//*****************************************************************************
+//
+// The longest response text that is kept.  Longer responses are truncated.
+//
+//*****************************************************************************
+#define FP_PARSER_TEXT_SIZE     48
+
+//*****************************************************************************
+//
+// An event reported by the parser.  The data pointer refers either to the
+// text kept by the parser (KEY and TEXT) or straight into the buffer passed
+// to FpParserFeed() (IMAGE_CHUNK); it is only valid during the callback.
+//
+//*****************************************************************************
+typedef struct
+{
+    //
+    // One of the FP_EVENT_* values.
+    //
+    uint32_t ui32Type;
+
+    //
+    // The PASS index, DS state bits, number, or for IMAGE_START and
+    // IMAGE_END the payload size.
+    //
+    uint32_t ui32Value;
+
+    //
+    // The image dimensions of an INFO response.
+    //
+    uint32_t ui32Width;
+    uint32_t ui32Height;
+
+    //
+    // The event text or image payload.
+    //
+    const uint8_t *pui8Data;
+    uint32_t ui32Len;
+}
+tFpEvent;
+
+//*****************************************************************************
+//
+// The function called for every event.
+//
+//*****************************************************************************
+typedef void (*tFpEventCallback)(void *pvCBData, const tFpEvent *psEvent);
+
+//*****************************************************************************
+//
+// The state of one parser.  The members are private to fp_parser.c.
+//
+//*****************************************************************************
+typedef struct
+{
+    tFpEventCallback pfnCallback;
+    void *pvCBData;
+    uint32_t ui32State;
+    uint32_t ui32ImageSize;
+    uint32_t ui32ImageLeft;
+    uint32_t ui32Len;
+    uint8_t pui8Text[FP_PARSER_TEXT_SIZE];
+}
+tFpParser;
+
+//*****************************************************************************
+//
+// Prototypes for the APIs.
+//
+//*****************************************************************************
+extern void FpParserInit(tFpParser *psParser, tFpEventCallback pfnCallback,
+                         void *pvCBData);
+extern void FpParserReset(tFpParser *psParser);
+extern void FpParserImageSizeSet(tFpParser *psParser, uint32_t ui32Size);
+extern void FpParserFeed(tFpParser *psParser, const uint8_t *pui8Data,
+                         uint32_t ui32Len);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __FP_PARSER_H__
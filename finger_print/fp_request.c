@@ -0,0 +1,513 @@
+//*****************************************************************************
+//
+// fp_request.c - Sensor command deadlines and retries.
+//
+// Every command is sent through FpRequestSend(), which keeps a copy of the
+// frame and starts the deadline of the command.  The command ends when the
+// sensor sends one of the responses its policy expects.  A sensor that
+// missed a byte or reset in the middle never answers, so once the deadline
+// passes the command is sent again after a back off that doubles with each
+// retry, and when the retries run out it is given up on.
+//
+// The deadlines, retry counts and back off of each command can be changed at
+// run time; the defaults below suit the Fingerprint 2 Click.  Commands that
+// wait for the user, such as a registration, are never retried, since
+// sending them again would start the operation over.
+//
+// The sensor handles one command at a time, so only one request is
+// outstanding on it; its state is a tFpRequest.  The further sensors in
+// fp_sensor.c each keep a tFpRequest of their own and run it through the
+// FpRequestState*() calls, under the same policies.  Responses and ticks are
+// passed in from the event loop.
+//
+//*****************************************************************************
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include "inc/hw_memmap.h"
+#include "uart_tx.h"
+#include "fp_command.h"
+#include "fp_parser.h"
+#include "fp_request.h"
+
+//*****************************************************************************
+//
+// The responses that end each kind of command.
+//
+//*****************************************************************************
+#define FP_END(ui32Event)       (1 << (ui32Event))
+#define FP_END_ANY              (FP_END(FP_EVENT_OK) | FP_END(FP_EVENT_NG) |  \
+                                 FP_END(FP_EVENT_FINISHED) |                  \
+                                 FP_END(FP_EVENT_PASS) |                      \
+                                 FP_END(FP_EVENT_FAIL) |                      \
+                                 FP_END(FP_EVENT_INFO) |                      \
+                                 FP_END(FP_EVENT_DS) | FP_END(FP_EVENT_KEY) | \
+                                 FP_END(FP_EVENT_NUMBER) |                    \
+                                 FP_END(FP_EVENT_TEXT))
+#define FP_END_REGISTER         (FP_END(FP_EVENT_FINISHED) |                  \
+                                 FP_END(FP_EVENT_FAIL) | FP_END(FP_EVENT_NG))
+#define FP_END_COMPARE          (FP_END(FP_EVENT_PASS) |                      \
+                                 FP_END(FP_EVENT_FAIL) | FP_END(FP_EVENT_NG))
+#define FP_END_INFO             (FP_END(FP_EVENT_INFO) | FP_END(FP_EVENT_NG))
+#define FP_END_IMAGE            (FP_END(FP_EVENT_IMAGE_END) |                 \
+                                 FP_END(FP_EVENT_FAIL) | FP_END(FP_EVENT_NG))
+#define FP_END_NUMBER           (FP_END(FP_EVENT_NUMBER) |                    \
+                                 FP_END(FP_EVENT_NG))
+#define FP_END_ACK              (FP_END(FP_EVENT_OK) | FP_END(FP_EVENT_NG))
+
+#define FP_POLICY(ui16TimeoutMs, ui8Retries, ui32EndEvents)                   \
+        { ui16TimeoutMs, FP_REQUEST_BACKOFF_MS, ui8Retries, ui32EndEvents }
+
+//*****************************************************************************
+//
+// The back off before the first retry of every command.
+//
+//*****************************************************************************
+#define FP_REQUEST_BACKOFF_MS   50
+
+//*****************************************************************************
+//
+// The default policies, indexed by FP_CMD_*.
+//
+//*****************************************************************************
+static const tFpRequestPolicy g_psFpRequestDefaults[FP_CMD_COUNT] =
+{
+    FP_POLICY(30000, 0, FP_END_REGISTER),   // RegisterFingerprint
+    FP_POLICY(30000, 0, FP_END_REGISTER),   // RegisterOneFp
+    FP_POLICY(10000, 0, FP_END_COMPARE),    // CompareFingerprint
+    FP_POLICY(200, 2, FP_END_INFO),         // FpImageInformation
+    FP_POLICY(10000, 0, FP_END_IMAGE),      // ScanFpImage
+    FP_POLICY(200, 2, FP_END_NUMBER),       // CheckRegisteredNo
+    FP_POLICY(500, 0, FP_END_ACK),          // Baudrate
+    FP_POLICY(100, 2, FP_END(FP_EVENT_NUMBER)),
+                                            // GetFWVer
+    FP_POLICY(1000, 1, FP_END_ACK),         // ClearRegisteredFp
+    FP_POLICY(1000, 1, FP_END_ACK | FP_END(FP_EVENT_FAIL)),
+                                            // ClearOneFp
+    FP_POLICY(200, 2, FP_END(FP_EVENT_DS) | FP_END(FP_EVENT_NG)),
+                                            // GetDS
+    FP_POLICY(200, 2, FP_END_ANY),          // GetSuccStr
+    FP_POLICY(200, 2, FP_END_ANY),          // GetFailStr
+    FP_POLICY(500, 1, FP_END_ACK),          // SetSuccStr
+    FP_POLICY(500, 1, FP_END_ACK),          // SetFailStr
+    FP_POLICY(10000, 0, FP_END_COMPARE),    // UnlockCompareFp
+    FP_POLICY(500, 1, FP_END_ACK),          // UnlockComparePWD
+    FP_POLICY(200, 2, FP_END_ANY),          // GetPWD
+    FP_POLICY(500, 1, FP_END_ACK),          // SetPWD
+    FP_POLICY(500, 1, FP_END_ACK),          // ClearPWD
+    FP_POLICY(500, 1, FP_END_ACK),          // LockDevice
+    FP_POLICY(500, 1, FP_END(FP_EVENT_KEY) | FP_END(FP_EVENT_NG)),
+                                            // SearchKeyByID
+    FP_POLICY(500, 0, FP_END_ACK),          // SetKey
+    FP_POLICY(500, 0, FP_END_ACK),          // DeleteCurrentKey
+    FP_POLICY(500, 1, FP_END_ACK),          // DeleteKeyByID
+    FP_POLICY(1000, 1, FP_END_ACK),         // DeleteAllKey
+    FP_POLICY(1000, 1, FP_END_ANY),         // ListAllKey
+    FP_POLICY(500, 1, FP_END_ACK),          // UnlockTimeout
+    FP_POLICY(200, 2, FP_END_ANY),          // GetUnlockTimeout
+    FP_POLICY(500, 1, FP_END_ACK),          // SetUnlockGPIO
+    FP_POLICY(200, 2, FP_END_ANY),          // GetUnlockGPIO
+    FP_POLICY(500, 1, FP_END_ACK),          // EnableSysMsg
+    FP_POLICY(500, 1, FP_END_ACK),          // DisableSysMsg
+    FP_POLICY(500, 1, FP_END_ACK),          // EnableErrRegFpInAuto
+    FP_POLICY(500, 1, FP_END_ACK),          // DisableErrRegFpInAuto
+    FP_POLICY(500, 0, FP_END_ACK)           // SetCommCh
+};
+
+//*****************************************************************************
+//
+// The policies in use and the statistics of each command.
+//
+//*****************************************************************************
+static tFpRequestPolicy g_psFpRequestPolicies[FP_CMD_COUNT];
+static tFpRequestStats g_psFpRequestStats[FP_CMD_COUNT];
+
+//*****************************************************************************
+//
+// The command outstanding on UART5.
+//
+//*****************************************************************************
+static tFpRequest g_sFpRequest;
+
+//*****************************************************************************
+//
+// The function told when a command ends.
+//
+//*****************************************************************************
+static tFpRequestCallback g_pfnFpRequestCallback;
+
+//*****************************************************************************
+//
+// Sends the outstanding command of a sensor and starts its deadline.
+//
+//*****************************************************************************
+static void
+FpRequestTransmit(tFpRequest *psRequest)
+{
+    UARTTxQueue(psRequest->ui32Base, psRequest->pui8Frame, psRequest->ui32Len);
+    psRequest->ui32Left =
+        g_psFpRequestPolicies[psRequest->ui32Cmd].ui16TimeoutMs;
+    psRequest->bBackoff = false;
+}
+
+//*****************************************************************************
+//
+// Ends the command outstanding on UART5.
+//
+//*****************************************************************************
+static void
+FpRequestEnd(uint32_t ui32Result)
+{
+    tFpRequestStats *psStats;
+
+    psStats = &g_psFpRequestStats[g_sFpRequest.ui32Cmd];
+    if(ui32Result == FP_REQUEST_RESULT_OK)
+    {
+        psStats->ui32Completed++;
+        if(g_sFpRequest.ui32Elapsed > psStats->ui32MaxMs)
+        {
+            psStats->ui32MaxMs = g_sFpRequest.ui32Elapsed;
+        }
+    }
+    else
+    {
+        psStats->ui32Timeouts++;
+    }
+
+    if(g_pfnFpRequestCallback)
+    {
+        g_pfnFpRequestCallback(g_sFpRequest.ui32Cmd, ui32Result);
+    }
+}
+
+//*****************************************************************************
+//
+//! Initializes the command service with the default policies.
+//!
+//! \param pfnCallback is the function told when a command ends, or 0.  It is
+//! called from the event loop.
+//!
+//! The statistics are cleared.
+//!
+//! \return None.
+//
+//*****************************************************************************
+void
+FpRequestInit(tFpRequestCallback pfnCallback)
+{
+    memcpy(g_psFpRequestPolicies, g_psFpRequestDefaults,
+           sizeof(g_psFpRequestPolicies));
+    memset(g_psFpRequestStats, 0, sizeof(g_psFpRequestStats));
+    g_pfnFpRequestCallback = pfnCallback;
+    FpRequestStateInit(&g_sFpRequest, UART5_BASE);
+}
+
+//*****************************************************************************
+//
+//! Sends a command to the sensor and starts its deadline.
+//!
+//! \param ui32Cmd is the FP_CMD_* value the frame was encoded from.
+//! \param pui8Frame is the encoded frame.  It is copied.
+//! \param ui32Len is the length of the frame.
+//!
+//! \return Returns \b false if a command is outstanding already or the frame
+//! is empty or longer than FP_COMMAND_BUF_SIZE.
+//
+//*****************************************************************************
+bool
+FpRequestSend(uint32_t ui32Cmd, const uint8_t *pui8Frame, uint32_t ui32Len)
+{
+    if(!FpRequestStateSend(&g_sFpRequest, ui32Cmd, pui8Frame, ui32Len))
+    {
+        return(false);
+    }
+
+    g_psFpRequestStats[ui32Cmd].ui32Sent++;
+
+    return(true);
+}
+
+//*****************************************************************************
+//
+//! Returns whether a command is outstanding.
+//!
+//! \return Returns \b true from the send of a command until it ends.
+//
+//*****************************************************************************
+bool
+FpRequestIsBusy(void)
+{
+    return(g_sFpRequest.bActive);
+}
+
+//*****************************************************************************
+//
+//! Forgets the outstanding command without calling the callback.
+//!
+//! \return None.
+//
+//*****************************************************************************
+void
+FpRequestCancel(void)
+{
+    g_sFpRequest.bActive = false;
+}
+
+//*****************************************************************************
+//
+//! Handles a sensor response.
+//!
+//! \param ui32Event is the FP_EVENT_* type of the response.
+//!
+//! A response that arrives during a back off still ends the command.  This
+//! must only be called from the event loop.
+//!
+//! \return None.
+//
+//*****************************************************************************
+void
+FpRequestEventHandler(uint32_t ui32Event)
+{
+    if(FpRequestStateEvent(&g_sFpRequest, ui32Event))
+    {
+        FpRequestEnd(FP_REQUEST_RESULT_OK);
+    }
+}
+
+//*****************************************************************************
+//
+//! Counts down the deadline of the outstanding command.
+//!
+//! This must be called every FP_REQUEST_TICK_MS milliseconds from the event
+//! loop.
+//!
+//! \return None.
+//
+//*****************************************************************************
+void
+FpRequestTick(void)
+{
+    switch(FpRequestStateTick(&g_sFpRequest))
+    {
+    case FP_REQUEST_TICK_RETRY:
+        g_psFpRequestStats[g_sFpRequest.ui32Cmd].ui32Retries++;
+        break;
+    case FP_REQUEST_TICK_TIMEOUT:
+        FpRequestEnd(FP_REQUEST_RESULT_TIMEOUT);
+        break;
+    default:
+        break;
+    }
+}
+
+//*****************************************************************************
+//
+//! Returns the policy of a command.
+//!
+//! \param ui32Cmd is one of the FP_CMD_* values.
+//! \param psPolicy is a pointer to the structure that is filled in.
+//!
+//! \return None.
+//
+//*****************************************************************************
+void
+FpRequestPolicyGet(uint32_t ui32Cmd, tFpRequestPolicy *psPolicy)
+{
+    if(ui32Cmd < FP_CMD_COUNT)
+    {
+        *psPolicy = g_psFpRequestPolicies[ui32Cmd];
+    }
+}
+
+//*****************************************************************************
+//
+//! Changes the policy of a command.
+//!
+//! \param ui32Cmd is one of the FP_CMD_* values.
+//! \param psPolicy is the new policy.  A timeout of 0 lets the command wait
+//! for ever.
+//!
+//! \return None.
+//
+//*****************************************************************************
+void
+FpRequestPolicySet(uint32_t ui32Cmd, const tFpRequestPolicy *psPolicy)
+{
+    if(ui32Cmd < FP_CMD_COUNT)
+    {
+        g_psFpRequestPolicies[ui32Cmd] = *psPolicy;
+    }
+}
+
+//*****************************************************************************
+//
+//! Returns the statistics of a command.
+//!
+//! \param ui32Cmd is one of the FP_CMD_* values.
+//! \param psStats is a pointer to the structure that is filled in.
+//!
+//! \return None.
+//
+//*****************************************************************************
+void
+FpRequestStatsGet(uint32_t ui32Cmd, tFpRequestStats *psStats)
+{
+    if(ui32Cmd < FP_CMD_COUNT)
+    {
+        *psStats = g_psFpRequestStats[ui32Cmd];
+    }
+    else
+    {
+        memset(psStats, 0, sizeof(*psStats));
+    }
+}
+
+//*****************************************************************************
+//
+//! Prepares the command state of a sensor.
+//!
+//! \param psRequest is the state.
+//! \param ui32Base is the UART the sensor is on.
+//!
+//! The commands of every sensor follow the policies of this service; the
+//! caller keeps its own statistics from the results of the other calls.
+//!
+//! \return None.
+//
+//*****************************************************************************
+void
+FpRequestStateInit(tFpRequest *psRequest, uint32_t ui32Base)
+{
+    memset(psRequest, 0, sizeof(*psRequest));
+    psRequest->ui32Base = ui32Base;
+}
+
+//*****************************************************************************
+//
+//! Sends a command to a sensor and starts its deadline.
+//!
+//! \param psRequest is the command state of the sensor.
+//! \param ui32Cmd is the FP_CMD_* value the frame was encoded from.
+//! \param pui8Frame is the encoded frame.  It is copied.
+//! \param ui32Len is the length of the frame.
+//!
+//! \return Returns \b false if a command is outstanding already or the frame
+//! is empty or longer than FP_COMMAND_BUF_SIZE.
+//
+//*****************************************************************************
+bool
+FpRequestStateSend(tFpRequest *psRequest, uint32_t ui32Cmd,
+                   const uint8_t *pui8Frame, uint32_t ui32Len)
+{
+    if(psRequest->bActive || (ui32Cmd >= FP_CMD_COUNT) || !ui32Len ||
+       (ui32Len > sizeof(psRequest->pui8Frame)))
+    {
+        return(false);
+    }
+
+    memcpy(psRequest->pui8Frame, pui8Frame, ui32Len);
+    psRequest->ui32Len = ui32Len;
+    psRequest->ui32Cmd = ui32Cmd;
+    psRequest->ui32Retry = 0;
+    psRequest->ui32Elapsed = 0;
+    psRequest->bActive = true;
+
+    FpRequestTransmit(psRequest);
+
+    return(true);
+}
+
+//*****************************************************************************
+//
+//! Checks whether a response ends the command outstanding on a sensor.
+//!
+//! \param psRequest is the command state of the sensor.
+//! \param ui32Event is the FP_EVENT_* type of the response.
+//!
+//! \return Returns \b true if the response ended the command.
+//
+//*****************************************************************************
+bool
+FpRequestStateEvent(tFpRequest *psRequest, uint32_t ui32Event)
+{
+    if(psRequest->bActive && (ui32Event < 32) &&
+       (g_psFpRequestPolicies[psRequest->ui32Cmd].ui32EndEvents &
+        FP_END(ui32Event)))
+    {
+        psRequest->bActive = false;
+        return(true);
+    }
+
+    return(false);
+}
+
+//*****************************************************************************
+//
+//! Counts down the deadline of the command outstanding on a sensor.
+//!
+//! \param psRequest is the command state of the sensor.
+//!
+//! A command that misses its deadline is sent again after its back off,
+//! until its retries run out and it is given up on.  This must be called
+//! every FP_REQUEST_TICK_MS milliseconds from the event loop.
+//!
+//! \return Returns one of the FP_REQUEST_TICK_* values.
+//
+//*****************************************************************************
+uint32_t
+FpRequestStateTick(tFpRequest *psRequest)
+{
+    const tFpRequestPolicy *psPolicy;
+
+    if(!psRequest->bActive)
+    {
+        return(FP_REQUEST_TICK_WAIT);
+    }
+
+    psRequest->ui32Elapsed += FP_REQUEST_TICK_MS;
+
+    //
+    // A command without a deadline waits for ever.
+    //
+    psPolicy = &g_psFpRequestPolicies[psRequest->ui32Cmd];
+    if(!psPolicy->ui16TimeoutMs && !psRequest->bBackoff)
+    {
+        return(FP_REQUEST_TICK_WAIT);
+    }
+
+    if(psRequest->ui32Left > FP_REQUEST_TICK_MS)
+    {
+        psRequest->ui32Left -= FP_REQUEST_TICK_MS;
+        return(FP_REQUEST_TICK_WAIT);
+    }
+
+    if(psRequest->bBackoff)
+    {
+        FpRequestTransmit(psRequest);
+        return(FP_REQUEST_TICK_WAIT);
+    }
+
+    if(psRequest->ui32Retry == psPolicy->ui8Retries)
+    {
+        psRequest->bActive = false;
+        return(FP_REQUEST_TICK_TIMEOUT);
+    }
+
+    //
+    // Back off before sending again, for twice as long after every retry.
+    //
+    psRequest->ui32Left = (uint32_t)psPolicy->ui16BackoffMs <<
+                          psRequest->ui32Retry;
+    psRequest->ui32Retry++;
+    if(psRequest->ui32Left)
+    {
+        psRequest->bBackoff = true;
+    }
+    else
+    {
+        FpRequestTransmit(psRequest);
+    }
+
+    return(FP_REQUEST_TICK_RETRY);
+}
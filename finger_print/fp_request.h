@@ -0,0 +1,142 @@
+//*****************************************************************************
+//
+// fp_request.h - Prototypes for the sensor command deadlines and retries.
+//
+//*****************************************************************************
+
+#ifndef __FP_REQUEST_H__
+#define __FP_REQUEST_H__
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+//*****************************************************************************
+//
+// The period FpRequestTick() must be called at, in milliseconds.
+//
+//*****************************************************************************
+#define FP_REQUEST_TICK_MS      10
+
+//*****************************************************************************
+//
+// The results a command ends with.
+//
+//*****************************************************************************
+#define FP_REQUEST_RESULT_OK    0
+#define FP_REQUEST_RESULT_TIMEOUT                                             \
+                                1
+
+//*****************************************************************************
+//
+// What FpRequestStateTick() did with a command.
+//
+//*****************************************************************************
+#define FP_REQUEST_TICK_WAIT    0       // Still waiting, or resent
+#define FP_REQUEST_TICK_RETRY   1       // Missed its deadline, will be resent
+#define FP_REQUEST_TICK_TIMEOUT 2       // Given up on
+
+//*****************************************************************************
+//
+// How a command is timed.  The sensor has ui16TimeoutMs to send a response
+// that ends the command, one of the FP_EVENT_* types set in ui32EndEvents.
+// Otherwise the command is sent again, up to ui8Retries times; before the
+// first retry the service waits ui16BackoffMs, and twice as long before each
+// one after that.
+//
+//*****************************************************************************
+typedef struct
+{
+    uint16_t ui16TimeoutMs;
+    uint16_t ui16BackoffMs;
+    uint8_t ui8Retries;
+    uint32_t ui32EndEvents;
+}
+tFpRequestPolicy;
+
+//*****************************************************************************
+//
+// Statistics kept for each command.
+//
+//*****************************************************************************
+typedef struct
+{
+    //
+    // The number of times the command was requested, and the number of
+    // those that ended with a response.
+    //
+    uint32_t ui32Sent;
+    uint32_t ui32Completed;
+
+    //
+    // The number of times it was sent again, and the number of times it was
+    // given up on.
+    //
+    uint32_t ui32Retries;
+    uint32_t ui32Timeouts;
+
+    //
+    // The longest time from the first send to the end of the command, in
+    // milliseconds.
+    //
+    uint32_t ui32MaxMs;
+}
+tFpRequestStats;
+
+//*****************************************************************************
+//
+// The state of the command outstanding on one sensor: the UART it is sent
+// on, a copy of its frame, the number of retries made, the milliseconds left
+// until its deadline or the end of the back off, and the milliseconds since
+// it was first sent.  The members are private to fp_request.c.
+//
+//*****************************************************************************
+typedef struct
+{
+    uint32_t ui32Base;
+    uint32_t ui32Cmd;
+    uint32_t ui32Len;
+    uint32_t ui32Retry;
+    uint32_t ui32Left;
+    uint32_t ui32Elapsed;
+    bool bBackoff;
+    bool bActive;
+    uint8_t pui8Frame[FP_COMMAND_BUF_SIZE];
+}
+tFpRequest;
+
+//*****************************************************************************
+//
+// The function called when a command ends.
+//
+//*****************************************************************************
+typedef void (*tFpRequestCallback)(uint32_t ui32Cmd, uint32_t ui32Result);
+
+//*****************************************************************************
+//
+// Prototypes for the APIs.
+//
+//*****************************************************************************
+extern void FpRequestInit(tFpRequestCallback pfnCallback);
+extern bool FpRequestSend(uint32_t ui32Cmd, const uint8_t *pui8Frame,
+                          uint32_t ui32Len);
+extern bool FpRequestIsBusy(void);
+extern void FpRequestCancel(void);
+extern void FpRequestEventHandler(uint32_t ui32Event);
+extern void FpRequestTick(void);
+extern void FpRequestPolicyGet(uint32_t ui32Cmd, tFpRequestPolicy *psPolicy);
+extern void FpRequestPolicySet(uint32_t ui32Cmd,
+                               const tFpRequestPolicy *psPolicy);
+extern void FpRequestStatsGet(uint32_t ui32Cmd, tFpRequestStats *psStats);
+extern void FpRequestStateInit(tFpRequest *psRequest, uint32_t ui32Base);
+extern bool FpRequestStateSend(tFpRequest *psRequest, uint32_t ui32Cmd,
+                               const uint8_t *pui8Frame, uint32_t ui32Len);
+extern bool FpRequestStateEvent(tFpRequest *psRequest, uint32_t ui32Event);
+extern uint32_t FpRequestStateTick(tFpRequest *psRequest);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __FP_REQUEST_H__
@@ -0,0 +1,531 @@
+//*****************************************************************************
+//
+// fp_sensor.c - Sensors on the other UARTs.
+//
+// A turnstile bank serves several readers from one controller.  The sensor
+// on UART5 is driven by the rest of the application as before; this module
+// runs any number of further sensors, one on each of the other UARTs, side
+// by side.  Each has its own pins, transmit ring, receive ring, parser and
+// outstanding command, so a command can be running on every one of them at
+// once.
+//
+// The receive interrupt of a sensor only copies bytes into its ring and
+// returns true when the event loop must call FpSensorProcess() for it, which
+// feeds the parser.  Should that request be lost, FpSensorTick() also feeds
+// any ring that is not empty, so a sensor is never left unheard.  Each
+// sensor keeps a tFpRequest, which fp_request.c runs with the deadlines and
+// retries of each command; FpSensorTick() counts them down.
+// The sensors run at FP_LINK_DEFAULT_BAUD; the link negotiation is only
+// done on UART5.  Image uploads are not forwarded.
+//
+//*****************************************************************************
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include "inc/hw_gpio.h"
+#include "inc/hw_ints.h"
+#include "inc/hw_memmap.h"
+#include "inc/hw_types.h"
+#include "driverlib/gpio.h"
+#include "driverlib/interrupt.h"
+#include "driverlib/pin_map.h"
+#include "driverlib/rom.h"
+#include "driverlib/rom_map.h"
+#include "driverlib/sysctl.h"
+#include "driverlib/uart.h"
+#include "clock_profile.h"
+#include "fp_command.h"
+#include "fp_parser.h"
+#include "fp_link.h"
+#include "fp_request.h"
+#include "uart_tx.h"
+#include "fp_sensor.h"
+
+//*****************************************************************************
+//
+// The hardware of each sensor, indexed by the UART number minus one.  UART1
+// uses port B so that port C is left for UART3 and UART4.
+//
+//*****************************************************************************
+typedef struct
+{
+    uint32_t ui32Base;
+    uint32_t ui32Periph;
+    uint32_t ui32Int;
+    uint32_t ui32GPIOPeriph;
+    uint32_t ui32GPIOBase;
+    uint32_t ui32Pins;
+    uint32_t ui32RxPin;
+    uint32_t ui32TxPin;
+}
+tFpSensorPort;
+
+static const tFpSensorPort g_psFpSensorPorts[FP_SENSOR_MAX] =
+{
+    { UART1_BASE, SYSCTL_PERIPH_UART1, INT_UART1, SYSCTL_PERIPH_GPIOB,
+      GPIO_PORTB_BASE, GPIO_PIN_0 | GPIO_PIN_1, GPIO_PB0_U1RX, GPIO_PB1_U1TX },
+    { UART2_BASE, SYSCTL_PERIPH_UART2, INT_UART2, SYSCTL_PERIPH_GPIOD,
+      GPIO_PORTD_BASE, GPIO_PIN_6 | GPIO_PIN_7, GPIO_PD6_U2RX, GPIO_PD7_U2TX },
+    { UART3_BASE, SYSCTL_PERIPH_UART3, INT_UART3, SYSCTL_PERIPH_GPIOC,
+      GPIO_PORTC_BASE, GPIO_PIN_6 | GPIO_PIN_7, GPIO_PC6_U3RX, GPIO_PC7_U3TX },
+    { UART4_BASE, SYSCTL_PERIPH_UART4, INT_UART4, SYSCTL_PERIPH_GPIOC,
+      GPIO_PORTC_BASE, GPIO_PIN_4 | GPIO_PIN_5, GPIO_PC4_U4RX, GPIO_PC5_U4TX },
+    { UART5_BASE, SYSCTL_PERIPH_UART5, INT_UART5, SYSCTL_PERIPH_GPIOE,
+      GPIO_PORTE_BASE, GPIO_PIN_4 | GPIO_PIN_5, GPIO_PE4_U5RX, GPIO_PE5_U5TX },
+    { UART6_BASE, SYSCTL_PERIPH_UART6, INT_UART6, SYSCTL_PERIPH_GPIOD,
+      GPIO_PORTD_BASE, GPIO_PIN_4 | GPIO_PIN_5, GPIO_PD4_U6RX, GPIO_PD5_U6TX },
+    { UART7_BASE, SYSCTL_PERIPH_UART7, INT_UART7, SYSCTL_PERIPH_GPIOE,
+      GPIO_PORTE_BASE, GPIO_PIN_0 | GPIO_PIN_1, GPIO_PE0_U7RX, GPIO_PE1_U7TX }
+};
+
+//*****************************************************************************
+//
+// The state of one sensor.
+//
+//*****************************************************************************
+typedef struct
+{
+    //
+    // The sensor number, for the callback.
+    //
+    uint32_t ui32Sensor;
+
+    //
+    // The receive ring.  The interrupt writes the head and the event loop
+    // the tail; both count freely.  bRxPosted is set by the interrupt when
+    // it asks for the ring to be processed and cleared when it is.
+    //
+    uint8_t pui8Rx[FP_SENSOR_RX_SIZE];
+    volatile uint32_t ui32RxHead;
+    volatile uint32_t ui32RxTail;
+    volatile bool bRxPosted;
+
+    //
+    // The parser for the responses.
+    //
+    tFpParser sParser;
+
+    //
+    // The outstanding command.
+    //
+    tFpRequest sRequest;
+
+    tFpSensorStats sStats;
+}
+tFpSensor;
+
+static tFpSensor g_psFpSensors[FP_SENSOR_MAX];
+static uint32_t g_ui32FpSensorPorts;
+static tFpSensorCallback g_pfnFpSensorCallback;
+
+//*****************************************************************************
+//
+// Returns the state of a sensor in use, or 0.
+//
+//*****************************************************************************
+static tFpSensor *
+FpSensorGet(uint32_t ui32Sensor)
+{
+    if((ui32Sensor < 1) || (ui32Sensor > FP_SENSOR_MAX) ||
+       !(g_ui32FpSensorPorts & FP_SENSOR_PORT(ui32Sensor)))
+    {
+        return(0);
+    }
+
+    return(&g_psFpSensors[ui32Sensor - 1]);
+}
+
+//*****************************************************************************
+//
+// Ends the outstanding command.
+//
+//*****************************************************************************
+static void
+FpSensorEnd(tFpSensor *psSensor, uint32_t ui32Result)
+{
+    if(ui32Result == FP_REQUEST_RESULT_OK)
+    {
+        psSensor->sStats.ui32Completed++;
+    }
+    else
+    {
+        psSensor->sStats.ui32Timeouts++;
+    }
+
+    if(g_pfnFpSensorCallback)
+    {
+        g_pfnFpSensorCallback(psSensor->ui32Sensor,
+                              psSensor->sRequest.ui32Cmd, ui32Result,
+                              psSensor->sStats.ui32Event,
+                              psSensor->sStats.ui32Value);
+    }
+}
+
+//*****************************************************************************
+//
+// Handles a response decoded by the parser of a sensor.  This runs from the
+// event loop.
+//
+//*****************************************************************************
+static void
+FpSensorEventHandler(void *pvCBData, const tFpEvent *psEvent)
+{
+    tFpSensor *psSensor;
+
+    psSensor = (tFpSensor *)pvCBData;
+
+    if((psEvent->ui32Type == FP_EVENT_IMAGE_START) ||
+       (psEvent->ui32Type == FP_EVENT_IMAGE_CHUNK))
+    {
+        return;
+    }
+
+    psSensor->sStats.ui32Event = psEvent->ui32Type;
+    psSensor->sStats.ui32Value = psEvent->ui32Value;
+
+    if(FpRequestStateEvent(&psSensor->sRequest, psEvent->ui32Type))
+    {
+        FpSensorEnd(psSensor, FP_REQUEST_RESULT_OK);
+    }
+}
+
+//*****************************************************************************
+//
+//! Sets up the sensors.
+//!
+//! \param ui32Ports is the mask of FP_SENSOR_PORT() bits of the UARTs that
+//! have a sensor.  UART0 and UART5, which the application drives, are
+//! ignored if they are given.
+//! \param pfnCallback is the function told when a command ends.  It is
+//! called from the event loop.
+//!
+//! Each UART is configured for FP_LINK_DEFAULT_BAUD with its transmit ring
+//! and receive interrupts, and kept clocked while the processor sleeps.
+//!
+//! \return None.
+//
+//*****************************************************************************
+void
+FpSensorInit(uint32_t ui32Ports, tFpSensorCallback pfnCallback)
+{
+    const tFpSensorPort *psPort;
+    tFpSensor *psSensor;
+    uint32_t ui32Sensor;
+
+    g_pfnFpSensorCallback = pfnCallback;
+    g_ui32FpSensorPorts = ui32Ports & ~(FP_SENSOR_PORT(0) |
+                                        FP_SENSOR_PORT(5));
+
+    for(ui32Sensor = 1; ui32Sensor <= FP_SENSOR_MAX; ui32Sensor++)
+    {
+        psSensor = FpSensorGet(ui32Sensor);
+        if(!psSensor)
+        {
+            continue;
+        }
+
+        psPort = &g_psFpSensorPorts[ui32Sensor - 1];
+        memset(psSensor, 0, sizeof(*psSensor));
+        psSensor->ui32Sensor = ui32Sensor;
+        FpRequestStateInit(&psSensor->sRequest, psPort->ui32Base);
+        FpParserInit(&psSensor->sParser, FpSensorEventHandler, psSensor);
+
+        MAP_SysCtlPeripheralEnable(psPort->ui32Periph);
+        MAP_SysCtlPeripheralEnable(psPort->ui32GPIOPeriph);
+        MAP_SysCtlPeripheralSleepEnable(psPort->ui32Periph);
+        MAP_SysCtlPeripheralSleepEnable(psPort->ui32GPIOPeriph);
+        MAP_SysCtlPeripheralDeepSleepEnable(psPort->ui32Periph);
+        MAP_SysCtlPeripheralDeepSleepEnable(psPort->ui32GPIOPeriph);
+
+        //
+        // PD7 is an NMI pin and has to be unlocked before it can be given to
+        // UART2.
+        //
+        if(psPort->ui32GPIOBase == GPIO_PORTD_BASE)
+        {
+            HWREG(GPIO_PORTD_BASE + GPIO_O_LOCK) = GPIO_LOCK_KEY;
+            HWREG(GPIO_PORTD_BASE + GPIO_O_CR) |= GPIO_PIN_7;
+            HWREG(GPIO_PORTD_BASE + GPIO_O_LOCK) = 0;
+        }
+
+        GPIOPinConfigure(psPort->ui32RxPin);
+        GPIOPinConfigure(psPort->ui32TxPin);
+        MAP_GPIOPinTypeUART(psPort->ui32GPIOBase, psPort->ui32Pins);
+
+        MAP_UARTConfigSetExpClk(psPort->ui32Base,
+                                ClockUARTFreq(psPort->ui32Base),
+                                FP_LINK_DEFAULT_BAUD,
+                                (UART_CONFIG_WLEN_8 | UART_CONFIG_STOP_ONE |
+                                 UART_CONFIG_PAR_NONE));
+        UARTTxInit(psPort->ui32Base);
+        MAP_UARTIntEnable(psPort->ui32Base, UART_INT_RX | UART_INT_RT);
+        MAP_IntEnable(psPort->ui32Int);
+    }
+}
+
+//*****************************************************************************
+//
+//! Returns the sensors in use.
+//!
+//! \return Returns the mask of FP_SENSOR_PORT() bits given to FpSensorInit().
+//
+//*****************************************************************************
+uint32_t
+FpSensorPortsGet(void)
+{
+    return(g_ui32FpSensorPorts);
+}
+
+//*****************************************************************************
+//
+//! Handles the interrupt of the UART of a sensor.
+//!
+//! \param ui32Sensor is the sensor.
+//!
+//! \return Returns \b true when FpSensorProcess() must be called for the
+//! sensor from the event loop.
+//
+//*****************************************************************************
+bool
+FpSensorIntHandler(uint32_t ui32Sensor)
+{
+    tFpSensor *psSensor;
+    uint32_t ui32Base, ui32Status, ui32Head;
+    uint8_t ui8Char;
+    bool bPost;
+
+    psSensor = FpSensorGet(ui32Sensor);
+    if(!psSensor)
+    {
+        return(false);
+    }
+
+    ui32Base = g_psFpSensorPorts[ui32Sensor - 1].ui32Base;
+    ui32Status = MAP_UARTIntStatus(ui32Base, true);
+    MAP_UARTIntClear(ui32Base, ui32Status);
+
+    bPost = false;
+    if(ui32Status & (UART_INT_RX | UART_INT_RT))
+    {
+        ui32Head = psSensor->ui32RxHead;
+        while(MAP_UARTCharsAvail(ui32Base))
+        {
+            ui8Char = MAP_UARTCharGetNonBlocking(ui32Base);
+            psSensor->sStats.ui32RxBytes++;
+            if((ui32Head - psSensor->ui32RxTail) >= FP_SENSOR_RX_SIZE)
+            {
+                psSensor->sStats.ui32RxDropped++;
+                continue;
+            }
+            psSensor->pui8Rx[ui32Head++ & (FP_SENSOR_RX_SIZE - 1)] = ui8Char;
+        }
+        psSensor->ui32RxHead = ui32Head;
+
+        if(!psSensor->bRxPosted)
+        {
+            psSensor->bRxPosted = true;
+            bPost = true;
+        }
+    }
+
+    if(ui32Status & UART_INT_TX)
+    {
+        UARTTxIntHandler(ui32Base);
+    }
+
+    return(bPost);
+}
+
+//*****************************************************************************
+//
+//! Notes that the request to process a sensor could not be posted.
+//!
+//! \param ui32Sensor is the sensor.
+//!
+//! This is called from the interrupt handler when FpSensorIntHandler()
+//! returned \b true but the event loop had no room for the request, so that
+//! the next interrupt of the sensor asks again.
+//!
+//! \return None.
+//
+//*****************************************************************************
+void
+FpSensorPostFailed(uint32_t ui32Sensor)
+{
+    tFpSensor *psSensor;
+
+    psSensor = FpSensorGet(ui32Sensor);
+    if(psSensor)
+    {
+        psSensor->bRxPosted = false;
+    }
+}
+
+//*****************************************************************************
+//
+//! Parses what a sensor has sent.
+//!
+//! \param ui32Sensor is the sensor.
+//!
+//! This must only be called from the event loop.
+//!
+//! \return None.
+//
+//*****************************************************************************
+void
+FpSensorProcess(uint32_t ui32Sensor)
+{
+    tFpSensor *psSensor;
+    uint32_t ui32Tail, ui32Len;
+
+    psSensor = FpSensorGet(ui32Sensor);
+    if(!psSensor)
+    {
+        return;
+    }
+
+    //
+    // Clear the request first, so that bytes arriving from here on ask
+    // again.
+    //
+    psSensor->bRxPosted = false;
+
+    //
+    // Feed the ring in at most two pieces, up to its end and from its start.
+    //
+    while(psSensor->ui32RxTail != psSensor->ui32RxHead)
+    {
+        ui32Tail = psSensor->ui32RxTail & (FP_SENSOR_RX_SIZE - 1);
+        ui32Len = psSensor->ui32RxHead - psSensor->ui32RxTail;
+        if(ui32Len > (FP_SENSOR_RX_SIZE - ui32Tail))
+        {
+            ui32Len = FP_SENSOR_RX_SIZE - ui32Tail;
+        }
+
+        FpParserFeed(&psSensor->sParser, psSensor->pui8Rx + ui32Tail,
+                     ui32Len);
+        psSensor->ui32RxTail += ui32Len;
+    }
+}
+
+//*****************************************************************************
+//
+//! Sends a command to a sensor.
+//!
+//! \param ui32Sensor is the sensor.
+//! \param ui32Cmd is the FP_CMD_* value of the command.
+//! \param pui8Frame is the encoded command; it is copied.
+//! \param ui32Len is the length of the frame.
+//!
+//! \return Returns \b false if the sensor is not in use, another command is
+//! outstanding on it or the frame is not valid.
+//
+//*****************************************************************************
+bool
+FpSensorSend(uint32_t ui32Sensor, uint32_t ui32Cmd, const uint8_t *pui8Frame,
+             uint32_t ui32Len)
+{
+    tFpSensor *psSensor;
+
+    psSensor = FpSensorGet(ui32Sensor);
+    if(!psSensor ||
+       !FpRequestStateSend(&psSensor->sRequest, ui32Cmd, pui8Frame, ui32Len))
+    {
+        return(false);
+    }
+
+    psSensor->sStats.ui32Sent++;
+
+    return(true);
+}
+
+//*****************************************************************************
+//
+//! Returns whether a command is outstanding on a sensor.
+//!
+//! \param ui32Sensor is the sensor.
+//!
+//! \return Returns \b true from the send of a command until it ends.
+//
+//*****************************************************************************
+bool
+FpSensorIsBusy(uint32_t ui32Sensor)
+{
+    tFpSensor *psSensor;
+
+    psSensor = FpSensorGet(ui32Sensor);
+
+    return(psSensor && psSensor->sRequest.bActive);
+}
+
+//*****************************************************************************
+//
+//! Counts down the deadlines of the outstanding commands.
+//!
+//! Any data a sensor has sent that is still waiting to be parsed, because
+//! the request to process it was lost, is parsed first.  This must be called
+//! every FP_REQUEST_TICK_MS milliseconds from the event loop.
+//!
+//! \return None.
+//
+//*****************************************************************************
+void
+FpSensorTick(void)
+{
+    tFpSensor *psSensor;
+    uint32_t ui32Sensor;
+
+    for(ui32Sensor = 1; ui32Sensor <= FP_SENSOR_MAX; ui32Sensor++)
+    {
+        psSensor = FpSensorGet(ui32Sensor);
+        if(!psSensor)
+        {
+            continue;
+        }
+
+        if(psSensor->ui32RxTail != psSensor->ui32RxHead)
+        {
+            FpSensorProcess(ui32Sensor);
+        }
+
+        switch(FpRequestStateTick(&psSensor->sRequest))
+        {
+        case FP_REQUEST_TICK_RETRY:
+            psSensor->sStats.ui32Retries++;
+            break;
+        case FP_REQUEST_TICK_TIMEOUT:
+            FpSensorEnd(psSensor, FP_REQUEST_RESULT_TIMEOUT);
+            break;
+        default:
+            break;
+        }
+    }
+}
+
+//*****************************************************************************
+//
+//! Returns the statistics of a sensor.
+//!
+//! \param ui32Sensor is the sensor.
+//! \param psStats is a pointer to the structure that is filled in.
+//!
+//! \return None.
+//
+//*****************************************************************************
+void
+FpSensorStatsGet(uint32_t ui32Sensor, tFpSensorStats *psStats)
+{
+    tFpSensor *psSensor;
+
+    psSensor = FpSensorGet(ui32Sensor);
+    if(!psSensor)
+    {
+        memset(psStats, 0, sizeof(*psStats));
+        return;
+    }
+
+    MAP_IntMasterDisable();
+    *psStats = psSensor->sStats;
+    MAP_IntMasterEnable();
+}
@@ -0,0 +1,92 @@
+//*****************************************************************************
+//
+// fp_sensor.h - Prototypes for the sensors on the other UARTs.
+//
+//*****************************************************************************
+
+#ifndef __FP_SENSOR_H__
+#define __FP_SENSOR_H__
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+//*****************************************************************************
+//
+// The sensors are numbered after their UART, 1 to FP_SENSOR_MAX.
+// FpSensorInit() takes the ones to use as a mask of FP_SENSOR_PORT() bits.
+//
+//*****************************************************************************
+#define FP_SENSOR_MAX           7
+#define FP_SENSOR_PORT(n)       (1 << (n))
+
+//*****************************************************************************
+//
+// The size of the receive ring of each sensor, which must be a power of two.
+//
+//*****************************************************************************
+#define FP_SENSOR_RX_SIZE       64
+
+//*****************************************************************************
+//
+// Statistics kept for each sensor.
+//
+//*****************************************************************************
+typedef struct
+{
+    //
+    // The number of commands sent, ended by a response, sent again and
+    // given up on.
+    //
+    uint32_t ui32Sent;
+    uint32_t ui32Completed;
+    uint32_t ui32Retries;
+    uint32_t ui32Timeouts;
+
+    //
+    // The number of bytes received, and lost because the receive ring was
+    // full.
+    //
+    uint32_t ui32RxBytes;
+    uint32_t ui32RxDropped;
+
+    //
+    // The last response, as an FP_EVENT_* type and its value.
+    //
+    uint32_t ui32Event;
+    uint32_t ui32Value;
+}
+tFpSensorStats;
+
+//*****************************************************************************
+//
+// The function called when a command ends.  ui32Result is one of
+// FP_REQUEST_RESULT_*, and ui32Event and ui32Value are the last response.
+//
+//*****************************************************************************
+typedef void (*tFpSensorCallback)(uint32_t ui32Sensor, uint32_t ui32Cmd,
+                                  uint32_t ui32Result, uint32_t ui32Event,
+                                  uint32_t ui32Value);
+
+//*****************************************************************************
+//
+// Prototypes for the APIs.
+//
+//*****************************************************************************
+extern void FpSensorInit(uint32_t ui32Ports, tFpSensorCallback pfnCallback);
+extern uint32_t FpSensorPortsGet(void);
+extern bool FpSensorIntHandler(uint32_t ui32Sensor);
+extern void FpSensorPostFailed(uint32_t ui32Sensor);
+extern void FpSensorProcess(uint32_t ui32Sensor);
+extern bool FpSensorSend(uint32_t ui32Sensor, uint32_t ui32Cmd,
+                         const uint8_t *pui8Frame, uint32_t ui32Len);
+extern bool FpSensorIsBusy(uint32_t ui32Sensor);
+extern void FpSensorTick(void);
+extern void FpSensorStatsGet(uint32_t ui32Sensor, tFpSensorStats *psStats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __FP_SENSOR_H__
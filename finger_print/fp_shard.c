@@ -0,0 +1,653 @@
+//*****************************************************************************
+//
+// fp_shard.c - Identification across several sensors.
+//
+// A sensor holds at most 24 fingerprints.  To hold more, identities are
+// spread over all the attached sensors and numbered globally; a map kept in
+// EEPROM gives the sensor and slot of each global ID.  A new identity goes
+// to the sensor with the most free slots, so they fill evenly.
+//
+// To identify a finger, CompareFingerprint is sent to every sensor that
+// holds an identity at once, and the first PASS_n is looked up in the map.
+// The sensors compare side by side, so the time to a match does not grow
+// with their number.  The operation stays busy until every sensor has
+// answered, so no command is sent to one that is still comparing.
+//
+// The sensors in the shard must only be enrolled and cleared through here,
+// or the map no longer matches them; the slot cache of the main sensor is
+// kept up to date as they are.  The map is written to the older of two
+// EEPROM banks with a sequence number and a CRC, as the configuration store
+// does, so a write cut short leaves the previous map in place.  The write
+// goes through ConfigBlockWrite(), so the event loop never waits for the
+// EEPROM; if the writer is taken, FpShardTick() tries again.
+//
+//*****************************************************************************
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include "driverlib/eeprom.h"
+#include "driverlib/rom.h"
+#include "driverlib/rom_map.h"
+#include "config.h"
+#include "crc_ctx.h"
+#include "fp_command.h"
+#include "fp_flow.h"
+#include "fp_parser.h"
+#include "fp_request.h"
+#include "fp_sensor.h"
+#include "fp_slots.h"
+#include "fp_shard.h"
+
+//*****************************************************************************
+//
+// The map holds a byte for each global ID: the sensor in the top three bits
+// and the slot in the low five, or FP_SHARD_FREE.
+//
+//*****************************************************************************
+#define FP_SHARD_FREE           0xFF
+#define FP_SHARD_ENTRY(s, n)    (((s) << 5) | (n))
+#define FP_SHARD_SENSOR(e)      ((e) >> 5)
+#define FP_SHARD_SLOT(e)        ((e) & 0x1F)
+
+//*****************************************************************************
+//
+// A record is a header with a marker and the number of map words, a
+// sequence number, the map and a CRC-32 of the lot.
+//
+//*****************************************************************************
+#define FP_SHARD_MARKER         0x5348
+#define FP_SHARD_MAP_WORDS      ((FP_SHARD_MAX_IDS + 3) / 4)
+#define FP_SHARD_RECORD_WORDS   (FP_SHARD_MAP_WORDS + 3)
+
+#define FpShardBankAddr(b)      (FP_SHARD_EEPROM_ADDR +                       \
+                                 ((b) * FP_SHARD_BANK_SIZE))
+
+//*****************************************************************************
+//
+// The map, with the bank holding the newest record and its sequence number.
+//
+//*****************************************************************************
+static union
+{
+    uint32_t pui32Words[FP_SHARD_RECORD_WORDS];
+    struct
+    {
+        uint32_t ui32Header;
+        uint32_t ui32Seq;
+        uint8_t pui8Map[FP_SHARD_MAP_WORDS * 4];
+        uint32_t ui32Crc;
+    }
+    sRecord;
+}
+g_uFpShard;
+
+static uint32_t g_ui32FpShardBank;
+static bool g_bFpShardDirty;
+
+//*****************************************************************************
+//
+// The sensors in the shard, and the running operation: its type, the
+// sensors still to answer, and the ID and slot it is about.
+//
+//*****************************************************************************
+static uint32_t g_ui32FpShardSensors;
+static bool g_bFpShardBusy;
+static bool g_bFpShardResolved;
+static uint32_t g_ui32FpShardOp;
+static uint32_t g_ui32FpShardPending;
+static uint32_t g_ui32FpShardTimeouts;
+static uint32_t g_ui32FpShardId;
+static uint32_t g_ui32FpShardSensor;
+static uint32_t g_ui32FpShardSlot;
+static tFpShardCallback g_pfnFpShardCallback;
+
+#define g_pui8FpShardMap        (g_uFpShard.sRecord.pui8Map)
+
+//*****************************************************************************
+//
+// Returns the CRC of a record, uninverted as for the configuration.
+//
+//*****************************************************************************
+static uint32_t
+FpShardCrc(void)
+{
+    return(CrcCtxBlock(CRC_CTX_CRC32, (const uint8_t *)g_uFpShard.pui32Words,
+                       (FP_SHARD_RECORD_WORDS - 1) * 4) ^ 0xFFFFFFFF);
+}
+
+//*****************************************************************************
+//
+// Reads a bank.  Returns false, with the map in an unknown state, if it does
+// not hold a valid record.
+//
+//*****************************************************************************
+static bool
+FpShardBankRead(uint32_t ui32Bank)
+{
+    MAP_EEPROMRead(g_uFpShard.pui32Words, FpShardBankAddr(ui32Bank),
+                   sizeof(g_uFpShard.pui32Words));
+
+    return((g_uFpShard.sRecord.ui32Header ==
+            ((FP_SHARD_MARKER << 16) | FP_SHARD_MAP_WORDS)) &&
+           (g_uFpShard.sRecord.ui32Crc == FpShardCrc()));
+}
+
+//*****************************************************************************
+//
+// Hands the map to the EEPROM writer for the older bank.  If the writer is
+// still taken, the sequence number is left as it was and the map stays
+// dirty.
+//
+//*****************************************************************************
+static void
+FpShardWrite(void)
+{
+    g_uFpShard.sRecord.ui32Header = (FP_SHARD_MARKER << 16) |
+                                    FP_SHARD_MAP_WORDS;
+    g_uFpShard.sRecord.ui32Seq++;
+    g_uFpShard.sRecord.ui32Crc = FpShardCrc();
+
+    if(!ConfigBlockWrite(g_uFpShard.pui32Words,
+                         FpShardBankAddr(g_ui32FpShardBank ^ 1),
+                         FP_SHARD_RECORD_WORDS))
+    {
+        g_uFpShard.sRecord.ui32Seq--;
+        return;
+    }
+
+    g_ui32FpShardBank ^= 1;
+    g_bFpShardDirty = false;
+}
+
+//*****************************************************************************
+//
+// Writes the map, now or from FpShardTick().
+//
+//*****************************************************************************
+static void
+FpShardSave(void)
+{
+    g_bFpShardDirty = true;
+    FpShardWrite();
+}
+
+//*****************************************************************************
+//
+// Sends a command to a sensor, through fp_request.c for the main one.
+//
+//*****************************************************************************
+static bool
+FpShardSend(uint32_t ui32Sensor, uint32_t ui32Cmd, const uint8_t *pui8Frame,
+            uint32_t ui32Len)
+{
+    if(ui32Sensor == FP_SHARD_MAIN)
+    {
+        return(!FpFlowIsBusy() && FpRequestSend(ui32Cmd, pui8Frame, ui32Len));
+    }
+
+    return(FpSensorSend(ui32Sensor, ui32Cmd, pui8Frame, ui32Len));
+}
+
+//*****************************************************************************
+//
+// Returns the global ID stored in a slot of a sensor, or FP_SHARD_MAX_IDS.
+//
+//*****************************************************************************
+static uint32_t
+FpShardFind(uint32_t ui32Sensor, uint32_t ui32Slot)
+{
+    uint32_t ui32Id;
+
+    for(ui32Id = 0; ui32Id < FP_SHARD_MAX_IDS; ui32Id++)
+    {
+        if(g_pui8FpShardMap[ui32Id] == FP_SHARD_ENTRY(ui32Sensor, ui32Slot))
+        {
+            break;
+        }
+    }
+
+    return(ui32Id);
+}
+
+//*****************************************************************************
+//
+// Ends the running operation.
+//
+//*****************************************************************************
+static void
+FpShardDone(uint32_t ui32Result)
+{
+    if(g_pfnFpShardCallback)
+    {
+        g_pfnFpShardCallback(g_ui32FpShardOp, ui32Result, g_ui32FpShardId,
+                             g_ui32FpShardSensor, g_ui32FpShardSlot);
+    }
+}
+
+//*****************************************************************************
+//
+//! Loads the ID map.
+//!
+//! \param ui32Sensors is the mask of FP_SENSOR_PORT() bits of the sensors in
+//! the shard, including FP_SHARD_MAIN.
+//! \param pfnCallback is the function told when an operation ends.  It is
+//! called from the event loop.
+//!
+//! ConfigInit() must have been called, which starts the EEPROM.  If neither
+//! bank holds a valid map, the map starts empty.
+//!
+//! \return None.
+//
+//*****************************************************************************
+void
+FpShardInit(uint32_t ui32Sensors, tFpShardCallback pfnCallback)
+{
+    uint32_t ui32Seq;
+    bool bValid;
+
+    g_ui32FpShardSensors = ui32Sensors & (FP_SENSOR_PORT(FP_SENSOR_MAX + 1) -
+                                          FP_SENSOR_PORT(1));
+    g_pfnFpShardCallback = pfnCallback;
+    g_bFpShardBusy = false;
+    g_bFpShardDirty = false;
+
+    //
+    // Take the bank with the newer valid record, reading it last so that it
+    // is the one left in the buffer.
+    //
+    bValid = FpShardBankRead(0);
+    ui32Seq = g_uFpShard.sRecord.ui32Seq;
+    if(FpShardBankRead(1) &&
+       (!bValid || ((int32_t)(g_uFpShard.sRecord.ui32Seq - ui32Seq) > 0)))
+    {
+        g_ui32FpShardBank = 1;
+        return;
+    }
+
+    if(bValid && FpShardBankRead(0))
+    {
+        g_ui32FpShardBank = 0;
+        return;
+    }
+
+    //
+    // Start empty; the first save goes to bank 0.
+    //
+    memset(&g_uFpShard, 0, sizeof(g_uFpShard));
+    memset(g_pui8FpShardMap, FP_SHARD_FREE, sizeof(g_pui8FpShardMap));
+    g_ui32FpShardBank = 1;
+}
+
+//*****************************************************************************
+//
+//! Enrolls a new identity on the sensor with the most free slots.
+//!
+//! \return Returns \b false if an operation is running, every slot is taken
+//! or the sensor chosen is busy.
+//
+//*****************************************************************************
+bool
+FpShardEnroll(void)
+{
+    uint8_t pui8Frame[FP_COMMAND_BUF_SIZE];
+    uint32_t pui32Used[FP_SENSOR_MAX + 1];
+    uint32_t ui32Id, ui32Sensor, ui32Slot, ui32Free;
+
+    if(g_bFpShardBusy)
+    {
+        return(false);
+    }
+
+    //
+    // Count the slots taken on each sensor and find a free ID.
+    //
+    memset(pui32Used, 0, sizeof(pui32Used));
+    g_ui32FpShardId = FP_SHARD_MAX_IDS;
+    for(ui32Id = 0; ui32Id < FP_SHARD_MAX_IDS; ui32Id++)
+    {
+        if(g_pui8FpShardMap[ui32Id] == FP_SHARD_FREE)
+        {
+            if(g_ui32FpShardId == FP_SHARD_MAX_IDS)
+            {
+                g_ui32FpShardId = ui32Id;
+            }
+            continue;
+        }
+        pui32Used[FP_SHARD_SENSOR(g_pui8FpShardMap[ui32Id])]++;
+    }
+
+    ui32Free = 0;
+    g_ui32FpShardSensor = 0;
+    for(ui32Sensor = 1; ui32Sensor <= FP_SENSOR_MAX; ui32Sensor++)
+    {
+        if((g_ui32FpShardSensors & FP_SENSOR_PORT(ui32Sensor)) &&
+           ((FP_SHARD_SLOTS - pui32Used[ui32Sensor]) > ui32Free))
+        {
+            ui32Free = FP_SHARD_SLOTS - pui32Used[ui32Sensor];
+            g_ui32FpShardSensor = ui32Sensor;
+        }
+    }
+    if(!ui32Free || (g_ui32FpShardId == FP_SHARD_MAX_IDS))
+    {
+        return(false);
+    }
+
+    //
+    // Take the first slot of that sensor not in the map.  On the main sensor
+    // skip the slots the cache knows are used by registrations from the
+    // menu.
+    //
+    for(ui32Slot = 0; ui32Slot < FP_SHARD_SLOTS; ui32Slot++)
+    {
+        if((FpShardFind(g_ui32FpShardSensor, ui32Slot) == FP_SHARD_MAX_IDS) &&
+           !((g_ui32FpShardSensor == FP_SHARD_MAIN) && FpSlotsIsKnown() &&
+             FpSlotsIsUsed(ui32Slot)))
+        {
+            break;
+        }
+    }
+    if(ui32Slot == FP_SHARD_SLOTS)
+    {
+        return(false);
+    }
+    g_ui32FpShardSlot = ui32Slot;
+
+    if(!FpShardSend(g_ui32FpShardSensor, FP_CMD_REGISTER_ONE_FP, pui8Frame,
+                    FpCommandEncodeNum(FP_CMD_REGISTER_ONE_FP, ui32Slot,
+                                       pui8Frame, sizeof(pui8Frame))))
+    {
+        return(false);
+    }
+
+    g_ui32FpShardOp = FP_SHARD_ENROLL;
+    g_ui32FpShardPending = FP_SENSOR_PORT(g_ui32FpShardSensor);
+    g_bFpShardBusy = true;
+
+    return(true);
+}
+
+//*****************************************************************************
+//
+//! Identifies a finger on all the sensors at once.
+//!
+//! \return Returns \b false if an operation is running, nothing is enrolled
+//! or every sensor holding an identity is busy.
+//
+//*****************************************************************************
+bool
+FpShardIdentify(void)
+{
+    uint8_t pui8Frame[FP_COMMAND_BUF_SIZE];
+    uint32_t ui32Id, ui32Sensors, ui32Sensor, ui32Len;
+
+    if(g_bFpShardBusy)
+    {
+        return(false);
+    }
+
+    ui32Sensors = 0;
+    for(ui32Id = 0; ui32Id < FP_SHARD_MAX_IDS; ui32Id++)
+    {
+        if(g_pui8FpShardMap[ui32Id] != FP_SHARD_FREE)
+        {
+            ui32Sensors |= FP_SENSOR_PORT(
+                FP_SHARD_SENSOR(g_pui8FpShardMap[ui32Id]));
+        }
+    }
+
+    ui32Len = FpCommandEncode(FP_CMD_COMPARE_FINGERPRINT, pui8Frame,
+                              sizeof(pui8Frame));
+    g_ui32FpShardPending = 0;
+    for(ui32Sensor = 1; ui32Sensor <= FP_SENSOR_MAX; ui32Sensor++)
+    {
+        if((ui32Sensors & g_ui32FpShardSensors & FP_SENSOR_PORT(ui32Sensor)) &&
+           FpShardSend(ui32Sensor, FP_CMD_COMPARE_FINGERPRINT, pui8Frame,
+                       ui32Len))
+        {
+            g_ui32FpShardPending |= FP_SENSOR_PORT(ui32Sensor);
+        }
+    }
+    if(!g_ui32FpShardPending)
+    {
+        return(false);
+    }
+
+    g_ui32FpShardOp = FP_SHARD_IDENTIFY;
+    g_ui32FpShardId = FP_SHARD_MAX_IDS;
+    g_ui32FpShardSensor = 0;
+    g_ui32FpShardSlot = 0;
+    g_ui32FpShardTimeouts = 0;
+    g_bFpShardResolved = false;
+    g_bFpShardBusy = true;
+
+    return(true);
+}
+
+//*****************************************************************************
+//
+//! Deletes an identity from its sensor and from the map.
+//!
+//! \param ui32Id is the global ID.
+//!
+//! \return Returns \b false if an operation is running, the ID is not
+//! enrolled or its sensor is busy.
+//
+//*****************************************************************************
+bool
+FpShardDelete(uint32_t ui32Id)
+{
+    uint8_t pui8Frame[FP_COMMAND_BUF_SIZE];
+
+    if(g_bFpShardBusy ||
+       !FpShardLookup(ui32Id, &g_ui32FpShardSensor, &g_ui32FpShardSlot) ||
+       !FpShardSend(g_ui32FpShardSensor, FP_CMD_CLEAR_ONE_FP, pui8Frame,
+                    FpCommandEncodeNum(FP_CMD_CLEAR_ONE_FP, g_ui32FpShardSlot,
+                                       pui8Frame, sizeof(pui8Frame))))
+    {
+        return(false);
+    }
+
+    g_ui32FpShardOp = FP_SHARD_DELETE;
+    g_ui32FpShardId = ui32Id;
+    g_ui32FpShardPending = FP_SENSOR_PORT(g_ui32FpShardSensor);
+    g_bFpShardBusy = true;
+
+    return(true);
+}
+
+//*****************************************************************************
+//
+//! Returns whether an operation is running.
+//!
+//! \return Returns \b true until every sensor it used has answered.
+//
+//*****************************************************************************
+bool
+FpShardIsBusy(void)
+{
+    return(g_bFpShardBusy);
+}
+
+//*****************************************************************************
+//
+//! Takes the end of a command on a sensor.
+//!
+//! \param ui32Sensor is the sensor.
+//! \param ui32Cmd is the command that ended.
+//! \param ui32Result is one of FP_REQUEST_RESULT_*.
+//! \param ui32Event is the FP_EVENT_* type of the last response.
+//! \param ui32Value is the value of the last response.
+//!
+//! This is called with the end of every command on a sensor in the shard.
+//!
+//! \return Returns \b true if the command belonged to the running operation.
+//
+//*****************************************************************************
+bool
+FpShardCommandEnded(uint32_t ui32Sensor, uint32_t ui32Cmd,
+                    uint32_t ui32Result, uint32_t ui32Event,
+                    uint32_t ui32Value)
+{
+    uint32_t ui32Outcome;
+
+    if(!g_bFpShardBusy || (ui32Sensor < 1) || (ui32Sensor > FP_SENSOR_MAX) ||
+       !(g_ui32FpShardPending & FP_SENSOR_PORT(ui32Sensor)))
+    {
+        return(false);
+    }
+
+    g_ui32FpShardPending &= ~FP_SENSOR_PORT(ui32Sensor);
+
+    if(ui32Result == FP_REQUEST_RESULT_TIMEOUT)
+    {
+        ui32Outcome = FP_FLOW_RESULT_TIMEOUT;
+    }
+    else if(ui32Event == FP_EVENT_NG)
+    {
+        ui32Outcome = FP_FLOW_RESULT_NG;
+    }
+    else if((ui32Event == FP_EVENT_OK) || (ui32Event == FP_EVENT_FINISHED) ||
+            (ui32Event == FP_EVENT_PASS))
+    {
+        ui32Outcome = FP_FLOW_RESULT_OK;
+    }
+    else
+    {
+        ui32Outcome = FP_FLOW_RESULT_FAIL;
+    }
+
+    switch(g_ui32FpShardOp)
+    {
+    case FP_SHARD_ENROLL:
+        if(ui32Outcome == FP_FLOW_RESULT_OK)
+        {
+            g_pui8FpShardMap[g_ui32FpShardId] =
+                FP_SHARD_ENTRY(g_ui32FpShardSensor, g_ui32FpShardSlot);
+            FpShardSave();
+            if(g_ui32FpShardSensor == FP_SHARD_MAIN)
+            {
+                FpSlotsSet(g_ui32FpShardSlot, true);
+            }
+        }
+        g_bFpShardBusy = false;
+        FpShardDone(ui32Outcome);
+        break;
+    case FP_SHARD_DELETE:
+        if(ui32Outcome == FP_FLOW_RESULT_OK)
+        {
+            g_pui8FpShardMap[g_ui32FpShardId] = FP_SHARD_FREE;
+            FpShardSave();
+            if(g_ui32FpShardSensor == FP_SHARD_MAIN)
+            {
+                FpSlotsSet(g_ui32FpShardSlot, false);
+            }
+        }
+        g_bFpShardBusy = false;
+        FpShardDone(ui32Outcome);
+        break;
+    case FP_SHARD_IDENTIFY:
+        if(ui32Outcome == FP_FLOW_RESULT_TIMEOUT)
+        {
+            g_ui32FpShardTimeouts++;
+        }
+
+        //
+        // The first match that is in the map ends the identification.  A
+        // PASS without an index, or for a slot not in the map, is no match.
+        //
+        if(!g_bFpShardResolved && (ui32Event == FP_EVENT_PASS) &&
+           (ui32Result == FP_REQUEST_RESULT_OK) &&
+           (ui32Value < FP_SHARD_SLOTS) &&
+           (FpShardFind(ui32Sensor, ui32Value) != FP_SHARD_MAX_IDS))
+        {
+            g_ui32FpShardId = FpShardFind(ui32Sensor, ui32Value);
+            g_ui32FpShardSensor = ui32Sensor;
+            g_ui32FpShardSlot = ui32Value;
+            g_bFpShardResolved = true;
+            FpShardDone(FP_FLOW_RESULT_OK);
+        }
+
+        if(!g_ui32FpShardPending)
+        {
+            g_bFpShardBusy = false;
+            if(!g_bFpShardResolved)
+            {
+                FpShardDone(g_ui32FpShardTimeouts ? FP_FLOW_RESULT_TIMEOUT :
+                                                    FP_FLOW_RESULT_FAIL);
+            }
+        }
+        break;
+    default:
+        break;
+    }
+
+    return(true);
+}
+
+//*****************************************************************************
+//
+//! Returns where an identity is stored.
+//!
+//! \param ui32Id is the global ID.
+//! \param pui32Sensor receives the sensor.
+//! \param pui32Slot receives the slot on the sensor.
+//!
+//! \return Returns \b false if the ID is not enrolled.
+//
+//*****************************************************************************
+bool
+FpShardLookup(uint32_t ui32Id, uint32_t *pui32Sensor, uint32_t *pui32Slot)
+{
+    if((ui32Id >= FP_SHARD_MAX_IDS) ||
+       (g_pui8FpShardMap[ui32Id] == FP_SHARD_FREE))
+    {
+        return(false);
+    }
+
+    *pui32Sensor = FP_SHARD_SENSOR(g_pui8FpShardMap[ui32Id]);
+    *pui32Slot = FP_SHARD_SLOT(g_pui8FpShardMap[ui32Id]);
+
+    return(true);
+}
+
+//*****************************************************************************
+//
+//! Returns the number of identities enrolled.
+//!
+//! \return Returns the number of IDs in the map.
+//
+//*****************************************************************************
+uint32_t
+FpShardCount(void)
+{
+    uint32_t ui32Id, ui32Count;
+
+    for(ui32Id = 0, ui32Count = 0; ui32Id < FP_SHARD_MAX_IDS; ui32Id++)
+    {
+        if(g_pui8FpShardMap[ui32Id] != FP_SHARD_FREE)
+        {
+            ui32Count++;
+        }
+    }
+
+    return(ui32Count);
+}
+
+//*****************************************************************************
+//
+//! Writes the map if it changed while the EEPROM writer was taken.
+//!
+//! This must be called every CONFIG_TICK_MS, after ConfigTick().
+//!
+//! \return None.
+//
+//*****************************************************************************
+void
+FpShardTick(void)
+{
+    if(g_bFpShardDirty)
+    {
+        FpShardWrite();
+    }
+}
@@ -0,0 +1,76 @@
+//*****************************************************************************
+//
+// fp_shard.h - Prototypes for identification across several sensors.
+//
+//*****************************************************************************
+
+#ifndef __FP_SHARD_H__
+#define __FP_SHARD_H__
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+//*****************************************************************************
+//
+// The sensors are numbered after their UART, as in fp_sensor.h; the main
+// sensor is on UART5.  Each holds FP_SHARD_SLOTS fingerprints.
+//
+//*****************************************************************************
+#define FP_SHARD_MAIN           5
+#define FP_SHARD_SLOTS          24
+#define FP_SHARD_MAX_IDS        (FP_SENSOR_MAX * FP_SHARD_SLOTS)
+
+//*****************************************************************************
+//
+// The EEPROM location of the ID map, after the configuration store.  It
+// takes two banks, written in turn.
+//
+//*****************************************************************************
+#define FP_SHARD_EEPROM_ADDR    0x0100
+#define FP_SHARD_BANK_SIZE      0x0100
+
+//*****************************************************************************
+//
+// The operations.  They end with one of the FP_FLOW_RESULT_* values;
+// FP_FLOW_RESULT_FAIL from FP_SHARD_IDENTIFY means no sensor matched.
+//
+//*****************************************************************************
+#define FP_SHARD_ENROLL         0
+#define FP_SHARD_IDENTIFY       1
+#define FP_SHARD_DELETE         2
+
+//*****************************************************************************
+//
+// The function called when an operation ends, with the global ID and where
+// it is stored.
+//
+//*****************************************************************************
+typedef void (*tFpShardCallback)(uint32_t ui32Op, uint32_t ui32Result,
+                                 uint32_t ui32Id, uint32_t ui32Sensor,
+                                 uint32_t ui32Slot);
+
+//*****************************************************************************
+//
+// Prototypes for the APIs.
+//
+//*****************************************************************************
+extern void FpShardInit(uint32_t ui32Sensors, tFpShardCallback pfnCallback);
+extern bool FpShardEnroll(void);
+extern bool FpShardIdentify(void);
+extern bool FpShardDelete(uint32_t ui32Id);
+extern bool FpShardIsBusy(void);
+extern bool FpShardCommandEnded(uint32_t ui32Sensor, uint32_t ui32Cmd,
+                                uint32_t ui32Result, uint32_t ui32Event,
+                                uint32_t ui32Value);
+extern bool FpShardLookup(uint32_t ui32Id, uint32_t *pui32Sensor,
+                          uint32_t *pui32Slot);
+extern uint32_t FpShardCount(void);
+extern void FpShardTick(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __FP_SHARD_H__
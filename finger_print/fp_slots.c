@@ -0,0 +1,257 @@
+//*****************************************************************************
+//
+// fp_slots.c - Slot occupancy cache.
+//
+// The sensor can only say how many of its slots hold a fingerprint, and
+// asking costs a round trip.  The cache keeps a bitmap of the used slots
+// instead, updated from the outcome of every registration, clear and
+// compare, so the count and the free slots are known without asking.  A
+// clear that fails, because the slot held nothing, frees the slot as well.
+// The bitmap is kept in the configuration store, so it survives a reset.
+//
+// Fingerprints can be registered or cleared without the firmware seeing it,
+// for example by another host on the sensor's USB port, so the cache is
+// checked against the count the sensor reports whenever one is seen.  If
+// the two disagree the cache is marked unknown and queries go back to the
+// sensor until the used slots can be told again: a count of none or all of
+// them, or a clear of every slot.
+//
+//*****************************************************************************
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "config.h"
+#include "fp_slots.h"
+
+//*****************************************************************************
+//
+// The bits of the cache word: one per slot, and one that is set while the
+// cache is known to match the sensor.
+//
+//*****************************************************************************
+#define FP_SLOTS_ALL            ((1 << FP_SLOTS_NUM) - 1)
+#define FP_SLOTS_KNOWN          0x80000000
+
+//*****************************************************************************
+//
+// The cache word.
+//
+//*****************************************************************************
+static uint32_t g_ui32SlotsMap;
+
+//*****************************************************************************
+//
+// Changes the cache word and stores it.
+//
+//*****************************************************************************
+static void
+FpSlotsStore(uint32_t ui32Map)
+{
+    g_ui32SlotsMap = ui32Map;
+    ConfigNumSet(CONFIG_SLOTS, ui32Map);
+}
+
+//*****************************************************************************
+//
+// Returns the number of bits set in a word.
+//
+//*****************************************************************************
+static uint32_t
+FpSlotsBits(uint32_t ui32Map)
+{
+    uint32_t ui32Count;
+
+    for(ui32Count = 0; ui32Map; ui32Count++)
+    {
+        ui32Map &= ui32Map - 1;
+    }
+
+    return(ui32Count);
+}
+
+//*****************************************************************************
+//
+//! Loads the cache from the configuration store.
+//!
+//! The store must have been initialized.  A cache that was never stored
+//! starts unknown.
+//!
+//! \return None.
+//
+//*****************************************************************************
+void
+FpSlotsInit(void)
+{
+    g_ui32SlotsMap = ConfigNumGet(CONFIG_SLOTS);
+}
+
+//*****************************************************************************
+//
+//! Restores the cache from a word returned by FpSlotsMapGet().
+//!
+//! \param ui32Map is the word, kept for example over a standby.
+//!
+//! \return None.
+//
+//*****************************************************************************
+void
+FpSlotsRestore(uint32_t ui32Map)
+{
+    FpSlotsStore(ui32Map & (FP_SLOTS_KNOWN | FP_SLOTS_ALL));
+}
+
+//*****************************************************************************
+//
+//! Returns the whole cache as a word.
+//!
+//! \return Returns a word that can be passed back to FpSlotsRestore().
+//
+//*****************************************************************************
+uint32_t
+FpSlotsMapGet(void)
+{
+    return(g_ui32SlotsMap);
+}
+
+//*****************************************************************************
+//
+//! Returns whether the cache is known to match the sensor.
+//!
+//! \return Returns \b false if the other queries may be wrong, in which case
+//! the sensor has to be asked.
+//
+//*****************************************************************************
+bool
+FpSlotsIsKnown(void)
+{
+    return((g_ui32SlotsMap & FP_SLOTS_KNOWN) ? true : false);
+}
+
+//*****************************************************************************
+//
+//! Returns whether a slot holds a fingerprint.
+//!
+//! \param ui32Slot is the slot.
+//!
+//! \return Returns \b true if the slot is used.
+//
+//*****************************************************************************
+bool
+FpSlotsIsUsed(uint32_t ui32Slot)
+{
+    if(ui32Slot >= FP_SLOTS_NUM)
+    {
+        return(false);
+    }
+
+    return((g_ui32SlotsMap & (1 << ui32Slot)) ? true : false);
+}
+
+//*****************************************************************************
+//
+//! Returns the number of slots that hold a fingerprint.
+//!
+//! \return Returns the number of used slots.
+//
+//*****************************************************************************
+uint32_t
+FpSlotsCount(void)
+{
+    return(FpSlotsBits(g_ui32SlotsMap & FP_SLOTS_ALL));
+}
+
+//*****************************************************************************
+//
+//! Returns the lowest slot that does not hold a fingerprint.
+//!
+//! \return Returns the slot, or FP_SLOTS_NONE if every slot is used.
+//
+//*****************************************************************************
+uint32_t
+FpSlotsNextFree(void)
+{
+    uint32_t ui32Free;
+
+    ui32Free = ~g_ui32SlotsMap & FP_SLOTS_ALL;
+    if(!ui32Free)
+    {
+        return(FP_SLOTS_NONE);
+    }
+
+    //
+    // The lowest set bit is the only one left when the others are cleared.
+    //
+    return(FpSlotsBits((ui32Free & (0 - ui32Free)) - 1));
+}
+
+//*****************************************************************************
+//
+//! Records that a slot was registered or cleared.
+//!
+//! \param ui32Slot is the slot.
+//! \param bUsed is \b true if the slot now holds a fingerprint.
+//!
+//! \return None.
+//
+//*****************************************************************************
+void
+FpSlotsSet(uint32_t ui32Slot, bool bUsed)
+{
+    if(ui32Slot >= FP_SLOTS_NUM)
+    {
+        return;
+    }
+
+    if(bUsed)
+    {
+        FpSlotsStore(g_ui32SlotsMap | (1 << ui32Slot));
+    }
+    else
+    {
+        FpSlotsStore(g_ui32SlotsMap & ~(1 << ui32Slot));
+    }
+}
+
+//*****************************************************************************
+//
+//! Records that every slot was cleared.
+//!
+//! \return None.
+//
+//*****************************************************************************
+void
+FpSlotsClear(void)
+{
+    FpSlotsStore(FP_SLOTS_KNOWN);
+}
+
+//*****************************************************************************
+//
+//! Checks the cache against the count reported by the sensor.
+//!
+//! \param ui32Count is the number of used slots the sensor reported.
+//!
+//! A count above FP_SLOTS_NUM cannot be right, so the cache is then left
+//! unknown rather than marking every slot used.
+//!
+//! \return Returns \b true if the cache matches the sensor afterwards.
+//
+//*****************************************************************************
+bool
+FpSlotsSync(uint32_t ui32Count)
+{
+    if(ui32Count == 0)
+    {
+        FpSlotsStore(FP_SLOTS_KNOWN);
+    }
+    else if(ui32Count == FP_SLOTS_NUM)
+    {
+        FpSlotsStore(FP_SLOTS_KNOWN | FP_SLOTS_ALL);
+    }
+    else if((ui32Count > FP_SLOTS_NUM) || (ui32Count != FpSlotsCount()))
+    {
+        FpSlotsStore(g_ui32SlotsMap & ~FP_SLOTS_KNOWN);
+    }
+
+    return(FpSlotsIsKnown());
+}
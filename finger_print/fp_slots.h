@@ -0,0 +1,44 @@
+//*****************************************************************************
+//
+// fp_slots.h - Prototypes for the slot occupancy cache.
+//
+//*****************************************************************************
+
+#ifndef __FP_SLOTS_H__
+#define __FP_SLOTS_H__
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+//*****************************************************************************
+//
+// The number of fingerprint slots in the sensor, and the value returned when
+// no slot is free.
+//
+//*****************************************************************************
+#define FP_SLOTS_NUM            24
+#define FP_SLOTS_NONE           0xFFFFFFFF
+
+//*****************************************************************************
+//
+// Prototypes for the APIs.
+//
+//*****************************************************************************
+extern void FpSlotsInit(void);
+extern void FpSlotsRestore(uint32_t ui32Map);
+extern uint32_t FpSlotsMapGet(void);
+extern bool FpSlotsIsKnown(void);
+extern bool FpSlotsIsUsed(uint32_t ui32Slot);
+extern uint32_t FpSlotsCount(void);
+extern uint32_t FpSlotsNextFree(void);
+extern void FpSlotsSet(uint32_t ui32Slot, bool bUsed);
+extern void FpSlotsClear(void);
+extern bool FpSlotsSync(uint32_t ui32Count);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __FP_SLOTS_H__
@@ -0,0 +1,256 @@
+//*****************************************************************************
+//
+// host_proto.c - Binary host protocol.
+//
+// The menu on the console is meant for people.  Host software can switch
+// the console to this protocol instead, where every message is a frame:
+//
+//     type | sequence | payload | CRC-16 (LSB first)
+//
+// encoded with COBS and ended by a zero byte.  The CRC is the CRC_CTX_CRC16
+// of crc_ctx.c over the type, sequence and payload.  A frame that fails to
+// decode or fails its CRC is dropped and the receiver picks up again at the
+// next zero, so the host only has to retry the request.
+//
+// The UART0 interrupt passes each byte to HostProtoRxByte(), which collects
+// frames into a small ring without decoding them, so a host can send several
+// requests back to back.  HostProtoProcess() then decodes and handles them
+// from the event loop.
+//
+//*****************************************************************************
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "driverlib/interrupt.h"
+#include "driverlib/rom.h"
+#include "driverlib/rom_map.h"
+#include "console.h"
+#include "cobs.h"
+#include "crc_ctx.h"
+#include "host_proto.h"
+
+//*****************************************************************************
+//
+// The sizes of a frame before and after encoding.
+//
+//*****************************************************************************
+#define HOST_FRAME_SIZE         (HOST_PROTO_MAX_PAYLOAD + 4)
+#define HOST_ENCODED_SIZE       COBS_ENCODED_SIZE(HOST_FRAME_SIZE)
+
+//*****************************************************************************
+//
+// The received frames.  The interrupt fills the frame at the head and the
+// event loop handles the one at the tail; both count freely.  A frame that
+// is too long or has no room is discarded up to its delimiter.
+//
+//*****************************************************************************
+static uint8_t g_ppui8HostRxFrame[HOST_PROTO_RX_FRAMES][HOST_ENCODED_SIZE];
+static uint32_t g_pui32HostRxLen[HOST_PROTO_RX_FRAMES];
+static uint32_t g_ui32HostRxFill;
+static bool g_bHostRxDiscard;
+static volatile uint32_t g_ui32HostRxHead;
+static volatile uint32_t g_ui32HostRxTail;
+
+//*****************************************************************************
+//
+// The frame being sent.
+//
+//*****************************************************************************
+static uint8_t g_pui8HostTxFrame[HOST_FRAME_SIZE];
+static uint8_t g_pui8HostTxEncoded[HOST_ENCODED_SIZE + 1];
+
+static tHostProtoHandler g_pfnHostHandler;
+static tHostProtoStats g_sHostStats;
+
+//*****************************************************************************
+//
+//! Sets the function called with each message received.
+//!
+//! \param pfnHandler is the function.  It is called from the event loop.
+//!
+//! \return None.
+//
+//*****************************************************************************
+void
+HostProtoInit(tHostProtoHandler pfnHandler)
+{
+    g_pfnHostHandler = pfnHandler;
+    g_ui32HostRxFill = 0;
+    g_bHostRxDiscard = false;
+    g_ui32HostRxHead = 0;
+    g_ui32HostRxTail = 0;
+}
+
+//*****************************************************************************
+//
+//! Takes a byte received from the host.
+//!
+//! \param ui8Byte is the byte.
+//!
+//! This is called from the UART0 interrupt.
+//!
+//! \return Returns \b true when the byte ended a frame, after which
+//! HostProtoProcess() must be called from the event loop.
+//
+//*****************************************************************************
+bool
+HostProtoRxByte(uint8_t ui8Byte)
+{
+    uint32_t ui32Head;
+
+    ui32Head = g_ui32HostRxHead % HOST_PROTO_RX_FRAMES;
+
+    if(ui8Byte)
+    {
+        if((g_ui32HostRxHead - g_ui32HostRxTail) >= HOST_PROTO_RX_FRAMES)
+        {
+            g_bHostRxDiscard = true;
+        }
+        else if(g_ui32HostRxFill >= HOST_ENCODED_SIZE)
+        {
+            g_bHostRxDiscard = true;
+        }
+        else
+        {
+            g_ppui8HostRxFrame[ui32Head][g_ui32HostRxFill++] = ui8Byte;
+        }
+
+        return(false);
+    }
+
+    //
+    // A zero ends the frame.
+    //
+    if(g_bHostRxDiscard)
+    {
+        g_sHostStats.ui32Overruns++;
+        g_bHostRxDiscard = false;
+        g_ui32HostRxFill = 0;
+        return(false);
+    }
+
+    if(!g_ui32HostRxFill)
+    {
+        return(false);
+    }
+
+    g_pui32HostRxLen[ui32Head] = g_ui32HostRxFill;
+    g_ui32HostRxFill = 0;
+    g_ui32HostRxHead++;
+
+    return(true);
+}
+
+//*****************************************************************************
+//
+//! Handles every frame received so far.
+//!
+//! \return None.
+//
+//*****************************************************************************
+void
+HostProtoProcess(void)
+{
+    uint8_t *pui8Frame;
+    uint32_t ui32Len;
+    uint16_t ui16Crc;
+
+    while(g_ui32HostRxTail != g_ui32HostRxHead)
+    {
+        pui8Frame = g_ppui8HostRxFrame[g_ui32HostRxTail %
+                                       HOST_PROTO_RX_FRAMES];
+        ui32Len = CobsDecode(pui8Frame,
+                             g_pui32HostRxLen[g_ui32HostRxTail %
+                                              HOST_PROTO_RX_FRAMES],
+                             pui8Frame, HOST_FRAME_SIZE);
+
+        if(ui32Len >= 4)
+        {
+            ui16Crc = pui8Frame[ui32Len - 2] | (pui8Frame[ui32Len - 1] << 8);
+            if(CrcCtxBlock(CRC_CTX_CRC16, pui8Frame, ui32Len - 2) !=
+               ui16Crc)
+            {
+                ui32Len = 0;
+            }
+        }
+
+        if(ui32Len >= 4)
+        {
+            g_sHostStats.ui32Received++;
+            if(g_pfnHostHandler)
+            {
+                g_pfnHostHandler(pui8Frame[0], pui8Frame[1], pui8Frame + 2,
+                                 ui32Len - 4);
+            }
+        }
+        else
+        {
+            g_sHostStats.ui32Bad++;
+        }
+
+        g_ui32HostRxTail++;
+    }
+}
+
+//*****************************************************************************
+//
+//! Sends a message to the host.
+//!
+//! \param ui32Type is the message type.
+//! \param ui32Seq is the sequence number.
+//! \param pui8Payload is the payload.
+//! \param ui32Len is the length of the payload, at most
+//! HOST_PROTO_MAX_PAYLOAD.
+//!
+//! This must only be called from the event loop.  It waits when the console
+//! transmit ring is full.
+//!
+//! \return None.
+//
+//*****************************************************************************
+void
+HostProtoSend(uint32_t ui32Type, uint32_t ui32Seq, const uint8_t *pui8Payload,
+              uint32_t ui32Len)
+{
+    uint32_t ui32Idx;
+    uint16_t ui16Crc;
+
+    if(ui32Len > HOST_PROTO_MAX_PAYLOAD)
+    {
+        ui32Len = HOST_PROTO_MAX_PAYLOAD;
+    }
+
+    g_pui8HostTxFrame[0] = ui32Type;
+    g_pui8HostTxFrame[1] = ui32Seq;
+    for(ui32Idx = 0; ui32Idx < ui32Len; ui32Idx++)
+    {
+        g_pui8HostTxFrame[ui32Idx + 2] = pui8Payload[ui32Idx];
+    }
+
+    ui16Crc = CrcCtxBlock(CRC_CTX_CRC16, g_pui8HostTxFrame, ui32Len + 2);
+    g_pui8HostTxFrame[ui32Len + 2] = ui16Crc & 0xFF;
+    g_pui8HostTxFrame[ui32Len + 3] = ui16Crc >> 8;
+
+    ui32Len = CobsEncode(g_pui8HostTxFrame, ui32Len + 4, g_pui8HostTxEncoded);
+    g_pui8HostTxEncoded[ui32Len++] = 0;
+    ConsoleWriteLen((const char *)g_pui8HostTxEncoded, ui32Len);
+
+    g_sHostStats.ui32Sent++;
+}
+
+//*****************************************************************************
+//
+//! Returns the protocol statistics.
+//!
+//! \param psStats is a pointer to the structure that is filled in.
+//!
+//! \return None.
+//
+//*****************************************************************************
+void
+HostProtoStatsGet(tHostProtoStats *psStats)
+{
+    MAP_IntMasterDisable();
+    *psStats = g_sHostStats;
+    MAP_IntMasterEnable();
+}
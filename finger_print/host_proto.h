@@ -0,0 +1,116 @@
+//*****************************************************************************
+//
+// host_proto.h - Prototypes for the binary host protocol.
+//
+//*****************************************************************************
+
+#ifndef __HOST_PROTO_H__
+#define __HOST_PROTO_H__
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+//*****************************************************************************
+//
+// The largest payload a message carries.
+//
+//*****************************************************************************
+#define HOST_PROTO_MAX_PAYLOAD  64
+
+//*****************************************************************************
+//
+// The number of received messages that can wait to be handled.
+//
+//*****************************************************************************
+#define HOST_PROTO_RX_FRAMES    4
+
+//*****************************************************************************
+//
+// The requests the host sends.  Each is answered with HOST_MSG_ACK carrying
+// the same sequence number.
+//
+//*****************************************************************************
+#define HOST_MSG_PING           0x01    // Any payload, echoed by the ACK
+#define HOST_MSG_COMMAND        0x02    // FP_CMD_*, then number (LE32) or text
+#define HOST_MSG_REGISTER       0x03    // Slot
+#define HOST_MSG_COMPARE        0x04
+#define HOST_MSG_SLOTS          0x05    // ACK has known, count, map (LE32)
+#define HOST_MSG_TEXT_MODE      0x06    // Back to the menu after the ACK
+#define HOST_MSG_BATCH          0x07    // Commands, each length then COMMAND
+#define HOST_MSG_KEY_SET        0x08    // ID length, ID, then KEY
+
+//*****************************************************************************
+//
+// The messages the firmware sends.  HOST_MSG_DONE and HOST_MSG_FLOW end the
+// request with the same sequence number.  HOST_MSG_EVENT reports each
+// response from the sensor as it arrives, with the sequence number of the
+// request outstanding at the time.  HOST_MSG_ITEM reports each command of a
+// batch as it ends, with the sequence number of the batch and the index of
+// the command in it.
+//
+//*****************************************************************************
+#define HOST_MSG_ACK            0x80    // Status, then any data
+#define HOST_MSG_DONE           0x81    // FP_CMD_*, result, event, value
+#define HOST_MSG_FLOW           0x82    // FP_FLOW_*, result, slot or 0xFF
+#define HOST_MSG_ITEM           0x83    // Index, then as HOST_MSG_DONE
+#define HOST_MSG_EVENT          0xC0    // FP_EVENT_*, value
+
+//*****************************************************************************
+//
+// The status in an HOST_MSG_ACK.
+//
+//*****************************************************************************
+#define HOST_STATUS_OK          0
+#define HOST_STATUS_BUSY        1
+#define HOST_STATUS_INVALID     2
+
+//*****************************************************************************
+//
+// Statistics kept by the protocol.
+//
+//*****************************************************************************
+typedef struct
+{
+    //
+    // The number of messages received and sent.
+    //
+    uint32_t ui32Received;
+    uint32_t ui32Sent;
+
+    //
+    // The number of frames dropped because they failed their CRC or could
+    // not be decoded, and because too many were waiting.
+    //
+    uint32_t ui32Bad;
+    uint32_t ui32Overruns;
+}
+tHostProtoStats;
+
+//*****************************************************************************
+//
+// The function called with each message received.
+//
+//*****************************************************************************
+typedef void (*tHostProtoHandler)(uint32_t ui32Type, uint32_t ui32Seq,
+                                  const uint8_t *pui8Payload,
+                                  uint32_t ui32Len);
+
+//*****************************************************************************
+//
+// Prototypes for the APIs.
+//
+//*****************************************************************************
+extern void HostProtoInit(tHostProtoHandler pfnHandler);
+extern bool HostProtoRxByte(uint8_t ui8Byte);
+extern void HostProtoProcess(void);
+extern void HostProtoSend(uint32_t ui32Type, uint32_t ui32Seq,
+                          const uint8_t *pui8Payload, uint32_t ui32Len);
+extern void HostProtoStatsGet(tHostProtoStats *psStats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __HOST_PROTO_H__
@@ -5,13 +5,175 @@ import PIL.Image as Image
 # configure the serial connections
 ser = serial.Serial(
     port='/dev/ttyACM0',
-    baudrate=9600,
+    baudrate=115200,
     parity='N',
     stopbits=1,
     bytesize=8)
 
 ser.isOpen()
 
+# Golomb-Rice coder shared by the image codecs, see rice.c
+RICE_LIMIT = 16
+RICE_INIT_SUM = 4
+RICE_INIT_COUNT = 1
+RICE_RESET_COUNT = 32
+
+class BitReader:
+	def __init__(self, code):
+		self.code = code
+		self.pos = 0
+		self.bits = 0
+		self.nbits = 0
+
+	def get(self, n):
+		while self.nbits < n:
+			self.bits = (self.bits << 8) | self.code[self.pos]
+			self.pos += 1
+			self.nbits += 8
+		self.nbits -= n
+		return (self.bits >> self.nbits) & ((1 << n) - 1)
+
+class RiceModel:
+	def __init__(self):
+		self.total = RICE_INIT_SUM
+		self.count = RICE_INIT_COUNT
+
+	def get(self, reader, max_k, escape_bits):
+		k = 0
+		while k < max_k and (self.count << k) < self.total:
+			k += 1
+		q = 0
+		while q < RICE_LIMIT and reader.get(1):
+			q += 1
+		if q < RICE_LIMIT:
+			value = (q << k) | reader.get(k)
+		else:
+			value = reader.get(escape_bits)
+		self.total += value
+		self.count += 1
+		if self.count == RICE_RESET_COUNT:
+			self.total >>= 1
+			self.count >>= 1
+		return value
+
+# lossless row codec used by option 8, see img_lossless.c
+LOSSLESS_MAX_K = 7
+
+def predict(a, b, c):
+	if c >= max(a, b):
+		return min(a, b)
+	if c <= min(a, b):
+		return max(a, b)
+	return a + b - c
+
+def decode_row(code, above, width):
+	reader = BitReader(code)
+	model = RiceModel()
+	row = bytearray(width)
+	a = above[0]
+	c = above[0]
+	for x in range(width):
+		err = model.get(reader, LOSSLESS_MAX_K, 8)
+		diff = (err >> 1) if (err & 1) == 0 else -((err + 1) >> 1)
+		row[x] = (predict(a, above[x], c) + diff) & 0xFF
+		a = row[x]
+		c = above[x]
+	return row
+
+def read_compressed(ser):
+	# wait for the start marker, then decode each row as it arrives
+	window = b''
+	while window != b'<Z>':
+		window = (window + ser.read(1))[-3:]
+	header = ser.read(4)
+	width = header[0] | (header[1] << 8)
+	height = header[2] | (header[3] << 8)
+	pixels = bytearray()
+	above = bytes(width)
+	for y in range(height):
+		frame = ser.read(3)
+		if frame[0] == 0xFF:
+			print('scan was rejected, please scan again')
+			return None
+		payload = ser.read(frame[1] | (frame[2] << 8))
+		if frame[0] == 0:
+			above = payload
+		else:
+			above = decode_row(payload, above, width)
+		pixels.extend(above)
+	if ser.read(4) != b'</Z>':
+		print('image was cut short')
+	return width, height, pixels
+
+# lossy wavelet codec used by option 9, see img_wavelet.c
+WAVELET_LEVELS = 3
+WAVELET_MAX_K = 15
+WAVELET_STEP_MIN = 16
+
+def unlift(coef, start, stride, n):
+	if n < 2:
+		return
+	at = lambda i: start + i * stride
+	for i in range(0, n, 2):
+		right = coef[at(i + 1)] if i + 1 < n else coef[at(i - 1)]
+		left = coef[at(i - 1)] if i > 0 else right
+		coef[at(i)] -= (left + right + 2) >> 2
+	for i in range(1, n, 2):
+		left = coef[at(i - 1)]
+		right = coef[at(i + 1)] if i + 1 < n else left
+		coef[at(i)] += (left + right) >> 1
+
+def wavelet_step(step, x, y):
+	level = 0
+	while level < WAVELET_LEVELS and not ((x | y) & (1 << level)):
+		level += 1
+	return max(step >> level, WAVELET_STEP_MIN)
+
+def decode_strip(code, width, rows, step):
+	reader = BitReader(code)
+	runs = RiceModel()
+	values = RiceModel()
+	total = width * rows
+	coef = [0] * total
+	pos = 0
+	while pos < total:
+		pos += runs.get(reader, WAVELET_MAX_K, 16)
+		if pos >= total:
+			break
+		q = values.get(reader, WAVELET_MAX_K, 16) + 1
+		value = ((2 * q + 1) * wavelet_step(step, pos % width, pos // width)) >> 5
+		coef[pos] = -value if reader.get(1) else value
+		pos += 1
+	for level in reversed(range(WAVELET_LEVELS)):
+		s = 1 << level
+		for x in range(0, width, s):
+			unlift(coef, x, s * width, (rows + s - 1) // s)
+		for y in range(0, rows, s):
+			unlift(coef, y * width, s, (width + s - 1) // s)
+	return bytes(max(0, min(255, c + 128)) for c in coef)
+
+def read_wavelet(ser):
+	# wait for the start marker, then decode each strip as it arrives
+	window = b''
+	while window != b'<W>':
+		window = (window + ser.read(1))[-3:]
+	header = ser.read(4)
+	width = header[0] | (header[1] << 8)
+	height = header[2] | (header[3] << 8)
+	pixels = bytearray()
+	while len(pixels) < width * height:
+		frame = ser.read(5)
+		rows = frame[0]
+		if rows == 0:
+			print('scan was rejected, please scan again')
+			return None
+		step = frame[1] | (frame[2] << 8)
+		payload = ser.read(frame[3] | (frame[4] << 8))
+		pixels.extend(decode_strip(payload, width, rows, step))
+	if ser.read(4) != b'</W>':
+		print('image was cut short')
+	return width, height, pixels
+
 while 1 :
 	# get keyboard input
 	user_input = input(">> ")
@@ -43,3 +205,17 @@ while 1 :
 		img.putdata(out1)
 		img.save('fingerprint.png')
 
+	elif user_input == '8' or user_input == '9':
+		# send the character to the device and decode the compressed image
+		ser.write(user_input.encode())
+		if user_input == '8':
+			result = read_compressed(ser)
+		else:
+			result = read_wavelet(ser)
+
+		if result:
+			width, height, pixels = result
+			img = Image.new('L', (width, height))
+			img.putdata(pixels)
+			img.save('fingerprint.png')
+
@@ -0,0 +1,302 @@
+//*****************************************************************************
+//
+// img_lossless.c - Lossless image encoder pipeline stage.
+//
+// Each row is coded on its own, in the manner of LOCO-I (JPEG-LS) without its
+// context modelling.  A pixel is predicted from its left (a), upper (b) and
+// upper left (c) neighbours with the median edge detector, and the
+// prediction error, taken modulo 256 and folded to a positive number, is
+// Golomb-Rice coded (see rice.c), with the error in eight bits as the escape.
+// The Rice model starts from the same state on every row, so that the
+// decoder only needs the row above to decode a row.  The last byte of a row
+// is padded with zeros.
+//
+// The first row is predicted from a row of zeros, and the first pixel of
+// every row from the pixel above it.
+//
+//*****************************************************************************
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include "fp_parser.h"
+#include "img_pipe.h"
+#include "rice.h"
+#include "img_lossless.h"
+
+//*****************************************************************************
+//
+// The largest Rice parameter.  Folded errors are below 256, so a larger one
+// would never pay off.
+//
+//*****************************************************************************
+#define LOSSLESS_MAX_K              7
+
+//*****************************************************************************
+//
+// Predicts a pixel with the median edge detector.
+//
+//*****************************************************************************
+static uint32_t
+LosslessPredict(uint32_t ui32A, uint32_t ui32B, uint32_t ui32C)
+{
+    uint32_t ui32Min, ui32Max;
+
+    if(ui32A < ui32B)
+    {
+        ui32Min = ui32A;
+        ui32Max = ui32B;
+    }
+    else
+    {
+        ui32Min = ui32B;
+        ui32Max = ui32A;
+    }
+
+    if(ui32C >= ui32Max)
+    {
+        return(ui32Min);
+    }
+    else if(ui32C <= ui32Min)
+    {
+        return(ui32Max);
+    }
+
+    return(ui32A + ui32B - ui32C);
+}
+
+//*****************************************************************************
+//
+//! Encodes one row.
+//!
+//! \param pui8Row is the row.
+//! \param pui8Above is the row above it, or a row of zeros for the first one.
+//! \param ui32Width is the number of pixels in the row.
+//! \param pui8Out is where the code is written.
+//! \param ui32Size is the size of the output buffer.
+//!
+//! \return Returns the number of bytes written, or 0 if the code did not fit
+//! in the output buffer.
+//
+//*****************************************************************************
+uint32_t
+ImgLosslessEncodeRow(const uint8_t *pui8Row, const uint8_t *pui8Above,
+                     uint32_t ui32Width, uint8_t *pui8Out, uint32_t ui32Size)
+{
+    tRiceWriter sWriter;
+    tRiceModel sModel;
+    uint32_t ui32X, ui32A, ui32C, ui32Err;
+
+    RiceWriterInit(&sWriter, pui8Out, ui32Size);
+    RiceModelInit(&sModel);
+    ui32A = pui8Above[0];
+    ui32C = pui8Above[0];
+
+    for(ui32X = 0; ui32X < ui32Width; ui32X++)
+    {
+        //
+        // Fold the error modulo 256 so that small errors of either sign give
+        // small numbers: 0, -1, 1, -2, 2 become 0, 1, 2, 3, 4.
+        //
+        ui32Err = (pui8Row[ui32X] -
+                   LosslessPredict(ui32A, pui8Above[ui32X], ui32C)) & 0xFF;
+        ui32Err = ((ui32Err < 128) ? (ui32Err << 1) :
+                   (((256 - ui32Err) << 1) - 1));
+
+        if(!RiceCodePut(&sWriter, ui32Err, RiceModelK(&sModel, LOSSLESS_MAX_K),
+                        8))
+        {
+            return(0);
+        }
+
+        RiceModelUpdate(&sModel, ui32Err);
+
+        ui32A = pui8Row[ui32X];
+        ui32C = pui8Above[ui32X];
+    }
+
+    return(RiceWriterFlush(&sWriter));
+}
+
+//*****************************************************************************
+//
+// Sends the image header when an image starts.
+//
+//*****************************************************************************
+static void
+ImgLosslessStart(void *pvStage, uint32_t ui32Width, uint32_t ui32Height)
+{
+    tImgLossless *psCodec = pvStage;
+    uint8_t pui8Header[sizeof(IMG_LOSSLESS_START) + 3];
+
+    psCodec->ui32Width = ui32Width;
+    psCodec->ui32InBytes = 0;
+    psCodec->ui32OutBytes = 0;
+    psCodec->ui32RawRows = 0;
+    psCodec->bActive = false;
+
+    if(!psCodec->bEnabled)
+    {
+        return;
+    }
+
+    memcpy(pui8Header, IMG_LOSSLESS_START, sizeof(IMG_LOSSLESS_START) - 1);
+    pui8Header[sizeof(IMG_LOSSLESS_START) - 1] = (uint8_t)ui32Width;
+    pui8Header[sizeof(IMG_LOSSLESS_START)] = (uint8_t)(ui32Width >> 8);
+    pui8Header[sizeof(IMG_LOSSLESS_START) + 1] = (uint8_t)ui32Height;
+    pui8Header[sizeof(IMG_LOSSLESS_START) + 2] = (uint8_t)(ui32Height >> 8);
+
+    if(psCodec->pfnSink(pui8Header, sizeof(pui8Header)))
+    {
+        psCodec->ui32OutBytes = sizeof(pui8Header);
+        psCodec->bActive = true;
+    }
+    else
+    {
+        psCodec->ui32Overflows++;
+    }
+}
+
+//*****************************************************************************
+//
+// Encodes and sends a chunk of rows.
+//
+//*****************************************************************************
+static void
+ImgLosslessRows(void *pvStage, uint8_t *pui8Rows, uint32_t ui32Row,
+                uint32_t ui32Count)
+{
+    tImgLossless *psCodec = pvStage;
+    uint32_t ui32Width, ui32Len;
+    uint8_t *pui8Frame;
+
+    ui32Width = psCodec->ui32Width;
+    pui8Frame = psCodec->pui8Frame;
+
+    while(ui32Count-- && psCodec->bActive)
+    {
+        //
+        // Only keep the code if it is smaller than the row.
+        //
+        ui32Len = ImgLosslessEncodeRow(pui8Rows, pui8Rows - ui32Width,
+                                       ui32Width,
+                                       pui8Frame + IMG_LOSSLESS_ROW_HDR,
+                                       ui32Width - 1);
+        if(ui32Len)
+        {
+            pui8Frame[0] = IMG_LOSSLESS_ROW_RICE;
+        }
+        else
+        {
+            pui8Frame[0] = IMG_LOSSLESS_ROW_RAW;
+            memcpy(pui8Frame + IMG_LOSSLESS_ROW_HDR, pui8Rows, ui32Width);
+            ui32Len = ui32Width;
+            psCodec->ui32RawRows++;
+        }
+
+        pui8Frame[1] = (uint8_t)ui32Len;
+        pui8Frame[2] = (uint8_t)(ui32Len >> 8);
+        ui32Len += IMG_LOSSLESS_ROW_HDR;
+
+        if(!psCodec->pfnSink(pui8Frame, ui32Len))
+        {
+            psCodec->ui32Overflows++;
+            psCodec->bActive = false;
+            return;
+        }
+
+        psCodec->ui32InBytes += ui32Width;
+        psCodec->ui32OutBytes += ui32Len;
+        pui8Rows += ui32Width;
+    }
+}
+
+//*****************************************************************************
+//
+// Sends the closing marker after the last row, or an abort frame if the
+// image was abandoned.
+//
+//*****************************************************************************
+static void
+ImgLosslessEnd(void *pvStage, bool bComplete)
+{
+    static const uint8_t pui8Abort[IMG_LOSSLESS_ROW_HDR] =
+    {
+        IMG_LOSSLESS_ROW_ABORT, 0, 0
+    };
+    tImgLossless *psCodec = pvStage;
+    const uint8_t *pui8Data;
+    uint32_t ui32Len;
+
+    if(!psCodec->bActive)
+    {
+        return;
+    }
+
+    psCodec->bActive = false;
+
+    if(bComplete)
+    {
+        pui8Data = (const uint8_t *)IMG_LOSSLESS_END;
+        ui32Len = sizeof(IMG_LOSSLESS_END) - 1;
+    }
+    else
+    {
+        pui8Data = pui8Abort;
+        ui32Len = sizeof(pui8Abort);
+    }
+
+    if(psCodec->pfnSink(pui8Data, ui32Len))
+    {
+        psCodec->ui32OutBytes += ui32Len;
+    }
+    else
+    {
+        psCodec->ui32Overflows++;
+    }
+}
+
+//*****************************************************************************
+//
+//! Prepares a lossless encoder stage.
+//!
+//! \param psStage is the stage to fill in.
+//! \param psCodec is the encoder state.
+//! \param pfnSink is called with the encoded image.  It is called from the
+//! pipeline's context and must not wait.
+//!
+//! The stage starts out disabled and passes images by untouched.
+//!
+//! \return None.
+//
+//*****************************************************************************
+void
+ImgLosslessStageInit(tImgStage *psStage, tImgLossless *psCodec,
+                     tImgSink pfnSink)
+{
+    memset(psCodec, 0, sizeof(*psCodec));
+    psCodec->pfnSink = pfnSink;
+
+    psStage->pfnStart = ImgLosslessStart;
+    psStage->pfnRows = ImgLosslessRows;
+    psStage->pfnEnd = ImgLosslessEnd;
+    psStage->pvStage = psCodec;
+}
+
+//*****************************************************************************
+//
+//! Enables or disables encoding of the images that follow.
+//!
+//! \param psCodec is the encoder state.
+//! \param bEnable is \b true to encode images.
+//!
+//! An image that is already being encoded is finished.
+//!
+//! \return None.
+//
+//*****************************************************************************
+void
+ImgLosslessEnable(tImgLossless *psCodec, bool bEnable)
+{
+    psCodec->bEnabled = bEnable;
+}
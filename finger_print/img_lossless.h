@@ -0,0 +1,103 @@
+//*****************************************************************************
+//
+// img_lossless.h - Prototypes for the lossless image encoder stage.
+//
+//*****************************************************************************
+
+#ifndef __IMG_LOSSLESS_H__
+#define __IMG_LOSSLESS_H__
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+//*****************************************************************************
+//
+// The markers around an encoded image.  The opening marker is followed by
+// the width and height, each two bytes little endian, and then one frame per
+// row.
+//
+//*****************************************************************************
+#define IMG_LOSSLESS_START      "<Z>"
+#define IMG_LOSSLESS_END        "</Z>"
+
+//*****************************************************************************
+//
+// The row frame types.  A frame is the type byte, the payload length (two
+// bytes little endian) and the payload.  A row that would not get smaller is
+// sent as it is.  An abandoned image ends with an empty abort frame instead
+// of the closing marker.
+//
+//*****************************************************************************
+#define IMG_LOSSLESS_ROW_RAW    0
+#define IMG_LOSSLESS_ROW_RICE   1
+#define IMG_LOSSLESS_ROW_ABORT  0xFF
+#define IMG_LOSSLESS_ROW_HDR    3
+
+//*****************************************************************************
+//
+// The state of an encoder stage.  The statistics describe the image being
+// encoded or the last one.
+//
+//*****************************************************************************
+typedef struct
+{
+    //
+    // Where the encoded image goes, and whether images are encoded at all.
+    //
+    tImgSink pfnSink;
+    bool bEnabled;
+
+    //
+    // Set while the current image is being encoded.
+    //
+    bool bActive;
+
+    //
+    // The image width.
+    //
+    uint32_t ui32Width;
+
+    //
+    // The number of pixels taken in and bytes passed to the sink, including
+    // the markers and row headers.
+    //
+    uint32_t ui32InBytes;
+    uint32_t ui32OutBytes;
+
+    //
+    // The number of rows that had to be sent as they were.
+    //
+    uint32_t ui32RawRows;
+
+    //
+    // The number of images abandoned because the sink could not keep up.
+    //
+    uint32_t ui32Overflows;
+
+    //
+    // The frame of the row being encoded.
+    //
+    uint8_t pui8Frame[IMG_LOSSLESS_ROW_HDR + IMG_PIPE_MAX_WIDTH];
+}
+tImgLossless;
+
+//*****************************************************************************
+//
+// Prototypes for the APIs.
+//
+//*****************************************************************************
+extern void ImgLosslessStageInit(tImgStage *psStage, tImgLossless *psCodec,
+                                 tImgSink pfnSink);
+extern void ImgLosslessEnable(tImgLossless *psCodec, bool bEnable);
+extern uint32_t ImgLosslessEncodeRow(const uint8_t *pui8Row,
+                                     const uint8_t *pui8Above,
+                                     uint32_t ui32Width, uint8_t *pui8Out,
+                                     uint32_t ui32Size);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __IMG_LOSSLESS_H__
@@ -0,0 +1,346 @@
+//*****************************************************************************
+//
+// img_pipe.c - Row streaming image pipeline.
+//
+// A full 176 x 176 scan does not fit in SRAM next to everything else, so
+// images are never stored.  The pipeline collects the payload reported by
+// the sensor parser into a line buffer of IMG_PIPE_CHUNK_ROWS rows and hands
+// each filled chunk to the attached stages in turn.  The last row of every
+// chunk is kept in front of the next one so that stages can look one row up
+// without keeping a copy of their own.
+//
+// The image width comes from the last INFO response, and the height from the
+// payload size announced with the image.
+//
+//*****************************************************************************
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include "fp_parser.h"
+#include "img_pipe.h"
+
+//*****************************************************************************
+//
+// The line buffer.  The first row holds the row above the chunk and the
+// chunk itself follows, packed at the image width.
+//
+//*****************************************************************************
+static uint8_t g_pui8PipeLines[(IMG_PIPE_CHUNK_ROWS + 1) * IMG_PIPE_MAX_WIDTH];
+
+//*****************************************************************************
+//
+// The attached stages.
+//
+//*****************************************************************************
+static const tImgStage *g_ppsPipeStages[IMG_PIPE_MAX_STAGES];
+static uint32_t g_ui32PipeNumStages;
+
+//*****************************************************************************
+//
+// The width reported by the last INFO response, the size of the image being
+// passed through, the next row to be handed over and the number of bytes of
+// the current chunk received so far.
+//
+//*****************************************************************************
+static uint32_t g_ui32PipeInfoWidth;
+static uint32_t g_ui32PipeWidth;
+static uint32_t g_ui32PipeHeight;
+static uint32_t g_ui32PipeRow;
+static uint32_t g_ui32PipeFill;
+static bool g_bPipeActive;
+
+//*****************************************************************************
+//
+// The pipeline statistics.
+//
+//*****************************************************************************
+static tImgPipeStats g_sPipeStats;
+
+//*****************************************************************************
+//
+// Returns the number of rows in the chunk that starts at the current row.
+//
+//*****************************************************************************
+static uint32_t
+ImgPipeChunkRows(void)
+{
+    uint32_t ui32Rows;
+
+    ui32Rows = g_ui32PipeHeight - g_ui32PipeRow;
+
+    return((ui32Rows > IMG_PIPE_CHUNK_ROWS) ? IMG_PIPE_CHUNK_ROWS : ui32Rows);
+}
+
+//*****************************************************************************
+//
+// Tells every stage that the image has ended.
+//
+//*****************************************************************************
+static void
+ImgPipeEnd(bool bComplete)
+{
+    uint32_t ui32Stage;
+
+    g_bPipeActive = false;
+
+    for(ui32Stage = 0; ui32Stage < g_ui32PipeNumStages; ui32Stage++)
+    {
+        if(g_ppsPipeStages[ui32Stage]->pfnEnd)
+        {
+            g_ppsPipeStages[ui32Stage]->pfnEnd(
+                g_ppsPipeStages[ui32Stage]->pvStage, bComplete);
+        }
+    }
+
+    if(bComplete)
+    {
+        g_sPipeStats.ui32Images++;
+    }
+    else
+    {
+        g_sPipeStats.ui32Aborted++;
+    }
+}
+
+//*****************************************************************************
+//
+// Starts passing an image of the given payload size through the stages.
+//
+//*****************************************************************************
+static void
+ImgPipeStart(uint32_t ui32Size)
+{
+    uint32_t ui32Stage;
+
+    if(g_bPipeActive)
+    {
+        ImgPipeEnd(false);
+    }
+
+    if(!ui32Size || !g_ui32PipeInfoWidth ||
+       (g_ui32PipeInfoWidth > IMG_PIPE_MAX_WIDTH) ||
+       (ui32Size % g_ui32PipeInfoWidth))
+    {
+        g_sPipeStats.ui32Rejected++;
+        return;
+    }
+
+    g_ui32PipeWidth = g_ui32PipeInfoWidth;
+    g_ui32PipeHeight = ui32Size / g_ui32PipeWidth;
+    g_ui32PipeRow = 0;
+    g_ui32PipeFill = 0;
+    memset(g_pui8PipeLines, 0, g_ui32PipeWidth);
+    g_bPipeActive = true;
+
+    for(ui32Stage = 0; ui32Stage < g_ui32PipeNumStages; ui32Stage++)
+    {
+        if(g_ppsPipeStages[ui32Stage]->pfnStart)
+        {
+            g_ppsPipeStages[ui32Stage]->pfnStart(
+                g_ppsPipeStages[ui32Stage]->pvStage, g_ui32PipeWidth,
+                g_ui32PipeHeight);
+        }
+    }
+}
+
+//*****************************************************************************
+//
+// Hands the filled chunk to every stage and keeps its last row for the next
+// one.
+//
+//*****************************************************************************
+static void
+ImgPipeDeliver(uint32_t ui32Rows)
+{
+    uint32_t ui32Stage;
+
+    for(ui32Stage = 0; ui32Stage < g_ui32PipeNumStages; ui32Stage++)
+    {
+        //
+        // A stage may abandon the image.
+        //
+        if(!g_bPipeActive)
+        {
+            return;
+        }
+
+        if(g_ppsPipeStages[ui32Stage]->pfnRows)
+        {
+            g_ppsPipeStages[ui32Stage]->pfnRows(
+                g_ppsPipeStages[ui32Stage]->pvStage,
+                g_pui8PipeLines + g_ui32PipeWidth, g_ui32PipeRow, ui32Rows);
+        }
+    }
+
+    if(!g_bPipeActive)
+    {
+        return;
+    }
+
+    memcpy(g_pui8PipeLines, g_pui8PipeLines + (ui32Rows * g_ui32PipeWidth),
+           g_ui32PipeWidth);
+    g_ui32PipeRow += ui32Rows;
+    g_ui32PipeFill = 0;
+    g_sPipeStats.ui32Rows += ui32Rows;
+
+    if(g_ui32PipeRow == g_ui32PipeHeight)
+    {
+        ImgPipeEnd(true);
+    }
+}
+
+//*****************************************************************************
+//
+// Collects image payload into the line buffer.
+//
+//*****************************************************************************
+static void
+ImgPipeFeed(const uint8_t *pui8Data, uint32_t ui32Len)
+{
+    uint32_t ui32Rows, ui32Copy;
+
+    while(ui32Len && g_bPipeActive)
+    {
+        ui32Rows = ImgPipeChunkRows();
+        ui32Copy = (ui32Rows * g_ui32PipeWidth) - g_ui32PipeFill;
+        if(ui32Copy > ui32Len)
+        {
+            ui32Copy = ui32Len;
+        }
+
+        memcpy(g_pui8PipeLines + g_ui32PipeWidth + g_ui32PipeFill, pui8Data,
+               ui32Copy);
+        g_ui32PipeFill += ui32Copy;
+        pui8Data += ui32Copy;
+        ui32Len -= ui32Copy;
+
+        if(g_ui32PipeFill == (ui32Rows * g_ui32PipeWidth))
+        {
+            ImgPipeDeliver(ui32Rows);
+        }
+    }
+}
+
+//*****************************************************************************
+//
+//! Initializes the pipeline and detaches every stage.
+//!
+//! \return None.
+//
+//*****************************************************************************
+void
+ImgPipeInit(void)
+{
+    g_ui32PipeNumStages = 0;
+    g_ui32PipeInfoWidth = FP_IMAGE_WIDTH;
+    g_bPipeActive = false;
+}
+
+//*****************************************************************************
+//
+//! Attaches a stage to the end of the pipeline.
+//!
+//! \param psStage is the stage.  It is referenced, not copied, so it must
+//! stay valid while it is attached.
+//!
+//! This must not be called while an image is passing through.
+//!
+//! \return Returns \b false if IMG_PIPE_MAX_STAGES stages are attached
+//! already.
+//
+//*****************************************************************************
+bool
+ImgPipeStageAdd(const tImgStage *psStage)
+{
+    if(g_ui32PipeNumStages == IMG_PIPE_MAX_STAGES)
+    {
+        return(false);
+    }
+
+    g_ppsPipeStages[g_ui32PipeNumStages++] = psStage;
+
+    return(true);
+}
+
+//*****************************************************************************
+//
+//! Abandons the image passing through, if any.
+//!
+//! Every stage is told that the image ended incomplete, and the rest of its
+//! payload is ignored.  A stage may call this from its own functions.
+//!
+//! \return None.
+//
+//*****************************************************************************
+void
+ImgPipeAbort(void)
+{
+    if(g_bPipeActive)
+    {
+        ImgPipeEnd(false);
+    }
+}
+
+//*****************************************************************************
+//
+//! Returns whether an image is passing through.
+//!
+//! \return Returns \b true between the start of an image and its end.
+//
+//*****************************************************************************
+bool
+ImgPipeIsActive(void)
+{
+    return(g_bPipeActive);
+}
+
+//*****************************************************************************
+//
+//! Handles an event from the sensor parser.
+//!
+//! \param psEvent is the event.
+//!
+//! Every parser event must be passed here; the ones that do not concern
+//! images are ignored.
+//!
+//! \return None.
+//
+//*****************************************************************************
+void
+ImgPipeEventHandler(const tFpEvent *psEvent)
+{
+    switch(psEvent->ui32Type)
+    {
+    case FP_EVENT_INFO:
+        g_ui32PipeInfoWidth = psEvent->ui32Width;
+        break;
+    case FP_EVENT_IMAGE_START:
+        ImgPipeStart(psEvent->ui32Value);
+        break;
+    case FP_EVENT_IMAGE_CHUNK:
+        ImgPipeFeed(psEvent->pui8Data, psEvent->ui32Len);
+        break;
+    default:
+        //
+        // FP_EVENT_IMAGE_END needs no handling, since the last row has
+        // already ended the image.
+        //
+        break;
+    }
+}
+
+//*****************************************************************************
+//
+//! Returns the pipeline statistics.
+//!
+//! \param psStats is a pointer to the structure that is filled in.
+//!
+//! \return None.
+//
+//*****************************************************************************
+void
+ImgPipeStatsGet(tImgPipeStats *psStats)
+{
+    *psStats = g_sPipeStats;
+}
@@ -0,0 +1,105 @@
+//*****************************************************************************
+//
+// img_pipe.h - Prototypes for the row streaming image pipeline.
+//
+//*****************************************************************************
+
+#ifndef __IMG_PIPE_H__
+#define __IMG_PIPE_H__
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+//*****************************************************************************
+//
+// The widest image the pipeline accepts, the number of rows handed to the
+// stages at a time and the number of stages that can be attached.  The line
+// buffer holds one chunk plus the row above it, so it takes
+// (IMG_PIPE_CHUNK_ROWS + 1) * IMG_PIPE_MAX_WIDTH bytes.
+//
+//*****************************************************************************
+#define IMG_PIPE_MAX_WIDTH      256
+#define IMG_PIPE_CHUNK_ROWS     4
+#define IMG_PIPE_MAX_STAGES     4
+
+//*****************************************************************************
+//
+// A stage of the pipeline.  The functions are called in the order the stages
+// were added, from the context that feeds sensor events to the pipeline.
+//
+// pfnStart is called when an image starts.  pfnRows is called with each
+// chunk of ui32Count rows, the first of which is row ui32Row of the image.
+// The rows are packed ui32Width bytes apart and the row above the first one
+// is at pui8Rows - ui32Width (all zero for the first chunk).  A stage may
+// change the rows in place; later stages see the changed rows.  pfnEnd is
+// called with bComplete set once every row has been passed on, or with it
+// clear when the image was abandoned.  Any of the functions may be 0.
+//
+//*****************************************************************************
+typedef struct
+{
+    void (*pfnStart)(void *pvStage, uint32_t ui32Width, uint32_t ui32Height);
+    void (*pfnRows)(void *pvStage, uint8_t *pui8Rows, uint32_t ui32Row,
+                    uint32_t ui32Count);
+    void (*pfnEnd)(void *pvStage, bool bComplete);
+    void *pvStage;
+}
+tImgStage;
+
+//*****************************************************************************
+//
+// The function an output stage passes its data to.  It returns false if it
+// could not take all of it, in which case nothing was taken.
+//
+//*****************************************************************************
+typedef bool (*tImgSink)(const uint8_t *pui8Data, uint32_t ui32Len);
+
+//*****************************************************************************
+//
+// Statistics kept by the pipeline.
+//
+//*****************************************************************************
+typedef struct
+{
+    //
+    // The number of images that were passed through completely.
+    //
+    uint32_t ui32Images;
+
+    //
+    // The number of images that were abandoned part way through.
+    //
+    uint32_t ui32Aborted;
+
+    //
+    // The number of images that were not started because their size did not
+    // fit the line buffer.
+    //
+    uint32_t ui32Rejected;
+
+    //
+    // The total number of rows passed to the stages.
+    //
+    uint32_t ui32Rows;
+}
+tImgPipeStats;
+
+//*****************************************************************************
+//
+// Prototypes for the APIs.
+//
+//*****************************************************************************
+extern void ImgPipeInit(void);
+extern bool ImgPipeStageAdd(const tImgStage *psStage);
+extern void ImgPipeAbort(void);
+extern bool ImgPipeIsActive(void);
+extern void ImgPipeEventHandler(const tFpEvent *psEvent);
+extern void ImgPipeStatsGet(tImgPipeStats *psStats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __IMG_PIPE_H__
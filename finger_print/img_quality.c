@@ -0,0 +1,358 @@
+//*****************************************************************************
+//
+// img_quality.c - Streaming image quality pipeline stage.
+//
+// The image is measured in blocks IMG_QUALITY_BLOCK_WIDTH pixels wide and one
+// pipeline chunk tall, each of which is finished as soon as its chunk
+// arrives.  A block holds ridges (foreground) when its grey levels spread
+// more than the empty sensor's noise does.  For every foreground block three
+// measures are kept, each scaled to 0 to 100:
+//
+// - contrast, the range from the darkest to the brightest pixel;
+// - variance, the standard deviation of the grey levels;
+// - coherence, how well the pixel gradients agree on one ridge direction,
+//   from the gradient structure tensor as
+//   sqrt((Gxx - Gyy)^2 + 4 Gxy^2) / (Gxx + Gyy).
+//
+// The quality of the ridges is a weighted mean of the three measures over the
+// foreground blocks, and the score is that quality scaled by the coverage,
+// the share of foreground blocks, with half coverage or more counting in
+// full.  A partial or missing finger therefore scores low however clear its
+// ridges are.
+//
+// The image is abandoned through ImgPipeAbort(), which stops the stages
+// after this one, as soon as the best score it could still reach if every
+// block still to come were perfect is below the minimum, or once the decision
+// point has been passed and the score of the blocks seen so far is below it.
+//
+//*****************************************************************************
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include "fp_parser.h"
+#include "img_pipe.h"
+#include "img_quality.h"
+
+//*****************************************************************************
+//
+// The grey level variance above which a block counts as foreground, and the
+// contrast and standard deviation that score 100.
+//
+//*****************************************************************************
+#define QUALITY_FG_VARIANCE     100
+#define QUALITY_FULL_CONTRAST   160
+#define QUALITY_FULL_STDDEV     48
+
+//*****************************************************************************
+//
+// The weight of each measure in the ridge quality, in percent, and the
+// coverage that counts in full.
+//
+//*****************************************************************************
+#define QUALITY_WEIGHT_COHERENCE 50
+#define QUALITY_WEIGHT_CONTRAST 25
+#define QUALITY_WEIGHT_VARIANCE 25
+#define QUALITY_FULL_COVERAGE   50
+
+//*****************************************************************************
+//
+// Returns the integer square root.
+//
+//*****************************************************************************
+static uint32_t
+QualitySqrt(uint64_t ui64Value)
+{
+    uint64_t ui64Root, ui64Bit;
+
+    ui64Root = 0;
+    ui64Bit = (uint64_t)1 << 62;
+    while(ui64Bit > ui64Value)
+    {
+        ui64Bit >>= 2;
+    }
+
+    while(ui64Bit)
+    {
+        if(ui64Value >= (ui64Root + ui64Bit))
+        {
+            ui64Value -= ui64Root + ui64Bit;
+            ui64Root = (ui64Root >> 1) + ui64Bit;
+        }
+        else
+        {
+            ui64Root >>= 1;
+        }
+        ui64Bit >>= 2;
+    }
+
+    return((uint32_t)ui64Root);
+}
+
+//*****************************************************************************
+//
+// Returns a measure scaled to 0 to 100 of full scale.
+//
+//*****************************************************************************
+static uint32_t
+QualityScale(uint32_t ui32Value, uint32_t ui32Full)
+{
+    return((ui32Value >= ui32Full) ? 100 : ((ui32Value * 100) / ui32Full));
+}
+
+//*****************************************************************************
+//
+// Measures one block and adds it to the image totals.
+//
+//*****************************************************************************
+static void
+QualityBlock(tImgQuality *psQuality, const uint8_t *pui8Rows, uint32_t ui32Row,
+             uint32_t ui32Count, uint32_t ui32X0, uint32_t ui32X1)
+{
+    const uint8_t *pui8Row, *pui8Above;
+    uint32_t ui32X, ui32Y, ui32Pixel, ui32Min, ui32Max, ui32N, ui32Sum;
+    uint32_t ui32SumSq, ui32Variance, ui32Width;
+    int32_t i32Gx, i32Gy, i32Gxx, i32Gyy, i32Gxy;
+    int64_t i64Diff;
+
+    ui32Width = psQuality->ui32Width;
+    ui32Min = 255;
+    ui32Max = 0;
+    ui32Sum = 0;
+    ui32SumSq = 0;
+    i32Gxx = 0;
+    i32Gyy = 0;
+    i32Gxy = 0;
+
+    for(ui32Y = 0; ui32Y < ui32Count; ui32Y++)
+    {
+        pui8Row = pui8Rows + (ui32Y * ui32Width);
+        pui8Above = pui8Row - ui32Width;
+
+        for(ui32X = ui32X0; ui32X < ui32X1; ui32X++)
+        {
+            ui32Pixel = pui8Row[ui32X];
+            ui32Sum += ui32Pixel;
+            ui32SumSq += ui32Pixel * ui32Pixel;
+            if(ui32Pixel < ui32Min)
+            {
+                ui32Min = ui32Pixel;
+            }
+            if(ui32Pixel > ui32Max)
+            {
+                ui32Max = ui32Pixel;
+            }
+
+            //
+            // The row above the first row of the image is not real.
+            //
+            i32Gx = ((ui32X + 1) < ui32Width) ?
+                    ((int32_t)pui8Row[ui32X + 1] - (int32_t)ui32Pixel) : 0;
+            i32Gy = (ui32Row + ui32Y) ?
+                    ((int32_t)ui32Pixel - (int32_t)pui8Above[ui32X]) : 0;
+            i32Gxx += i32Gx * i32Gx;
+            i32Gyy += i32Gy * i32Gy;
+            i32Gxy += i32Gx * i32Gy;
+        }
+    }
+
+    psQuality->ui32Seen++;
+
+    ui32N = ui32Count * (ui32X1 - ui32X0);
+    ui32Variance = ((ui32N * ui32SumSq) - (ui32Sum * ui32Sum)) /
+                   (ui32N * ui32N);
+    if(ui32Variance < QUALITY_FG_VARIANCE)
+    {
+        return;
+    }
+
+    psQuality->ui32Foreground++;
+    psQuality->ui32ContrastSum += QualityScale(ui32Max - ui32Min,
+                                               QUALITY_FULL_CONTRAST);
+    psQuality->ui32VarianceSum += QualityScale(QualitySqrt(ui32Variance),
+                                               QUALITY_FULL_STDDEV);
+
+    if(i32Gxx + i32Gyy)
+    {
+        i64Diff = (int64_t)i32Gxx - i32Gyy;
+        psQuality->ui32CoherenceSum +=
+            (QualitySqrt((uint64_t)(i64Diff * i64Diff) +
+                         (4 * (uint64_t)((int64_t)i32Gxy * i32Gxy))) * 100) /
+            (uint32_t)(i32Gxx + i32Gyy);
+    }
+}
+
+//*****************************************************************************
+//
+// Works out the measures and the score as if ui32Extra more blocks had been
+// seen, all perfect, out of a total of ui32Total.
+//
+//*****************************************************************************
+static uint32_t
+QualityScore(tImgQuality *psQuality, uint32_t ui32Extra, uint32_t ui32Total)
+{
+    uint32_t ui32Fg;
+
+    ui32Fg = psQuality->ui32Foreground + ui32Extra;
+    if(!ui32Fg)
+    {
+        psQuality->ui32Coverage = 0;
+        psQuality->ui32Contrast = 0;
+        psQuality->ui32Variance = 0;
+        psQuality->ui32Coherence = 0;
+        return(0);
+    }
+
+    psQuality->ui32Coverage = (ui32Fg * 100) / ui32Total;
+    psQuality->ui32Contrast =
+        (psQuality->ui32ContrastSum + (ui32Extra * 100)) / ui32Fg;
+    psQuality->ui32Variance =
+        (psQuality->ui32VarianceSum + (ui32Extra * 100)) / ui32Fg;
+    psQuality->ui32Coherence =
+        (psQuality->ui32CoherenceSum + (ui32Extra * 100)) / ui32Fg;
+
+    return((((psQuality->ui32Coherence * QUALITY_WEIGHT_COHERENCE) +
+             (psQuality->ui32Contrast * QUALITY_WEIGHT_CONTRAST) +
+             (psQuality->ui32Variance * QUALITY_WEIGHT_VARIANCE)) *
+            QualityScale(psQuality->ui32Coverage, QUALITY_FULL_COVERAGE)) /
+           10000);
+}
+
+//*****************************************************************************
+//
+// Records the verdict and reports it.
+//
+//*****************************************************************************
+static void
+QualityVerdict(tImgQuality *psQuality, uint32_t ui32Verdict)
+{
+    psQuality->ui32Score = QualityScore(psQuality, 0, psQuality->ui32Seen);
+    psQuality->ui32Verdict = ui32Verdict;
+
+    if(psQuality->pfnCallback)
+    {
+        psQuality->pfnCallback(ui32Verdict, psQuality->ui32Score);
+    }
+}
+
+//*****************************************************************************
+//
+// Clears the totals when an image starts.
+//
+//*****************************************************************************
+static void
+ImgQualityStart(void *pvStage, uint32_t ui32Width, uint32_t ui32Height)
+{
+    tImgQuality *psQuality = pvStage;
+
+    psQuality->ui32Verdict = IMG_QUALITY_NONE;
+    psQuality->ui32Score = 0;
+    psQuality->ui32Width = ui32Width;
+    psQuality->ui32Blocks =
+        ((ui32Width + IMG_QUALITY_BLOCK_WIDTH - 1) / IMG_QUALITY_BLOCK_WIDTH) *
+        ((ui32Height + IMG_PIPE_CHUNK_ROWS - 1) / IMG_PIPE_CHUNK_ROWS);
+    psQuality->ui32Seen = 0;
+    psQuality->ui32Foreground = 0;
+    psQuality->ui32ContrastSum = 0;
+    psQuality->ui32VarianceSum = 0;
+    psQuality->ui32CoherenceSum = 0;
+}
+
+//*****************************************************************************
+//
+// Measures a chunk and abandons the image if it can no longer pass.
+//
+//*****************************************************************************
+static void
+ImgQualityRows(void *pvStage, uint8_t *pui8Rows, uint32_t ui32Row,
+               uint32_t ui32Count)
+{
+    tImgQuality *psQuality = pvStage;
+    uint32_t ui32X, ui32X1;
+
+    for(ui32X = 0; ui32X < psQuality->ui32Width; ui32X = ui32X1)
+    {
+        ui32X1 = ui32X + IMG_QUALITY_BLOCK_WIDTH;
+        if(ui32X1 > psQuality->ui32Width)
+        {
+            ui32X1 = psQuality->ui32Width;
+        }
+
+        QualityBlock(psQuality, pui8Rows, ui32Row, ui32Count, ui32X, ui32X1);
+    }
+
+    if(!psQuality->bAbort)
+    {
+        return;
+    }
+
+    if((QualityScore(psQuality, psQuality->ui32Blocks - psQuality->ui32Seen,
+                     psQuality->ui32Blocks) < psQuality->ui32MinScore) ||
+       (((psQuality->ui32Seen * 100) >=
+         (psQuality->ui32Blocks * psQuality->ui32DecidePercent)) &&
+        (QualityScore(psQuality, 0, psQuality->ui32Seen) <
+         psQuality->ui32MinScore)))
+    {
+        QualityVerdict(psQuality, IMG_QUALITY_REJECTED);
+        ImgPipeAbort();
+    }
+}
+
+//*****************************************************************************
+//
+// Gives the verdict on a complete image.
+//
+//*****************************************************************************
+static void
+ImgQualityEnd(void *pvStage, bool bComplete)
+{
+    tImgQuality *psQuality = pvStage;
+
+    if(!bComplete)
+    {
+        return;
+    }
+
+    if(QualityScore(psQuality, 0, psQuality->ui32Seen) >=
+       psQuality->ui32MinScore)
+    {
+        QualityVerdict(psQuality, IMG_QUALITY_GOOD);
+    }
+    else
+    {
+        QualityVerdict(psQuality, IMG_QUALITY_POOR);
+    }
+}
+
+//*****************************************************************************
+//
+//! Prepares a quality stage.
+//!
+//! \param psStage is the stage to fill in.
+//! \param psQuality is the stage state.
+//! \param pfnCallback is called from the pipeline's context with the verdict
+//! and score of every image.  It may be 0.
+//!
+//! The stage starts with the default minimum score and decision point, and
+//! with abandoning images that fall short enabled.  It should be attached
+//! ahead of the stages that send the image on, so that a rejected image
+//! stops before it reaches them.
+//!
+//! \return None.
+//
+//*****************************************************************************
+void
+ImgQualityStageInit(tImgStage *psStage, tImgQuality *psQuality,
+                    tImgQualityCallback pfnCallback)
+{
+    memset(psQuality, 0, sizeof(*psQuality));
+    psQuality->ui32MinScore = IMG_QUALITY_MIN_SCORE;
+    psQuality->ui32DecidePercent = IMG_QUALITY_DECIDE_PERCENT;
+    psQuality->bAbort = true;
+    psQuality->pfnCallback = pfnCallback;
+
+    psStage->pfnStart = ImgQualityStart;
+    psStage->pfnRows = ImgQualityRows;
+    psStage->pfnEnd = ImgQualityEnd;
+    psStage->pvStage = psQuality;
+}
@@ -0,0 +1,116 @@
+//*****************************************************************************
+//
+// img_quality.h - Prototypes for the streaming image quality stage.
+//
+//*****************************************************************************
+
+#ifndef __IMG_QUALITY_H__
+#define __IMG_QUALITY_H__
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+//*****************************************************************************
+//
+// The verdicts.  An image is rejected as soon as it can no longer reach the
+// minimum score, and poor if it only turns out to be below it at the end.
+//
+//*****************************************************************************
+#define IMG_QUALITY_NONE        0
+#define IMG_QUALITY_GOOD        1
+#define IMG_QUALITY_POOR        2
+#define IMG_QUALITY_REJECTED    3
+
+//*****************************************************************************
+//
+// The width of the blocks the image is measured in.  Blocks are as tall as a
+// pipeline chunk.
+//
+//*****************************************************************************
+#define IMG_QUALITY_BLOCK_WIDTH 16
+
+//*****************************************************************************
+//
+// The default minimum score, and the default share of the image, in percent,
+// after which an image is judged on what has been seen of it.
+//
+//*****************************************************************************
+#define IMG_QUALITY_MIN_SCORE   40
+#define IMG_QUALITY_DECIDE_PERCENT                                            \
+                                50
+
+//*****************************************************************************
+//
+// The function called once the verdict on an image is known.
+//
+//*****************************************************************************
+typedef void (*tImgQualityCallback)(uint32_t ui32Verdict, uint32_t ui32Score);
+
+//*****************************************************************************
+//
+// The state of a quality stage.  The results may be read once the verdict is
+// known.
+//
+//*****************************************************************************
+typedef struct
+{
+    //
+    // The lowest acceptable score, the share of the image in percent after
+    // which the score so far is trusted, whether an image that falls short is
+    // abandoned, and the function told about the verdict (which may be 0).
+    //
+    uint32_t ui32MinScore;
+    uint32_t ui32DecidePercent;
+    bool bAbort;
+    tImgQualityCallback pfnCallback;
+
+    //
+    // One of the IMG_QUALITY_* verdicts, and the score from 0 to 100.  A
+    // rejected image is scored on the blocks seen up to that point.
+    //
+    uint32_t ui32Verdict;
+    uint32_t ui32Score;
+
+    //
+    // The measures making up the score, each from 0 to 100: the share of
+    // blocks that hold ridges, and over those blocks the mean local
+    // contrast, grey level spread and ridge orientation coherence.
+    //
+    uint32_t ui32Coverage;
+    uint32_t ui32Contrast;
+    uint32_t ui32Variance;
+    uint32_t ui32Coherence;
+
+    //
+    // The image width, the number of blocks in the image, the number seen
+    // and the number of those that hold ridges.
+    //
+    uint32_t ui32Width;
+    uint32_t ui32Blocks;
+    uint32_t ui32Seen;
+    uint32_t ui32Foreground;
+
+    //
+    // The sums of the per block measures over the ridge blocks.
+    //
+    uint32_t ui32ContrastSum;
+    uint32_t ui32VarianceSum;
+    uint32_t ui32CoherenceSum;
+}
+tImgQuality;
+
+//*****************************************************************************
+//
+// Prototypes for the APIs.
+//
+//*****************************************************************************
+extern void ImgQualityStageInit(tImgStage *psStage, tImgQuality *psQuality,
+                                tImgQualityCallback pfnCallback);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __IMG_QUALITY_H__
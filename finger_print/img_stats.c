@@ -0,0 +1,120 @@
+//*****************************************************************************
+//
+// img_stats.c - Image statistics pipeline stage.
+//
+// Accumulates the range, sum and histogram of the grey levels of every image
+// passed through the pipeline.
+//
+//*****************************************************************************
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include "fp_parser.h"
+#include "img_pipe.h"
+#include "img_stats.h"
+
+//*****************************************************************************
+//
+// Clears the statistics when an image starts.
+//
+//*****************************************************************************
+static void
+ImgStatsStart(void *pvStage, uint32_t ui32Width, uint32_t ui32Height)
+{
+    tImgStats *psStats = pvStage;
+
+    memset(psStats, 0, sizeof(*psStats));
+    psStats->ui32Width = ui32Width;
+    psStats->ui32Height = ui32Height;
+    psStats->ui32Min = 255;
+}
+
+//*****************************************************************************
+//
+// Accumulates a chunk of rows.
+//
+//*****************************************************************************
+static void
+ImgStatsRows(void *pvStage, uint8_t *pui8Rows, uint32_t ui32Row,
+             uint32_t ui32Count)
+{
+    tImgStats *psStats = pvStage;
+    uint32_t ui32Pixels, ui32Pixel, ui32Min, ui32Max, ui32Sum;
+
+    ui32Min = psStats->ui32Min;
+    ui32Max = psStats->ui32Max;
+    ui32Sum = 0;
+
+    for(ui32Pixels = ui32Count * psStats->ui32Width; ui32Pixels; ui32Pixels--)
+    {
+        ui32Pixel = *pui8Rows++;
+        ui32Sum += ui32Pixel;
+        if(ui32Pixel < ui32Min)
+        {
+            ui32Min = ui32Pixel;
+        }
+        if(ui32Pixel > ui32Max)
+        {
+            ui32Max = ui32Pixel;
+        }
+        psStats->pui32Histogram[ui32Pixel / (256 / IMG_STATS_BINS)]++;
+    }
+
+    psStats->ui32Min = ui32Min;
+    psStats->ui32Max = ui32Max;
+    psStats->ui32Sum += ui32Sum;
+}
+
+//*****************************************************************************
+//
+// Records whether the image was seen in full.
+//
+//*****************************************************************************
+static void
+ImgStatsEnd(void *pvStage, bool bComplete)
+{
+    tImgStats *psStats = pvStage;
+
+    psStats->bComplete = bComplete;
+}
+
+//*****************************************************************************
+//
+//! Prepares a statistics stage.
+//!
+//! \param psStage is the stage to fill in.
+//! \param psStats is where the statistics of each image are kept.
+//!
+//! \return None.
+//
+//*****************************************************************************
+void
+ImgStatsStageInit(tImgStage *psStage, tImgStats *psStats)
+{
+    memset(psStats, 0, sizeof(*psStats));
+
+    psStage->pfnStart = ImgStatsStart;
+    psStage->pfnRows = ImgStatsRows;
+    psStage->pfnEnd = ImgStatsEnd;
+    psStage->pvStage = psStats;
+}
+
+//*****************************************************************************
+//
+//! Returns the mean grey level of an image.
+//!
+//! \param psStats is the statistics of the image.
+//!
+//! \return Returns the mean, rounded down, or 0 for an empty image.
+//
+//*****************************************************************************
+uint32_t
+ImgStatsMean(const tImgStats *psStats)
+{
+    uint32_t ui32Pixels;
+
+    ui32Pixels = psStats->ui32Width * psStats->ui32Height;
+
+    return(ui32Pixels ? (psStats->ui32Sum / ui32Pixels) : 0);
+}
@@ -0,0 +1,68 @@
+//*****************************************************************************
+//
+// img_stats.h - Prototypes for the image statistics pipeline stage.
+//
+//*****************************************************************************
+
+#ifndef __IMG_STATS_H__
+#define __IMG_STATS_H__
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+//*****************************************************************************
+//
+// The number of histogram bins.  Each one covers 256 / IMG_STATS_BINS grey
+// levels.
+//
+//*****************************************************************************
+#define IMG_STATS_BINS          16
+
+//*****************************************************************************
+//
+// The statistics of the last image.  The members are filled in by the stage
+// and may be read once bComplete is set.
+//
+//*****************************************************************************
+typedef struct
+{
+    //
+    // The image size.
+    //
+    uint32_t ui32Width;
+    uint32_t ui32Height;
+
+    //
+    // The darkest and the brightest pixel, and the sum of all of them.
+    //
+    uint32_t ui32Min;
+    uint32_t ui32Max;
+    uint32_t ui32Sum;
+
+    //
+    // The number of pixels in each histogram bin.
+    //
+    uint32_t pui32Histogram[IMG_STATS_BINS];
+
+    //
+    // Set when every row of the image has been seen.
+    //
+    bool bComplete;
+}
+tImgStats;
+
+//*****************************************************************************
+//
+// Prototypes for the APIs.
+//
+//*****************************************************************************
+extern void ImgStatsStageInit(tImgStage *psStage, tImgStats *psStats);
+extern uint32_t ImgStatsMean(const tImgStats *psStats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __IMG_STATS_H__
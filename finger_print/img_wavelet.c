@@ -0,0 +1,446 @@
+//*****************************************************************************
+//
+// img_wavelet.c - Lossy wavelet image encoder pipeline stage.
+//
+// An adaptation of wavelet scalar quantization to the row pipeline.  Every
+// chunk of IMG_PIPE_CHUNK_ROWS rows is coded as a strip on its own:
+//
+// - The pixels are shifted down by 128 and transformed in place with the
+//   reversible 5/3 (LeGall) integer lifting wavelet, using symmetric
+//   extension at the strip edges.  Level l works on the samples whose
+//   coordinates are multiples of 2^(l-1); rows are lifted first, then
+//   columns.  A four row strip only has two levels vertically, so the third
+//   level is horizontal only.
+//
+// - Each coefficient is quantized with a dead zone.  Level l detail uses the
+//   step of the strip shifted right by l - 1, the remaining low pass samples
+//   the step shifted right by IMG_WAVELET_LEVELS, and no step goes below one
+//   grey level.  A coefficient's level is one more than the number of
+//   trailing zero bits of (x | y).  Steps are in sixteenths of a grey level;
+//   a coefficient c is coded as q = (|c| * 16) / step and rebuilt as
+//   ((2q + 1) * step) / 32 with the sign of c.
+//
+// - The coefficients are scanned in raster order and coded as alternating
+//   runs of zeros and non-zero values: the length of the run before a value,
+//   then the magnitude less one and a sign bit (1 for negative).  A final run
+//   covers any zeros at the end.  Runs and magnitudes use separate adaptive
+//   Rice models (see rice.c) with a sixteen bit escape.
+//
+// The step is adjusted after each strip to keep the code near the target
+// bit rate, and is sent in front of every strip.
+//
+//*****************************************************************************
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include "fp_parser.h"
+#include "img_pipe.h"
+#include "rice.h"
+#include "img_wavelet.h"
+
+//*****************************************************************************
+//
+// The largest Rice parameter, the finest step (one grey level) and the
+// coarsest one.
+//
+//*****************************************************************************
+#define WAVELET_MAX_K           15
+#define WAVELET_STEP_MIN        16
+#define WAVELET_STEP_MAX        8192
+
+//*****************************************************************************
+//
+// Lifts a line of n samples, spaced ui32Stride apart, in place.  Even
+// samples become low pass and odd samples high pass coefficients.
+//
+//*****************************************************************************
+static void
+WaveletLift(int16_t *pi16Line, uint32_t ui32Stride, uint32_t ui32N)
+{
+    int32_t i32Left, i32Right;
+    uint32_t ui32Idx;
+
+    if(ui32N < 2)
+    {
+        return;
+    }
+
+    //
+    // Predict the odd samples from their neighbours.
+    //
+    for(ui32Idx = 1; ui32Idx < ui32N; ui32Idx += 2)
+    {
+        i32Left = pi16Line[(ui32Idx - 1) * ui32Stride];
+        i32Right = ((ui32Idx + 1) < ui32N) ?
+                   pi16Line[(ui32Idx + 1) * ui32Stride] : i32Left;
+        pi16Line[ui32Idx * ui32Stride] -= (i32Left + i32Right) >> 1;
+    }
+
+    //
+    // Update the even samples from the new odd ones.
+    //
+    for(ui32Idx = 0; ui32Idx < ui32N; ui32Idx += 2)
+    {
+        i32Right = ((ui32Idx + 1) < ui32N) ?
+                   pi16Line[(ui32Idx + 1) * ui32Stride] :
+                   pi16Line[(ui32Idx - 1) * ui32Stride];
+        i32Left = ui32Idx ? pi16Line[(ui32Idx - 1) * ui32Stride] : i32Right;
+        pi16Line[ui32Idx * ui32Stride] += (i32Left + i32Right + 2) >> 2;
+    }
+}
+
+//*****************************************************************************
+//
+// Transforms a strip in place.
+//
+//*****************************************************************************
+static void
+WaveletTransform(int16_t *pi16Coef, uint32_t ui32Width, uint32_t ui32Rows)
+{
+    uint32_t ui32Level, ui32Step, ui32Idx;
+
+    for(ui32Level = 0; ui32Level < IMG_WAVELET_LEVELS; ui32Level++)
+    {
+        ui32Step = 1 << ui32Level;
+
+        for(ui32Idx = 0; ui32Idx < ui32Rows; ui32Idx += ui32Step)
+        {
+            WaveletLift(pi16Coef + (ui32Idx * ui32Width), ui32Step,
+                        (ui32Width + ui32Step - 1) / ui32Step);
+        }
+
+        for(ui32Idx = 0; ui32Idx < ui32Width; ui32Idx += ui32Step)
+        {
+            WaveletLift(pi16Coef + ui32Idx, ui32Step * ui32Width,
+                        (ui32Rows + ui32Step - 1) / ui32Step);
+        }
+    }
+}
+
+//*****************************************************************************
+//
+// Returns the quantizer step of the coefficient at x, y.
+//
+//*****************************************************************************
+static uint32_t
+WaveletStep(uint32_t ui32Step, uint32_t ui32X, uint32_t ui32Y)
+{
+    uint32_t ui32Level;
+
+    for(ui32Level = 0; ui32Level < IMG_WAVELET_LEVELS; ui32Level++)
+    {
+        if((ui32X | ui32Y) & (1 << ui32Level))
+        {
+            break;
+        }
+    }
+
+    ui32Step >>= ui32Level;
+
+    return((ui32Step < WAVELET_STEP_MIN) ? WAVELET_STEP_MIN : ui32Step);
+}
+
+//*****************************************************************************
+//
+// Quantizes and codes the transformed strip.  Returns the payload length, or
+// 0 if it did not fit.
+//
+//*****************************************************************************
+static uint32_t
+WaveletCode(tImgWavelet *psCodec, uint32_t ui32Rows, uint32_t ui32Step)
+{
+    tRiceWriter sWriter;
+    tRiceModel sRuns, sValues;
+    uint32_t ui32X, ui32Y, ui32Run, ui32Q;
+    int32_t i32Coef;
+    const int16_t *pi16Coef;
+
+    RiceWriterInit(&sWriter, psCodec->pui8Frame + IMG_WAVELET_STRIP_HDR,
+                   IMG_WAVELET_CODE_SIZE);
+    RiceModelInit(&sRuns);
+    RiceModelInit(&sValues);
+    pi16Coef = psCodec->pi16Coef;
+    ui32Run = 0;
+
+    for(ui32Y = 0; ui32Y < ui32Rows; ui32Y++)
+    {
+        for(ui32X = 0; ui32X < psCodec->ui32Width; ui32X++)
+        {
+            i32Coef = *pi16Coef++;
+            ui32Q = (((i32Coef < 0) ? -i32Coef : i32Coef) * 16) /
+                    WaveletStep(ui32Step, ui32X, ui32Y);
+            if(!ui32Q)
+            {
+                ui32Run++;
+                continue;
+            }
+
+            if(!RiceCodePut(&sWriter, ui32Run,
+                            RiceModelK(&sRuns, WAVELET_MAX_K), 16) ||
+               !RiceCodePut(&sWriter, ui32Q - 1,
+                            RiceModelK(&sValues, WAVELET_MAX_K), 16) ||
+               !RiceBitsPut(&sWriter, (i32Coef < 0) ? 1 : 0, 1))
+            {
+                return(0);
+            }
+
+            RiceModelUpdate(&sRuns, ui32Run);
+            RiceModelUpdate(&sValues, ui32Q - 1);
+            ui32Run = 0;
+        }
+    }
+
+    if(ui32Run &&
+       !RiceCodePut(&sWriter, ui32Run, RiceModelK(&sRuns, WAVELET_MAX_K), 16))
+    {
+        return(0);
+    }
+
+    return(RiceWriterFlush(&sWriter));
+}
+
+//*****************************************************************************
+//
+// Sends the image header when an image starts.
+//
+//*****************************************************************************
+static void
+ImgWaveletStart(void *pvStage, uint32_t ui32Width, uint32_t ui32Height)
+{
+    tImgWavelet *psCodec = pvStage;
+    uint8_t pui8Header[sizeof(IMG_WAVELET_START) + 3];
+
+    psCodec->ui32Width = ui32Width;
+    psCodec->ui32Step = IMG_WAVELET_STEP_INIT;
+    psCodec->ui32InBytes = 0;
+    psCodec->ui32OutBytes = 0;
+    psCodec->bActive = false;
+
+    if(!psCodec->bEnabled)
+    {
+        return;
+    }
+
+    memcpy(pui8Header, IMG_WAVELET_START, sizeof(IMG_WAVELET_START) - 1);
+    pui8Header[sizeof(IMG_WAVELET_START) - 1] = (uint8_t)ui32Width;
+    pui8Header[sizeof(IMG_WAVELET_START)] = (uint8_t)(ui32Width >> 8);
+    pui8Header[sizeof(IMG_WAVELET_START) + 1] = (uint8_t)ui32Height;
+    pui8Header[sizeof(IMG_WAVELET_START) + 2] = (uint8_t)(ui32Height >> 8);
+
+    if(psCodec->pfnSink(pui8Header, sizeof(pui8Header)))
+    {
+        psCodec->ui32OutBytes = sizeof(pui8Header);
+        psCodec->bActive = true;
+    }
+    else
+    {
+        psCodec->ui32Overflows++;
+    }
+}
+
+//*****************************************************************************
+//
+// Sends the closing marker after the last strip, or an abort frame if the
+// image was abandoned.
+//
+//*****************************************************************************
+static void
+ImgWaveletEnd(void *pvStage, bool bComplete)
+{
+    static const uint8_t pui8Abort[IMG_WAVELET_STRIP_HDR] = { 0 };
+    tImgWavelet *psCodec = pvStage;
+    const uint8_t *pui8Data;
+    uint32_t ui32Len;
+
+    if(!psCodec->bActive)
+    {
+        return;
+    }
+
+    psCodec->bActive = false;
+
+    if(bComplete)
+    {
+        pui8Data = (const uint8_t *)IMG_WAVELET_END;
+        ui32Len = sizeof(IMG_WAVELET_END) - 1;
+    }
+    else
+    {
+        pui8Data = pui8Abort;
+        ui32Len = sizeof(pui8Abort);
+    }
+
+    if(psCodec->pfnSink(pui8Data, ui32Len))
+    {
+        psCodec->ui32OutBytes += ui32Len;
+    }
+    else
+    {
+        psCodec->ui32Overflows++;
+    }
+}
+
+//*****************************************************************************
+//
+// Encodes and sends a strip.
+//
+//*****************************************************************************
+static void
+ImgWaveletRows(void *pvStage, uint8_t *pui8Rows, uint32_t ui32Row,
+               uint32_t ui32Count)
+{
+    tImgWavelet *psCodec = pvStage;
+    uint32_t ui32Pixels, ui32Idx, ui32Len, ui32Budget, ui32Step;
+    uint8_t *pui8Frame;
+
+    if(!psCodec->bActive)
+    {
+        return;
+    }
+
+    ui32Pixels = ui32Count * psCodec->ui32Width;
+    for(ui32Idx = 0; ui32Idx < ui32Pixels; ui32Idx++)
+    {
+        psCodec->pi16Coef[ui32Idx] = (int16_t)pui8Rows[ui32Idx] - 128;
+    }
+
+    WaveletTransform(psCodec->pi16Coef, psCodec->ui32Width, ui32Count);
+
+    //
+    // Coarsen the step until the strip fits.  The step must fit in the
+    // strip header, so a strip that does not fit even at the coarsest step
+    // abandons the image.
+    //
+    ui32Step = psCodec->ui32Step;
+    while(!(ui32Len = WaveletCode(psCodec, ui32Count, ui32Step)))
+    {
+        if(ui32Step >= WAVELET_STEP_MAX)
+        {
+            psCodec->ui32Overflows++;
+            ImgWaveletEnd(psCodec, false);
+            return;
+        }
+
+        ui32Step *= 2;
+        if(ui32Step > WAVELET_STEP_MAX)
+        {
+            ui32Step = WAVELET_STEP_MAX;
+        }
+    }
+
+    pui8Frame = psCodec->pui8Frame;
+    pui8Frame[0] = (uint8_t)ui32Count;
+    pui8Frame[1] = (uint8_t)ui32Step;
+    pui8Frame[2] = (uint8_t)(ui32Step >> 8);
+    pui8Frame[3] = (uint8_t)ui32Len;
+    pui8Frame[4] = (uint8_t)(ui32Len >> 8);
+    ui32Len += IMG_WAVELET_STRIP_HDR;
+
+    if(!psCodec->pfnSink(pui8Frame, ui32Len))
+    {
+        psCodec->ui32Overflows++;
+        psCodec->bActive = false;
+        return;
+    }
+
+    psCodec->ui32InBytes += ui32Pixels;
+    psCodec->ui32OutBytes += ui32Len;
+
+    //
+    // Steer the step towards the target rate for the next strip.
+    //
+    ui32Len -= IMG_WAVELET_STRIP_HDR;
+    ui32Budget = (psCodec->ui32Rate * ui32Pixels) / 800;
+    if(ui32Len > ui32Budget)
+    {
+        ui32Step += (ui32Step / 4) + 1;
+    }
+    else if((ui32Len * 4) < (ui32Budget * 3))
+    {
+        ui32Step -= ui32Step / 8;
+    }
+
+    if(ui32Step < WAVELET_STEP_MIN)
+    {
+        ui32Step = WAVELET_STEP_MIN;
+    }
+    else if(ui32Step > WAVELET_STEP_MAX)
+    {
+        ui32Step = WAVELET_STEP_MAX;
+    }
+
+    psCodec->ui32Step = ui32Step;
+}
+
+//*****************************************************************************
+//
+//! Prepares a lossy wavelet encoder stage.
+//!
+//! \param psStage is the stage to fill in.
+//! \param psCodec is the encoder state.
+//! \param pfnSink is called with the encoded image.  It is called from the
+//! pipeline's context and must not wait.
+//!
+//! The stage starts out disabled, at the default rate.
+//!
+//! \return None.
+//
+//*****************************************************************************
+void
+ImgWaveletStageInit(tImgStage *psStage, tImgWavelet *psCodec,
+                    tImgSink pfnSink)
+{
+    memset(psCodec, 0, sizeof(*psCodec));
+    psCodec->pfnSink = pfnSink;
+    psCodec->ui32Rate = IMG_WAVELET_RATE_DEFAULT;
+
+    psStage->pfnStart = ImgWaveletStart;
+    psStage->pfnRows = ImgWaveletRows;
+    psStage->pfnEnd = ImgWaveletEnd;
+    psStage->pvStage = psCodec;
+}
+
+//*****************************************************************************
+//
+//! Enables or disables encoding of the images that follow.
+//!
+//! \param psCodec is the encoder state.
+//! \param bEnable is \b true to encode images.
+//!
+//! An image that is already being encoded is finished.
+//!
+//! \return None.
+//
+//*****************************************************************************
+void
+ImgWaveletEnable(tImgWavelet *psCodec, bool bEnable)
+{
+    psCodec->bEnabled = bEnable;
+}
+
+//*****************************************************************************
+//
+//! Sets the target bit rate of the images that follow.
+//!
+//! \param psCodec is the encoder state.
+//! \param ui32Rate is the rate in hundredths of a bit per pixel.  It is
+//! clamped to IMG_WAVELET_RATE_MIN to IMG_WAVELET_RATE_MAX.
+//!
+//! \return None.
+//
+//*****************************************************************************
+void
+ImgWaveletRateSet(tImgWavelet *psCodec, uint32_t ui32Rate)
+{
+    if(ui32Rate < IMG_WAVELET_RATE_MIN)
+    {
+        ui32Rate = IMG_WAVELET_RATE_MIN;
+    }
+    else if(ui32Rate > IMG_WAVELET_RATE_MAX)
+    {
+        ui32Rate = IMG_WAVELET_RATE_MAX;
+    }
+
+    psCodec->ui32Rate = ui32Rate;
+}
@@ -0,0 +1,124 @@
+//*****************************************************************************
+//
+// img_wavelet.h - Prototypes for the lossy wavelet image encoder stage.
+//
+//*****************************************************************************
+
+#ifndef __IMG_WAVELET_H__
+#define __IMG_WAVELET_H__
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+//*****************************************************************************
+//
+// The markers around an encoded image.  The opening marker is followed by
+// the width and height, each two bytes little endian, and then one frame per
+// strip of rows.
+//
+//*****************************************************************************
+#define IMG_WAVELET_START       "<W>"
+#define IMG_WAVELET_END         "</W>"
+
+//*****************************************************************************
+//
+// A strip frame is the number of rows, the quantizer step and the payload
+// length (both two bytes little endian), followed by the payload.  An
+// abandoned image ends with a frame of zero rows instead of the closing
+// marker.
+//
+//*****************************************************************************
+#define IMG_WAVELET_STRIP_HDR   5
+
+//*****************************************************************************
+//
+// The number of decomposition levels, and the largest payload of a strip.
+// A strip whose code does not fit is coded again with a coarser step, and
+// the image is abandoned if it does not fit at the coarsest.
+//
+//*****************************************************************************
+#define IMG_WAVELET_LEVELS      3
+#define IMG_WAVELET_CODE_SIZE   512
+
+//*****************************************************************************
+//
+// The target bit rate in hundredths of a bit per pixel, the default one and
+// the quantizer step every image starts with, in sixteenths of a grey level.
+// At the highest rate the budget of the widest strip fills the payload, 4
+// bits per pixel, so the step is not held coarser than the rate asks for.
+//
+//*****************************************************************************
+#define IMG_WAVELET_RATE_MIN    10
+#define IMG_WAVELET_RATE_MAX    ((IMG_WAVELET_CODE_SIZE * 800) /              \
+                                 (IMG_PIPE_CHUNK_ROWS * IMG_PIPE_MAX_WIDTH))
+#define IMG_WAVELET_RATE_DEFAULT 80
+#define IMG_WAVELET_STEP_INIT   128
+
+//*****************************************************************************
+//
+// The state of an encoder stage.  The statistics describe the image being
+// encoded or the last one.
+//
+//*****************************************************************************
+typedef struct
+{
+    //
+    // Where the encoded image goes, and whether images are encoded at all.
+    //
+    tImgSink pfnSink;
+    bool bEnabled;
+
+    //
+    // Set while the current image is being encoded.
+    //
+    bool bActive;
+
+    //
+    // The target bit rate and the current quantizer step.
+    //
+    uint32_t ui32Rate;
+    uint32_t ui32Step;
+
+    //
+    // The image width.
+    //
+    uint32_t ui32Width;
+
+    //
+    // The number of pixels taken in and bytes passed to the sink, including
+    // the markers and strip headers.
+    //
+    uint32_t ui32InBytes;
+    uint32_t ui32OutBytes;
+
+    //
+    // The number of images abandoned because the sink could not keep up or a
+    // strip did not fit.
+    //
+    uint32_t ui32Overflows;
+
+    //
+    // The coefficients of the strip being encoded, and its frame.
+    //
+    int16_t pi16Coef[IMG_PIPE_CHUNK_ROWS * IMG_PIPE_MAX_WIDTH];
+    uint8_t pui8Frame[IMG_WAVELET_STRIP_HDR + IMG_WAVELET_CODE_SIZE];
+}
+tImgWavelet;
+
+//*****************************************************************************
+//
+// Prototypes for the APIs.
+//
+//*****************************************************************************
+extern void ImgWaveletStageInit(tImgStage *psStage, tImgWavelet *psCodec,
+                                tImgSink pfnSink);
+extern void ImgWaveletEnable(tImgWavelet *psCodec, bool bEnable);
+extern void ImgWaveletRateSet(tImgWavelet *psCodec, uint32_t ui32Rate);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __IMG_WAVELET_H__
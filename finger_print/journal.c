@@ -0,0 +1,441 @@
+//*****************************************************************************
+//
+// journal.c - Flash event journal.
+//
+// Every registration, compare and clear is appended to a journal in flash,
+// so there is a record of what the reader did that survives a reset or a
+// loss of power.  A flash page can only be erased as a whole, and only so
+// many times, so records are never rewritten in place.  They are appended
+// one after the other with word writes, filling the pages of the journal in
+// turn; when the last page is full the writer goes round to the first, and
+// the page it moves into, holding the oldest records, is erased then.  Each
+// page is erased once per round, so the wear is spread evenly.
+//
+// A page starts with a header holding its sequence number, one more than
+// that of the page before it, so the newest page is the one with the
+// highest number and the oldest is the next one round.  A record carries a
+// CRC-32 of its contents.  Words are programmed in order and the header
+// marker and the record CRC come last, so whatever the power cut off is
+// either still erased or fails its check:
+//
+// - a page whose header has no marker was being erased or opened and holds
+//   no records;
+// - a record that is not erased but fails its CRC was being written and is
+//   skipped;
+// - the next record goes into the first erased slot of the newest page.
+//
+// Recovery after a reset therefore only reads the page headers and the
+// newest page.
+//
+// A host build, which simulates the flash to measure appends and recovery,
+// defines JOURNAL_HOST and provides JournalHostProgram(), JournalHostErase()
+// and JournalHostWord() in place of the flash controller.
+//
+//*****************************************************************************
+
+#include <stdint.h>
+#include <stdbool.h>
+#ifndef JOURNAL_HOST
+#include "inc/hw_types.h"
+#include "driverlib/flash.h"
+#include "driverlib/rom.h"
+#include "driverlib/rom_map.h"
+#endif
+#include "crc_ctx.h"
+#include "journal.h"
+
+//*****************************************************************************
+//
+// Programs words, erases a page and reads a word of the flash.
+//
+//*****************************************************************************
+#ifdef JOURNAL_HOST
+extern int32_t JournalHostProgram(uint32_t *pui32Data, uint32_t ui32Address,
+                                  uint32_t ui32Count);
+extern int32_t JournalHostErase(uint32_t ui32Address);
+extern uint32_t JournalHostWord(uint32_t ui32Address);
+#define JournalProgram(p, a, n) JournalHostProgram(p, a, n)
+#define JournalErase(a)         JournalHostErase(a)
+#define JournalWord(a)          JournalHostWord(a)
+#else
+#define JournalProgram(p, a, n) MAP_FlashProgram(p, a, n)
+#define JournalErase(a)         MAP_FlashErase(a)
+#define JournalWord(a)          HWREG(a)
+#endif
+
+//*****************************************************************************
+//
+// The marker in a page header ("JRNL").  The header is the sequence number
+// followed by the marker, and takes the space of one record.
+//
+//*****************************************************************************
+#define JOURNAL_MARKER          0x4C4E524A
+#define JOURNAL_HEADER_SIZE     16
+
+//*****************************************************************************
+//
+// A record in flash is the time, the type and result, the value and the
+// CRC-32 of those three words.
+//
+//*****************************************************************************
+#define JOURNAL_RECORD_WORDS    4
+#define JOURNAL_RECORD_SIZE     (JOURNAL_RECORD_WORDS * 4)
+#define JOURNAL_PAGE_RECORDS    ((JOURNAL_PAGE_SIZE - JOURNAL_HEADER_SIZE) /  \
+                                 JOURNAL_RECORD_SIZE)
+
+//*****************************************************************************
+//
+// The address of a page.
+//
+//*****************************************************************************
+#define JournalPageAddr(p)      (JOURNAL_BASE + ((p) * JOURNAL_PAGE_SIZE))
+
+//*****************************************************************************
+//
+// The page being written, its sequence number and the offset of the next
+// record in it.  The offset is JOURNAL_PAGE_SIZE when the next record needs
+// a new page.
+//
+//*****************************************************************************
+static uint32_t g_ui32JournalHead;
+static uint32_t g_ui32JournalSeq;
+static uint32_t g_ui32JournalOffset;
+
+//*****************************************************************************
+//
+// The appends and erases made since boot.
+//
+//*****************************************************************************
+static uint32_t g_ui32JournalAppends;
+static uint32_t g_ui32JournalErases;
+
+//*****************************************************************************
+//
+// Returns whether a page has a complete header.
+//
+//*****************************************************************************
+static bool
+JournalPageValid(uint32_t ui32Page)
+{
+    return(JournalWord(JournalPageAddr(ui32Page) + 4) == JOURNAL_MARKER);
+}
+
+//*****************************************************************************
+//
+// Returns whether the words at an address are all erased.
+//
+//*****************************************************************************
+static bool
+JournalBlank(uint32_t ui32Addr, uint32_t ui32Size)
+{
+    for(; ui32Size; ui32Size -= 4, ui32Addr += 4)
+    {
+        if(JournalWord(ui32Addr) != 0xFFFFFFFF)
+        {
+            return(false);
+        }
+    }
+
+    return(true);
+}
+
+//*****************************************************************************
+//
+// Returns the CRC of the first three words of a record, uninverted like
+// those of the records already in flash.
+//
+//*****************************************************************************
+static uint32_t
+JournalCrc(const uint32_t *pui32Words)
+{
+    return(CrcCtxBlock(CRC_CTX_CRC32, (const uint8_t *)pui32Words,
+                       (JOURNAL_RECORD_WORDS - 1) * 4) ^ 0xFFFFFFFF);
+}
+
+//*****************************************************************************
+//
+// Reads the record at an address.  Returns 0 if it is erased, -1 if it is
+// torn and 1 if it is good.
+//
+//*****************************************************************************
+static int32_t
+JournalRecordRead(uint32_t ui32Addr, tJournalRecord *psRecord)
+{
+    uint32_t pui32Words[JOURNAL_RECORD_WORDS], ui32Idx;
+
+    for(ui32Idx = 0; ui32Idx < JOURNAL_RECORD_WORDS; ui32Idx++)
+    {
+        pui32Words[ui32Idx] = JournalWord(ui32Addr + (ui32Idx * 4));
+    }
+
+    if((pui32Words[0] & pui32Words[1] & pui32Words[2] & pui32Words[3]) ==
+       0xFFFFFFFF)
+    {
+        return(0);
+    }
+
+    if(JournalCrc(pui32Words) != pui32Words[3])
+    {
+        return(-1);
+    }
+
+    psRecord->ui32Time = pui32Words[0];
+    psRecord->ui16Type = (uint16_t)pui32Words[1];
+    psRecord->ui16Result = (uint16_t)(pui32Words[1] >> 16);
+    psRecord->ui32Value = pui32Words[2];
+
+    return(1);
+}
+
+//*****************************************************************************
+//
+// Moves the writer into the next page, erasing the oldest records if they
+// are there.  Returns false if the flash could not be written.
+//
+//*****************************************************************************
+static bool
+JournalRotate(void)
+{
+    uint32_t pui32Header[2], ui32Page, ui32Addr;
+
+    ui32Page = (g_ui32JournalHead + 1) % JOURNAL_PAGES;
+    ui32Addr = JournalPageAddr(ui32Page);
+
+    if(!JournalBlank(ui32Addr, JOURNAL_PAGE_SIZE))
+    {
+        g_ui32JournalErases++;
+        if(JournalErase(ui32Addr))
+        {
+            return(false);
+        }
+    }
+
+    pui32Header[0] = g_ui32JournalSeq + 1;
+    pui32Header[1] = JOURNAL_MARKER;
+    if(JournalProgram(pui32Header, ui32Addr, sizeof(pui32Header)))
+    {
+        return(false);
+    }
+
+    g_ui32JournalHead = ui32Page;
+    g_ui32JournalSeq++;
+    g_ui32JournalOffset = JOURNAL_HEADER_SIZE;
+
+    return(true);
+}
+
+//*****************************************************************************
+//
+//! Finds where the journal ends after a reset.
+//!
+//! Only the page headers and the newest page are read; nothing is written
+//! until the next record is appended.
+//!
+//! \return None.
+//
+//*****************************************************************************
+void
+JournalInit(void)
+{
+    uint32_t ui32Page, ui32Seq, ui32Addr;
+
+    //
+    // With no page written yet, the first record opens page 0.
+    //
+    g_ui32JournalHead = JOURNAL_PAGES - 1;
+    g_ui32JournalSeq = 0;
+    g_ui32JournalOffset = JOURNAL_PAGE_SIZE;
+    g_ui32JournalAppends = 0;
+    g_ui32JournalErases = 0;
+
+    for(ui32Page = 0; ui32Page < JOURNAL_PAGES; ui32Page++)
+    {
+        ui32Seq = JournalWord(JournalPageAddr(ui32Page));
+        if(JournalPageValid(ui32Page) && (ui32Seq > g_ui32JournalSeq))
+        {
+            g_ui32JournalHead = ui32Page;
+            g_ui32JournalSeq = ui32Seq;
+        }
+    }
+
+    if(!g_ui32JournalSeq)
+    {
+        return;
+    }
+
+    //
+    // Continue after the last record that was started, good or torn.
+    //
+    ui32Addr = JournalPageAddr(g_ui32JournalHead);
+    for(g_ui32JournalOffset = JOURNAL_HEADER_SIZE;
+        g_ui32JournalOffset < JOURNAL_PAGE_SIZE;
+        g_ui32JournalOffset += JOURNAL_RECORD_SIZE)
+    {
+        if(JournalBlank(ui32Addr + g_ui32JournalOffset, JOURNAL_RECORD_SIZE))
+        {
+            break;
+        }
+    }
+}
+
+//*****************************************************************************
+//
+//! Appends a record to the journal.
+//!
+//! \param psRecord is the record.
+//!
+//! Once every JOURNAL_PAGE_RECORDS records a page is erased, which stalls
+//! the processor, interrupts included, for several milliseconds.
+//!
+//! \return Returns \b false if the flash could not be written.
+//
+//*****************************************************************************
+bool
+JournalAppend(const tJournalRecord *psRecord)
+{
+    uint32_t pui32Words[JOURNAL_RECORD_WORDS], ui32Addr;
+
+    if((g_ui32JournalOffset >= JOURNAL_PAGE_SIZE) && !JournalRotate())
+    {
+        return(false);
+    }
+
+    pui32Words[0] = psRecord->ui32Time;
+    pui32Words[1] = psRecord->ui16Type | (psRecord->ui16Result << 16);
+    pui32Words[2] = psRecord->ui32Value;
+    pui32Words[3] = JournalCrc(pui32Words);
+
+    //
+    // A slot that fails to program is left behind like a torn record.
+    //
+    ui32Addr = JournalPageAddr(g_ui32JournalHead) + g_ui32JournalOffset;
+    g_ui32JournalOffset += JOURNAL_RECORD_SIZE;
+    if(JournalProgram(pui32Words, ui32Addr, sizeof(pui32Words)))
+    {
+        return(false);
+    }
+
+    g_ui32JournalAppends++;
+
+    return(true);
+}
+
+//*****************************************************************************
+//
+//! Starts reading the journal at the oldest record.
+//!
+//! \param psCursor is the reader position to set.
+//!
+//! \return None.
+//
+//*****************************************************************************
+void
+JournalFirst(tJournalCursor *psCursor)
+{
+    psCursor->ui32Page = (g_ui32JournalHead + 1) % JOURNAL_PAGES;
+    psCursor->ui32Offset = JOURNAL_HEADER_SIZE;
+    psCursor->ui32Pages = JOURNAL_PAGES;
+}
+
+//*****************************************************************************
+//
+//! Reads the next record of the journal.
+//!
+//! \param psCursor is the reader position, which is advanced.
+//! \param psRecord is filled in with the record.
+//!
+//! Torn records are skipped.  Records appended while reading are only seen
+//! if they go into the newest page.
+//!
+//! \return Returns \b false when there are no more records.
+//
+//*****************************************************************************
+bool
+JournalNext(tJournalCursor *psCursor, tJournalRecord *psRecord)
+{
+    int32_t i32Read;
+
+    while(psCursor->ui32Pages)
+    {
+        if(!JournalPageValid(psCursor->ui32Page) ||
+           (psCursor->ui32Offset >= JOURNAL_PAGE_SIZE))
+        {
+            i32Read = 0;
+        }
+        else
+        {
+            i32Read = JournalRecordRead(JournalPageAddr(psCursor->ui32Page) +
+                                        psCursor->ui32Offset, psRecord);
+            psCursor->ui32Offset += JOURNAL_RECORD_SIZE;
+        }
+
+        if(i32Read > 0)
+        {
+            return(true);
+        }
+
+        //
+        // An erased record ends the page.
+        //
+        if(i32Read == 0)
+        {
+            psCursor->ui32Page = (psCursor->ui32Page + 1) % JOURNAL_PAGES;
+            psCursor->ui32Offset = JOURNAL_HEADER_SIZE;
+            psCursor->ui32Pages--;
+        }
+    }
+
+    return(false);
+}
+
+//*****************************************************************************
+//
+//! Returns the journal statistics.
+//!
+//! \param psStats is a pointer to the structure that is filled in.
+//!
+//! This reads the whole journal.
+//!
+//! \return None.
+//
+//*****************************************************************************
+void
+JournalStatsGet(tJournalStats *psStats)
+{
+    tJournalRecord sRecord;
+    uint32_t ui32Page, ui32Offset;
+    int32_t i32Read;
+
+    psStats->ui32Records = 0;
+    psStats->ui32Torn = 0;
+    psStats->ui32Capacity = JOURNAL_PAGES * JOURNAL_PAGE_RECORDS;
+    psStats->ui32Appends = g_ui32JournalAppends;
+    psStats->ui32Erases = g_ui32JournalErases;
+
+    for(ui32Page = 0; ui32Page < JOURNAL_PAGES; ui32Page++)
+    {
+        if(!JournalPageValid(ui32Page))
+        {
+            continue;
+        }
+
+        for(ui32Offset = JOURNAL_HEADER_SIZE; ui32Offset < JOURNAL_PAGE_SIZE;
+            ui32Offset += JOURNAL_RECORD_SIZE)
+        {
+            i32Read = JournalRecordRead(JournalPageAddr(ui32Page) + ui32Offset,
+                                        &sRecord);
+            if(i32Read > 0)
+            {
+                psStats->ui32Records++;
+            }
+            else if(i32Read < 0)
+            {
+                psStats->ui32Torn++;
+            }
+            else
+            {
+                break;
+            }
+        }
+    }
+}
@@ -0,0 +1,120 @@
+//*****************************************************************************
+//
+// journal.h - Prototypes for the flash event journal.
+//
+//*****************************************************************************
+
+#ifndef __JOURNAL_H__
+#define __JOURNAL_H__
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+//*****************************************************************************
+//
+// The flash the journal is kept in: the last 16 KB of the 256 KB flash, in
+// 1 KB erase pages.  The linker must not place anything there.
+//
+//*****************************************************************************
+#define JOURNAL_BASE            0x0003C000
+#define JOURNAL_PAGE_SIZE       0x00000400
+#define JOURNAL_PAGES           16
+
+//*****************************************************************************
+//
+// The operations recorded in the journal.
+//
+//*****************************************************************************
+#define JOURNAL_TYPE_BOOT       0   // Value is the STANDBY_WAKE_* reason
+#define JOURNAL_TYPE_REGISTER   1   // Value is the slot
+#define JOURNAL_TYPE_COMPARE    2   // Value is the slot matched
+#define JOURNAL_TYPE_CLEAR      3   // Value is the slot
+#define JOURNAL_TYPE_CLEAR_ALL  4
+#define JOURNAL_TYPE_ENROLL     5   // Value is the global ID
+#define JOURNAL_TYPE_IDENTIFY   6   // Value is the global ID matched
+#define JOURNAL_TYPE_DELETE     7   // Value is the global ID
+
+//*****************************************************************************
+//
+// A journal record.
+//
+//*****************************************************************************
+typedef struct
+{
+    //
+    // When the operation ended, in seconds.
+    //
+    uint32_t ui32Time;
+
+    //
+    // One of the JOURNAL_TYPE_* values, and the outcome in whatever terms
+    // the caller uses.
+    //
+    uint16_t ui16Type;
+    uint16_t ui16Result;
+
+    //
+    // The value that goes with the type.
+    //
+    uint32_t ui32Value;
+}
+tJournalRecord;
+
+//*****************************************************************************
+//
+// The position of a reader in the journal.  The members are private.
+//
+//*****************************************************************************
+typedef struct
+{
+    uint32_t ui32Page;
+    uint32_t ui32Offset;
+    uint32_t ui32Pages;
+}
+tJournalCursor;
+
+//*****************************************************************************
+//
+// Statistics kept by the journal.
+//
+//*****************************************************************************
+typedef struct
+{
+    //
+    // The number of records held and the number the journal has room for.
+    //
+    uint32_t ui32Records;
+    uint32_t ui32Capacity;
+
+    //
+    // The number of records appended and of pages erased since boot.
+    //
+    uint32_t ui32Appends;
+    uint32_t ui32Erases;
+
+    //
+    // The number of torn records found, which were being written when the
+    // power failed and are skipped.
+    //
+    uint32_t ui32Torn;
+}
+tJournalStats;
+
+//*****************************************************************************
+//
+// Prototypes for the APIs.
+//
+//*****************************************************************************
+extern void JournalInit(void);
+extern bool JournalAppend(const tJournalRecord *psRecord);
+extern void JournalFirst(tJournalCursor *psCursor);
+extern bool JournalNext(tJournalCursor *psCursor, tJournalRecord *psRecord);
+extern void JournalStatsGet(tJournalStats *psStats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __JOURNAL_H__
@@ -51,7 +51,35 @@
 #include "driverlib/rom.h"
 #include "driverlib/rom_map.h"
 #include "driverlib/sysctl.h"
+#include "driverlib/systick.h"
 #include "driverlib/uart.h"
+#include "uart_tx.h"
+#include "uart_bridge.h"
+#include "fp_parser.h"
+#include "fp_command.h"
+#include "fp_link.h"
+#include "clock_profile.h"
+#include "console.h"
+#include "bench.h"
+#include "img_pipe.h"
+#include "img_stats.h"
+#include "img_lossless.h"
+#include "img_wavelet.h"
+#include "img_quality.h"
+#include "event.h"
+#include "flow.h"
+#include "fp_flow.h"
+#include "fp_request.h"
+#include "power.h"
+#include "standby.h"
+#include "fp_slots.h"
+#include "journal.h"
+#include "config.h"
+#include "host_proto.h"
+#include "fp_batch.h"
+#include "fp_sensor.h"
+#include "fp_shard.h"
+#include "probe.h"
 
 //*****************************************************************************
 //
@@ -88,6 +116,134 @@
 //
 //*****************************************************************************
 
+//
+// The console baud rate.  It matches the fast sensor link so that sensor data
+// can be forwarded without falling behind.
+//
+#define CONSOLE_BAUD_RATE       115200
+
+//
+// What the processor does while the event loop is idle.  POWER_MODE_DEEP
+// saves more but runs both UARTs from the internal oscillator.
+//
+#define IDLE_POWER_MODE         POWER_MODE_SLEEP
+
+//
+// How long standby lasts before the RTC wakes the processor, in seconds.
+// The wake pin ends it sooner.
+//
+#define STANDBY_WAKE_SECONDS    3600
+
+//
+// The UARTs, besides UART5, that have further sensors attached, as a mask of
+// FP_SENSOR_PORT() bits; for example FP_SENSOR_PORT(1) | FP_SENSOR_PORT(3)
+// for readers on UART1 and UART3.  UART0 is the console and UART5 the main
+// sensor, so neither may be given.
+//
+#define SENSOR_PORTS            0
+
+//
+// What the next key typed on the console is taken as: a menu option, the
+// slot to register or clear, or the key that ends the option.
+//
+#define CONSOLE_STATE_MENU      0
+#define CONSOLE_STATE_REGISTER  1
+#define CONSOLE_STATE_CLEAR     2
+#define CONSOLE_STATE_CONTINUE  3
+
+//
+// What the console speaks, kept in CONFIG_CONSOLE_MODE: the menu, or the
+// binary protocol for host software.
+//
+#define CONSOLE_MODE_TEXT       0
+#define CONSOLE_MODE_BINARY     1
+
+//
+// The event loop timers.
+//
+#define TIMER_FLOW              0
+#define TIMER_REQUEST           1
+#define TIMER_CONFIG            2
+
+//*****************************************************************************
+//
+// The parser for everything the sensor sends, and the last response it has
+// decoded.
+//
+//*****************************************************************************
+static tFpParser g_sSensorParser;
+static uint32_t g_ui32SensorEvent;
+static uint32_t g_ui32SensorValue;
+
+//*****************************************************************************
+//
+// The number of retried sensor commands in a row that have timed out.
+//
+//*****************************************************************************
+static uint32_t g_ui32SensorTimeouts;
+
+//*****************************************************************************
+//
+// The meaning of the next key typed on the console.
+//
+//*****************************************************************************
+static uint32_t g_ui32ConsoleState;
+
+//*****************************************************************************
+//
+// Whether the console speaks the binary protocol, and the sequence number of
+// the host request outstanding and the message that ends it.
+//
+//*****************************************************************************
+static volatile bool g_bConsoleBinary;
+static uint32_t g_ui32HostSeq;
+static uint32_t g_ui32HostPending;
+
+//*****************************************************************************
+//
+// The state kept over standby, and how this boot started.
+//
+//*****************************************************************************
+static tStandbyState g_sStandby;
+static uint32_t g_ui32StandbyWake;
+
+//*****************************************************************************
+//
+// The slot of the outstanding ClearOneFp, recorded in the slot cache once
+// the sensor has answered.
+//
+//*****************************************************************************
+static uint32_t g_ui32ClearSlot;
+
+//*****************************************************************************
+//
+// The image pipeline stage that measures every scanned image, and its
+// results, with the number of payload bytes received of the current image.
+//
+//*****************************************************************************
+static tImgStage g_sImageStatsStage;
+static tImgStats g_sImageStats;
+static volatile uint32_t g_ui32ImageBytes;
+
+//*****************************************************************************
+//
+// The image pipeline stage that compresses scanned images for the console.
+//
+//*****************************************************************************
+static tImgStage g_sImageCodecStage;
+static tImgLossless g_sImageCodec;
+static tImgStage g_sImageLossyStage;
+static tImgWavelet g_sImageLossy;
+
+//*****************************************************************************
+//
+// The image pipeline stage that scores every scanned image and stops the
+// upload of one that cannot pass.
+//
+//*****************************************************************************
+static tImgStage g_sImageQualityStage;
+static tImgQuality g_sImageQuality;
+
 //*****************************************************************************
 //
 // The error routine that is called if the driver library encounters an error.
@@ -100,340 +256,1823 @@ __error__(char *pcFilename, uint32_t ui32Line)
 }
 #endif
 
-void
-UART5IntHandler(void)
+//*****************************************************************************
+//
+// Stores a value in a host message, least significant byte first.
+//
+//*****************************************************************************
+static void
+HostPut32(uint8_t *pui8Buf, uint32_t ui32Value)
 {
-    uint32_t ui32Status;
+    pui8Buf[0] = ui32Value;
+    pui8Buf[1] = ui32Value >> 8;
+    pui8Buf[2] = ui32Value >> 16;
+    pui8Buf[3] = ui32Value >> 24;
+}
 
-    //
-    // Get the interrupt status.
-    //
-    ui32Status = UARTIntStatus(UART5_BASE, true);
+//*****************************************************************************
+//
+// Reads a value from a host message, least significant byte first.
+//
+//*****************************************************************************
+static uint32_t
+HostGet32(const uint8_t *pui8Buf)
+{
+    return(pui8Buf[0] | (pui8Buf[1] << 8) | (pui8Buf[2] << 16) |
+           ((uint32_t)pui8Buf[3] << 24));
+}
+
+//*****************************************************************************
+//
+// Handles a decoded sensor event.  This runs in the UART5 interrupt; image
+// data goes straight into the pipeline and responses are posted to the event
+// loop.  The link negotiation runs before the loop does, so it is told here,
+// and the responses it asked for are kept from the loop.
+//
+//*****************************************************************************
+static void
+SensorEventHandler(void *pvCBData, const tFpEvent *psEvent)
+{
+    ImgPipeEventHandler(psEvent);
+
+    switch(psEvent->ui32Type)
+    {
+    case FP_EVENT_IMAGE_START:
+        g_ui32ImageBytes = 0;
+        break;
+    case FP_EVENT_IMAGE_CHUNK:
+        g_ui32ImageBytes += psEvent->ui32Len;
+        break;
+    default:
+        FpLinkEventHandler(psEvent);
+        if(!FpLinkBusy())
+        {
+            EventPost(EVENT_SENSOR, psEvent->ui32Type, psEvent->ui32Value);
+        }
+        break;
+    }
+}
+
+//*****************************************************************************
+//
+// Records the last sensor response.  This runs from the event loop.
+//
+//*****************************************************************************
+static void
+SensorResponseHandler(const tEvent *psEvent)
+{
+    uint8_t pui8Msg[5];
+
+    g_ui32SensorEvent = psEvent->ui32Param;
+    g_ui32SensorValue = psEvent->ui32Value;
+
+    if(g_bConsoleBinary && g_ui32HostPending)
+    {
+        pui8Msg[0] = psEvent->ui32Param;
+        HostPut32(pui8Msg + 1, psEvent->ui32Value);
+        HostProtoSend(HOST_MSG_EVENT, g_ui32HostSeq, pui8Msg, sizeof(pui8Msg));
+    }
+
+    FpRequestEventHandler(psEvent->ui32Param);
+    FlowSensorEvent(psEvent->ui32Param, psEvent->ui32Value);
+}
+
+//*****************************************************************************
+//
+// The outcomes of sensor operations, indexed by FP_FLOW_RESULT_*.
+//
+//*****************************************************************************
+static const char * const g_ppcSensorResult[] =
+{
+    "done", "failed", "refused", "timed out"
+};
+
+//*****************************************************************************
+//
+// Records the outcome of a sensor operation in the journal.
+//
+//*****************************************************************************
+static void
+SensorJournal(uint32_t ui32Type, uint32_t ui32Result, uint32_t ui32Value)
+{
+    tJournalRecord sRecord;
+
+    sRecord.ui32Time = StandbyTimeGet();
+    sRecord.ui16Type = ui32Type;
+    sRecord.ui16Result = ui32Result;
+    sRecord.ui32Value = ui32Value;
+
+    if(!JournalAppend(&sRecord) && !g_bConsoleBinary)
+    {
+        ConsoleWrite("\r\nJournal write failed\r\n");
+    }
+}
 
+//*****************************************************************************
+//
+// Keeps the slot cache and the journal up to date with the end of a
+// command.
+//
+//*****************************************************************************
+static void
+SensorCommandEnded(uint32_t ui32Cmd, uint32_t ui32Result)
+{
     //
-    // Clear the asserted interrupts.
+    // Put the end of a clear in the terms of the flows.
     //
-    ROM_UARTIntClear(UART5_BASE, ui32Status);
+    if(ui32Result == FP_REQUEST_RESULT_TIMEOUT)
+    {
+        ui32Result = FP_FLOW_RESULT_TIMEOUT;
+    }
+    else if(g_ui32SensorEvent == FP_EVENT_OK)
+    {
+        ui32Result = FP_FLOW_RESULT_OK;
+    }
+    else
+    {
+        ui32Result = (g_ui32SensorEvent == FP_EVENT_FAIL) ?
+                     FP_FLOW_RESULT_FAIL : FP_FLOW_RESULT_NG;
+    }
 
-    if(((ui32Status & UART_INT_RX) == UART_INT_RX) || ((ui32Status & UART_INT_RT) == UART_INT_RT))
+    switch(ui32Cmd)
     {
+    case FP_CMD_CHECK_REGISTERED_NO:
+        if((g_ui32SensorEvent == FP_EVENT_NUMBER) &&
+           (ui32Result != FP_FLOW_RESULT_TIMEOUT) &&
+           !FpSlotsSync(g_ui32SensorValue) && !g_bConsoleBinary)
+        {
+            ConsoleWrite("\r\nSlot cache out of date, asking the sensor\r\n");
+        }
+        break;
+    case FP_CMD_CLEAR_ONE_FP:
         //
-        // Loop while there are characters in the receive FIFO.
+        // The sensor answers FAIL when the slot held nothing to clear, so
+        // the slot is free either way.
         //
-        while(UARTCharsAvail(UART5_BASE))
+        if((ui32Result == FP_FLOW_RESULT_OK) ||
+           (ui32Result == FP_FLOW_RESULT_FAIL))
         {
-            //
-            // Read the next character from the UART5 and write it back to the UART0
-            //
-            ROM_UARTCharPutNonBlocking(UART0_BASE,
-                                       ROM_UARTCharGetNonBlocking(UART5_BASE));
+            FpSlotsSet(g_ui32ClearSlot, false);
+        }
+        SensorJournal(JOURNAL_TYPE_CLEAR, ui32Result, g_ui32ClearSlot);
+        break;
+    case FP_CMD_CLEAR_REGISTERED_FP:
+        if(ui32Result == FP_FLOW_RESULT_OK)
+        {
+            FpSlotsClear();
         }
+        SensorJournal(JOURNAL_TYPE_CLEAR_ALL, ui32Result, 0);
+        break;
+    default:
+        break;
+    }
+}
+
+//*****************************************************************************
+//
+// Finds the sensor again once it has stopped answering, in case it was moved
+// to another rate, for example while the processor was in standby.  This
+// blocks the event loop for up to a few seconds.
+//
+//*****************************************************************************
+static void
+SensorRelink(void)
+{
+    uint32_t ui32Baud;
 
+    if(!g_bConsoleBinary)
+    {
+        ConsoleWrite("\r\nSensor not answering, finding it again\r\n");
     }
 
+    ui32Baud = FpLinkNegotiate();
+
+    if(!g_bConsoleBinary)
+    {
+        if(ui32Baud)
+        {
+            ConsoleWrite("Sensor found at ");
+            ConsoleWriteNum(ui32Baud);
+            ConsoleWrite(" baud\r\n");
+        }
+        else
+        {
+            ConsoleWrite("Sensor not found\r\n");
+        }
+    }
 }
 
 //*****************************************************************************
 //
-// Send a string to the UART.  This function sends a string of characters to a
-// particular UART module.
+// Reports a command the sensor did not answer in time, and tells the flow
+// waiting for it.  This runs from the event loop.
 //
 //*****************************************************************************
-void
-UARTSend(uint32_t ui32UARTBase, const uint8_t *pui8Buffer, uint32_t ui32Count)
+static void
+SensorRequestHandler(uint32_t ui32Cmd, uint32_t ui32Result)
 {
+    tFpRequestPolicy sPolicy;
+    const char *pcName;
+    uint32_t ui32Len;
+    uint8_t pui8Msg[7];
+
     //
-    // Loop while there are more characters to send.
+    // No command is outstanding now, so the link can be negotiated again if
+    // too many have timed out in a row.  A command that waits for the user
+    // is not retried and times out when nobody comes, which says nothing
+    // about the link, so only the short retried commands are counted.
     //
-    while(ui32Count--)
+    FpRequestPolicyGet(ui32Cmd, &sPolicy);
+    if(ui32Result != FP_REQUEST_RESULT_TIMEOUT)
     {
-        //
-        // Write the next character to the UART.
-        //
-        MAP_UARTCharPut(ui32UARTBase, *pui8Buffer++);
+        g_ui32SensorTimeouts = 0;
+    }
+    else if(sPolicy.ui8Retries &&
+            (++g_ui32SensorTimeouts >= FP_LINK_TIMEOUTS))
+    {
+        g_ui32SensorTimeouts = 0;
+        SensorRelink();
+    }
+
+    //
+    // The batch reports its own commands and sends the next one.
+    //
+    if(FpBatchRequestEnded(ui32Cmd, ui32Result) ||
+       FpShardCommandEnded(FP_SHARD_MAIN, ui32Cmd, ui32Result,
+                           g_ui32SensorEvent, g_ui32SensorValue))
+    {
+        return;
+    }
+
+    SensorCommandEnded(ui32Cmd, ui32Result);
+
+    //
+    // Tell the host how a command it sent ended.
+    //
+    if(g_bConsoleBinary && (g_ui32HostPending == HOST_MSG_DONE))
+    {
+        pui8Msg[0] = ui32Cmd;
+        pui8Msg[1] = ui32Result;
+        pui8Msg[2] = g_ui32SensorEvent;
+        HostPut32(pui8Msg + 3, g_ui32SensorValue);
+        HostProtoSend(HOST_MSG_DONE, g_ui32HostSeq, pui8Msg, sizeof(pui8Msg));
+        g_ui32HostPending = 0;
+    }
+
+    if(ui32Result != FP_REQUEST_RESULT_TIMEOUT)
+    {
+        return;
+    }
+
+    if(!g_bConsoleBinary)
+    {
+        pcName = FpCommandName(ui32Cmd, &ui32Len);
+        ConsoleWrite("\r\n");
+        ConsoleWriteLen(pcName, ui32Len);
+        ConsoleWrite(" timed out\r\n");
     }
+
+    FlowSensorEvent(FLOW_EVENT_TIMEOUT, 0);
 }
 
-void startOptions()
+//*****************************************************************************
+//
+// Handles the expiry of an event loop timer.
+//
+//*****************************************************************************
+static void
+TimerHandler(const tEvent *psEvent)
 {
-    //write available options
-    UARTSend(UART0_BASE, (uint8_t *)"\033[2J\033[H1. Check number of registered fingerprints\r\n",
-                             strlen("\033[2J\033[H1. Check number of registered fingerprints\r\n"));
-    UARTSend(UART0_BASE, (uint8_t *)"2. Register fingerprint\r\n",
-                                 strlen("2. Register fingerprint\r\n"));
-    UARTSend(UART0_BASE, (uint8_t *)"3. Compare fingerprint\r\n", strlen("3. Compare fingerprint\r\n"));
-    UARTSend(UART0_BASE, (uint8_t *)"4. Query fingerprint information\r\n", strlen("4. Query fingerprint information\r\n"));
-    UARTSend(UART0_BASE, (uint8_t *)"5. Scan and upload fingerprint image\r\n", strlen("5. Scan and upload fingerprint image\r\n"));
-    UARTSend(UART0_BASE, (uint8_t *)"6. Clear registered fingerprint\r\n", strlen("6. Clear registered fingerprint\r\n"));
-    UARTSend(UART0_BASE, (uint8_t *)"*After the previous option is done, press anything to continue!\r\n",
-                                             strlen("*After the previous option is done, press anything to continue!\r\n"));
+    switch(psEvent->ui32Param)
+    {
+    case TIMER_FLOW:
+        FlowTick();
+        break;
+    case TIMER_REQUEST:
+        FpRequestTick();
+        FpSensorTick();
+        FpBatchRun();
+        break;
+    case TIMER_CONFIG:
+        ConfigTick();
+        FpShardTick();
+        break;
+    default:
+        break;
+    }
+}
+
+//*****************************************************************************
+//
+// Reports the outcome of a registration or a compare, and records it in the
+// journal.  This runs from the event loop.
+//
+//*****************************************************************************
+static void
+SensorFlowHandler(uint32_t ui32Flow, uint32_t ui32Result, uint32_t ui32Value)
+{
+    uint8_t pui8Msg[3];
+
+    if(ui32Flow != FP_FLOW_KEY_SET)
+    {
+        SensorJournal((ui32Flow == FP_FLOW_REGISTER) ? JOURNAL_TYPE_REGISTER :
+                                                       JOURNAL_TYPE_COMPARE,
+                      ui32Result, ui32Value);
+    }
 
     //
-    // Wait for the UART module to complete transmitting.
+    // A registered slot, or one that matched, holds a fingerprint.
     //
-    while(MAP_UARTBusy(UART0_BASE))
+    if((ui32Result == FP_FLOW_RESULT_OK) && (ui32Value != FP_PASS_NO_INDEX) &&
+       (ui32Flow != FP_FLOW_KEY_SET))
+    {
+        FpSlotsSet(ui32Value, true);
+    }
+
+    if(g_bConsoleBinary)
+    {
+        if(g_ui32HostPending == HOST_MSG_FLOW)
+        {
+            pui8Msg[0] = ui32Flow;
+            pui8Msg[1] = ui32Result;
+            pui8Msg[2] = ui32Value;
+            HostProtoSend(HOST_MSG_FLOW, g_ui32HostSeq, pui8Msg,
+                          sizeof(pui8Msg));
+            g_ui32HostPending = 0;
+        }
+        return;
+    }
+
+    ConsoleWrite((ui32Flow == FP_FLOW_REGISTER) ? "\r\nRegister " :
+                 (ui32Flow == FP_FLOW_COMPARE) ? "\r\nCompare " :
+                                                 "\r\nSet KEY ");
+    ConsoleWrite(g_ppcSensorResult[ui32Result]);
+    if((ui32Result == FP_FLOW_RESULT_OK) && (ui32Value != FP_PASS_NO_INDEX) &&
+       (ui32Flow != FP_FLOW_KEY_SET))
     {
+        ConsoleWrite(", slot ");
+        ConsoleWriteNum(ui32Value);
     }
+    ConsoleWrite("\r\n");
 }
 
-void checkRegisteredNumber()
+//*****************************************************************************
+//
+// The names of the sensor responses, indexed by FP_EVENT_*.
+//
+//*****************************************************************************
+static const char * const g_ppcSensorEvent[] =
+{
+    "OK", "NG", "FINISHED", "PASS", "FAIL", "INFO", "DS", "KEY", "number",
+    "text", "image", "image data", "image end"
+};
+
+//*****************************************************************************
+//
+// Prints how a command ended on one of the further sensors.  This runs from
+// the event loop.
+//
+//*****************************************************************************
+static void
+ReaderCommandHandler(uint32_t ui32Sensor, uint32_t ui32Cmd,
+                     uint32_t ui32Result, uint32_t ui32Event,
+                     uint32_t ui32Value)
 {
-    UARTSend(UART5_BASE, (uint8_t*)"<C>CheckRegisteredNo</C>", strlen("<C>CheckRegisteredNo</C>"));
+    const char *pcName;
+    uint32_t ui32Len;
+
+    if(FpShardCommandEnded(ui32Sensor, ui32Cmd, ui32Result, ui32Event,
+                           ui32Value) || g_bConsoleBinary)
+    {
+        return;
+    }
+
+    pcName = FpCommandName(ui32Cmd, &ui32Len);
+    ConsoleWrite("\r\nSensor ");
+    ConsoleWriteNum(ui32Sensor);
+    ConsoleWrite(": ");
+    ConsoleWriteLen(pcName, ui32Len);
+    if(ui32Result == FP_REQUEST_RESULT_TIMEOUT)
+    {
+        ConsoleWrite(" timed out\r\n");
+        return;
+    }
+
+    ConsoleWrite(" ");
+    ConsoleWrite(g_ppcSensorEvent[ui32Event]);
+    if((ui32Event == FP_EVENT_NUMBER) || (ui32Event == FP_EVENT_DS) ||
+       ((ui32Event == FP_EVENT_PASS) && (ui32Value != FP_PASS_NO_INDEX)))
+    {
+        ConsoleWrite(" ");
+        ConsoleWriteNum(ui32Value);
+    }
+    ConsoleWrite("\r\n");
 }
 
-void writeIndexMenu()
+//*****************************************************************************
+//
+// Reports the outcome of an enrollment, identification or deletion across
+// the sensors, and keeps the journal up to date with it.  This runs from the
+// event loop.
+//
+//*****************************************************************************
+static void
+ShardHandler(uint32_t ui32Op, uint32_t ui32Result, uint32_t ui32Id,
+             uint32_t ui32Sensor, uint32_t ui32Slot)
 {
-    UARTSend(UART0_BASE, (uint8_t *)"Enter index:\r\n", strlen("Enter index:\r\n\r\n"));
+    static const uint16_t pui16Type[] =
+    {
+        JOURNAL_TYPE_ENROLL, JOURNAL_TYPE_IDENTIFY, JOURNAL_TYPE_DELETE
+    };
+
+    SensorJournal(pui16Type[ui32Op], ui32Result, ui32Id);
+
+    if(g_bConsoleBinary)
+    {
+        return;
+    }
 
-    //write menu
-    UARTSend(UART0_BASE, (uint8_t *)"a. 0-index\r\n", strlen("a. 0-index\r\n"));
-    UARTSend(UART0_BASE, (uint8_t *)"b. 1-index\r\n", strlen("b. 1-index\r\n"));
-    UARTSend(UART0_BASE, (uint8_t *)"c. 2-index\r\n", strlen("c. 2-index\r\n"));
-    UARTSend(UART0_BASE, (uint8_t *)"d. 3-index\r\n", strlen("d. 3-index\r\n"));
-    UARTSend(UART0_BASE, (uint8_t *)"e. 4-index\r\n", strlen("e. 4-index\r\n"));
-    UARTSend(UART0_BASE, (uint8_t *)"f. 5-index\r\n", strlen("f. 5-index\r\n"));
-    UARTSend(UART0_BASE, (uint8_t *)"g. 6-index\r\n", strlen("g. 6-index\r\n"));
-    UARTSend(UART0_BASE, (uint8_t *)"h. 7-index\r\n", strlen("h. 7-index\r\n"));
-    UARTSend(UART0_BASE, (uint8_t *)"i. 8-index\r\n", strlen("i. 8-index\r\n"));
-    UARTSend(UART0_BASE, (uint8_t *)"j. 9-index\r\n", strlen("j. 9-index\r\n"));
-    UARTSend(UART0_BASE, (uint8_t *)"k. 10-index\r\n", strlen("k. 10-index\r\n"));
-    UARTSend(UART0_BASE, (uint8_t *)"l. 11-index\r\n", strlen("l. 11-index\r\n"));
-    UARTSend(UART0_BASE, (uint8_t *)"m. 12-index\r\n", strlen("m. 12-index\r\n"));
-    UARTSend(UART0_BASE, (uint8_t *)"n. 13-index\r\n", strlen("n. 13-index\r\n"));
-    UARTSend(UART0_BASE, (uint8_t *)"o. 14-index\r\n", strlen("o. 14-index\r\n"));
-    UARTSend(UART0_BASE, (uint8_t *)"p. 15-index\r\n", strlen("p. 15-index\r\n"));
-    UARTSend(UART0_BASE, (uint8_t *)"q. 16-index\r\n", strlen("q. 16-index\r\n"));
-    UARTSend(UART0_BASE, (uint8_t *)"r. 17-index\r\n", strlen("r. 17-index\r\n"));
-    UARTSend(UART0_BASE, (uint8_t *)"s. 18-index\r\n", strlen("s. 18-index\r\n"));
-    UARTSend(UART0_BASE, (uint8_t *)"t. 19-index\r\n", strlen("t. 19-index\r\n"));
-    UARTSend(UART0_BASE, (uint8_t *)"u. 20-index\r\n", strlen("u. 20-index\r\n"));
-    UARTSend(UART0_BASE, (uint8_t *)"v. 21-index\r\n", strlen("v. 21-index\r\n"));
-    UARTSend(UART0_BASE, (uint8_t *)"w. 22-index\r\n", strlen("w. 22-index\r\n"));
-    UARTSend(UART0_BASE, (uint8_t *)"x. 23-index\r\n", strlen("x. 23-index\r\n"));
+    ConsoleWrite((ui32Op == FP_SHARD_ENROLL) ? "\r\nEnroll " :
+                 (ui32Op == FP_SHARD_IDENTIFY) ? "\r\nIdentify " :
+                                                 "\r\nDelete ");
+    ConsoleWrite(g_ppcSensorResult[ui32Result]);
+    if(ui32Result == FP_FLOW_RESULT_OK)
+    {
+        ConsoleWrite(", ID ");
+        ConsoleWriteNum(ui32Id);
+        ConsoleWrite(" on sensor ");
+        ConsoleWriteNum(ui32Sensor);
+        ConsoleWrite(" slot ");
+        ConsoleWriteNum(ui32Slot);
+    }
+    ConsoleWrite("\r\n");
 }
 
-uint8_t terminalRead()
+//*****************************************************************************
+//
+// Parses what one of the further sensors has sent.  This runs from the event
+// loop.
+//
+//*****************************************************************************
+static void
+ReaderDataHandler(const tEvent *psEvent)
+{
+    FpSensorProcess(psEvent->ui32Param);
+}
+
+//*****************************************************************************
+//
+// Tells the user that a sensor operation is still running.
+//
+//*****************************************************************************
+static void
+SensorBusy(void)
+{
+    ConsoleWrite("Sensor busy, wait for the running operation to end!\r\n");
+}
+
+//*****************************************************************************
+//
+// Feeds sensor data forwarded by the uDMA bridge to the parser.
+//
+//*****************************************************************************
+static void
+SensorBridgeRx(const uint8_t *pui8Data, uint32_t ui32Len)
+{
+    uint32_t ui32Start;
+
+    ui32Start = ProbeStart();
+    FpParserFeed(&g_sSensorParser, pui8Data, ui32Len);
+    ProbeRecord(PROBE_PARSE, ui32Start);
+}
+
+//*****************************************************************************
+//
+// Queues encoded image data for the console.  This runs in the UART5
+// interrupt, which shares the console ring with the event loop, so it must
+// not wait for space.
+//
+//*****************************************************************************
+static bool
+ImageSink(const uint8_t *pui8Data, uint32_t ui32Len)
+{
+    if(UARTTxSpaceAvail(UART0_BASE) < ui32Len)
+    {
+        return(false);
+    }
+
+    UARTTxQueue(UART0_BASE, pui8Data, ui32Len);
+
+    return(true);
+}
+
+//*****************************************************************************
+//
+// Asks for a new scan as soon as an image is rejected.  Like ImageSink(),
+// this runs in the UART5 interrupt and must not wait, so the prompt is
+// skipped whole if the console ring has no room for it.
+//
+//*****************************************************************************
+static void
+ImageQualityHandler(uint32_t ui32Verdict, uint32_t ui32Score)
+{
+    static const char pcPrompt[] =
+        "\r\nPoor scan, upload stopped. Press any key and scan again.\r\n";
+
+    if((ui32Verdict == IMG_QUALITY_REJECTED) &&
+       (UARTTxSpaceAvail(UART0_BASE) >= (sizeof(pcPrompt) - 1)))
+    {
+        UARTTxQueue(UART0_BASE, (const uint8_t *)pcPrompt,
+                    sizeof(pcPrompt) - 1);
+    }
+}
+
+//*****************************************************************************
+//
+// The UART0 interrupt handler.  UART0 interrupts to post the keys typed on
+// the console to the event loop, or the frames sent by the host in binary
+// mode, to have its transmit FIFO refilled from the console ring, or when the
+// bridge has finished sending a buffer.
+//
+//*****************************************************************************
+void
+UART0IntHandler(void)
+{
+    uint32_t ui32Status, ui32Count, ui32Start;
+    uint8_t ui8Char;
+
+    ui32Start = ProbeStart();
+
+    //
+    // Get and clear the interrupt status.
+    //
+    ui32Status = UARTIntStatus(UART0_BASE, true);
+    ROM_UARTIntClear(UART0_BASE, ui32Status);
+
+    if(ui32Status & (UART_INT_RX | UART_INT_RT))
+    {
+        for(ui32Count = 0; UARTCharsAvail(UART0_BASE); ui32Count++)
+        {
+            ui8Char = ROM_UARTCharGetNonBlocking(UART0_BASE);
+            if(!g_bConsoleBinary)
+            {
+                EventPost(EVENT_CONSOLE, 0, ui8Char);
+            }
+            else if(HostProtoRxByte(ui8Char))
+            {
+                EventPost(EVENT_FRAME, 0, 0);
+            }
+        }
+        PowerRxNote(UART0_BASE, ui32Count);
+    }
+
+    if((ui32Status & UART_INT_TX) == UART_INT_TX)
+    {
+        UARTTxIntHandler(UART0_BASE);
+    }
+
+    UARTBridgeTxIntHandler();
+
+    ProbeRecord(PROBE_UART0_ISR, ui32Start);
+}
+
+void
+UART5IntHandler(void)
+{
+    uint32_t ui32Status, ui32Count, ui32Start, ui32Parse;
+    uint8_t ui8Char;
+
+    ui32Start = ProbeStart();
+
+    //
+    // Get the interrupt status.
+    //
+    ui32Status = UARTIntStatus(UART5_BASE, true);
+
+    //
+    // Clear the asserted interrupts.
+    //
+    ROM_UARTIntClear(UART5_BASE, ui32Status);
+
+    if(UARTBridgeIsEnabled())
+    {
+        //
+        // The uDMA is forwarding sensor data.
+        //
+        ui32Parse = ProbeStart();
+        UARTBridgeRxIntHandler(ui32Status);
+        ProbeRecord(PROBE_FORWARD, ui32Parse);
+    }
+    else if(((ui32Status & UART_INT_RX) == UART_INT_RX) || ((ui32Status & UART_INT_RT) == UART_INT_RT))
+    {
+        //
+        // Loop while there are characters in the receive FIFO.
+        //
+        for(ui32Count = 0; UARTCharsAvail(UART5_BASE); ui32Count++)
+        {
+            //
+            // Read the next character from the UART5, parse it and write it
+            // back to the UART0, unless the host is reading binary messages
+            // there.
+            //
+            ui8Char = ROM_UARTCharGetNonBlocking(UART5_BASE);
+            ui32Parse = ProbeStart();
+            FpParserFeed(&g_sSensorParser, &ui8Char, 1);
+            ProbeRecord(PROBE_PARSE, ui32Parse);
+            if(!g_bConsoleBinary)
+            {
+                UARTTxQueue(UART0_BASE, &ui8Char, 1);
+            }
+        }
+        PowerRxNote(UART5_BASE, ui32Count);
+    }
+
+    //
+    // Refill the transmit FIFO with the rest of the pending command.
+    //
+    if((ui32Status & UART_INT_TX) == UART_INT_TX)
+    {
+        UARTTxIntHandler(UART5_BASE);
+    }
+
+    ProbeRecord(PROBE_UART5_ISR, ui32Start);
+}
+
+//*****************************************************************************
+//
+// The interrupt handlers of the UARTs of the further sensors.  Each posts
+// the sensor to the event loop when it has data to parse.  If the queue is
+// full the sensor is told, so that its next interrupt posts again.
+//
+//*****************************************************************************
+static void
+SensorPortIntHandler(uint32_t ui32Sensor)
+{
+    uint32_t ui32Start;
+
+    ui32Start = ProbeStart();
+
+    if(FpSensorIntHandler(ui32Sensor) &&
+       !EventPost(EVENT_READER, ui32Sensor, 0))
+    {
+        FpSensorPostFailed(ui32Sensor);
+    }
+
+    ProbeRecord(PROBE_READER_ISR, ui32Start);
+}
+
+void
+UART1IntHandler(void)
+{
+    SensorPortIntHandler(1);
+}
+
+void
+UART2IntHandler(void)
+{
+    SensorPortIntHandler(2);
+}
+
+void
+UART3IntHandler(void)
+{
+    SensorPortIntHandler(3);
+}
+
+void
+UART4IntHandler(void)
+{
+    SensorPortIntHandler(4);
+}
+
+void
+UART6IntHandler(void)
+{
+    SensorPortIntHandler(6);
+}
+
+void
+UART7IntHandler(void)
+{
+    SensorPortIntHandler(7);
+}
+
+//*****************************************************************************
+//
+// The SysTick interrupt handler, which drives the event loop timers.
+//
+//*****************************************************************************
+void
+SysTickIntHandler(void)
+{
+    EventTick();
+}
+
+//*****************************************************************************
+//
+// Keeps the SysTick period at one event loop tick when the clock changes.
+//
+//*****************************************************************************
+static void
+SysTickClockChange(uint32_t ui32OldFreq, uint32_t ui32NewFreq)
+{
+    MAP_SysTickPeriodSet(ui32NewFreq / EVENT_TICKS_PER_SECOND);
+}
+
+//*****************************************************************************
+//
+// Send a string to the UART.  This function queues a string of characters on
+// the transmit ring of a particular UART module; the UART interrupt sends them
+// in the background.  It only waits when the string does not fit in the free
+// space of the ring.
+//
+//*****************************************************************************
+void
+UARTSend(uint32_t ui32UARTBase, const uint8_t *pui8Buffer, uint32_t ui32Count)
+{
+    uint32_t ui32Queued;
+
+    //
+    // Loop while there are more characters to queue.
+    //
+    while(ui32Count)
+    {
+        ui32Queued = UARTTxSpaceAvail(ui32UARTBase);
+        if(ui32Queued > ui32Count)
+        {
+            ui32Queued = ui32Count;
+        }
+
+        ui32Queued = UARTTxQueue(ui32UARTBase, pui8Buffer, ui32Queued);
+        pui8Buffer += ui32Queued;
+        ui32Count -= ui32Queued;
+    }
+}
+
+void startOptions()
+{
+    //write available options
+    ConsoleWrite("\033[2J\033[H1. Check number of registered fingerprints\r\n");
+    ConsoleWrite("2. Register fingerprint\r\n");
+    ConsoleWrite("3. Compare fingerprint\r\n");
+    ConsoleWrite("4. Query fingerprint information\r\n");
+    ConsoleWrite("5. Scan and upload fingerprint image\r\n");
+    ConsoleWrite("6. Clear registered fingerprint\r\n");
+    ConsoleWrite("7. Benchmark clock profiles and CRCs\r\n");
+    ConsoleWrite("8. Scan and upload compressed fingerprint image\r\n");
+    ConsoleWrite("9. Scan and upload lossy compressed fingerprint image\r\n");
+    ConsoleWrite("0. Show event loop and command statistics\r\n");
+    ConsoleWrite("j. Show journal\r\n");
+    ConsoleWrite("p. Show probe timings\r\n");
+    ConsoleWrite("s. Enter standby\r\n");
+    ConsoleWrite("b. Switch to binary protocol\r\n");
+    if(FpSensorPortsGet())
+    {
+        ConsoleWrite("m. Show all sensors\r\n");
+        ConsoleWrite("c. Compare on all sensors\r\n");
+    }
+    ConsoleWrite("e. Enroll on the emptiest sensor\r\n");
+    ConsoleWrite("i. Identify on all sensors\r\n");
+    ConsoleWrite("*After the previous option is done, press anything to continue!\r\n");
+}
+
+//*****************************************************************************
+//
+// Encode a command and send it to the sensor with its deadline.  Returns
+// false, after telling the user, if another command is outstanding.
+//
+//*****************************************************************************
+bool sendSensorCommand(uint32_t ui32Cmd)
+{
+    uint8_t pui8Frame[FP_COMMAND_BUF_SIZE];
+
+    if(!FpRequestSend(ui32Cmd, pui8Frame,
+                      FpCommandEncode(ui32Cmd, pui8Frame, sizeof(pui8Frame))))
+    {
+        SensorBusy();
+        return(false);
+    }
+
+    return(true);
+}
+
+bool sendSensorCommandNum(uint32_t ui32Cmd, uint32_t ui32Value)
+{
+    uint8_t pui8Frame[FP_COMMAND_BUF_SIZE];
+
+    if(!FpRequestSend(ui32Cmd, pui8Frame,
+                      FpCommandEncodeNum(ui32Cmd, ui32Value, pui8Frame,
+                                         sizeof(pui8Frame))))
+    {
+        SensorBusy();
+        return(false);
+    }
+
+    return(true);
+}
+
+//*****************************************************************************
+//
+// Print the number of registered fingerprints, from the slot cache when it
+// is known and from the sensor otherwise.
+//
+//*****************************************************************************
+void checkRegisteredNumber()
+{
+    if(!FpSlotsIsKnown())
+    {
+        sendSensorCommand(FP_CMD_CHECK_REGISTERED_NO);
+        return;
+    }
+
+    ConsoleWriteNum(FpSlotsCount());
+    ConsoleWrite(" registered, ");
+    ConsoleWriteNum(FP_SLOTS_NUM - FpSlotsCount());
+    ConsoleWrite(" free\r\n");
+}
+
+//*****************************************************************************
+//
+// Show the slots to choose from, marking the ones the cache knows are used.
+// A registration can also take the first free slot.
+//
+//*****************************************************************************
+void writeIndexMenu(bool bRegister)
+{
+    uint32_t ui32Slot;
+    char cKey;
+
+    ConsoleWrite("Enter index:\r\n");
+
+    for(ui32Slot = 0; ui32Slot < FP_SLOTS_NUM; ui32Slot++)
+    {
+        cKey = 'a' + ui32Slot;
+        ConsoleWriteLen(&cKey, 1);
+        ConsoleWrite(". ");
+        ConsoleWriteNum(ui32Slot);
+        ConsoleWrite("-index");
+        if(FpSlotsIsKnown() && FpSlotsIsUsed(ui32Slot))
+        {
+            ConsoleWrite(" (used)");
+        }
+        ConsoleWrite("\r\n");
+    }
+
+    if(bRegister && FpSlotsIsKnown() && (FpSlotsNextFree() != FP_SLOTS_NONE))
+    {
+        ConsoleWrite("y. first free index (");
+        ConsoleWriteNum(FpSlotsNextFree());
+        ConsoleWrite(")\r\n");
+    }
+}
+
+void registerOneFp(uint8_t index)
+{
+    uint32_t ui32Slot;
+
+    //
+    // Menu entries 'a' to 'x' select slots 0 to 23, and 'y' the first free
+    // one.
+    //
+    if((index == 'y') && FpSlotsIsKnown() &&
+       (FpSlotsNextFree() != FP_SLOTS_NONE))
+    {
+        ui32Slot = FpSlotsNextFree();
+    }
+    else if((index >= 'a') && (index <= 'x'))
+    {
+        ui32Slot = index - 'a';
+    }
+    else
+    {
+        ui32Slot = FP_SLOTS_NONE;
+    }
+
+    if(ui32Slot != FP_SLOTS_NONE)
+    {
+        //
+        // Do not overwrite a fingerprint; it has to be cleared first.
+        //
+        if(FpSlotsIsKnown() && FpSlotsIsUsed(ui32Slot))
+        {
+            ConsoleWrite("Slot in use, clear it first! Press anything to continue!\r\n");
+        }
+        else if(!FpFlowRegister(ui32Slot))
+        {
+            SensorBusy();
+        }
+    }
+    else
+    {
+        ConsoleWrite("Wrong input! Press anything to continue!\r\n");
+    }
+}
+
+void compareFingerprint()
+{
+    if(!FpFlowCompare())
+    {
+        SensorBusy();
+    }
+}
+
+void fpImageInformation()
+{
+    sendSensorCommand(FP_CMD_FP_IMAGE_INFORMATION);
+}
+
+void scanFpImage()
+{
+    ImgLosslessEnable(&g_sImageCodec, false);
+    ImgWaveletEnable(&g_sImageLossy, false);
+    if(!sendSensorCommand(FP_CMD_SCAN_FP_IMAGE))
+    {
+        return;
+    }
+
+    //
+    // Let the uDMA forward the image so that no byte is lost.
+    //
+    UARTBridgeEnable(true);
+}
+
+void scanFpImageCompressed(bool bLossy)
+{
+    ImgLosslessEnable(&g_sImageCodec, !bLossy);
+    ImgWaveletEnable(&g_sImageLossy, bLossy);
+    if(!sendSensorCommand(FP_CMD_SCAN_FP_IMAGE))
+    {
+        return;
+    }
+
+    //
+    // Let the uDMA receive the image; the encoder sends it on.
+    //
+    UARTBridgeEnable(false);
+}
+
+//*****************************************************************************
+//
+// Print the statistics of the last image once it has been received in full.
+//
+//*****************************************************************************
+void reportImage()
+{
+    static const char * const ppcVerdict[] =
+    {
+        "none", "good", "poor", "rejected"
+    };
+
+    if(g_sImageQuality.ui32Verdict != IMG_QUALITY_NONE)
+    {
+        ConsoleWrite("Quality ");
+        ConsoleWriteNum(g_sImageQuality.ui32Score);
+        ConsoleWrite(" (");
+        ConsoleWrite(ppcVerdict[g_sImageQuality.ui32Verdict]);
+        ConsoleWrite("): coverage ");
+        ConsoleWriteNum(g_sImageQuality.ui32Coverage);
+        ConsoleWrite(", coherence ");
+        ConsoleWriteNum(g_sImageQuality.ui32Coherence);
+        ConsoleWrite(", contrast ");
+        ConsoleWriteNum(g_sImageQuality.ui32Contrast);
+        ConsoleWrite(", variance ");
+        ConsoleWriteNum(g_sImageQuality.ui32Variance);
+        ConsoleWrite("\r\n");
+        g_sImageQuality.ui32Verdict = IMG_QUALITY_NONE;
+    }
+
+    if(!g_sImageStats.bComplete)
+    {
+        return;
+    }
+
+    g_sImageStats.bComplete = false;
+
+    ConsoleWrite("Image ");
+    ConsoleWriteNum(g_sImageStats.ui32Width);
+    ConsoleWrite("x");
+    ConsoleWriteNum(g_sImageStats.ui32Height);
+    ConsoleWrite(": min ");
+    ConsoleWriteNum(g_sImageStats.ui32Min);
+    ConsoleWrite(", max ");
+    ConsoleWriteNum(g_sImageStats.ui32Max);
+    ConsoleWrite(", mean ");
+    ConsoleWriteNum(ImgStatsMean(&g_sImageStats));
+    if(g_sImageCodec.ui32InBytes)
+    {
+        ConsoleWrite(", compressed ");
+        ConsoleWriteNum(g_sImageCodec.ui32InBytes);
+        ConsoleWrite(" to ");
+        ConsoleWriteNum(g_sImageCodec.ui32OutBytes);
+        ConsoleWrite(" bytes");
+    }
+    if(g_sImageLossy.ui32InBytes)
+    {
+        ConsoleWrite(", lossy ");
+        ConsoleWriteNum(g_sImageLossy.ui32InBytes);
+        ConsoleWrite(" to ");
+        ConsoleWriteNum(g_sImageLossy.ui32OutBytes);
+        ConsoleWrite(" bytes");
+    }
+    ConsoleWrite("\r\n");
+}
+
+//*****************************************************************************
+//
+// Print the dispatch latency of each event type since the last report.
+//
+//*****************************************************************************
+void reportEvents()
+{
+    static const char * const ppcType[] =
+    {
+        "console", "sensor", "timer", "frame", "reader"
+    };
+    tEventStats sStats;
+    uint32_t ui32Type, ui32CyclesPerUs;
+
+    ui32CyclesPerUs = ClockFreqGet() / 1000000;
+
+    for(ui32Type = 0; ui32Type < (sizeof(ppcType) / sizeof(ppcType[0]));
+        ui32Type++)
+    {
+        EventStatsGet(ui32Type, &sStats);
+
+        ConsoleWrite(ppcType[ui32Type]);
+        ConsoleWrite(": ");
+        ConsoleWriteNum(sStats.ui32Count);
+        ConsoleWrite(" events, ");
+        ConsoleWriteNum(sStats.ui32Dropped);
+        ConsoleWrite(" dropped");
+        if(sStats.ui32Count)
+        {
+            ConsoleWrite(", latency mean ");
+            ConsoleWriteNum((uint32_t)(sStats.ui64TotalLatency /
+                                       sStats.ui32Count));
+            ConsoleWrite(" max ");
+            ConsoleWriteNum(sStats.ui32MaxLatency);
+            ConsoleWrite(" cycles (");
+            ConsoleWriteNum(sStats.ui32MaxLatency / ui32CyclesPerUs);
+            ConsoleWrite(" us)");
+        }
+        ConsoleWrite("\r\n");
+    }
+
+    EventStatsReset();
+}
+
+//*****************************************************************************
+//
+// Print how often the processor slept, and how long received data waited
+// for it to wake up.
+//
+//*****************************************************************************
+void reportPower()
+{
+    tPowerStats sStats;
+
+    PowerStatsGet(&sStats);
+
+    ConsoleWrite("Idle: ");
+    ConsoleWriteNum(sStats.ui32Sleeps);
+    ConsoleWrite(" sleeps, ");
+    ConsoleWriteNum(sStats.ui32DeepSleeps);
+    ConsoleWrite(" deep sleeps, ");
+    ConsoleWriteNum(sStats.ui32RxWakes);
+    ConsoleWrite(" receive wakes, first read up to ");
+    ConsoleWriteNum(sStats.ui32MaxRxWaiting);
+    ConsoleWrite(" bytes (");
+    ConsoleWriteNum((sStats.ui32MaxRxWaiting * 10000000) / FpLinkBaudGet());
+    ConsoleWrite(" us) late, ");
+    ConsoleWriteNum(sStats.ui32Overruns);
+    ConsoleWrite(" overruns\r\n");
+}
+
+//*****************************************************************************
+//
+// Print how often the settings changed and how much was written to EEPROM.
+//
+//*****************************************************************************
+void reportConfig()
+{
+    tConfigStats sStats;
+
+    ConfigStatsGet(&sStats);
+
+    ConsoleWrite("Config: layout ");
+    ConsoleWriteNum(sStats.ui32Version);
+    ConsoleWrite(", ");
+    ConsoleWriteNum(sStats.ui32Changes);
+    ConsoleWrite(" changes in ");
+    ConsoleWriteNum(sStats.ui32Commits);
+    ConsoleWrite(" commits, ");
+    ConsoleWriteNum(sStats.ui32Words);
+    ConsoleWrite(" words written, ");
+    ConsoleWriteNum(sStats.ui32Skipped);
+    ConsoleWrite(" unchanged\r\n");
+}
+
+//*****************************************************************************
+//
+// Print how much sensor data the uDMA bridge forwarded, and how often it fell
+// behind.
+//
+//*****************************************************************************
+void reportBridge()
+{
+    tUARTBridgeStats sStats;
+
+    UARTBridgeStatsGet(&sStats);
+
+    ConsoleWrite("Bridge: ");
+    ConsoleWriteNum(sStats.ui32Bytes);
+    ConsoleWrite(" bytes forwarded, ");
+    ConsoleWriteNum(sStats.ui32Swaps);
+    ConsoleWrite(" full buffers, ");
+    ConsoleWriteNum(sStats.ui32Flushes);
+    ConsoleWrite(" flushed on timeout, ");
+    ConsoleWriteNum(sStats.ui32Overruns);
+    ConsoleWrite(" overruns\r\n");
+}
+
+//*****************************************************************************
+//
+// Print the state of every sensor: the main one on UART5 and the further
+// ones.
+//
+//*****************************************************************************
+void reportSensors()
+{
+    tFpSensorStats sStats;
+    uint32_t ui32Sensor, ui32Slots;
+
+    ConsoleWrite("Sensor 5: ");
+    ConsoleWrite((FpRequestIsBusy() || FpFlowIsBusy()) ? "busy" : "idle");
+    ConsoleWrite(", last ");
+    ConsoleWrite(g_ppcSensorEvent[g_ui32SensorEvent]);
+    ConsoleWrite(", ");
+    ConsoleWriteNum(FpSlotsCount());
+    ConsoleWrite(FpSlotsIsKnown() ? " registered\r\n" : " registered?\r\n");
+
+    for(ui32Sensor = 1; ui32Sensor <= FP_SENSOR_MAX; ui32Sensor++)
+    {
+        if(!(FpSensorPortsGet() & FP_SENSOR_PORT(ui32Sensor)))
+        {
+            continue;
+        }
+
+        FpSensorStatsGet(ui32Sensor, &sStats);
+
+        ConsoleWrite("Sensor ");
+        ConsoleWriteNum(ui32Sensor);
+        ConsoleWrite(": ");
+        ConsoleWrite(FpSensorIsBusy(ui32Sensor) ? "busy" : "idle");
+        ConsoleWrite(", last ");
+        ConsoleWrite(g_ppcSensorEvent[sStats.ui32Event]);
+        ConsoleWrite(", ");
+        ConsoleWriteNum(sStats.ui32Sent);
+        ConsoleWrite(" sent, ");
+        ConsoleWriteNum(sStats.ui32Completed);
+        ConsoleWrite(" answered, ");
+        ConsoleWriteNum(sStats.ui32Retries);
+        ConsoleWrite(" retries, ");
+        ConsoleWriteNum(sStats.ui32Timeouts);
+        ConsoleWrite(" timeouts, ");
+        ConsoleWriteNum(sStats.ui32RxBytes);
+        ConsoleWrite(" bytes in, ");
+        ConsoleWriteNum(sStats.ui32RxDropped);
+        ConsoleWrite(" lost\r\n");
+    }
+
+    //
+    // Every sensor, the main one included, holds FP_SHARD_SLOTS identities.
+    //
+    ui32Slots = FP_SHARD_SLOTS;
+    for(ui32Sensor = 1; ui32Sensor <= FP_SENSOR_MAX; ui32Sensor++)
+    {
+        if(FpSensorPortsGet() & FP_SENSOR_PORT(ui32Sensor))
+        {
+            ui32Slots += FP_SHARD_SLOTS;
+        }
+    }
+
+    ConsoleWrite("Shard: ");
+    ConsoleWriteNum(FpShardCount());
+    ConsoleWrite(" of ");
+    ConsoleWriteNum(ui32Slots);
+    ConsoleWrite(" IDs enrolled\r\n");
+}
+
+//*****************************************************************************
+//
+// Start a compare on every sensor that is free, all at once.  The outcomes
+// are printed as each one ends.
+//
+//*****************************************************************************
+void compareAllSensors()
+{
+    uint8_t pui8Frame[FP_COMMAND_BUF_SIZE];
+    uint32_t ui32Sensor, ui32Len;
+
+    ui32Len = FpCommandEncode(FP_CMD_COMPARE_FINGERPRINT, pui8Frame,
+                              sizeof(pui8Frame));
+    for(ui32Sensor = 1; ui32Sensor <= FP_SENSOR_MAX; ui32Sensor++)
+    {
+        if((FpSensorPortsGet() & FP_SENSOR_PORT(ui32Sensor)) &&
+           !FpSensorSend(ui32Sensor, FP_CMD_COMPARE_FINGERPRINT, pui8Frame,
+                         ui32Len))
+        {
+            ConsoleWrite("Sensor ");
+            ConsoleWriteNum(ui32Sensor);
+            ConsoleWrite(" busy\r\n");
+        }
+    }
+
+    compareFingerprint();
+}
+
+//*****************************************************************************
+//
+// Print the binary protocol statistics.
+//
+//*****************************************************************************
+void reportHost()
+{
+    tHostProtoStats sStats;
+
+    HostProtoStatsGet(&sStats);
+
+    ConsoleWrite("Host: ");
+    ConsoleWriteNum(sStats.ui32Received);
+    ConsoleWrite(" received, ");
+    ConsoleWriteNum(sStats.ui32Sent);
+    ConsoleWrite(" sent, ");
+    ConsoleWriteNum(sStats.ui32Bad);
+    ConsoleWrite(" bad, ");
+    ConsoleWriteNum(sStats.ui32Overruns);
+    ConsoleWrite(" overruns\r\n");
+}
+
+//*****************************************************************************
+//
+// Print the deadline statistics of every command that has been sent.
+//
+//*****************************************************************************
+void reportRequests()
+{
+    tFpRequestStats sStats;
+    const char *pcName;
+    uint32_t ui32Cmd, ui32Len;
+
+    for(ui32Cmd = 0; ui32Cmd < FP_CMD_COUNT; ui32Cmd++)
+    {
+        FpRequestStatsGet(ui32Cmd, &sStats);
+        if(!sStats.ui32Sent)
+        {
+            continue;
+        }
+
+        pcName = FpCommandName(ui32Cmd, &ui32Len);
+        ConsoleWriteLen(pcName, ui32Len);
+        ConsoleWrite(": sent ");
+        ConsoleWriteNum(sStats.ui32Sent);
+        ConsoleWrite(", answered ");
+        ConsoleWriteNum(sStats.ui32Completed);
+        ConsoleWrite(", retries ");
+        ConsoleWriteNum(sStats.ui32Retries);
+        ConsoleWrite(", timeouts ");
+        ConsoleWriteNum(sStats.ui32Timeouts);
+        ConsoleWrite(", slowest ");
+        ConsoleWriteNum(sStats.ui32MaxMs);
+        ConsoleWrite(" ms\r\n");
+    }
+}
+
+//*****************************************************************************
+//
+// Print how long it took from reset until the menu was shown, and whether
+// the boot was a wake from standby.
+//
+//*****************************************************************************
+void reportBoot(uint32_t ui32Cycles)
+{
+    ConsoleWrite((g_ui32StandbyWake == STANDBY_WAKE_NONE) ? "Cold boot" :
+                 (g_ui32StandbyWake == STANDBY_WAKE_RTC) ?
+                 "Woke from standby (RTC)" : "Woke from standby (pin)");
+    ConsoleWrite(", ready in ");
+    ConsoleWriteNum(ui32Cycles / (ClockFreqGet() / 1000));
+    ConsoleWrite(" ms, ");
+    ConsoleWriteNum(g_sStandby.ui32Standbys);
+    ConsoleWrite(" standbys, ");
+    ConsoleWriteNum(g_sStandby.ui32RTCWakes);
+    ConsoleWrite(" RTC wakes, ");
+    ConsoleWriteNum(g_sStandby.ui32PinWakes);
+    ConsoleWrite(" pin wakes\r\n");
+}
+
+//*****************************************************************************
+//
+// Power everything but the hibernation module down, keeping the sensor link
+// rate so the next wake does not have to negotiate it.
+//
+//*****************************************************************************
+void enterStandby()
+{
+    if(FpFlowIsBusy())
+    {
+        SensorBusy();
+        return;
+    }
+
+    ConsoleWrite("Entering standby, press the wake button to wake up\r\n");
+    UARTTxFlush(UART0_BASE);
+    ConfigFlush();
+
+    g_sStandby.ui32Baud = FpLinkBaudGet();
+    g_sStandby.ui32Slots = FpSlotsMapGet();
+    StandbyEnter(&g_sStandby, STANDBY_WAKE_SECONDS);
+}
+
+//*****************************************************************************
+//
+// Print every record in the journal, oldest first.
+//
+//*****************************************************************************
+void reportJournal()
+{
+    static const char * const ppcType[] =
+    {
+        "boot", "register", "compare", "clear", "clear all", "enroll",
+        "identify", "delete"
+    };
+    tJournalCursor sCursor;
+    tJournalRecord sRecord;
+    tJournalStats sStats;
+
+    JournalFirst(&sCursor);
+    while(JournalNext(&sCursor, &sRecord))
+    {
+        ConsoleWriteNum(sRecord.ui32Time);
+        ConsoleWrite(" s: ");
+        if(sRecord.ui16Type == JOURNAL_TYPE_BOOT)
+        {
+            ConsoleWrite(ppcType[JOURNAL_TYPE_BOOT]);
+            ConsoleWrite((sRecord.ui32Value == STANDBY_WAKE_NONE) ? " cold" :
+                         " from standby");
+        }
+        else if(sRecord.ui16Type <= JOURNAL_TYPE_DELETE)
+        {
+            ConsoleWrite(ppcType[sRecord.ui16Type]);
+            ConsoleWrite(" ");
+            ConsoleWrite((sRecord.ui16Result <= FP_FLOW_RESULT_TIMEOUT) ?
+                         g_ppcSensorResult[sRecord.ui16Result] : "?");
+            if((sRecord.ui16Type >= JOURNAL_TYPE_ENROLL) &&
+               (sRecord.ui32Value < FP_SHARD_MAX_IDS))
+            {
+                ConsoleWrite(", ID ");
+                ConsoleWriteNum(sRecord.ui32Value);
+            }
+            else if((sRecord.ui16Type < JOURNAL_TYPE_CLEAR_ALL) &&
+                    (sRecord.ui32Value != FP_PASS_NO_INDEX))
+            {
+                ConsoleWrite(", slot ");
+                ConsoleWriteNum(sRecord.ui32Value);
+            }
+        }
+        ConsoleWrite("\r\n");
+    }
+
+    JournalStatsGet(&sStats);
+    ConsoleWrite("Journal: ");
+    ConsoleWriteNum(sStats.ui32Records);
+    ConsoleWrite(" of ");
+    ConsoleWriteNum(sStats.ui32Capacity);
+    ConsoleWrite(" records, ");
+    ConsoleWriteNum(sStats.ui32Torn);
+    ConsoleWrite(" torn, ");
+    ConsoleWriteNum(sStats.ui32Appends);
+    ConsoleWrite(" appends and ");
+    ConsoleWriteNum(sStats.ui32Erases);
+    ConsoleWrite(" page erases since boot\r\n");
+}
+
+void clearOneFp(uint8_t delete_index)
+{
+    if((delete_index >= 'a') && (delete_index <= 'x'))
+    {
+        g_ui32ClearSlot = delete_index - 'a';
+        sendSensorCommandNum(FP_CMD_CLEAR_ONE_FP, g_ui32ClearSlot);
+    }
+    else
+    {
+        ConsoleWrite("Wrong input! Press anything to continue!\r\n");
+    }
+}
+
+//*****************************************************************************
+//
+// Switch the console between the menu and the binary protocol, and keep the
+// choice over resets.
+//
+//*****************************************************************************
+void consoleModeSet(uint32_t ui32Mode)
 {
-    uint8_t input  = ROM_UARTCharGet(UART0_BASE);
-    return input;
+    ConfigNumSet(CONFIG_CONSOLE_MODE, ui32Mode);
+    g_ui32HostPending = 0;
+    g_bConsoleBinary = (ui32Mode == CONSOLE_MODE_BINARY);
+
+    if(!g_bConsoleBinary)
+    {
+        FpBatchCancel();
+        startOptions();
+        g_ui32ConsoleState = CONSOLE_STATE_MENU;
+    }
 }
 
-void registerOneFp(uint8_t index)
+//*****************************************************************************
+//
+// Start a menu option and return what the next key is taken as.
+//
+//*****************************************************************************
+uint32_t sendCommand(uint8_t cmd)
 {
-    switch(index)
+    switch(cmd)
     {
-    case 'a':
-        UARTSend(UART5_BASE, (uint8_t*)"<C>RegisterOneFp=0</C>", strlen("<C>RegisterOneFp=0</C>"));
-        break;
-    case 'b':
-        UARTSend(UART5_BASE, (uint8_t*)"<C>RegisterOneFp=1</C>", strlen("<C>RegisterOneFp=1</C>"));
+    case '1':
+        checkRegisteredNumber();
         break;
-    case 'c':
-        UARTSend(UART5_BASE, (uint8_t*)"<C>RegisterOneFp=2</C>", strlen("<C>RegisterOneFp=2</C>"));
+    case '2':
+        writeIndexMenu(true);
+
+        //the next key is the index
+        return(CONSOLE_STATE_REGISTER);
+    case '3':
+        compareFingerprint();
         break;
-    case 'd':
-        UARTSend(UART5_BASE, (uint8_t*)"<C>RegisterOneFp=3</C>", strlen("<C>RegisterOneFp=3</C>"));
+    case '4':
+        fpImageInformation();
         break;
-    case 'e':
-        UARTSend(UART5_BASE, (uint8_t*)"<C>RegisterOneFp=4</C>", strlen("<C>RegisterOneFp=4</C>"));
+    case '5':
+        scanFpImage();
         break;
-    case 'f':
-        UARTSend(UART5_BASE, (uint8_t*)"<C>RegisterOneFp=5</C>", strlen("<C>RegisterOneFp=5</C>"));
+    case '6':
+        writeIndexMenu(false);
+
+        //the next key is the index
+        return(CONSOLE_STATE_CLEAR);
+    case '7':
+        BenchClockProfiles();
+        BenchCrc();
         break;
-    case 'g':
-        UARTSend(UART5_BASE, (uint8_t*)"<C>RegisterOneFp=6</C>", strlen("<C>RegisterOneFp=6</C>"));
+    case '8':
+        scanFpImageCompressed(false);
         break;
-    case 'h':
-        UARTSend(UART5_BASE, (uint8_t*)"<C>RegisterOneFp=7</C>", strlen("<C>RegisterOneFp=7</C>"));
+    case '9':
+        scanFpImageCompressed(true);
         break;
-    case 'i':
-        UARTSend(UART5_BASE, (uint8_t*)"<C>RegisterOneFp=8</C>", strlen("<C>RegisterOneFp=8</C>"));
+    case '0':
+        reportEvents();
+        reportRequests();
+        reportPower();
+        reportConfig();
+        reportBridge();
+        reportHost();
         break;
     case 'j':
-        UARTSend(UART5_BASE, (uint8_t*)"<C>RegisterOneFp=9</C>", strlen("<C>RegisterOneFp=9</C>"));
-        break;
-    case 'k':
-        UARTSend(UART5_BASE, (uint8_t*)"<C>RegisterOneFp=10</C>", strlen("<C>RegisterOneFp=10</C>"));
-        break;
-    case 'l':
-        UARTSend(UART5_BASE, (uint8_t*)"<C>RegisterOneFp=11</C>", strlen("<C>RegisterOneFp=11</C>"));
-        break;
-    case 'm':
-        UARTSend(UART5_BASE, (uint8_t*)"<C>RegisterOneFp=12</C>", strlen("<C>RegisterOneFp=12</C>"));
-        break;
-    case 'n':
-        UARTSend(UART5_BASE, (uint8_t*)"<C>RegisterOneFp=13</C>", strlen("<C>RegisterOneFp=13</C>"));
-        break;
-    case 'o':
-        UARTSend(UART5_BASE, (uint8_t*)"<C>RegisterOneFp=14</C>", strlen("<C>RegisterOneFp=14</C>"));
+        reportJournal();
         break;
     case 'p':
-        UARTSend(UART5_BASE, (uint8_t*)"<C>RegisterOneFp=15</C>", strlen("<C>RegisterOneFp=15</C>"));
-        break;
-    case 'q':
-        UARTSend(UART5_BASE, (uint8_t*)"<C>RegisterOneFp=16</C>", strlen("<C>RegisterOneFp=16</C>"));
-        break;
-    case 'r':
-        UARTSend(UART5_BASE, (uint8_t*)"<C>RegisterOneFp=17</C>", strlen("<C>RegisterOneFp=17</C>"));
+        ProbeDump();
         break;
     case 's':
-        UARTSend(UART5_BASE, (uint8_t*)"<C>RegisterOneFp=18</C>", strlen("<C>RegisterOneFp=18</C>"));
+        enterStandby();
         break;
-    case 't':
-        UARTSend(UART5_BASE, (uint8_t*)"<C>RegisterOneFp=19</C>", strlen("<C>RegisterOneFp=19</C>"));
-        break;
-    case 'u':
-        UARTSend(UART5_BASE, (uint8_t*)"<C>RegisterOneFp=20</C>", strlen("<C>RegisterOneFp=20</C>"));
+    case 'm':
+        reportSensors();
         break;
-    case ('v'):
-        UARTSend(UART5_BASE, (uint8_t*)"<C>RegisterOneFp=21</C>", strlen("<C>RegisterOneFp=21</C>"));
+    case 'c':
+        compareAllSensors();
         break;
-    case ('w'):
-        UARTSend(UART5_BASE, (uint8_t*)"<C>RegisterOneFp=22</C>", strlen("<C>RegisterOneFp=22</C>"));
+    case 'e':
+        if(!FpShardEnroll())
+        {
+            ConsoleWrite("Cannot enroll: sensor busy or every slot taken\r\n");
+        }
         break;
-    case ('x'):
-        UARTSend(UART5_BASE, (uint8_t*)"<C>RegisterOneFp=23</C>", strlen("<C>RegisterOneFp=23</C>"));
+    case 'i':
+        if(!FpShardIdentify())
+        {
+            ConsoleWrite("Cannot identify: sensors busy or nobody enrolled\r\n");
+        }
         break;
+    case 'b':
+        ConsoleWrite("Switching to binary protocol\r\n");
+        consoleModeSet(CONSOLE_MODE_BINARY);
+        return(CONSOLE_STATE_MENU);
     default:
-        UARTSend(UART0_BASE, (uint8_t*)"Wrong input! Press anything to continue!\r\n",
-                                         strlen("Wrong input! Press anything to continue!\r\n"));
         break;
     }
-}
 
-void compareFingerprint()
-{
-    UARTSend(UART5_BASE, (uint8_t*)"<C>CompareFingerprint</C>", strlen("<C>CompareFingerprint</C>"));
+    return(CONSOLE_STATE_CONTINUE);
 }
 
-void fpImageInformation()
+//*****************************************************************************
+//
+// End the current option and show the menu again.
+//
+//*****************************************************************************
+void finishCommand()
 {
-    UARTSend(UART5_BASE, (uint8_t*)"<C>FpImageInformation</C>", strlen("<C>FpImageInformation</C>"));
-}
+    //hand sensor forwarding back to the CPU
+    UARTBridgeDisable();
 
-void scanFpImage()
-{
-    UARTSend(UART5_BASE, (uint8_t*)"<C>ScanFpImage</C>", strlen("<C>ScanFpImage</C>"));
+    //drop an image that was cut short and report a complete one
+    ROM_IntDisable(INT_UART5);
+    ImgPipeAbort();
+    ROM_IntEnable(INT_UART5);
+    reportImage();
+
+    startOptions();
 }
 
-void clearOneFp(uint8_t delete_index)
+//*****************************************************************************
+//
+// Handles a key typed on the console.  This runs from the event loop.
+//
+//*****************************************************************************
+static void
+ConsoleKeyHandler(const tEvent *psEvent)
 {
-    switch(delete_index)
+    uint8_t ui8Key = (uint8_t)psEvent->ui32Value;
+
+    switch(g_ui32ConsoleState)
     {
-    case 'a':
-        UARTSend(UART5_BASE, (uint8_t*)"<C>ClearOneFp=0</C>", strlen("<C>ClearOneFp=0</C>"));
-        break;
-    case 'b':
-        UARTSend(UART5_BASE, (uint8_t*)"<C>ClearOneFp=1</C>", strlen("<C>ClearOneFp=1</C>"));
-        break;
-    case 'c':
-        UARTSend(UART5_BASE, (uint8_t*)"<C>ClearOneFp=2</C>", strlen("<C>ClearOneFp=2</C>"));
-        break;
-    case 'd':
-        UARTSend(UART5_BASE, (uint8_t*)"<C>ClearOneFp=3</C>", strlen("<C>ClearOneFp=3</C>"));
-        break;
-    case 'e':
-        UARTSend(UART5_BASE, (uint8_t*)"<C>ClearOneFp=4</C>", strlen("<C>ClearOneFp=4</C>"));
-        break;
-    case 'f':
-        UARTSend(UART5_BASE, (uint8_t*)"<C>ClearOneFp=5</C>", strlen("<C>ClearOneFp=5</C>"));
-        break;
-    case 'g':
-        UARTSend(UART5_BASE, (uint8_t*)"<C>ClearOneFp=6</C>", strlen("<C>ClearOneFp=6</C>"));
-        break;
-    case 'h':
-        UARTSend(UART5_BASE, (uint8_t*)"<C>ClearOneFp=7</C>", strlen("<C>ClearOneFp=7</C>"));
-        break;
-    case 'i':
-        UARTSend(UART5_BASE, (uint8_t*)"<C>ClearOneFp=8</C>", strlen("<C>ClearOneFp=8</C>"));
-        break;
-    case 'j':
-        UARTSend(UART5_BASE, (uint8_t*)"<C>ClearOneFp=9</C>", strlen("<C>ClearOneFp=9</C>"));
-        break;
-    case 'k':
-        UARTSend(UART5_BASE, (uint8_t*)"<C>ClearOneFp=10</C>", strlen("<C>ClearOneFp=10</C>"));
+    case CONSOLE_STATE_MENU:
+        g_ui32ConsoleState = sendCommand(ui8Key);
         break;
-    case 'l':
-        UARTSend(UART5_BASE, (uint8_t*)"<C>ClearOneFp=11</C>", strlen("<C>ClearOneFp=11</C>"));
+    case CONSOLE_STATE_REGISTER:
+        registerOneFp(ui8Key);
+        g_ui32ConsoleState = CONSOLE_STATE_CONTINUE;
         break;
-    case 'm':
-        UARTSend(UART5_BASE, (uint8_t*)"<C>ClearOneFp=12</C>", strlen("<C>ClearOneFp=12</C>"));
-        break;
-    case 'n':
-        UARTSend(UART5_BASE, (uint8_t*)"<C>ClearOneFp=13</C>", strlen("<C>ClearOneFp=13</C>"));
-        break;
-    case 'o':
-        UARTSend(UART5_BASE, (uint8_t*)"<C>ClearOneFp=14</C>", strlen("<C>ClearOneFp=14</C>"));
-        break;
-    case 'p':
-        UARTSend(UART5_BASE, (uint8_t*)"<C>ClearOneFp=15</C>", strlen("<C>ClearOneFp=15</C>"));
-        break;
-    case 'q':
-        UARTSend(UART5_BASE, (uint8_t*)"<C>ClearOneFp=16</C>", strlen("<C>ClearOneFp=16</C>"));
-        break;
-    case 'r':
-        UARTSend(UART5_BASE, (uint8_t*)"<C>ClearOneFp=17</C>", strlen("<C>ClearOneFp=17</C>"));
-        break;
-    case 's':
-        UARTSend(UART5_BASE, (uint8_t*)"<C>ClearOneFp=18</C>", strlen("<C>ClearOneFp=18</C>"));
-        break;
-    case 't':
-        UARTSend(UART5_BASE, (uint8_t*)"<C>ClearOneFp=19</C>", strlen("<C>ClearOneFp=19</C>"));
-        break;
-    case 'u':
-        UARTSend(UART5_BASE, (uint8_t*)"<C>ClearOneFp=20</C>", strlen("<C>ClearOneFp=20</C>"));
-        break;
-    case ('v'):
-        UARTSend(UART5_BASE, (uint8_t*)"<C>ClearOneFp=21</C>", strlen("<C>ClearOneFp=21</C>"));
-        break;
-    case ('w'):
-        UARTSend(UART5_BASE, (uint8_t*)"<C>ClearOneFp=22</C>", strlen("<C>ClearOneFp=22</C>"));
-        break;
-    case ('x'):
-        UARTSend(UART5_BASE, (uint8_t*)"<C>ClearOneFp=23</C>", strlen("<C>ClearOneFp=23</C>"));
+    case CONSOLE_STATE_CLEAR:
+        clearOneFp(ui8Key);
+        g_ui32ConsoleState = CONSOLE_STATE_CONTINUE;
         break;
     default:
-        UARTSend(UART0_BASE, (uint8_t*)"Wrong input! Press anything to continue!\r\n",
-                                                 strlen("Wrong input! Press anything to continue!\r\n"));
+        finishCommand();
+        g_ui32ConsoleState = CONSOLE_STATE_MENU;
         break;
     }
 }
 
-void sendCommand(uint8_t cmd)
+//*****************************************************************************
+//
+// Reports a command of a batch to the host, and keeps the slot cache and the
+// journal up to date with it.  This runs from the event loop.
+//
+//*****************************************************************************
+static void
+HostBatchHandler(uint32_t ui32Tag, uint32_t ui32Cmd, const uint8_t *pui8Arg,
+                 uint32_t ui32ArgLen, uint32_t ui32Result)
+{
+    uint8_t pui8Msg[8];
+
+    if(ui32Result != FP_BATCH_RESULT_INVALID)
+    {
+        if((ui32Cmd == FP_CMD_CLEAR_ONE_FP) && (ui32ArgLen == 4))
+        {
+            g_ui32ClearSlot = HostGet32(pui8Arg);
+        }
+        SensorCommandEnded(ui32Cmd, ui32Result);
+    }
+
+    if(g_bConsoleBinary)
+    {
+        pui8Msg[0] = ui32Tag;
+        pui8Msg[1] = ui32Cmd;
+        pui8Msg[2] = ui32Result;
+        pui8Msg[3] = g_ui32SensorEvent;
+        HostPut32(pui8Msg + 4, g_ui32SensorValue);
+        HostProtoSend(HOST_MSG_ITEM, ui32Tag >> 8, pui8Msg, sizeof(pui8Msg));
+    }
+}
+
+//*****************************************************************************
+//
+// Queues the commands of a batch, each a length followed by the payload of a
+// HOST_MSG_COMMAND, and returns the HOST_STATUS_* to acknowledge it with.
+// Either all of them are queued or none.
+//
+//*****************************************************************************
+static uint32_t
+HostBatchAdd(uint32_t ui32Seq, const uint8_t *pui8Payload, uint32_t ui32Len,
+             uint32_t *pui32Count)
 {
-    switch(cmd)
+    uint8_t pui8Frame[FP_COMMAND_BUF_SIZE];
+    uint32_t ui32Pos, ui32Count, ui32Cmd, ui32EntryLen;
+
+    //
+    // Check every command before queuing any.
+    //
+    for(ui32Pos = 0, ui32Count = 0; ui32Pos < ui32Len; ui32Count++)
     {
-    case '1':
-        checkRegisteredNumber();
-        break;
-    case '2':
-        writeIndexMenu();
+        ui32EntryLen = pui8Payload[ui32Pos++];
+        if(!ui32EntryLen || (ui32Pos + ui32EntryLen > ui32Len) ||
+           (ui32EntryLen > FP_BATCH_ARG_SIZE + 1))
+        {
+            return(HOST_STATUS_INVALID);
+        }
+
+        ui32Cmd = pui8Payload[ui32Pos];
+        if((ui32Cmd == FP_CMD_SCAN_FP_IMAGE) ||
+           !FpCommandEncodeArg(ui32Cmd, pui8Payload + ui32Pos + 1,
+                               ui32EntryLen - 1, pui8Frame,
+                               sizeof(pui8Frame)))
+        {
+            return(HOST_STATUS_INVALID);
+        }
+        ui32Pos += ui32EntryLen;
+    }
+
+    if(!ui32Count)
+    {
+        return(HOST_STATUS_INVALID);
+    }
+    if((ui32Count > FpBatchSpaceAvail()) || FpFlowIsBusy())
+    {
+        return(HOST_STATUS_BUSY);
+    }
+
+    for(ui32Pos = 0, ui32Count = 0; ui32Pos < ui32Len; ui32Count++)
+    {
+        ui32EntryLen = pui8Payload[ui32Pos++];
+        FpBatchAdd((ui32Seq << 8) | ui32Count, pui8Payload[ui32Pos],
+                   pui8Payload + ui32Pos + 1, ui32EntryLen - 1);
+        ui32Pos += ui32EntryLen;
+    }
+
+    *pui32Count = ui32Count;
+
+    return(HOST_STATUS_OK);
+}
+
+//*****************************************************************************
+//
+// Starts what a host request asks for and acknowledges it.  Commands end
+// with HOST_MSG_DONE, registrations and compares with HOST_MSG_FLOW, and the
+// commands of a batch each with HOST_MSG_ITEM.  This runs from the event
+// loop.
+//
+//*****************************************************************************
+static void
+HostMessageHandler(uint32_t ui32Type, uint32_t ui32Seq,
+                   const uint8_t *pui8Payload, uint32_t ui32Len)
+{
+    static uint8_t pui8Ack[HOST_PROTO_MAX_PAYLOAD];
+    uint8_t pui8Frame[FP_COMMAND_BUF_SIZE];
+    char pcID[FP_FLOW_TEXT_SIZE + 1], pcKey[FP_FLOW_TEXT_SIZE + 1];
+    uint32_t ui32AckLen, ui32Cmd, ui32Pending, ui32FrameLen, ui32Count;
 
-        //wait for user to enter index
-        uint8_t index = terminalRead();
+    pui8Ack[0] = HOST_STATUS_INVALID;
+    ui32AckLen = 1;
+    ui32Pending = 0;
 
-        registerOneFp(index);
+    switch(ui32Type)
+    {
+    case HOST_MSG_PING:
+        if(ui32Len >= HOST_PROTO_MAX_PAYLOAD)
+        {
+            ui32Len = HOST_PROTO_MAX_PAYLOAD - 1;
+        }
+        memcpy(pui8Ack + 1, pui8Payload, ui32Len);
+        ui32AckLen += ui32Len;
+        pui8Ack[0] = HOST_STATUS_OK;
         break;
-    case '3':
-        compareFingerprint();
+    case HOST_MSG_COMMAND:
+        //
+        // Images are sent raw, which the protocol cannot carry.
+        //
+        ui32Cmd = ui32Len ? pui8Payload[0] : FP_CMD_COUNT;
+        if((ui32Cmd >= FP_CMD_COUNT) || (ui32Cmd == FP_CMD_SCAN_FP_IMAGE))
+        {
+            break;
+        }
+
+        ui32FrameLen = FpCommandEncodeArg(ui32Cmd, pui8Payload + 1,
+                                          ui32Len - 1, pui8Frame,
+                                          sizeof(pui8Frame));
+        if(!ui32FrameLen)
+        {
+            break;
+        }
+
+        pui8Ack[0] = HOST_STATUS_BUSY;
+        if(FpFlowIsBusy() || FpRequestIsBusy() || FpBatchIsBusy())
+        {
+            break;
+        }
+
+        if(ui32Cmd == FP_CMD_CLEAR_ONE_FP)
+        {
+            g_ui32ClearSlot = HostGet32(pui8Payload + 1);
+        }
+        if(FpRequestSend(ui32Cmd, pui8Frame, ui32FrameLen))
+        {
+            pui8Ack[0] = HOST_STATUS_OK;
+            ui32Pending = HOST_MSG_DONE;
+        }
         break;
-    case '4':
-        fpImageInformation();
+    case HOST_MSG_REGISTER:
+        if((ui32Len != 1) || (pui8Payload[0] >= FP_SLOTS_NUM) ||
+           (FpSlotsIsKnown() && FpSlotsIsUsed(pui8Payload[0])))
+        {
+            break;
+        }
+        pui8Ack[0] = HOST_STATUS_BUSY;
+        if(!FpBatchIsBusy() && FpFlowRegister(pui8Payload[0]))
+        {
+            pui8Ack[0] = HOST_STATUS_OK;
+            ui32Pending = HOST_MSG_FLOW;
+        }
         break;
-    case '5':
-        scanFpImage();
+    case HOST_MSG_COMPARE:
+        pui8Ack[0] = HOST_STATUS_BUSY;
+        if(!FpBatchIsBusy() && FpFlowCompare())
+        {
+            pui8Ack[0] = HOST_STATUS_OK;
+            ui32Pending = HOST_MSG_FLOW;
+        }
         break;
-    case '6':
-        writeIndexMenu();
-
-        //wait for user to enter index
-        uint8_t del_index = terminalRead();
+    case HOST_MSG_KEY_SET:
+        //
+        // The ID is counted and the KEY takes the rest; FpFlowKeySet() takes
+        // both as strings.
+        //
+        if(!ui32Len || !pui8Payload[0] ||
+           (pui8Payload[0] > FP_FLOW_TEXT_SIZE) ||
+           (pui8Payload[0] > (ui32Len - 1)) ||
+           ((ui32Len - 1 - pui8Payload[0]) > FP_FLOW_TEXT_SIZE))
+        {
+            break;
+        }
+        memcpy(pcID, pui8Payload + 1, pui8Payload[0]);
+        pcID[pui8Payload[0]] = 0;
+        memcpy(pcKey, pui8Payload + 1 + pui8Payload[0],
+               ui32Len - 1 - pui8Payload[0]);
+        pcKey[ui32Len - 1 - pui8Payload[0]] = 0;
 
-        clearOneFp(del_index);
+        pui8Ack[0] = HOST_STATUS_BUSY;
+        if(!FpBatchIsBusy() && FpFlowKeySet(pcID, pcKey))
+        {
+            pui8Ack[0] = HOST_STATUS_OK;
+            ui32Pending = HOST_MSG_FLOW;
+        }
+        break;
+    case HOST_MSG_SLOTS:
+        pui8Ack[0] = HOST_STATUS_OK;
+        pui8Ack[1] = FpSlotsIsKnown();
+        pui8Ack[2] = FpSlotsCount();
+        HostPut32(pui8Ack + 3, FpSlotsMapGet());
+        ui32AckLen = 7;
+        break;
+    case HOST_MSG_BATCH:
+        ui32Count = 0;
+        pui8Ack[0] = HostBatchAdd(ui32Seq, pui8Payload, ui32Len, &ui32Count);
+        pui8Ack[1] = ui32Count;
+        ui32AckLen = 2;
         break;
+    case HOST_MSG_TEXT_MODE:
+        pui8Ack[0] = HOST_STATUS_OK;
+        HostProtoSend(HOST_MSG_ACK, ui32Seq, pui8Ack, ui32AckLen);
+        consoleModeSet(CONSOLE_MODE_TEXT);
+        return;
     default:
         break;
     }
+
+    //
+    // Acknowledge before the request can end, and only then take the
+    // sequence number of one that was started.
+    //
+    HostProtoSend(HOST_MSG_ACK, ui32Seq, pui8Ack, ui32AckLen);
+    if(ui32Pending)
+    {
+        g_ui32HostSeq = ui32Seq;
+        g_ui32HostPending = ui32Pending;
+    }
+
+    FpBatchRun();
+}
+
+//*****************************************************************************
+//
+// Handles the frames received from the host.  This runs from the event loop.
+//
+//*****************************************************************************
+static void
+HostFrameHandler(const tEvent *psEvent)
+{
+    HostProtoProcess();
 }
 //*****************************************************************************
 //
@@ -444,26 +2083,12 @@ void sendCommand(uint8_t cmd)
 int
 main(void)
 {
-
-#if defined(TARGET_IS_TM4C129_RA0) ||                                         \
-    defined(TARGET_IS_TM4C129_RA1) ||                                         \
-    defined(TARGET_IS_TM4C129_RA2)
-    uint32_t ui32SysClock;
-#endif
-
-
     //
-    // Set the clocking to run directly from the crystal.
+    // Set the clocking to run from the PLL.
     //
-#if defined(TARGET_IS_TM4C129_RA0) ||                                         \
-    defined(TARGET_IS_TM4C129_RA1) ||                                         \
-    defined(TARGET_IS_TM4C129_RA2)
-    ui32SysClock = SysCtlClockFreqSet((SYSCTL_XTAL_25MHZ | SYSCTL_OSC_MAIN |
-                                       SYSCTL_USE_OSC), 25000000);
-#else
-    MAP_SysCtlClockSet(SYSCTL_SYSDIV_1 | SYSCTL_USE_OSC | SYSCTL_OSC_MAIN |
-                       SYSCTL_XTAL_16MHZ);
-#endif
+    ClockProfileSet(CLOCK_PROFILE_DEFAULT);
+    BenchInit();
+    ProbeInit();
 
     //
     // Enable the peripherals used by this example.
@@ -498,45 +2123,156 @@ main(void)
     //
     // Configure the UART for 115,200, 8-N-1 operation.
     //
-#if defined(TARGET_IS_TM4C129_RA0) ||                                         \
-    defined(TARGET_IS_TM4C129_RA1) ||                                         \
-    defined(TARGET_IS_TM4C129_RA2)
-    MAP_UARTConfigSetExpClk(UART0_BASE, ui32SysClock, 9600,
-                            (UART_CONFIG_WLEN_8 | UART_CONFIG_STOP_ONE |
-                             UART_CONFIG_PAR_NONE));
-    MAP_UARTConfigSetExpClk(UART5_BASE, ui32SysClock, 9600,
+    MAP_UARTConfigSetExpClk(UART0_BASE, ClockFreqGet(), CONSOLE_BAUD_RATE,
                             (UART_CONFIG_WLEN_8 | UART_CONFIG_STOP_ONE |
                              UART_CONFIG_PAR_NONE));
-#else
-    MAP_UARTConfigSetExpClk(UART0_BASE, MAP_SysCtlClockGet(), 9600,
+    MAP_UARTConfigSetExpClk(UART5_BASE, ClockFreqGet(), FP_LINK_DEFAULT_BAUD,
                             (UART_CONFIG_WLEN_8 | UART_CONFIG_STOP_ONE |
                              UART_CONFIG_PAR_NONE));
-    MAP_UARTConfigSetExpClk(UART5_BASE, MAP_SysCtlClockGet(), 9600,
-                            (UART_CONFIG_WLEN_8 | UART_CONFIG_STOP_ONE |
-                             UART_CONFIG_PAR_NONE));
-#endif
 
     //
-    // Enable the UART interrupt.
+    // Set up the interrupt driven transmit rings.
+    //
+    UARTTxInit(UART0_BASE);
+    UARTTxInit(UART5_BASE);
+
+    //
+    // The UART5 interrupt queues image data and echoes the sensor on the
+    // console ring, as well as the event loop.
+    //
+    UARTTxShare(UART0_BASE, INT_UART5);
+    FpParserInit(&g_sSensorParser, SensorEventHandler, 0);
+    UARTBridgeInit(SensorBridgeRx);
+
+    //
+    // Load the settings.
+    //
+    ConfigInit();
+
+    //
+    // Pass scanned images through the row pipeline.
+    //
+    ImgPipeInit();
+    ImgQualityStageInit(&g_sImageQualityStage, &g_sImageQuality,
+                        ImageQualityHandler);
+    ImgPipeStageAdd(&g_sImageQualityStage);
+    ImgStatsStageInit(&g_sImageStatsStage, &g_sImageStats);
+    ImgPipeStageAdd(&g_sImageStatsStage);
+    ImgLosslessStageInit(&g_sImageCodecStage, &g_sImageCodec, ImageSink);
+    ImgPipeStageAdd(&g_sImageCodecStage);
+    ImgWaveletStageInit(&g_sImageLossyStage, &g_sImageLossy, ImageSink);
+    ImgWaveletRateSet(&g_sImageLossy, ConfigNumGet(CONFIG_LOSSY_RATE));
+    ImgPipeStageAdd(&g_sImageLossyStage);
+
+    //
+    // Dispatch console keys and sensor responses from the event loop, and
+    // tick its timers from SysTick.
+    //
+    EventInit();
+    EventHandlerSet(EVENT_CONSOLE, ConsoleKeyHandler);
+    EventHandlerSet(EVENT_SENSOR, SensorResponseHandler);
+    EventHandlerSet(EVENT_TIMER, TimerHandler);
+    EventHandlerSet(EVENT_FRAME, HostFrameHandler);
+    EventHandlerSet(EVENT_READER, ReaderDataHandler);
+    HostProtoInit(HostMessageHandler);
+    g_bConsoleBinary = (ConfigNumGet(CONFIG_CONSOLE_MODE) ==
+                        CONSOLE_MODE_BINARY);
+    ClockNotifyRegister(SysTickClockChange);
+    MAP_SysTickPeriodSet(ClockFreqGet() / EVENT_TICKS_PER_SECOND);
+    MAP_SysTickIntEnable();
+    MAP_SysTickEnable();
+
+    //
+    // Enable the UART interrupts.
     //
     ROM_IntEnable(INT_UART5);
     ROM_UARTIntEnable(UART5_BASE, UART_INT_RX | UART_INT_RT);
+    ROM_UARTIntEnable(UART0_BASE, UART_INT_RX | UART_INT_RT);
 
+    //
+    // Bring the sensor link up at the fastest rate it supports, or straight
+    // back at the rate it was left at when this is a wake from standby.
+    //
+    g_ui32StandbyWake = StandbyInit(&g_sStandby);
+    FpLinkInit();
+    FpSlotsInit();
 
-
-    while(1)
+    //
+    // Find the end of the journal and record the boot in it.
+    //
+    JournalInit();
+    SensorJournal(JOURNAL_TYPE_BOOT, FP_FLOW_RESULT_OK, g_ui32StandbyWake);
+    if(g_sStandby.ui32Baud)
     {
-        startOptions();
+        FpLinkResume(g_sStandby.ui32Baud);
+        FpSlotsRestore(g_sStandby.ui32Slots);
+    }
+    else
+    {
+        FpLinkNegotiate();
+    }
+
+    //
+    // Run registrations and compares as flows ticked by an event loop timer.
+    //
+    FlowInit();
+    FpFlowInit(SensorFlowHandler);
+    EventTimerStart(TIMER_FLOW,
+                    (FLOW_TICK_MS * EVENT_TICKS_PER_SECOND) / 1000, true);
+
+    //
+    // Give every command a deadline and retry the ones that miss it.
+    //
+    FpRequestInit(SensorRequestHandler);
+    FpBatchInit(HostBatchHandler);
+
+    //
+    // Run the further sensors next to the main one.  Their commands share
+    // the deadlines of the main sensor and its timer.
+    //
+    FpSensorInit(SENSOR_PORTS, ReaderCommandHandler);
 
-        //wait for user to choose option
-        uint8_t number = terminalRead();
+    //
+    // Spread enrolled identities over all the sensors.
+    //
+    FpShardInit(FP_SENSOR_PORT(FP_SHARD_MAIN) | SENSOR_PORTS, ShardHandler);
+    EventTimerStart(TIMER_REQUEST,
+                    (FP_REQUEST_TICK_MS * EVENT_TICKS_PER_SECOND) / 1000,
+                    true);
+
+    //
+    // Write changed settings to EEPROM once they settle.
+    //
+    EventTimerStart(TIMER_CONFIG,
+                    (CONFIG_TICK_MS * EVENT_TICKS_PER_SECOND) / 1000, true);
 
-        sendCommand(number);
+    //
+    // Check the slot cache against the sensor once the loop is running,
+    // unless it was kept over a standby.
+    //
+    if(!g_sStandby.ui32Baud)
+    {
+        sendSensorCommand(FP_CMD_CHECK_REGISTERED_NO);
+    }
 
-        //wait for user to press anything to continue
-        uint8_t next = terminalRead();
+    //
+    // Stop the processor whenever the event loop has nothing to do.
+    //
+    PowerInit();
+    PowerModeSet(IDLE_POWER_MODE);
+    EventIdleHookAdd(PowerIdle);
 
+    //
+    // Show the menu, unless host software talks to the console.
+    //
+    if(!g_bConsoleBinary)
+    {
+        startOptions();
+        reportBoot(BenchCycles());
     }
+    g_ui32ConsoleState = CONSOLE_STATE_MENU;
+
+    EventLoop();
 
     //
     // Return no errors
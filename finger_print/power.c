@@ -0,0 +1,243 @@
+//*****************************************************************************
+//
+// power.c - Idle power manager.
+//
+// A reader sits idle between touches for most of its life.  PowerIdle() is
+// added to the event loop as an idle hook and stops the processor whenever
+// no event is waiting; the next interrupt wakes it.  The event queue is
+// checked with interrupts masked, and WFI still wakes on an interrupt that
+// is masked, so an event posted just before the processor stops is handled
+// straight after.
+//
+// While asleep, only the peripherals the firmware waits on stay clocked:
+// UART0 and UART5, their pins, and the uDMA that forwards sensor data.
+// fp_sensor.c adds the UARTs and pins of any further sensors.
+// SysTick belongs to the core and keeps the event loop timers running.
+//
+// Deep sleep also stops the PLL and runs from the 16 MHz internal
+// oscillator.  The UARTs are moved to that oscillator while deep sleep is
+// selected, so they keep their rates and wake the processor on the first
+// byte.  The uDMA is not clocked in deep sleep, so while the bridge is
+// enabled the manager only sleeps.
+//
+// Whether waking is fast enough is measured by the UART interrupts, which
+// report how many bytes were waiting when they first read their FIFO after a
+// wake and whether the FIFO overran.
+//
+//*****************************************************************************
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "inc/hw_memmap.h"
+#include "inc/hw_types.h"
+#include "driverlib/interrupt.h"
+#include "driverlib/rom.h"
+#include "driverlib/rom_map.h"
+#include "driverlib/sysctl.h"
+#include "driverlib/systick.h"
+#include "driverlib/uart.h"
+#include "clock_profile.h"
+#include "uart_bridge.h"
+#include "event.h"
+#include "power.h"
+
+//*****************************************************************************
+//
+// The peripherals that stay clocked in sleep and in deep sleep.
+//
+//*****************************************************************************
+static const uint32_t g_pui32PowerSleepPeriphs[] =
+{
+    SYSCTL_PERIPH_UART0, SYSCTL_PERIPH_UART5, SYSCTL_PERIPH_UDMA,
+    SYSCTL_PERIPH_GPIOA, SYSCTL_PERIPH_GPIOE
+};
+
+static const uint32_t g_pui32PowerDeepSleepPeriphs[] =
+{
+    SYSCTL_PERIPH_UART0, SYSCTL_PERIPH_UART5, SYSCTL_PERIPH_GPIOA,
+    SYSCTL_PERIPH_GPIOE
+};
+
+#define NUM_SLEEP_PERIPHS       (sizeof(g_pui32PowerSleepPeriphs) /           \
+                                 sizeof(g_pui32PowerSleepPeriphs[0]))
+#define NUM_DEEP_SLEEP_PERIPHS  (sizeof(g_pui32PowerDeepSleepPeriphs) /       \
+                                 sizeof(g_pui32PowerDeepSleepPeriphs[0]))
+
+//*****************************************************************************
+//
+// The selected mode, whether the processor has slept since the last receive
+// interrupt, and the statistics.
+//
+//*****************************************************************************
+static uint32_t g_ui32PowerMode;
+static volatile bool g_bPowerWoken;
+static tPowerStats g_sPowerStats;
+
+//*****************************************************************************
+//
+//! Selects the peripherals that stay clocked while the processor sleeps.
+//!
+//! The idle mode is left at POWER_MODE_RUN.  PowerIdle() must be added to the
+//! event loop as an idle hook.
+//!
+//! \return None.
+//
+//*****************************************************************************
+void
+PowerInit(void)
+{
+    uint32_t ui32Idx;
+
+    for(ui32Idx = 0; ui32Idx < NUM_SLEEP_PERIPHS; ui32Idx++)
+    {
+        MAP_SysCtlPeripheralSleepEnable(g_pui32PowerSleepPeriphs[ui32Idx]);
+    }
+
+    for(ui32Idx = 0; ui32Idx < NUM_DEEP_SLEEP_PERIPHS; ui32Idx++)
+    {
+        MAP_SysCtlPeripheralDeepSleepEnable(
+            g_pui32PowerDeepSleepPeriphs[ui32Idx]);
+    }
+
+    MAP_SysCtlDeepSleepClockSet(SYSCTL_DSLP_DIV_1 | SYSCTL_DSLP_OSC_INT);
+    MAP_SysCtlPeripheralClockGating(true);
+
+    g_ui32PowerMode = POWER_MODE_RUN;
+}
+
+//*****************************************************************************
+//
+//! Selects what the processor does when it is idle.
+//!
+//! \param ui32Mode is one of the POWER_MODE_* values.
+//!
+//! Selecting or leaving POWER_MODE_DEEP moves the UARTs between the
+//! internal oscillator and the system clock, so this must not be called while
+//! the uDMA bridge is enabled.
+//!
+//! \return None.
+//
+//*****************************************************************************
+void
+PowerModeSet(uint32_t ui32Mode)
+{
+    if(ui32Mode > POWER_MODE_DEEP)
+    {
+        return;
+    }
+
+    ClockUARTSourceSet((ui32Mode == POWER_MODE_DEEP) ? UART_CLOCK_PIOSC :
+                                                       UART_CLOCK_SYSTEM);
+    g_ui32PowerMode = ui32Mode;
+}
+
+//*****************************************************************************
+//
+//! Returns what the processor does when it is idle.
+//!
+//! \return Returns one of the POWER_MODE_* values.
+//
+//*****************************************************************************
+uint32_t
+PowerModeGet(void)
+{
+    return(g_ui32PowerMode);
+}
+
+//*****************************************************************************
+//
+//! Stops the processor until the next interrupt if no event is waiting.
+//!
+//! This is the event loop idle hook.
+//!
+//! \return None.
+//
+//*****************************************************************************
+void
+PowerIdle(void)
+{
+    if(g_ui32PowerMode == POWER_MODE_RUN)
+    {
+        return;
+    }
+
+    MAP_IntMasterDisable();
+
+    if(!EventIsPending())
+    {
+        g_bPowerWoken = true;
+
+        if((g_ui32PowerMode == POWER_MODE_DEEP) && !UARTBridgeIsEnabled())
+        {
+            //
+            // SysTick counts the deep sleep clock while the processor is
+            // stopped, so keep its period at one tick of that clock.
+            //
+            g_sPowerStats.ui32DeepSleeps++;
+            MAP_SysTickPeriodSet(CLOCK_PIOSC_FREQ / EVENT_TICKS_PER_SECOND);
+            MAP_SysCtlDeepSleep();
+            MAP_SysTickPeriodSet(ClockFreqGet() / EVENT_TICKS_PER_SECOND);
+        }
+        else
+        {
+            g_sPowerStats.ui32Sleeps++;
+            MAP_SysCtlSleep();
+        }
+    }
+
+    //
+    // The interrupt that woke the processor runs here.
+    //
+    MAP_IntMasterEnable();
+    g_bPowerWoken = false;
+}
+
+//*****************************************************************************
+//
+//! Records a receive interrupt.
+//!
+//! \param ui32Base is the base address of the UART.
+//! \param ui32Count is the number of bytes the interrupt read.
+//!
+//! This must be called by each UART receive interrupt after it has emptied
+//! the receive FIFO.
+//!
+//! \return None.
+//
+//*****************************************************************************
+void
+PowerRxNote(uint32_t ui32Base, uint32_t ui32Count)
+{
+    if(MAP_UARTRxErrorGet(ui32Base) & UART_RXERROR_OVERRUN)
+    {
+        g_sPowerStats.ui32Overruns++;
+        MAP_UARTRxErrorClear(ui32Base);
+    }
+
+    if(g_bPowerWoken)
+    {
+        g_bPowerWoken = false;
+        g_sPowerStats.ui32RxWakes++;
+        if(ui32Count > g_sPowerStats.ui32MaxRxWaiting)
+        {
+            g_sPowerStats.ui32MaxRxWaiting = ui32Count;
+        }
+    }
+}
+
+//*****************************************************************************
+//
+//! Returns the power manager statistics.
+//!
+//! \param psStats is a pointer to the structure that is filled in.
+//!
+//! \return None.
+//
+//*****************************************************************************
+void
+PowerStatsGet(tPowerStats *psStats)
+{
+    MAP_IntMasterDisable();
+    *psStats = g_sPowerStats;
+    MAP_IntMasterEnable();
+}
@@ -0,0 +1,70 @@
+//*****************************************************************************
+//
+// power.h - Prototypes for the idle power manager.
+//
+//*****************************************************************************
+
+#ifndef __POWER_H__
+#define __POWER_H__
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+//*****************************************************************************
+//
+// What the processor does when the event loop has nothing to do: keep
+// polling, sleep with the unused peripherals gated, or deep sleep from the
+// internal oscillator.
+//
+//*****************************************************************************
+#define POWER_MODE_RUN          0
+#define POWER_MODE_SLEEP        1
+#define POWER_MODE_DEEP         2
+
+//*****************************************************************************
+//
+// Statistics kept by the power manager.
+//
+//*****************************************************************************
+typedef struct
+{
+    //
+    // The number of times the processor slept and deep slept.
+    //
+    uint32_t ui32Sleeps;
+    uint32_t ui32DeepSleeps;
+
+    //
+    // The number of wakes on received data, and the most bytes found waiting
+    // in a receive FIFO by the first read after a wake.  Each byte waiting
+    // is one character time the first byte waited to be read.
+    //
+    uint32_t ui32RxWakes;
+    uint32_t ui32MaxRxWaiting;
+
+    //
+    // The number of receive FIFO overruns, each of which lost data.
+    //
+    uint32_t ui32Overruns;
+}
+tPowerStats;
+
+//*****************************************************************************
+//
+// Prototypes for the APIs.
+//
+//*****************************************************************************
+extern void PowerInit(void);
+extern void PowerModeSet(uint32_t ui32Mode);
+extern uint32_t PowerModeGet(void);
+extern void PowerIdle(void);
+extern void PowerRxNote(uint32_t ui32Base, uint32_t ui32Count);
+extern void PowerStatsGet(tPowerStats *psStats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __POWER_H__
@@ -0,0 +1,282 @@
+//*****************************************************************************
+//
+// probe.c - Cycle count probes.
+//
+// A probe times a piece of code with the DWT cycle counter:
+//
+//     ui32Start = ProbeStart();
+//     ...
+//     ProbeRecord(PROBE_ENCODE, ui32Start);
+//
+// Each probe keeps the count, the shortest, longest and total time and a
+// histogram of the times by power of two, in a table of 88 bytes a probe.
+// ProbeRecord() does not mask interrupts, so each probe must only be
+// recorded from one context: a single interrupt handler, the handlers of
+// interrupts at one priority, or the event loop.
+//
+// ProbeInit() measures what a probe adds to the time of the code around it,
+// and ProbeDump() prints the table with it as comma separated values.
+//
+//*****************************************************************************
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include "inc/hw_types.h"
+#include "driverlib/interrupt.h"
+#include "driverlib/rom.h"
+#include "driverlib/rom_map.h"
+#include "bench.h"
+#include "clock_profile.h"
+#include "console.h"
+#include "probe.h"
+
+//*****************************************************************************
+//
+// The probe that ProbeInit() measures the overhead with, after the others.
+//
+//*****************************************************************************
+#define PROBE_CALIBRATE         PROBE_COUNT
+
+//*****************************************************************************
+//
+// The number of times the overhead is measured; the shortest is kept.
+//
+//*****************************************************************************
+#define PROBE_CALIBRATE_RUNS    8
+
+//*****************************************************************************
+//
+// The names of the probes in the dump.
+//
+//*****************************************************************************
+static const char * const g_ppcProbeNames[PROBE_COUNT] =
+{
+    "uart0_isr",
+    "uart5_isr",
+    "reader_isr",
+    "encode",
+    "parse",
+    "forward",
+    "flow_register",
+    "flow_compare",
+    "flow_key_set"
+};
+
+//*****************************************************************************
+//
+// The times recorded by each probe, and the overhead of a probe in cycles.
+//
+//*****************************************************************************
+static tProbeStats g_psProbes[PROBE_COUNT + 1];
+static uint32_t g_ui32ProbeOverhead;
+
+//*****************************************************************************
+//
+//! Clears the probes and measures their overhead.
+//!
+//! BenchInit() must have been called.
+//!
+//! \return None.
+//
+//*****************************************************************************
+void
+ProbeInit(void)
+{
+    uint32_t ui32Probe, ui32Run, ui32Start, ui32Cycles, ui32Empty, ui32Full;
+
+    memset(g_psProbes, 0, sizeof(g_psProbes));
+    for(ui32Probe = 0; ui32Probe <= PROBE_COUNT; ui32Probe++)
+    {
+        g_psProbes[ui32Probe].ui32Min = 0xFFFFFFFF;
+    }
+
+    //
+    // Time an empty stretch of code with and without a probe around it.
+    //
+    ui32Empty = 0xFFFFFFFF;
+    ui32Full = 0xFFFFFFFF;
+    for(ui32Run = 0; ui32Run < PROBE_CALIBRATE_RUNS; ui32Run++)
+    {
+        ui32Cycles = BenchCycles();
+        ui32Cycles = BenchCycles() - ui32Cycles;
+        if(ui32Cycles < ui32Empty)
+        {
+            ui32Empty = ui32Cycles;
+        }
+
+        ui32Cycles = BenchCycles();
+        ui32Start = ProbeStart();
+        ProbeRecord(PROBE_CALIBRATE, ui32Start);
+        ui32Cycles = BenchCycles() - ui32Cycles;
+        if(ui32Cycles < ui32Full)
+        {
+            ui32Full = ui32Cycles;
+        }
+    }
+
+    g_ui32ProbeOverhead = ui32Full - ui32Empty;
+}
+
+//*****************************************************************************
+//
+//! Records the time of a probe.
+//!
+//! \param ui32Probe is the probe, one of the \b PROBE_* values.
+//! \param ui32Start is the cycle count that ProbeStart() returned.
+//!
+//! \return None.
+//
+//*****************************************************************************
+void
+ProbeRecord(uint32_t ui32Probe, uint32_t ui32Start)
+{
+    tProbeStats *psProbe;
+    uint32_t ui32Cycles, ui32Value, ui32Bin;
+
+    ui32Cycles = BenchCycles() - ui32Start;
+    psProbe = &g_psProbes[ui32Probe];
+
+    psProbe->ui32Count++;
+    psProbe->ui64Total += ui32Cycles;
+    if(ui32Cycles < psProbe->ui32Min)
+    {
+        psProbe->ui32Min = ui32Cycles;
+    }
+    if(ui32Cycles > psProbe->ui32Max)
+    {
+        psProbe->ui32Max = ui32Cycles;
+    }
+
+    //
+    // Find the highest bit set, halving the range at each step.
+    //
+    ui32Value = ui32Cycles;
+    ui32Bin = 0;
+    if(ui32Value >= 0x10000)
+    {
+        ui32Bin += 16;
+        ui32Value >>= 16;
+    }
+    if(ui32Value >= 0x100)
+    {
+        ui32Bin += 8;
+        ui32Value >>= 8;
+    }
+    if(ui32Value >= 0x10)
+    {
+        ui32Bin += 4;
+        ui32Value >>= 4;
+    }
+    if(ui32Value >= 0x4)
+    {
+        ui32Bin += 2;
+        ui32Value >>= 2;
+    }
+    if(ui32Value >= 0x2)
+    {
+        ui32Bin++;
+    }
+
+    if(psProbe->pui16Hist[ui32Bin] != 0xFFFF)
+    {
+        psProbe->pui16Hist[ui32Bin]++;
+    }
+}
+
+//*****************************************************************************
+//
+//! Returns the times recorded by a probe.
+//!
+//! \param ui32Probe is the probe, one of the \b PROBE_* values.
+//! \param psStats is a pointer to the structure that is filled in.
+//!
+//! \return None.
+//
+//*****************************************************************************
+void
+ProbeStatsGet(uint32_t ui32Probe, tProbeStats *psStats)
+{
+    MAP_IntMasterDisable();
+    *psStats = g_psProbes[ui32Probe];
+    MAP_IntMasterEnable();
+}
+
+//*****************************************************************************
+//
+//! Returns the overhead of a probe.
+//!
+//! \return Returns the number of cycles that ProbeStart() and ProbeRecord()
+//! add to the code they time, as measured by ProbeInit().
+//
+//*****************************************************************************
+uint32_t
+ProbeOverheadGet(void)
+{
+    return(g_ui32ProbeOverhead);
+}
+
+//*****************************************************************************
+//
+//! Prints the probes on the console.
+//!
+//! A comment line gives the clock and the overhead of a probe, and a header
+//! line is followed by one line per probe:
+//!
+//! \verbatim
+//!     # probes: cycles at 16000000 Hz, overhead 23 cycles
+//!     probe,count,min,max,mean,histogram
+//!     encode,12,301,388,322,8:12
+//! \endverbatim
+//!
+//! The histogram lists the bins that are not empty as bin:count, separated
+//! by spaces.  A probe that has recorded nothing shows 0 for its times.
+//!
+//! \return None.
+//
+//*****************************************************************************
+void
+ProbeDump(void)
+{
+    tProbeStats sStats;
+    uint32_t ui32Probe, ui32Bin;
+    bool bFirst;
+
+    ConsoleWrite("# probes: cycles at ");
+    ConsoleWriteNum(ClockFreqGet());
+    ConsoleWrite(" Hz, overhead ");
+    ConsoleWriteNum(g_ui32ProbeOverhead);
+    ConsoleWrite(" cycles\r\nprobe,count,min,max,mean,histogram\r\n");
+
+    for(ui32Probe = 0; ui32Probe < PROBE_COUNT; ui32Probe++)
+    {
+        ProbeStatsGet(ui32Probe, &sStats);
+
+        ConsoleWrite(g_ppcProbeNames[ui32Probe]);
+        ConsoleWrite(",");
+        ConsoleWriteNum(sStats.ui32Count);
+        ConsoleWrite(",");
+        ConsoleWriteNum(sStats.ui32Count ? sStats.ui32Min : 0);
+        ConsoleWrite(",");
+        ConsoleWriteNum(sStats.ui32Max);
+        ConsoleWrite(",");
+        ConsoleWriteNum(sStats.ui32Count ?
+                        (uint32_t)(sStats.ui64Total / sStats.ui32Count) : 0);
+        ConsoleWrite(",");
+
+        bFirst = true;
+        for(ui32Bin = 0; ui32Bin < PROBE_HIST_BINS; ui32Bin++)
+        {
+            if(sStats.pui16Hist[ui32Bin])
+            {
+                ConsoleWrite(bFirst ? "" : " ");
+                ConsoleWriteNum(ui32Bin);
+                ConsoleWrite(":");
+                ConsoleWriteNum(sStats.pui16Hist[ui32Bin]);
+                bFirst = false;
+            }
+        }
+
+        ConsoleWrite("\r\n");
+    }
+}
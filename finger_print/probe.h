@@ -0,0 +1,78 @@
+//*****************************************************************************
+//
+// probe.h - Prototypes and macros for the cycle count probes.
+//
+//*****************************************************************************
+
+#ifndef __PROBE_H__
+#define __PROBE_H__
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+//*****************************************************************************
+//
+// The probes.  The flows are in the order of FP_FLOW_*, so the probe of a
+// flow is PROBE_FLOW_REGISTER plus its FP_FLOW_* value.
+//
+//*****************************************************************************
+#define PROBE_UART0_ISR         0       // UART0IntHandler()
+#define PROBE_UART5_ISR         1       // UART5IntHandler()
+#define PROBE_READER_ISR        2       // Interrupts of the further sensors
+#define PROBE_ENCODE            3       // Encoding of a command frame
+#define PROBE_PARSE             4       // Parsing of main sensor data
+#define PROBE_FORWARD           5       // Forwarding by the uDMA bridge
+#define PROBE_FLOW_REGISTER     6       // Start to end of each flow
+#define PROBE_FLOW_COMPARE      7
+#define PROBE_FLOW_KEY_SET      8
+#define PROBE_COUNT             9
+
+//*****************************************************************************
+//
+// The number of histogram bins.  Bin n counts the times from 2^n to
+// 2^(n + 1) - 1 cycles, with bin 0 also counting times of 0.
+//
+//*****************************************************************************
+#define PROBE_HIST_BINS         32
+
+//*****************************************************************************
+//
+// The times recorded by a probe, in system clock cycles.  The histogram
+// counts stop at 0xFFFF.
+//
+//*****************************************************************************
+typedef struct
+{
+    uint32_t ui32Count;
+    uint32_t ui32Min;
+    uint32_t ui32Max;
+    uint64_t ui64Total;
+    uint16_t pui16Hist[PROBE_HIST_BINS];
+}
+tProbeStats;
+
+//*****************************************************************************
+//
+// Reads the cycle count that a probe starts from.  bench.h must be included.
+//
+//*****************************************************************************
+#define ProbeStart()            BenchCycles()
+
+//*****************************************************************************
+//
+// Prototypes for the APIs.
+//
+//*****************************************************************************
+extern void ProbeInit(void);
+extern void ProbeRecord(uint32_t ui32Probe, uint32_t ui32Start);
+extern void ProbeStatsGet(uint32_t ui32Probe, tProbeStats *psStats);
+extern uint32_t ProbeOverheadGet(void);
+extern void ProbeDump(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __PROBE_H__
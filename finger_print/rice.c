@@ -0,0 +1,195 @@
+//*****************************************************************************
+//
+// rice.c - Adaptive Golomb-Rice coder shared by the image encoders.
+//
+// A value v is coded with parameter k as q = v >> k one bits, a zero bit and
+// the low k bits of v.  When q would be RICE_LIMIT or more the value is sent
+// as RICE_LIMIT one bits followed by the value in a fixed number of bits.
+//
+// k is picked from the running mean of the values coded so far as the
+// smallest k for which the mean is below 2^k.  The sum and count start at
+// RICE_INIT_SUM and RICE_INIT_COUNT and are halved whenever the count
+// reaches RICE_RESET_COUNT, so that k follows local detail.
+//
+//*****************************************************************************
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "rice.h"
+
+//*****************************************************************************
+//
+// The starting sum and count of a model, and the count at which both are
+// halved.
+//
+//*****************************************************************************
+#define RICE_INIT_SUM           4
+#define RICE_INIT_COUNT         1
+#define RICE_RESET_COUNT        32
+
+//*****************************************************************************
+//
+//! Prepares a bit writer.
+//!
+//! \param psWriter is the writer.
+//! \param pui8Out is where the bits are written.
+//! \param ui32Size is the size of the output buffer.
+//!
+//! \return None.
+//
+//*****************************************************************************
+void
+RiceWriterInit(tRiceWriter *psWriter, uint8_t *pui8Out, uint32_t ui32Size)
+{
+    psWriter->pui8Out = pui8Out;
+    psWriter->ui32Size = ui32Size;
+    psWriter->ui32Len = 0;
+    psWriter->ui32Acc = 0;
+    psWriter->ui32NumBits = 0;
+}
+
+//*****************************************************************************
+//
+//! Appends bits to the output, most significant bit first.
+//!
+//! \param psWriter is the writer.
+//! \param ui32Value holds the bits in its least significant end.
+//! \param ui32Bits is the number of bits, no more than 24.
+//!
+//! \return Returns \b false if the output buffer is full.
+//
+//*****************************************************************************
+bool
+RiceBitsPut(tRiceWriter *psWriter, uint32_t ui32Value, uint32_t ui32Bits)
+{
+    psWriter->ui32Acc = (psWriter->ui32Acc << ui32Bits) | ui32Value;
+    psWriter->ui32NumBits += ui32Bits;
+
+    while(psWriter->ui32NumBits >= 8)
+    {
+        if(psWriter->ui32Len == psWriter->ui32Size)
+        {
+            return(false);
+        }
+
+        psWriter->ui32NumBits -= 8;
+        psWriter->pui8Out[psWriter->ui32Len++] =
+            (uint8_t)(psWriter->ui32Acc >> psWriter->ui32NumBits);
+    }
+
+    return(true);
+}
+
+//*****************************************************************************
+//
+//! Appends a Rice code.
+//!
+//! \param psWriter is the writer.
+//! \param ui32Value is the value to code.
+//! \param ui32K is the Rice parameter.
+//! \param ui32EscapeBits is the number of bits a value is sent in when its
+//! unary prefix would be too long.
+//!
+//! \return Returns \b false if the output buffer is full.
+//
+//*****************************************************************************
+bool
+RiceCodePut(tRiceWriter *psWriter, uint32_t ui32Value, uint32_t ui32K,
+            uint32_t ui32EscapeBits)
+{
+    uint32_t ui32Q;
+
+    ui32Q = ui32Value >> ui32K;
+    if(ui32Q < RICE_LIMIT)
+    {
+        return(RiceBitsPut(psWriter, ((1 << ui32Q) - 1) << 1, ui32Q + 1) &&
+               RiceBitsPut(psWriter, ui32Value & ((1 << ui32K) - 1), ui32K));
+    }
+
+    return(RiceBitsPut(psWriter, (1 << RICE_LIMIT) - 1, RICE_LIMIT) &&
+           RiceBitsPut(psWriter, ui32Value, ui32EscapeBits));
+}
+
+//*****************************************************************************
+//
+//! Pads the output to a whole byte.
+//!
+//! \param psWriter is the writer.
+//!
+//! \return Returns the number of bytes written, or 0 if the output buffer
+//! was too small.
+//
+//*****************************************************************************
+uint32_t
+RiceWriterFlush(tRiceWriter *psWriter)
+{
+    if(psWriter->ui32NumBits &&
+       !RiceBitsPut(psWriter, 0, 8 - psWriter->ui32NumBits))
+    {
+        return(0);
+    }
+
+    return(psWriter->ui32Len);
+}
+
+//*****************************************************************************
+//
+//! Resets a model to its starting state.
+//!
+//! \param psModel is the model.
+//!
+//! \return None.
+//
+//*****************************************************************************
+void
+RiceModelInit(tRiceModel *psModel)
+{
+    psModel->ui32Sum = RICE_INIT_SUM;
+    psModel->ui32Count = RICE_INIT_COUNT;
+}
+
+//*****************************************************************************
+//
+//! Returns the Rice parameter for the next value.
+//!
+//! \param psModel is the model.
+//! \param ui32MaxK is the largest parameter that may be returned.
+//!
+//! \return Returns the parameter.
+//
+//*****************************************************************************
+uint32_t
+RiceModelK(const tRiceModel *psModel, uint32_t ui32MaxK)
+{
+    uint32_t ui32K;
+
+    ui32K = 0;
+    while((ui32K < ui32MaxK) &&
+          ((psModel->ui32Count << ui32K) < psModel->ui32Sum))
+    {
+        ui32K++;
+    }
+
+    return(ui32K);
+}
+
+//*****************************************************************************
+//
+//! Adds a coded value to a model.
+//!
+//! \param psModel is the model.
+//! \param ui32Value is the value.
+//!
+//! \return None.
+//
+//*****************************************************************************
+void
+RiceModelUpdate(tRiceModel *psModel, uint32_t ui32Value)
+{
+    psModel->ui32Sum += ui32Value;
+    if(++psModel->ui32Count == RICE_RESET_COUNT)
+    {
+        psModel->ui32Sum >>= 1;
+        psModel->ui32Count >>= 1;
+    }
+}
@@ -0,0 +1,72 @@
+//*****************************************************************************
+//
+// rice.h - Prototypes for the adaptive Golomb-Rice coder.
+//
+//*****************************************************************************
+
+#ifndef __RICE_H__
+#define __RICE_H__
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+//*****************************************************************************
+//
+// The longest unary prefix.  A value whose prefix would reach it is sent as
+// RICE_LIMIT one bits followed by the value itself.
+//
+//*****************************************************************************
+#define RICE_LIMIT              16
+
+//*****************************************************************************
+//
+// A bit writer.  Bits are packed from the most significant end of each byte.
+// The members are private to rice.c.
+//
+//*****************************************************************************
+typedef struct
+{
+    uint8_t *pui8Out;
+    uint32_t ui32Size;
+    uint32_t ui32Len;
+    uint32_t ui32Acc;
+    uint32_t ui32NumBits;
+}
+tRiceWriter;
+
+//*****************************************************************************
+//
+// The running mean of the coded values, from which the Rice parameter is
+// chosen.  The members are private to rice.c.
+//
+//*****************************************************************************
+typedef struct
+{
+    uint32_t ui32Sum;
+    uint32_t ui32Count;
+}
+tRiceModel;
+
+//*****************************************************************************
+//
+// Prototypes for the APIs.
+//
+//*****************************************************************************
+extern void RiceWriterInit(tRiceWriter *psWriter, uint8_t *pui8Out,
+                           uint32_t ui32Size);
+extern bool RiceBitsPut(tRiceWriter *psWriter, uint32_t ui32Value,
+                        uint32_t ui32Bits);
+extern bool RiceCodePut(tRiceWriter *psWriter, uint32_t ui32Value,
+                        uint32_t ui32K, uint32_t ui32EscapeBits);
+extern uint32_t RiceWriterFlush(tRiceWriter *psWriter);
+extern void RiceModelInit(tRiceModel *psModel);
+extern uint32_t RiceModelK(const tRiceModel *psModel, uint32_t ui32MaxK);
+extern void RiceModelUpdate(tRiceModel *psModel, uint32_t ui32Value);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __RICE_H__
@@ -0,0 +1,208 @@
+//*****************************************************************************
+//
+// standby.c - Hibernate standby mode.
+//
+// In standby everything but the hibernation module is powered down, which
+// keeps the RTC and 16 words of battery-backed memory.  The module powers
+// the rest of the chip back up when the RTC reaches the match value or the
+// wake pin is asserted, and the processor then starts from reset.
+//
+// The state the firmware would otherwise have to rebuild is kept in the
+// battery-backed memory: most of all the sensor link rate, so that a wake
+// only has to confirm the link instead of negotiating it.  The record is
+// guarded by a marker and a check word, so a record that did not survive
+// is treated as a cold boot.
+//
+//*****************************************************************************
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <time.h>
+#include "inc/hw_memmap.h"
+#include "driverlib/hibernate.h"
+#include "driverlib/rom.h"
+#include "driverlib/rom_map.h"
+#include "driverlib/sysctl.h"
+#include "clock_profile.h"
+#include "standby.h"
+
+//*****************************************************************************
+//
+// The marker stored in front of the record ("STBY").
+//
+//*****************************************************************************
+#define STANDBY_MARKER          0x59425453
+
+//*****************************************************************************
+//
+// The record kept in hibernate memory: the marker, the state and a check
+// word that makes the words sum to zero.
+//
+//*****************************************************************************
+#define STANDBY_STATE_WORDS     (sizeof(tStandbyState) / sizeof(uint32_t))
+#define STANDBY_RECORD_WORDS    (STANDBY_STATE_WORDS + 2)
+
+//*****************************************************************************
+//
+// Returns the sum of the words of a record.
+//
+//*****************************************************************************
+static uint32_t
+StandbySum(const uint32_t *pui32Record, uint32_t ui32Words)
+{
+    uint32_t ui32Sum;
+
+    ui32Sum = 0;
+    while(ui32Words--)
+    {
+        ui32Sum += *pui32Record++;
+    }
+
+    return(ui32Sum);
+}
+
+//*****************************************************************************
+//
+//! Starts the hibernation module and restores the state kept over standby.
+//!
+//! \param psState is a pointer to the state, which is filled in from
+//! hibernate memory after a wake and cleared otherwise.  The counters survive
+//! a reset as long as the hibernation module keeps its battery.
+//!
+//! \return Returns one of the STANDBY_WAKE_* values.
+//
+//*****************************************************************************
+uint32_t
+StandbyInit(tStandbyState *psState)
+{
+    uint32_t pui32Record[STANDBY_RECORD_WORDS];
+    uint32_t ui32Status, ui32Wake;
+    bool bActive;
+
+    MAP_SysCtlPeripheralEnable(SYSCTL_PERIPH_HIBERNATE);
+
+    //
+    // The module keeps running over a reset if it was active, in which case
+    // it says why the chip was powered up.
+    //
+    bActive = MAP_HibernateIsActive();
+    MAP_HibernateEnableExpClk(ClockFreqGet());
+
+    ui32Wake = STANDBY_WAKE_NONE;
+    memset(psState, 0, sizeof(*psState));
+
+    if(bActive)
+    {
+        ui32Status = MAP_HibernateIntStatus(false);
+        MAP_HibernateIntClear(ui32Status);
+        if(ui32Status & HIBERNATE_INT_PIN_WAKE)
+        {
+            ui32Wake = STANDBY_WAKE_PIN;
+        }
+        else if(ui32Status & HIBERNATE_INT_RTC_MATCH_0)
+        {
+            ui32Wake = STANDBY_WAKE_RTC;
+        }
+
+        MAP_HibernateDataGet(pui32Record, STANDBY_RECORD_WORDS);
+        if((pui32Record[0] == STANDBY_MARKER) &&
+           !StandbySum(pui32Record, STANDBY_RECORD_WORDS))
+        {
+            memcpy(psState, &pui32Record[1], sizeof(*psState));
+        }
+        else
+        {
+            ui32Wake = STANDBY_WAKE_NONE;
+        }
+    }
+    else
+    {
+        MAP_HibernateClockConfig(HIBERNATE_OSC_LOWDRIVE);
+    }
+
+    //
+    // Only a wake restores the link rate; after a reset the sensor may have
+    // been power cycled too.
+    //
+    if(ui32Wake == STANDBY_WAKE_NONE)
+    {
+        psState->ui32Baud = 0;
+    }
+    else if(ui32Wake == STANDBY_WAKE_PIN)
+    {
+        psState->ui32PinWakes++;
+    }
+    else
+    {
+        psState->ui32RTCWakes++;
+    }
+
+    MAP_HibernateRTCEnable();
+
+    return(ui32Wake);
+}
+
+//*****************************************************************************
+//
+//! Saves the state and powers the processor down.
+//!
+//! \param psState is the state to keep.  Its standby count is incremented.
+//! \param ui32Seconds is the time after which the RTC wakes the processor,
+//! or 0 to wake on the wake pin only.
+//!
+//! Anything queued on the UARTs should be flushed first.
+//!
+//! \return This function does not return; the processor restarts from reset
+//! when it wakes.
+//
+//*****************************************************************************
+void
+StandbyEnter(tStandbyState *psState, uint32_t ui32Seconds)
+{
+    uint32_t pui32Record[STANDBY_RECORD_WORDS];
+
+    psState->ui32Standbys++;
+
+    pui32Record[0] = STANDBY_MARKER;
+    memcpy(&pui32Record[1], psState, sizeof(*psState));
+    pui32Record[STANDBY_RECORD_WORDS - 1] = 0;
+    pui32Record[STANDBY_RECORD_WORDS - 1] =
+        0 - StandbySum(pui32Record, STANDBY_RECORD_WORDS);
+    MAP_HibernateDataSet(pui32Record, STANDBY_RECORD_WORDS);
+
+    if(ui32Seconds)
+    {
+        MAP_HibernateRTCMatchSet(0, MAP_HibernateRTCGet() + ui32Seconds);
+        MAP_HibernateWakeSet(HIBERNATE_WAKE_PIN | HIBERNATE_WAKE_RTC);
+    }
+    else
+    {
+        MAP_HibernateWakeSet(HIBERNATE_WAKE_PIN);
+    }
+
+    MAP_HibernateRequest();
+
+    //
+    // Power goes away within a few cycles of the request.
+    //
+    while(1)
+    {
+    }
+}
+
+//*****************************************************************************
+//
+//! Returns the time kept by the hibernation module RTC.
+//!
+//! The RTC keeps counting over standby, and over a reset as long as the
+//! hibernation module keeps its battery.
+//!
+//! \return Returns the number of seconds since the RTC was first enabled.
+//
+//*****************************************************************************
+uint32_t
+StandbyTimeGet(void)
+{
+    return(MAP_HibernateRTCGet());
+}
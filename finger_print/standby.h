@@ -0,0 +1,65 @@
+//*****************************************************************************
+//
+// standby.h - Prototypes for the hibernate standby mode.
+//
+//*****************************************************************************
+
+#ifndef __STANDBY_H__
+#define __STANDBY_H__
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+//*****************************************************************************
+//
+// How the processor came out of reset.
+//
+//*****************************************************************************
+#define STANDBY_WAKE_NONE       0   // Cold boot or reset
+#define STANDBY_WAKE_RTC        1   // The standby time ran out
+#define STANDBY_WAKE_PIN        2   // The wake pin was asserted
+
+//*****************************************************************************
+//
+// The state kept in the battery-backed hibernate memory while the processor
+// is powered down.
+//
+//*****************************************************************************
+typedef struct
+{
+    //
+    // The sensor link rate confirmed before standby, or 0 if there was none.
+    //
+    uint32_t ui32Baud;
+
+    //
+    // The slot occupancy cache, as returned by FpSlotsMapGet().
+    //
+    uint32_t ui32Slots;
+
+    //
+    // The number of times standby was entered, and the number of wakes by
+    // the RTC and by the wake pin.
+    //
+    uint32_t ui32Standbys;
+    uint32_t ui32RTCWakes;
+    uint32_t ui32PinWakes;
+}
+tStandbyState;
+
+//*****************************************************************************
+//
+// Prototypes for the APIs.
+//
+//*****************************************************************************
+extern uint32_t StandbyInit(tStandbyState *psState);
+extern void StandbyEnter(tStandbyState *psState, uint32_t ui32Seconds);
+extern uint32_t StandbyTimeGet(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __STANDBY_H__
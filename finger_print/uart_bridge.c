@@ -0,0 +1,548 @@
+//*****************************************************************************
+//
+// uart_bridge.c - uDMA backed UART5 (sensor) to UART0 (console) bridge.
+//
+// While the bridge is enabled the CPU does not touch sensor data, other than
+// to look at it in the receive callback.  The bridge can also run receive
+// only, for when the application sends its own rendering of the data.  UART5
+// receive runs the uDMA in ping-pong mode: the primary and alternate control
+// structures each own one buffer, and when one of them completes the other
+// one carries on receiving while the completed buffer is queued for
+// transmission.  UART0 transmit drains queued buffers with a basic mode uDMA
+// transfer straight out of the receive buffer, so nothing is copied.
+//
+// The receive channel only issues burst requests, which leaves fewer than
+// eight bytes in the UART5 FIFO at the end of a message.  Those raise the
+// receive timeout interrupt, which hands the partly filled buffer over and
+// appends the FIFO residue to it.
+//
+// The uDMA completion interrupts arrive on the UART5 and UART0 vectors.  Both
+// are left at the same priority, so the two handlers never preempt each
+// other and the buffer bookkeeping needs no further locking.
+//
+//*****************************************************************************
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "inc/hw_memmap.h"
+#include "inc/hw_ints.h"
+#include "inc/hw_uart.h"
+#include "driverlib/interrupt.h"
+#include "driverlib/rom.h"
+#include "driverlib/rom_map.h"
+#include "driverlib/sysctl.h"
+#include "driverlib/uart.h"
+#include "driverlib/udma.h"
+#include "uart_tx.h"
+#include "uart_bridge.h"
+
+//*****************************************************************************
+//
+// The uDMA control table.  It must be aligned on a 1024 byte boundary.
+//
+//*****************************************************************************
+#if defined(ewarm)
+#pragma data_alignment=1024
+static uint8_t g_pui8ControlTable[1024];
+#elif defined(ccs)
+#pragma DATA_ALIGN(g_pui8ControlTable, 1024)
+static uint8_t g_pui8ControlTable[1024];
+#else
+static uint8_t g_pui8ControlTable[1024] __attribute__ ((aligned(1024)));
+#endif
+
+//*****************************************************************************
+//
+// The states of a bridge buffer.
+//
+//*****************************************************************************
+#define BRIDGE_BUF_FREE         0
+#define BRIDGE_BUF_RX           1
+#define BRIDGE_BUF_READY        2
+#define BRIDGE_BUF_TX           3
+
+//*****************************************************************************
+//
+// The bridge buffers, the number of valid bytes in each and their states.
+//
+//*****************************************************************************
+static uint8_t g_ppui8BridgeBuf[UART_BRIDGE_NUM_BUFS][UART_BRIDGE_BUF_SIZE];
+static uint32_t g_pui32BridgeLen[UART_BRIDGE_NUM_BUFS];
+static volatile uint8_t g_pui8BridgeState[UART_BRIDGE_NUM_BUFS];
+
+//*****************************************************************************
+//
+// The buffers armed on the primary (0) and alternate (1) receive control
+// structures and which of the two the uDMA is currently filling.
+//
+//*****************************************************************************
+static uint32_t g_pui32RxBuf[2];
+static uint32_t g_ui32RxActive;
+
+//*****************************************************************************
+//
+// The queue of filled buffers in the order they must be sent, and the state
+// of the transmit channel.
+//
+//*****************************************************************************
+static uint8_t g_pui8ReadyQueue[UART_BRIDGE_NUM_BUFS];
+static volatile uint32_t g_ui32ReadyHead;
+static volatile uint32_t g_ui32ReadyTail;
+static volatile bool g_bTxBusy;
+
+//*****************************************************************************
+//
+// Whether the bridge is enabled, whether it forwards what it receives to
+// UART0, and its statistics.
+//
+//*****************************************************************************
+static volatile bool g_bBridgeEnabled;
+static bool g_bBridgeForward;
+static tUARTBridgeStats g_sBridgeStats;
+
+//*****************************************************************************
+//
+// The function that is shown every received buffer.
+//
+//*****************************************************************************
+static tUARTBridgeRxCallback g_pfnBridgeRxCallback;
+
+//*****************************************************************************
+//
+// Returns the control structure select flag for the primary (0) or alternate
+// (1) structure.
+//
+//*****************************************************************************
+#define BRIDGE_SEL(ui32Struct)                                                \
+        ((ui32Struct) ? UDMA_ALT_SELECT : UDMA_PRI_SELECT)
+
+//*****************************************************************************
+//
+// Returns the index of a free buffer, or UART_BRIDGE_NUM_BUFS if all of them
+// are in use.
+//
+//*****************************************************************************
+static uint32_t
+UARTBridgeBufAlloc(void)
+{
+    uint32_t ui32Buf;
+
+    for(ui32Buf = 0; ui32Buf < UART_BRIDGE_NUM_BUFS; ui32Buf++)
+    {
+        if(g_pui8BridgeState[ui32Buf] == BRIDGE_BUF_FREE)
+        {
+            break;
+        }
+    }
+
+    return(ui32Buf);
+}
+
+//*****************************************************************************
+//
+// Arms a receive control structure with the buffer assigned to it.
+//
+//*****************************************************************************
+static void
+UARTBridgeRxArm(uint32_t ui32Struct)
+{
+    MAP_uDMAChannelTransferSet(UDMA_CH6_UART5RX | BRIDGE_SEL(ui32Struct),
+                               UDMA_MODE_PINGPONG,
+                               (void *)(UART5_BASE + UART_O_DR),
+                               g_ppui8BridgeBuf[g_pui32RxBuf[ui32Struct]],
+                               UART_BRIDGE_BUF_SIZE);
+}
+
+//*****************************************************************************
+//
+// Starts sending the oldest filled buffer if the transmit channel is idle.
+//
+//*****************************************************************************
+static void
+UARTBridgeTxStart(void)
+{
+    uint32_t ui32Buf;
+
+    if(g_bTxBusy || (g_ui32ReadyHead == g_ui32ReadyTail))
+    {
+        return;
+    }
+
+    ui32Buf = g_pui8ReadyQueue[g_ui32ReadyTail % UART_BRIDGE_NUM_BUFS];
+    g_pui8BridgeState[ui32Buf] = BRIDGE_BUF_TX;
+    g_bTxBusy = true;
+
+    MAP_uDMAChannelTransferSet(UDMA_CH9_UART0TX | UDMA_PRI_SELECT,
+                               UDMA_MODE_BASIC, g_ppui8BridgeBuf[ui32Buf],
+                               (void *)(UART0_BASE + UART_O_DR),
+                               g_pui32BridgeLen[ui32Buf]);
+    MAP_uDMAChannelEnable(UDMA_CH9_UART0TX);
+}
+
+//*****************************************************************************
+//
+// Hands the buffer of a receive control structure over for transmission and
+// assigns it a fresh one.  If no buffer is free the data is discarded, the
+// same buffer is reused and an overrun is counted.  The receive callback sees
+// the data either way.  When the bridge does not forward, the buffer is
+// simply reused.
+//
+//*****************************************************************************
+static void
+UARTBridgeRxHandOver(uint32_t ui32Struct, uint32_t ui32Len)
+{
+    uint32_t ui32Buf, ui32Free;
+
+    ui32Buf = g_pui32RxBuf[ui32Struct];
+    if(g_pfnBridgeRxCallback)
+    {
+        g_pfnBridgeRxCallback(g_ppui8BridgeBuf[ui32Buf], ui32Len);
+    }
+
+    if(!g_bBridgeForward)
+    {
+        return;
+    }
+
+    ui32Free = UARTBridgeBufAlloc();
+
+    if(ui32Free == UART_BRIDGE_NUM_BUFS)
+    {
+        g_sBridgeStats.ui32Overruns++;
+        return;
+    }
+
+    g_pui32BridgeLen[ui32Buf] = ui32Len;
+    g_pui8BridgeState[ui32Buf] = BRIDGE_BUF_READY;
+    g_pui8ReadyQueue[g_ui32ReadyHead % UART_BRIDGE_NUM_BUFS] = ui32Buf;
+    g_ui32ReadyHead++;
+
+    g_pui8BridgeState[ui32Free] = BRIDGE_BUF_RX;
+    g_pui32RxBuf[ui32Struct] = ui32Free;
+}
+
+//*****************************************************************************
+//
+// Hands over every receive buffer that the uDMA has completely filled and
+// re-arms its control structure.
+//
+//*****************************************************************************
+static void
+UARTBridgeRxComplete(void)
+{
+    while(MAP_uDMAChannelModeGet(UDMA_CH6_UART5RX |
+                                 BRIDGE_SEL(g_ui32RxActive)) ==
+          UDMA_MODE_STOP)
+    {
+        UARTBridgeRxHandOver(g_ui32RxActive, UART_BRIDGE_BUF_SIZE);
+        UARTBridgeRxArm(g_ui32RxActive);
+        g_sBridgeStats.ui32Swaps++;
+        g_ui32RxActive ^= 1;
+    }
+
+    //
+    // If the interrupt was serviced so late that both structures had
+    // completed, the uDMA has disabled the channel.
+    //
+    if(!MAP_uDMAChannelIsEnabled(UDMA_CH6_UART5RX))
+    {
+        MAP_uDMAChannelEnable(UDMA_CH6_UART5RX);
+    }
+}
+
+//*****************************************************************************
+//
+// Stops the receive channel and hands over the partly filled active buffer,
+// including whatever is left in the UART5 FIFO.  Returns the number of bytes
+// handed over.
+//
+//*****************************************************************************
+static uint32_t
+UARTBridgeRxFlush(void)
+{
+    uint32_t ui32Len;
+    uint8_t *pui8Buf;
+
+    MAP_uDMAChannelDisable(UDMA_CH6_UART5RX);
+
+    ui32Len = UART_BRIDGE_BUF_SIZE -
+              MAP_uDMAChannelSizeGet(UDMA_CH6_UART5RX |
+                                     BRIDGE_SEL(g_ui32RxActive));
+    pui8Buf = g_ppui8BridgeBuf[g_pui32RxBuf[g_ui32RxActive]];
+
+    while((ui32Len < UART_BRIDGE_BUF_SIZE) && MAP_UARTCharsAvail(UART5_BASE))
+    {
+        pui8Buf[ui32Len++] = MAP_UARTCharGetNonBlocking(UART5_BASE);
+    }
+
+    if(ui32Len)
+    {
+        UARTBridgeRxHandOver(g_ui32RxActive, ui32Len);
+        g_sBridgeStats.ui32Flushes++;
+    }
+
+    return(ui32Len);
+}
+
+//*****************************************************************************
+//
+//! Initializes the uDMA controller and the channels used by the bridge.
+//!
+//! \param pfnRxCallback is called from the UART5 interrupt with every buffer
+//! of sensor data that is received, before it is sent on.  It may be 0.
+//!
+//! \return None.
+//
+//*****************************************************************************
+void
+UARTBridgeInit(tUARTBridgeRxCallback pfnRxCallback)
+{
+    g_pfnBridgeRxCallback = pfnRxCallback;
+
+    MAP_SysCtlPeripheralEnable(SYSCTL_PERIPH_UDMA);
+    MAP_uDMAEnable();
+    MAP_uDMAControlBaseSet(g_pui8ControlTable);
+
+    MAP_uDMAChannelAssign(UDMA_CH6_UART5RX);
+    MAP_uDMAChannelAssign(UDMA_CH9_UART0TX);
+
+    MAP_uDMAChannelAttributeDisable(UDMA_CH6_UART5RX, UDMA_ATTR_ALL);
+    MAP_uDMAChannelAttributeDisable(UDMA_CH9_UART0TX, UDMA_ATTR_ALL);
+
+    //
+    // Only burst requests move sensor data, so that a short tail is left in
+    // the FIFO to trigger the receive timeout.
+    //
+    MAP_uDMAChannelAttributeEnable(UDMA_CH6_UART5RX, UDMA_ATTR_USEBURST);
+
+    MAP_uDMAChannelControlSet(UDMA_CH6_UART5RX | UDMA_PRI_SELECT,
+                              UDMA_SIZE_8 | UDMA_SRC_INC_NONE |
+                              UDMA_DST_INC_8 | UDMA_ARB_8);
+    MAP_uDMAChannelControlSet(UDMA_CH6_UART5RX | UDMA_ALT_SELECT,
+                              UDMA_SIZE_8 | UDMA_SRC_INC_NONE |
+                              UDMA_DST_INC_8 | UDMA_ARB_8);
+    MAP_uDMAChannelControlSet(UDMA_CH9_UART0TX | UDMA_PRI_SELECT,
+                              UDMA_SIZE_8 | UDMA_SRC_INC_8 |
+                              UDMA_DST_INC_NONE | UDMA_ARB_4);
+
+    g_bBridgeEnabled = false;
+}
+
+//*****************************************************************************
+//
+//! Switches sensor reception, and optionally forwarding to the console, over
+//! to the uDMA.
+//!
+//! \param bForward is \b true to forward everything received to UART0, or
+//! \b false to only pass it to the receive callback.
+//!
+//! When forwarding, anything already queued for the console is sent first,
+//! and while the bridge is enabled console output from the application is
+//! held in the UART0 transmit ring so that it cannot interleave with sensor
+//! data.
+//!
+//! \return None.
+//
+//*****************************************************************************
+void
+UARTBridgeEnable(bool bForward)
+{
+    uint32_t ui32Buf;
+
+    if(g_bBridgeEnabled)
+    {
+        return;
+    }
+
+    g_bBridgeForward = bForward;
+    if(bForward)
+    {
+        UARTTxFlush(UART0_BASE);
+        UARTTxHold(UART0_BASE, true);
+    }
+
+    MAP_IntDisable(INT_UART5);
+    MAP_IntDisable(INT_UART0);
+
+    for(ui32Buf = 0; ui32Buf < UART_BRIDGE_NUM_BUFS; ui32Buf++)
+    {
+        g_pui8BridgeState[ui32Buf] = BRIDGE_BUF_FREE;
+    }
+    g_ui32ReadyHead = 0;
+    g_ui32ReadyTail = 0;
+    g_bTxBusy = false;
+
+    //
+    // Arm both halves of the ping-pong pair, starting with the primary.
+    //
+    g_pui32RxBuf[0] = 0;
+    g_pui32RxBuf[1] = 1;
+    g_pui8BridgeState[0] = BRIDGE_BUF_RX;
+    g_pui8BridgeState[1] = BRIDGE_BUF_RX;
+    g_ui32RxActive = 0;
+    UARTBridgeRxArm(0);
+    UARTBridgeRxArm(1);
+    MAP_uDMAChannelAttributeDisable(UDMA_CH6_UART5RX, UDMA_ATTR_ALTSELECT);
+
+    //
+    // The receive timeout still flags the end of a message, but the FIFO
+    // level interrupt now belongs to the uDMA.
+    //
+    MAP_UARTIntDisable(UART5_BASE, UART_INT_RX);
+    MAP_UARTDMAEnable(UART5_BASE, UART_DMA_RX);
+    if(bForward)
+    {
+        MAP_UARTDMAEnable(UART0_BASE, UART_DMA_TX);
+    }
+    MAP_uDMAChannelEnable(UDMA_CH6_UART5RX);
+
+    g_bBridgeEnabled = true;
+
+    MAP_IntEnable(INT_UART0);
+    MAP_IntEnable(INT_UART5);
+}
+
+//*****************************************************************************
+//
+//! Returns sensor reception and forwarding to the CPU.
+//!
+//! Whatever the bridge has already received is sent before this returns,
+//! after which held console output is released.
+//!
+//! \return None.
+//
+//*****************************************************************************
+void
+UARTBridgeDisable(void)
+{
+    if(!g_bBridgeEnabled)
+    {
+        return;
+    }
+
+    MAP_IntDisable(INT_UART5);
+    MAP_IntDisable(INT_UART0);
+
+    UARTBridgeRxComplete();
+    UARTBridgeRxFlush();
+    MAP_UARTDMADisable(UART5_BASE, UART_DMA_RX);
+    MAP_UARTIntEnable(UART5_BASE, UART_INT_RX | UART_INT_RT);
+    g_bBridgeEnabled = false;
+    UARTBridgeTxStart();
+
+    MAP_IntEnable(INT_UART0);
+    MAP_IntEnable(INT_UART5);
+
+    //
+    // Let the UART0 handler drain the queued buffers.
+    //
+    while(g_bTxBusy)
+    {
+    }
+
+    MAP_UARTDMADisable(UART0_BASE, UART_DMA_TX);
+    UARTTxHold(UART0_BASE, false);
+}
+
+//*****************************************************************************
+//
+//! Returns whether the bridge is enabled.
+//!
+//! \return Returns \b true if sensor data is forwarded by the uDMA.
+//
+//*****************************************************************************
+bool
+UARTBridgeIsEnabled(void)
+{
+    return(g_bBridgeEnabled);
+}
+
+//*****************************************************************************
+//
+//! Services the UART5 side of the bridge.
+//!
+//! \param ui32Status is the UART5 interrupt status that was just cleared.
+//!
+//! This must be called from the UART5 interrupt handler whenever the bridge
+//! is enabled, regardless of the status, since uDMA completion does not show
+//! up in the UART interrupt status.
+//!
+//! \return None.
+//
+//*****************************************************************************
+void
+UARTBridgeRxIntHandler(uint32_t ui32Status)
+{
+    UARTBridgeRxComplete();
+
+    if((ui32Status & UART_INT_RT) == UART_INT_RT)
+    {
+        //
+        // Hand over what has arrived so far and continue on the other half
+        // of the ping-pong pair, which has not received anything yet.
+        //
+        if(UARTBridgeRxFlush())
+        {
+            UARTBridgeRxArm(g_ui32RxActive);
+            g_ui32RxActive ^= 1;
+            if(g_ui32RxActive)
+            {
+                MAP_uDMAChannelAttributeEnable(UDMA_CH6_UART5RX,
+                                               UDMA_ATTR_ALTSELECT);
+            }
+            else
+            {
+                MAP_uDMAChannelAttributeDisable(UDMA_CH6_UART5RX,
+                                                UDMA_ATTR_ALTSELECT);
+            }
+        }
+
+        MAP_uDMAChannelEnable(UDMA_CH6_UART5RX);
+    }
+
+    UARTBridgeTxStart();
+}
+
+//*****************************************************************************
+//
+//! Services the UART0 side of the bridge.
+//!
+//! This must be called from the UART0 interrupt handler.  It retires the
+//! buffer that has finished sending and starts the next one.
+//!
+//! \return None.
+//
+//*****************************************************************************
+void
+UARTBridgeTxIntHandler(void)
+{
+    uint32_t ui32Buf;
+
+    if(!g_bTxBusy || MAP_uDMAChannelIsEnabled(UDMA_CH9_UART0TX))
+    {
+        return;
+    }
+
+    ui32Buf = g_pui8ReadyQueue[g_ui32ReadyTail % UART_BRIDGE_NUM_BUFS];
+    g_sBridgeStats.ui32Bytes += g_pui32BridgeLen[ui32Buf];
+    g_pui8BridgeState[ui32Buf] = BRIDGE_BUF_FREE;
+    g_ui32ReadyTail++;
+    g_bTxBusy = false;
+
+    UARTBridgeTxStart();
+}
+
+//*****************************************************************************
+//
+//! Returns the bridge statistics.
+//!
+//! \param psStats is a pointer to the structure that is filled in.
+//!
+//! \return None.
+//
+//*****************************************************************************
+void
+UARTBridgeStatsGet(tUARTBridgeStats *psStats)
+{
+    *psStats = g_sBridgeStats;
+}
@@ -0,0 +1,81 @@
+//*****************************************************************************
+//
+// uart_bridge.h - Prototypes for the uDMA backed UART5 to UART0 bridge.
+//
+//*****************************************************************************
+
+#ifndef __UART_BRIDGE_H__
+#define __UART_BRIDGE_H__
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+//*****************************************************************************
+//
+// The number and size of the bridge buffers.  Two buffers are always armed
+// for receive (the ping-pong pair) and the rest hold data waiting for, or in
+// the middle of, transmission.
+//
+//*****************************************************************************
+#define UART_BRIDGE_NUM_BUFS    4
+#define UART_BRIDGE_BUF_SIZE    256
+
+//*****************************************************************************
+//
+// Statistics kept by the bridge.
+//
+//*****************************************************************************
+typedef struct
+{
+    //
+    // The number of bytes that have been forwarded to UART0.
+    //
+    uint32_t ui32Bytes;
+
+    //
+    // The number of receive buffers that were filled completely and swapped.
+    //
+    uint32_t ui32Swaps;
+
+    //
+    // The number of partly filled receive buffers that were handed over on a
+    // receive timeout.
+    //
+    uint32_t ui32Flushes;
+
+    //
+    // The number of times a receive buffer had to be re-armed before its
+    // previous contents had been sent.
+    //
+    uint32_t ui32Overruns;
+}
+tUARTBridgeStats;
+
+//*****************************************************************************
+//
+// The function called with every buffer of sensor data the bridge receives.
+//
+//*****************************************************************************
+typedef void (*tUARTBridgeRxCallback)(const uint8_t *pui8Data,
+                                      uint32_t ui32Len);
+
+//*****************************************************************************
+//
+// Prototypes for the APIs.
+//
+//*****************************************************************************
+extern void UARTBridgeInit(tUARTBridgeRxCallback pfnRxCallback);
+extern void UARTBridgeEnable(bool bForward);
+extern void UARTBridgeDisable(void);
+extern bool UARTBridgeIsEnabled(void);
+extern void UARTBridgeRxIntHandler(uint32_t ui32Status);
+extern void UARTBridgeTxIntHandler(void);
+extern void UARTBridgeStatsGet(tUARTBridgeStats *psStats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __UART_BRIDGE_H__
@@ -0,0 +1,525 @@
+//*****************************************************************************
+//
+// uart_tx.c - Interrupt driven, ring buffered UART transmit engine.
+//
+// Each UART that is used for output owns a single-consumer ring.  The
+// application writes the head index and the UART transmit interrupt is the
+// only consumer and writes the tail index.  The indices are free running
+// 32-bit counters, so a store to either of them is atomic on the Cortex-M4
+// and no lock is needed between the two.
+//
+// The handler of one other interrupt may also queue on a ring once it has
+// been named with UARTTxShare().  The application then queues with that
+// interrupt masked, a few bytes at a time so that it is never held off for
+// long, and the handler cannot find a head that is only half written.
+//
+// The transmit interrupt is configured in FIFO mode with a 1/8 threshold, so
+// the handler runs once for every 14 bytes sent and refills the hardware FIFO
+// from the ring.  Because that interrupt only fires when the FIFO level
+// crosses the threshold, a queue operation that finds the FIFO idle primes it
+// with the transmit interrupt masked.
+//
+//*****************************************************************************
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "inc/hw_memmap.h"
+#include "inc/hw_ints.h"
+#include "driverlib/interrupt.h"
+#include "driverlib/rom.h"
+#include "driverlib/rom_map.h"
+#include "driverlib/uart.h"
+#include "uart_tx.h"
+
+//*****************************************************************************
+//
+// The state of one transmit ring.
+//
+//*****************************************************************************
+typedef struct
+{
+    //
+    // The base address and the interrupt of the UART that drains this ring.
+    //
+    uint32_t ui32Base;
+    uint32_t ui32Int;
+
+    //
+    // The storage for the ring and its size minus one.
+    //
+    uint8_t *pui8Buf;
+    uint32_t ui32Mask;
+
+    //
+    // The free running write (producer) and read (consumer) counters.
+    //
+    volatile uint32_t ui32Head;
+    volatile uint32_t ui32Tail;
+
+    //
+    // The interrupt whose handler also queues on this ring, or 0 if only the
+    // application does.
+    //
+    uint32_t ui32ShareInt;
+
+    //
+    // Set while another engine owns the transmitter; the ring keeps filling
+    // but nothing is moved into the FIFO.
+    //
+    volatile bool bHold;
+
+    //
+    // The statistics for this ring.
+    //
+    tUARTTxStats sStats;
+}
+tUARTTxRing;
+
+//*****************************************************************************
+//
+// The ring storage and state for the console (UART0), the sensor (UART5)
+// and the further sensors fp_sensor.c can run on the other UARTs.
+//
+//*****************************************************************************
+static uint8_t g_pui8ConsoleBuf[UART_TX_CONSOLE_RING_SIZE];
+static uint8_t g_pui8SensorBuf[UART_TX_SENSOR_RING_SIZE];
+static uint8_t g_ppui8SensorBufs[6][UART_TX_SENSOR_RING_SIZE];
+
+#define UART_TX_RING(ui32Base, ui32Int, pui8Buf, ui32Size)                    \
+        { ui32Base, ui32Int, pui8Buf, (ui32Size) - 1, 0, 0, 0, false,         \
+          { 0, 0, 0, 0, 0 } }
+
+static tUARTTxRing g_psRings[] =
+{
+    UART_TX_RING(UART0_BASE, INT_UART0, g_pui8ConsoleBuf,
+                 UART_TX_CONSOLE_RING_SIZE),
+    UART_TX_RING(UART5_BASE, INT_UART5, g_pui8SensorBuf,
+                 UART_TX_SENSOR_RING_SIZE),
+    UART_TX_RING(UART1_BASE, INT_UART1, g_ppui8SensorBufs[0],
+                 UART_TX_SENSOR_RING_SIZE),
+    UART_TX_RING(UART2_BASE, INT_UART2, g_ppui8SensorBufs[1],
+                 UART_TX_SENSOR_RING_SIZE),
+    UART_TX_RING(UART3_BASE, INT_UART3, g_ppui8SensorBufs[2],
+                 UART_TX_SENSOR_RING_SIZE),
+    UART_TX_RING(UART4_BASE, INT_UART4, g_ppui8SensorBufs[3],
+                 UART_TX_SENSOR_RING_SIZE),
+    UART_TX_RING(UART6_BASE, INT_UART6, g_ppui8SensorBufs[4],
+                 UART_TX_SENSOR_RING_SIZE),
+    UART_TX_RING(UART7_BASE, INT_UART7, g_ppui8SensorBufs[5],
+                 UART_TX_SENSOR_RING_SIZE)
+};
+
+#define NUM_RINGS               (sizeof(g_psRings) / sizeof(g_psRings[0]))
+
+//*****************************************************************************
+//
+// The most bytes that are queued at a time with the sharing interrupt masked.
+// Copying them takes well under the time the 16 byte receive FIFO of the
+// sharing UART takes to fill.
+//
+//*****************************************************************************
+#define UART_TX_SHARE_CHUNK     32
+
+//*****************************************************************************
+//
+// Returns the ring that belongs to the given UART, or 0 if the UART does not
+// have one.
+//
+//*****************************************************************************
+static tUARTTxRing *
+UARTTxRingGet(uint32_t ui32Base)
+{
+    uint32_t ui32Idx;
+
+    for(ui32Idx = 0; ui32Idx < NUM_RINGS; ui32Idx++)
+    {
+        if(g_psRings[ui32Idx].ui32Base == ui32Base)
+        {
+            return(&g_psRings[ui32Idx]);
+        }
+    }
+
+    return(0);
+}
+
+//*****************************************************************************
+//
+// Masks the interrupt that shares a ring, returning whether it was enabled.
+//
+//*****************************************************************************
+static bool
+UARTTxLock(tUARTTxRing *psRing)
+{
+    bool bEnabled;
+
+    if(!psRing->ui32ShareInt)
+    {
+        return(false);
+    }
+
+    bEnabled = MAP_IntIsEnabled(psRing->ui32ShareInt) ? true : false;
+    MAP_IntDisable(psRing->ui32ShareInt);
+
+    return(bEnabled);
+}
+
+//*****************************************************************************
+//
+// Unmasks the interrupt that shares a ring if UARTTxLock() found it enabled.
+//
+//*****************************************************************************
+static void
+UARTTxUnlock(tUARTTxRing *psRing, bool bEnabled)
+{
+    if(bEnabled)
+    {
+        MAP_IntEnable(psRing->ui32ShareInt);
+    }
+}
+
+//*****************************************************************************
+//
+// Moves as many bytes as will fit from the ring into the UART transmit FIFO.
+// This must only be called from the transmit interrupt or with the transmit
+// interrupt masked.
+//
+//*****************************************************************************
+static void
+UARTTxFill(tUARTTxRing *psRing)
+{
+    uint32_t ui32Tail;
+
+    if(psRing->bHold)
+    {
+        return;
+    }
+
+    ui32Tail = psRing->ui32Tail;
+
+    while((ui32Tail != psRing->ui32Head) &&
+          MAP_UARTSpaceAvail(psRing->ui32Base))
+    {
+        MAP_UARTCharPutNonBlocking(psRing->ui32Base,
+                                   psRing->pui8Buf[ui32Tail &
+                                                   psRing->ui32Mask]);
+        ui32Tail++;
+    }
+
+    psRing->sStats.ui32Sent += ui32Tail - psRing->ui32Tail;
+    psRing->ui32Tail = ui32Tail;
+}
+
+//*****************************************************************************
+//
+//! Initializes the transmit ring of a UART.
+//!
+//! \param ui32Base is the base address of the UART.
+//!
+//! The UART must already be configured with UARTConfigSetExpClk().  This
+//! empties the ring, clears its statistics, selects FIFO mode for the
+//! transmit interrupt and enables the interrupt in the UART and the NVIC.
+//!
+//! \return None.
+//
+//*****************************************************************************
+void
+UARTTxInit(uint32_t ui32Base)
+{
+    tUARTTxRing *psRing;
+
+    psRing = UARTTxRingGet(ui32Base);
+    if(!psRing)
+    {
+        return;
+    }
+
+    MAP_UARTIntDisable(ui32Base, UART_INT_TX);
+
+    psRing->ui32Head = 0;
+    psRing->ui32Tail = 0;
+    psRing->ui32ShareInt = 0;
+    psRing->bHold = false;
+    psRing->sStats.ui32Queued = 0;
+    psRing->sStats.ui32Sent = 0;
+    psRing->sStats.ui32Dropped = 0;
+    psRing->sStats.ui32HighWater = 0;
+    psRing->sStats.ui32Interrupts = 0;
+
+    //
+    // Interrupt when the transmit FIFO drains to 2 bytes, which leaves the
+    // handler two character times at any baud rate to refill it.
+    //
+    MAP_UARTFIFOEnable(ui32Base);
+    MAP_UARTFIFOLevelSet(ui32Base, UART_FIFO_TX1_8, UART_FIFO_RX4_8);
+    MAP_UARTTxIntModeSet(ui32Base, UART_TXINT_MODE_FIFO);
+
+    MAP_UARTIntEnable(ui32Base, UART_INT_TX);
+    MAP_IntEnable(psRing->ui32Int);
+}
+
+//*****************************************************************************
+//
+//! Queues bytes for transmission on a UART.
+//!
+//! \param ui32Base is the base address of the UART.
+//! \param pui8Buffer is a pointer to the bytes to send.
+//! \param ui32Count is the number of bytes to send.
+//!
+//! This function copies as many bytes as there is room for into the transmit
+//! ring and returns immediately; it never waits for the UART.  Bytes that do
+//! not fit are counted as dropped.
+//!
+//! It may be called from the application, and from the handler of the
+//! interrupt named with UARTTxShare() if there is one.
+//!
+//! \return Returns the number of bytes that were queued.
+//
+//*****************************************************************************
+uint32_t
+UARTTxQueue(uint32_t ui32Base, const uint8_t *pui8Buffer, uint32_t ui32Count)
+{
+    tUARTTxRing *psRing;
+    uint32_t ui32Head, ui32Free, ui32Idx, ui32Depth, ui32Chunk, ui32Queued;
+    bool bEnabled;
+
+    psRing = UARTTxRingGet(ui32Base);
+    if(!psRing)
+    {
+        return(0);
+    }
+
+    ui32Queued = 0;
+    do
+    {
+        ui32Chunk = ui32Count - ui32Queued;
+        if(ui32Chunk > UART_TX_SHARE_CHUNK)
+        {
+            ui32Chunk = UART_TX_SHARE_CHUNK;
+        }
+
+        bEnabled = UARTTxLock(psRing);
+
+        //
+        // Copy as much as there is room for and then publish the new head.
+        //
+        ui32Head = psRing->ui32Head;
+        ui32Free = (psRing->ui32Mask + 1) - (ui32Head - psRing->ui32Tail);
+        if(ui32Chunk > ui32Free)
+        {
+            psRing->sStats.ui32Dropped += ui32Count - ui32Queued - ui32Free;
+            ui32Count = ui32Queued + ui32Free;
+            ui32Chunk = ui32Free;
+        }
+
+        for(ui32Idx = 0; ui32Idx < ui32Chunk; ui32Idx++)
+        {
+            psRing->pui8Buf[(ui32Head + ui32Idx) & psRing->ui32Mask] =
+                pui8Buffer[ui32Queued + ui32Idx];
+        }
+
+        psRing->ui32Head = ui32Head + ui32Chunk;
+        psRing->sStats.ui32Queued += ui32Chunk;
+        ui32Queued += ui32Chunk;
+
+        ui32Depth = psRing->ui32Head - psRing->ui32Tail;
+        if(ui32Depth > psRing->sStats.ui32HighWater)
+        {
+            psRing->sStats.ui32HighWater = ui32Depth;
+        }
+
+        //
+        // Prime the FIFO in case the transmitter had gone idle and there is
+        // no interrupt on its way to pick up the new data.
+        //
+        MAP_UARTIntDisable(ui32Base, UART_INT_TX);
+        UARTTxFill(psRing);
+        MAP_UARTIntEnable(ui32Base, UART_INT_TX);
+
+        UARTTxUnlock(psRing, bEnabled);
+    }
+    while(ui32Queued < ui32Count);
+
+    return(ui32Count);
+}
+
+//*****************************************************************************
+//
+//! Lets the handler of another interrupt queue on the transmit ring of a UART.
+//!
+//! \param ui32Base is the base address of the UART.
+//! \param ui32Interrupt is the interrupt, such as \b INT_UART5, or 0 if only
+//! the application queues on the ring.
+//!
+//! The handler must not be interrupted by the transmit interrupt of the UART,
+//! so both must have the same priority.  UARTTxInit() removes the interrupt.
+//!
+//! \return None.
+//
+//*****************************************************************************
+void
+UARTTxShare(uint32_t ui32Base, uint32_t ui32Interrupt)
+{
+    tUARTTxRing *psRing;
+
+    psRing = UARTTxRingGet(ui32Base);
+    if(psRing)
+    {
+        psRing->ui32ShareInt = ui32Interrupt;
+    }
+}
+
+//*****************************************************************************
+//
+//! Returns the number of bytes that can be queued on a UART without dropping.
+//!
+//! \param ui32Base is the base address of the UART.
+//!
+//! \return Returns the free space in the transmit ring.
+//
+//*****************************************************************************
+uint32_t
+UARTTxSpaceAvail(uint32_t ui32Base)
+{
+    tUARTTxRing *psRing;
+
+    psRing = UARTTxRingGet(ui32Base);
+    if(!psRing)
+    {
+        return(0);
+    }
+
+    return((psRing->ui32Mask + 1) - (psRing->ui32Head - psRing->ui32Tail));
+}
+
+//*****************************************************************************
+//
+//! Returns the number of bytes waiting in the transmit ring of a UART.
+//!
+//! \param ui32Base is the base address of the UART.
+//!
+//! Bytes that have already been moved into the hardware FIFO are not counted.
+//!
+//! \return Returns the number of queued bytes.
+//
+//*****************************************************************************
+uint32_t
+UARTTxPending(uint32_t ui32Base)
+{
+    tUARTTxRing *psRing;
+
+    psRing = UARTTxRingGet(ui32Base);
+    if(!psRing)
+    {
+        return(0);
+    }
+
+    return(psRing->ui32Head - psRing->ui32Tail);
+}
+
+//*****************************************************************************
+//
+//! Waits until everything queued on a UART has left the transmitter.
+//!
+//! \param ui32Base is the base address of the UART.
+//!
+//! \return None.
+//
+//*****************************************************************************
+void
+UARTTxFlush(uint32_t ui32Base)
+{
+    while(UARTTxPending(ui32Base))
+    {
+    }
+
+    while(MAP_UARTBusy(ui32Base))
+    {
+    }
+}
+
+//*****************************************************************************
+//
+//! Stops or restarts the draining of the transmit ring of a UART.
+//!
+//! \param ui32Base is the base address of the UART.
+//! \param bHold is \b true to stop moving bytes into the UART FIFO and
+//! \b false to resume.
+//!
+//! This lets another engine, such as the uDMA bridge, own the transmitter
+//! for a while.  Bytes queued during the hold are kept, subject to the free
+//! space in the ring, and sent once the hold is released.  UARTTxFlush() must
+//! not be called while the ring is held.
+//!
+//! \return None.
+//
+//*****************************************************************************
+void
+UARTTxHold(uint32_t ui32Base, bool bHold)
+{
+    tUARTTxRing *psRing;
+    bool bEnabled;
+
+    psRing = UARTTxRingGet(ui32Base);
+    if(!psRing)
+    {
+        return;
+    }
+
+    bEnabled = UARTTxLock(psRing);
+    MAP_UARTIntDisable(ui32Base, UART_INT_TX);
+    psRing->bHold = bHold;
+    UARTTxFill(psRing);
+    MAP_UARTIntEnable(ui32Base, UART_INT_TX);
+    UARTTxUnlock(psRing, bEnabled);
+}
+
+//*****************************************************************************
+//
+//! Services the transmit interrupt of a UART.
+//!
+//! \param ui32Base is the base address of the UART.
+//!
+//! This must be called from the interrupt handler of the UART after the
+//! UART_INT_TX status has been cleared.
+//!
+//! \return None.
+//
+//*****************************************************************************
+void
+UARTTxIntHandler(uint32_t ui32Base)
+{
+    tUARTTxRing *psRing;
+
+    psRing = UARTTxRingGet(ui32Base);
+    if(!psRing)
+    {
+        return;
+    }
+
+    psRing->sStats.ui32Interrupts++;
+    UARTTxFill(psRing);
+}
+
+//*****************************************************************************
+//
+//! Returns the statistics of the transmit ring of a UART.
+//!
+//! \param ui32Base is the base address of the UART.
+//! \param psStats is a pointer to the structure that is filled in.
+//!
+//! \return None.
+//
+//*****************************************************************************
+void
+UARTTxStatsGet(uint32_t ui32Base, tUARTTxStats *psStats)
+{
+    tUARTTxRing *psRing;
+
+    psRing = UARTTxRingGet(ui32Base);
+    if(!psRing)
+    {
+        return;
+    }
+
+    *psStats = psRing->sStats;
+}
@@ -0,0 +1,83 @@
+//*****************************************************************************
+//
+// uart_tx.h - Prototypes for the interrupt driven, ring buffered UART
+//             transmit engine.
+//
+//*****************************************************************************
+
+#ifndef __UART_TX_H__
+#define __UART_TX_H__
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+//*****************************************************************************
+//
+// Sizes of the transmit rings.  Both must be a power of two.  The console
+// ring is large enough to hold a complete menu so that drawing it never
+// stalls, and a chunk of encoded image rows in the worst case; the sensor
+// ring only ever holds a single command frame.
+//
+//*****************************************************************************
+#define UART_TX_CONSOLE_RING_SIZE                                             \
+                                1024
+#define UART_TX_SENSOR_RING_SIZE                                              \
+                                128
+
+//*****************************************************************************
+//
+// Statistics kept for each transmit ring.
+//
+//*****************************************************************************
+typedef struct
+{
+    //
+    // The total number of bytes accepted into the ring.
+    //
+    uint32_t ui32Queued;
+
+    //
+    // The total number of bytes moved from the ring into the UART FIFO.
+    //
+    uint32_t ui32Sent;
+
+    //
+    // The number of bytes that were refused because the ring was full.
+    //
+    uint32_t ui32Dropped;
+
+    //
+    // The largest number of bytes that have been waiting in the ring.
+    //
+    uint32_t ui32HighWater;
+
+    //
+    // The number of transmit interrupts that have been serviced.
+    //
+    uint32_t ui32Interrupts;
+}
+tUARTTxStats;
+
+//*****************************************************************************
+//
+// Prototypes for the APIs.
+//
+//*****************************************************************************
+extern void UARTTxInit(uint32_t ui32Base);
+extern uint32_t UARTTxQueue(uint32_t ui32Base, const uint8_t *pui8Buffer,
+                            uint32_t ui32Count);
+extern uint32_t UARTTxSpaceAvail(uint32_t ui32Base);
+extern uint32_t UARTTxPending(uint32_t ui32Base);
+extern void UARTTxFlush(uint32_t ui32Base);
+extern void UARTTxHold(uint32_t ui32Base, bool bHold);
+extern void UARTTxShare(uint32_t ui32Base, uint32_t ui32Interrupt);
+extern void UARTTxIntHandler(uint32_t ui32Base);
+extern void UARTTxStatsGet(uint32_t ui32Base, tUARTTxStats *psStats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __UART_TX_H__
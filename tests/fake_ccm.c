@@ -0,0 +1,242 @@
+//*****************************************************************************
+//
+// fake_ccm.c - A model of the TM4C129 CRC engine for the host tests.
+//
+// The driverlib functions that crc_ctx.c calls are replaced by a model of the
+// CRC engine in the CCM, computed a bit at a time as the data sheet describes
+// it: the state is shifted left through the polynomial, MSB first, and with
+// CRC_CFG_IBR the bits of each byte or word written are reversed first.  Only
+// the settings crc_ctx.c uses are modelled.  The CCM must be enabled and
+// ready before the engine is used, and any use that breaks that, or that is
+// of another peripheral, is counted as a fault.
+//
+//*****************************************************************************
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "inc/hw_memmap.h"
+#include "driverlib/crc.h"
+#include "driverlib/sysctl.h"
+#include "fake_ccm.h"
+
+//*****************************************************************************
+//
+// The state of the model.
+//
+//*****************************************************************************
+static bool g_bFakeCCMEnabled;
+static uint32_t g_ui32FakeCCMReadyPolls;
+static uint32_t g_ui32FakeCCMConfig;
+static uint32_t g_ui32FakeCCMState;
+static uint32_t g_ui32FakeCCMBytes;
+static uint32_t g_ui32FakeCCMFaults;
+
+//*****************************************************************************
+//
+// Checks that a call is to the engine and that the engine can be used.
+//
+//*****************************************************************************
+static void
+FakeCCMCheck(uint32_t ui32Base)
+{
+    if((ui32Base != CCM0_BASE) || !g_bFakeCCMEnabled ||
+       g_ui32FakeCCMReadyPolls)
+    {
+        g_ui32FakeCCMFaults++;
+    }
+}
+
+//*****************************************************************************
+//
+// Reverses the low ui32Bits bits of a value.
+//
+//*****************************************************************************
+static uint32_t
+FakeCCMReverse(uint32_t ui32Value, uint32_t ui32Bits)
+{
+    uint32_t ui32Result, ui32Bit;
+
+    ui32Result = 0;
+    for(ui32Bit = 0; ui32Bit < ui32Bits; ui32Bit++)
+    {
+        if(ui32Value & ((uint32_t)1 << ui32Bit))
+        {
+            ui32Result |= (uint32_t)1 << (ui32Bits - 1 - ui32Bit);
+        }
+    }
+
+    return(ui32Result);
+}
+
+//*****************************************************************************
+//
+// Writes a byte or a word to the engine.
+//
+//*****************************************************************************
+static void
+FakeCCMWrite(uint32_t ui32Data)
+{
+    uint32_t ui32Bits, ui32Width, ui32Poly, ui32Top, ui32Mask, ui32Feedback;
+    int32_t i32Bit;
+
+    ui32Bits = (g_ui32FakeCCMConfig & CRC_CFG_SIZE_8BIT) ? 8 : 32;
+    if(g_ui32FakeCCMConfig & CRC_CFG_IBR)
+    {
+        ui32Data = FakeCCMReverse(ui32Data, ui32Bits);
+    }
+
+    if((g_ui32FakeCCMConfig & 0xF) == CRC_CFG_TYPE_P4C11DB7)
+    {
+        ui32Width = 32;
+        ui32Poly = 0x04C11DB7;
+    }
+    else
+    {
+        ui32Width = 16;
+        ui32Poly = 0x8005;
+    }
+    ui32Top = (uint32_t)1 << (ui32Width - 1);
+    ui32Mask = (ui32Width == 32) ? 0xFFFFFFFF : 0xFFFF;
+
+    for(i32Bit = ui32Bits - 1; i32Bit >= 0; i32Bit--)
+    {
+        ui32Feedback = (((g_ui32FakeCCMState & ui32Top) ? 1 : 0) ^
+                        ((ui32Data >> i32Bit) & 1));
+        g_ui32FakeCCMState = (((g_ui32FakeCCMState << 1) & ui32Mask) ^
+                              (ui32Feedback ? ui32Poly : 0));
+    }
+
+    g_ui32FakeCCMBytes += ui32Bits / 8;
+}
+
+//*****************************************************************************
+//
+// The driverlib functions that crc_ctx.c calls.
+//
+//*****************************************************************************
+void
+SysCtlPeripheralEnable(uint32_t ui32Peripheral)
+{
+    if(ui32Peripheral != SYSCTL_PERIPH_CCM0)
+    {
+        g_ui32FakeCCMFaults++;
+        return;
+    }
+
+    //
+    // The CCM is ready after it has been polled a few times.
+    //
+    g_bFakeCCMEnabled = true;
+    g_ui32FakeCCMReadyPolls = 3;
+}
+
+bool
+SysCtlPeripheralReady(uint32_t ui32Peripheral)
+{
+    if((ui32Peripheral != SYSCTL_PERIPH_CCM0) || !g_bFakeCCMEnabled)
+    {
+        return(false);
+    }
+
+    if(g_ui32FakeCCMReadyPolls)
+    {
+        g_ui32FakeCCMReadyPolls--;
+    }
+
+    return(g_ui32FakeCCMReadyPolls == 0);
+}
+
+void
+CRCConfigSet(uint32_t ui32Base, uint32_t ui32CRCConfig)
+{
+    FakeCCMCheck(ui32Base);
+
+    g_ui32FakeCCMConfig = ui32CRCConfig;
+}
+
+void
+CRCSeedSet(uint32_t ui32Base, uint32_t ui32Seed)
+{
+    FakeCCMCheck(ui32Base);
+
+    g_ui32FakeCCMState = ui32Seed;
+}
+
+uint32_t
+CRCResultRead(uint32_t ui32Base, bool bPPResult)
+{
+    FakeCCMCheck(ui32Base);
+
+    return(g_ui32FakeCCMState);
+}
+
+uint32_t
+CRCDataProcess(uint32_t ui32Base, uint32_t *pui32DataIn,
+               uint32_t ui32DataLength, bool bPPResult)
+{
+    const uint8_t *pui8DataIn;
+
+    FakeCCMCheck(ui32Base);
+
+    if(g_ui32FakeCCMConfig & CRC_CFG_SIZE_8BIT)
+    {
+        pui8DataIn = (const uint8_t *)pui32DataIn;
+        while(ui32DataLength--)
+        {
+            FakeCCMWrite(*pui8DataIn++);
+        }
+    }
+    else
+    {
+        //
+        // The words must be aligned, as they are on the target.
+        //
+        if((uintptr_t)pui32DataIn & 3)
+        {
+            g_ui32FakeCCMFaults++;
+        }
+        while(ui32DataLength--)
+        {
+            FakeCCMWrite(*pui32DataIn++);
+        }
+    }
+
+    return(g_ui32FakeCCMState);
+}
+
+//*****************************************************************************
+//
+// Disables the CCM and clears the counts.  This must be called before
+// crc_ctx.c first uses the engine, as it enables the CCM only once.
+//
+//*****************************************************************************
+void
+FakeCCMReset(void)
+{
+    g_bFakeCCMEnabled = false;
+    g_ui32FakeCCMReadyPolls = 0;
+    g_ui32FakeCCMBytes = 0;
+    g_ui32FakeCCMFaults = 0;
+}
+
+//*****************************************************************************
+//
+// Returns the number of bytes written to the engine.
+//
+//*****************************************************************************
+uint32_t
+FakeCCMBytes(void)
+{
+    return(g_ui32FakeCCMBytes);
+}
+
+//*****************************************************************************
+//
+// Returns the number of uses of the engine that would fail on the target.
+//
+//*****************************************************************************
+uint32_t
+FakeCCMFaults(void)
+{
+    return(g_ui32FakeCCMFaults);
+}
@@ -0,0 +1,34 @@
+//*****************************************************************************
+//
+// fake_ccm.h - A model of the TM4C129 CRC engine for the host tests.
+//
+// This header is forced ahead of the sources of a TM4C129 host build.  It
+// keeps out the ROM headers, whose calls go through tables in the part's ROM,
+// and sends the MAP_ calls crc_ctx.c makes to the model instead.
+//
+//*****************************************************************************
+
+#ifndef __FAKE_CCM_H__
+#define __FAKE_CCM_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define __DRIVERLIB_ROM_H__
+#define __DRIVERLIB_ROM_MAP_H__
+
+#define MAP_SysCtlPeripheralEnable                                            \
+        SysCtlPeripheralEnable
+#define MAP_SysCtlPeripheralReady                                             \
+        SysCtlPeripheralReady
+
+//*****************************************************************************
+//
+// Prototypes for the APIs.
+//
+//*****************************************************************************
+extern void FakeCCMReset(void);
+extern uint32_t FakeCCMBytes(void);
+extern uint32_t FakeCCMFaults(void);
+
+#endif // __FAKE_CCM_H__
@@ -0,0 +1,384 @@
+//*****************************************************************************
+//
+// fake_uart.c - A model of the UARTs and the NVIC for the host tests.
+//
+// The driverlib functions that uart_tx.c calls are replaced by a model of the
+// transmit side of each UART: a 16 byte FIFO, the interrupt mask register and
+// the raw transmit interrupt, which is raised when the FIFO drains past the
+// 1/8 level.  FakeUARTShift() plays the part of the line, moving bytes from
+// the FIFO onto a record of what was sent, and runs UARTTxIntHandler() as the
+// interrupt would.  The NVIC is modelled as an enable bit per interrupt.
+//
+// A watched interrupt stands for a handler that queues on a ring alongside
+// the application.  Every byte the application writes to a FIFO while that
+// interrupt is enabled is counted, since the handler could have run then.
+//
+//*****************************************************************************
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include "inc/hw_ints.h"
+#include "inc/hw_memmap.h"
+#include "driverlib/interrupt.h"
+#include "driverlib/uart.h"
+#include "uart_tx.h"
+#include "fake_uart.h"
+
+//*****************************************************************************
+//
+// The number of interrupts the NVIC model has.
+//
+//*****************************************************************************
+#define FAKE_NUM_INTS           256
+
+//*****************************************************************************
+//
+// The model of one UART.
+//
+//*****************************************************************************
+typedef struct
+{
+    //
+    // The base address and the interrupt of the UART.
+    //
+    uint32_t ui32Base;
+    uint32_t ui32Int;
+
+    //
+    // The interrupt mask register, the FIFO and transmit interrupt settings
+    // and the raw transmit interrupt.
+    //
+    uint32_t ui32IM;
+    bool bFifoEnabled;
+    uint32_t ui32TxLevel;
+    uint32_t ui32TxMode;
+    bool bTxRaw;
+
+    //
+    // The transmit FIFO.
+    //
+    uint8_t pui8Fifo[FAKE_UART_FIFO_SIZE];
+    uint32_t ui32FifoCount;
+
+    //
+    // What has been sent.
+    //
+    uint8_t pui8Wire[FAKE_UART_WIRE_SIZE];
+    uint32_t ui32WireLen;
+}
+tFakeUART;
+
+//*****************************************************************************
+//
+// The base address and interrupt of each UART.
+//
+//*****************************************************************************
+static const uint32_t g_ppui32FakeUARTs[][2] =
+{
+    { UART0_BASE, INT_UART0 }, { UART1_BASE, INT_UART1 },
+    { UART2_BASE, INT_UART2 }, { UART3_BASE, INT_UART3 },
+    { UART4_BASE, INT_UART4 }, { UART5_BASE, INT_UART5 },
+    { UART6_BASE, INT_UART6 }, { UART7_BASE, INT_UART7 }
+};
+
+#define FAKE_NUM_UARTS          (sizeof(g_ppui32FakeUARTs) /                  \
+                                 sizeof(g_ppui32FakeUARTs[0]))
+
+//*****************************************************************************
+//
+// The UARTs, the NVIC, and the state of the watch.  FakeUARTReset() must be
+// called before anything else.
+//
+//*****************************************************************************
+static tFakeUART g_psFakeUARTs[FAKE_NUM_UARTS];
+static bool g_pbFakeIntEnabled[FAKE_NUM_INTS];
+static uint32_t g_pui32FakeIntDisables[FAKE_NUM_INTS];
+static uint32_t g_ui32FakeWatchInt;
+static uint32_t g_ui32FakeUnmasked;
+static bool g_bFakeInHandler;
+
+//*****************************************************************************
+//
+// Returns the model of a UART.
+//
+//*****************************************************************************
+static tFakeUART *
+FakeUARTGet(uint32_t ui32Base)
+{
+    uint32_t ui32Idx;
+
+    for(ui32Idx = 0; ui32Idx < FAKE_NUM_UARTS; ui32Idx++)
+    {
+        if(g_psFakeUARTs[ui32Idx].ui32Base == ui32Base)
+        {
+            return(&g_psFakeUARTs[ui32Idx]);
+        }
+    }
+
+    return(0);
+}
+
+//*****************************************************************************
+//
+// Runs the transmit interrupt of a UART if it is raised, unmasked and
+// enabled.
+//
+//*****************************************************************************
+static void
+FakeUARTInterrupt(tFakeUART *psUART)
+{
+    if(psUART->bTxRaw && (psUART->ui32IM & UART_INT_TX) &&
+       g_pbFakeIntEnabled[psUART->ui32Int] && !g_bFakeInHandler)
+    {
+        psUART->bTxRaw = false;
+        g_bFakeInHandler = true;
+        UARTTxIntHandler(psUART->ui32Base);
+        g_bFakeInHandler = false;
+    }
+}
+
+//*****************************************************************************
+//
+//! Puts every UART and interrupt back to its reset state.
+//!
+//! \return None.
+//
+//*****************************************************************************
+void
+FakeUARTReset(void)
+{
+    uint32_t ui32Idx;
+    tFakeUART *psUART;
+
+    for(ui32Idx = 0; ui32Idx < FAKE_NUM_UARTS; ui32Idx++)
+    {
+        psUART = &g_psFakeUARTs[ui32Idx];
+        memset(psUART, 0, sizeof(*psUART));
+        psUART->ui32Base = g_ppui32FakeUARTs[ui32Idx][0];
+        psUART->ui32Int = g_ppui32FakeUARTs[ui32Idx][1];
+    }
+
+    memset(g_pbFakeIntEnabled, 0, sizeof(g_pbFakeIntEnabled));
+    memset(g_pui32FakeIntDisables, 0, sizeof(g_pui32FakeIntDisables));
+    g_ui32FakeWatchInt = 0;
+    g_ui32FakeUnmasked = 0;
+}
+
+//*****************************************************************************
+//
+//! Sends bytes from the transmit FIFO of a UART.
+//!
+//! \param ui32Base is the base address of the UART.
+//! \param ui32Count is the most bytes to send.
+//!
+//! The transmit interrupt is raised when the FIFO drains to 2 bytes, and its
+//! handler is run once the byte that did it is sent, if it is unmasked and
+//! enabled.
+//!
+//! \return Returns the number of bytes sent.
+//
+//*****************************************************************************
+uint32_t
+FakeUARTShift(uint32_t ui32Base, uint32_t ui32Count)
+{
+    tFakeUART *psUART;
+    uint32_t ui32Sent;
+
+    psUART = FakeUARTGet(ui32Base);
+
+    for(ui32Sent = 0; (ui32Sent < ui32Count) && psUART->ui32FifoCount;
+        ui32Sent++)
+    {
+        if(psUART->ui32WireLen < FAKE_UART_WIRE_SIZE)
+        {
+            psUART->pui8Wire[psUART->ui32WireLen++] = psUART->pui8Fifo[0];
+        }
+
+        memmove(psUART->pui8Fifo, psUART->pui8Fifo + 1,
+                --psUART->ui32FifoCount);
+
+        if(psUART->ui32FifoCount == 2)
+        {
+            psUART->bTxRaw = true;
+        }
+
+        FakeUARTInterrupt(psUART);
+    }
+
+    return(ui32Sent);
+}
+
+//*****************************************************************************
+//
+//! Returns the number of bytes in the transmit FIFO of a UART.
+//!
+//! \param ui32Base is the base address of the UART.
+//!
+//! \return Returns the FIFO level.
+//
+//*****************************************************************************
+uint32_t
+FakeUARTFifoLevel(uint32_t ui32Base)
+{
+    return(FakeUARTGet(ui32Base)->ui32FifoCount);
+}
+
+//*****************************************************************************
+//
+//! Returns what a UART has sent since the last reset.
+//!
+//! \param ui32Base is the base address of the UART.
+//! \param pui32Len is set to the number of bytes sent.
+//!
+//! \return Returns a pointer to the bytes.
+//
+//*****************************************************************************
+const uint8_t *
+FakeUARTWire(uint32_t ui32Base, uint32_t *pui32Len)
+{
+    tFakeUART *psUART;
+
+    psUART = FakeUARTGet(ui32Base);
+    *pui32Len = psUART->ui32WireLen;
+
+    return(psUART->pui8Wire);
+}
+
+//*****************************************************************************
+//
+//! Starts counting the FIFO writes made while an interrupt is enabled.
+//!
+//! \param ui32Interrupt is the interrupt.
+//!
+//! \return None.
+//
+//*****************************************************************************
+void
+FakeUARTWatch(uint32_t ui32Interrupt)
+{
+    g_ui32FakeWatchInt = ui32Interrupt;
+    g_ui32FakeUnmasked = 0;
+}
+
+//*****************************************************************************
+//
+//! Returns the number of bytes written to a FIFO outside a handler while the
+//! watched interrupt was enabled.
+//!
+//! \return Returns the count.
+//
+//*****************************************************************************
+uint32_t
+FakeUARTUnmaskedWrites(void)
+{
+    return(g_ui32FakeUnmasked);
+}
+
+//*****************************************************************************
+//
+//! Returns the number of times an interrupt has been disabled.
+//!
+//! \param ui32Interrupt is the interrupt.
+//!
+//! \return Returns the count.
+//
+//*****************************************************************************
+uint32_t
+FakeIntDisableCount(uint32_t ui32Interrupt)
+{
+    return(g_pui32FakeIntDisables[ui32Interrupt]);
+}
+
+//*****************************************************************************
+//
+// The driverlib functions that the model replaces.
+//
+//*****************************************************************************
+void
+UARTFIFOEnable(uint32_t ui32Base)
+{
+    FakeUARTGet(ui32Base)->bFifoEnabled = true;
+}
+
+void
+UARTFIFOLevelSet(uint32_t ui32Base, uint32_t ui32TxLevel,
+                 uint32_t ui32RxLevel)
+{
+    FakeUARTGet(ui32Base)->ui32TxLevel = ui32TxLevel;
+}
+
+void
+UARTTxIntModeSet(uint32_t ui32Base, uint32_t ui32Mode)
+{
+    FakeUARTGet(ui32Base)->ui32TxMode = ui32Mode;
+}
+
+bool
+UARTSpaceAvail(uint32_t ui32Base)
+{
+    return(FakeUARTGet(ui32Base)->ui32FifoCount < FAKE_UART_FIFO_SIZE);
+}
+
+bool
+UARTCharPutNonBlocking(uint32_t ui32Base, unsigned char ucData)
+{
+    tFakeUART *psUART;
+
+    psUART = FakeUARTGet(ui32Base);
+    if(psUART->ui32FifoCount == FAKE_UART_FIFO_SIZE)
+    {
+        return(false);
+    }
+
+    if(g_ui32FakeWatchInt && g_pbFakeIntEnabled[g_ui32FakeWatchInt] &&
+       !g_bFakeInHandler)
+    {
+        g_ui32FakeUnmasked++;
+    }
+
+    psUART->pui8Fifo[psUART->ui32FifoCount++] = ucData;
+
+    return(true);
+}
+
+bool
+UARTBusy(uint32_t ui32Base)
+{
+    return(FakeUARTGet(ui32Base)->ui32FifoCount != 0);
+}
+
+void
+UARTIntEnable(uint32_t ui32Base, uint32_t ui32IntFlags)
+{
+    tFakeUART *psUART;
+
+    psUART = FakeUARTGet(ui32Base);
+    psUART->ui32IM |= ui32IntFlags;
+    FakeUARTInterrupt(psUART);
+}
+
+void
+UARTIntDisable(uint32_t ui32Base, uint32_t ui32IntFlags)
+{
+    FakeUARTGet(ui32Base)->ui32IM &= ~ui32IntFlags;
+}
+
+void
+IntEnable(uint32_t ui32Interrupt)
+{
+    g_pbFakeIntEnabled[ui32Interrupt] = true;
+}
+
+void
+IntDisable(uint32_t ui32Interrupt)
+{
+    g_pbFakeIntEnabled[ui32Interrupt] = false;
+    g_pui32FakeIntDisables[ui32Interrupt]++;
+}
+
+uint32_t
+IntIsEnabled(uint32_t ui32Interrupt)
+{
+    return(g_pbFakeIntEnabled[ui32Interrupt] ? 1 : 0);
+}
@@ -0,0 +1,32 @@
+//*****************************************************************************
+//
+// fake_uart.h - A model of the UARTs and the NVIC for the host tests.
+//
+//*****************************************************************************
+
+#ifndef __FAKE_UART_H__
+#define __FAKE_UART_H__
+
+//*****************************************************************************
+//
+// The depth of the transmit FIFO, and the most bytes a UART keeps of what it
+// has sent.
+//
+//*****************************************************************************
+#define FAKE_UART_FIFO_SIZE     16
+#define FAKE_UART_WIRE_SIZE     8192
+
+//*****************************************************************************
+//
+// Prototypes for the APIs.
+//
+//*****************************************************************************
+extern void FakeUARTReset(void);
+extern uint32_t FakeUARTShift(uint32_t ui32Base, uint32_t ui32Count);
+extern uint32_t FakeUARTFifoLevel(uint32_t ui32Base);
+extern const uint8_t *FakeUARTWire(uint32_t ui32Base, uint32_t *pui32Len);
+extern void FakeUARTWatch(uint32_t ui32Interrupt);
+extern uint32_t FakeUARTUnmaskedWrites(void);
+extern uint32_t FakeIntDisableCount(uint32_t ui32Interrupt);
+
+#endif // __FAKE_UART_H__
@@ -0,0 +1,92 @@
+//*****************************************************************************
+//
+// test.c - Checks shared by the host tests.
+//
+//*****************************************************************************
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include "test.h"
+
+//*****************************************************************************
+//
+// The number of failures printed before the rest are only counted.
+//
+//*****************************************************************************
+#define TEST_MAX_PRINTED        10
+
+//*****************************************************************************
+//
+// The number of checks made and of those that failed.
+//
+//*****************************************************************************
+static uint32_t g_ui32TestChecks;
+static uint32_t g_ui32TestFailures;
+
+//*****************************************************************************
+//
+//! Records the result of a check.
+//!
+//! \param bPass is \b true if the check passed.
+//! \param pcCond is the condition that was checked.
+//! \param pcFile is the source file of the check.
+//! \param ui32Line is the line of the check.
+//!
+//! \return None.
+//
+//*****************************************************************************
+void
+TestCheck(bool bPass, const char *pcCond, const char *pcFile,
+          uint32_t ui32Line)
+{
+    g_ui32TestChecks++;
+
+    if(!bPass)
+    {
+        if(g_ui32TestFailures < TEST_MAX_PRINTED)
+        {
+            printf("%s:%u: failed: %s\n", pcFile, (unsigned)ui32Line, pcCond);
+        }
+        g_ui32TestFailures++;
+    }
+}
+
+//*****************************************************************************
+//
+//! Fills a buffer with pseudo-random bytes.
+//!
+//! \param pui8Data is the buffer.
+//! \param ui32Count is the number of bytes.
+//! \param ui32Seed selects the sequence.
+//!
+//! \return None.
+//
+//*****************************************************************************
+void
+TestFill(uint8_t *pui8Data, uint32_t ui32Count, uint32_t ui32Seed)
+{
+    while(ui32Count--)
+    {
+        ui32Seed = (ui32Seed * 1664525) + 1013904223;
+        *pui8Data++ = (uint8_t)(ui32Seed >> 24);
+    }
+}
+
+//*****************************************************************************
+//
+//! Prints the number of checks and failures.
+//!
+//! \param pcName is the name of the test.
+//!
+//! \return Returns the exit status of the test: 0 if every check passed.
+//
+//*****************************************************************************
+int
+TestReport(const char *pcName)
+{
+    printf("%s: %u checks, %u failures\n", pcName,
+           (unsigned)g_ui32TestChecks, (unsigned)g_ui32TestFailures);
+
+    return(g_ui32TestFailures ? 1 : 0);
+}
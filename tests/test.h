@@ -0,0 +1,28 @@
+//*****************************************************************************
+//
+// test.h - Checks shared by the host tests.
+//
+//*****************************************************************************
+
+#ifndef __TEST_H__
+#define __TEST_H__
+
+//*****************************************************************************
+//
+// Checks a condition, printing it with its place in the source if it fails.
+//
+//*****************************************************************************
+#define TEST_CHECK(bCond)                                                     \
+        TestCheck((bCond) ? true : false, #bCond, __FILE__, __LINE__)
+
+//*****************************************************************************
+//
+// Prototypes for the APIs.
+//
+//*****************************************************************************
+extern void TestCheck(bool bPass, const char *pcCond, const char *pcFile,
+                      uint32_t ui32Line);
+extern void TestFill(uint8_t *pui8Data, uint32_t ui32Count, uint32_t ui32Seed);
+extern int TestReport(const char *pcName);
+
+#endif // __TEST_H__
@@ -0,0 +1,215 @@
+//*****************************************************************************
+//
+// test_crc_ctx.c - Host test of the streaming CRC contexts.
+//
+// Each CRC is checked against its standard check value and against the
+// functions in sw_crc.c, over every length up to 200 bytes at every
+// alignment, both as a block and in random pieces, and with contexts
+// interleaved.  The test is built twice: as for the TM4C123, where the tables
+// compute every CRC, and as for a TM4C129 against a model of its CRC engine,
+// where it also checks that the engine computed the longer blocks and was
+// used as the target requires.
+//
+//*****************************************************************************
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "driverlib/sw_crc.h"
+#include "crc_ctx.h"
+#include "test.h"
+
+#ifdef TARGET_IS_TM4C129_RA1
+#include "fake_ccm.h"
+#define TEST_NAME               "crc_ctx_hw"
+#else
+#define TEST_NAME               "crc_ctx"
+#endif
+
+//*****************************************************************************
+//
+// The data the CRCs are computed over, the size of an image.
+//
+//*****************************************************************************
+#define TEST_DATA_SIZE          30976
+
+static uint8_t g_pui8Data[TEST_DATA_SIZE + 8];
+
+//*****************************************************************************
+//
+// The state of the random number generator that splits the data.
+//
+//*****************************************************************************
+static uint32_t g_ui32TestRand = 7;
+
+static uint32_t
+TestRand(void)
+{
+    g_ui32TestRand = (g_ui32TestRand * 1664525) + 1013904223;
+
+    return(g_ui32TestRand >> 8);
+}
+
+//*****************************************************************************
+//
+// Returns the CRC of a block as sw_crc.c computes it.
+//
+//*****************************************************************************
+static uint32_t
+TestReference(uint32_t ui32Type, const uint8_t *pui8Data, uint32_t ui32Count)
+{
+    switch(ui32Type)
+    {
+    case CRC_CTX_CRC8_CCITT:
+        return(Crc8CCITT(0, pui8Data, ui32Count));
+    case CRC_CTX_CRC16:
+        return(Crc16(0, pui8Data, ui32Count));
+    default:
+        return(Crc32(0xFFFFFFFF, pui8Data, ui32Count) ^ 0xFFFFFFFF);
+    }
+}
+
+//*****************************************************************************
+//
+// Checks the standard check values.
+//
+//*****************************************************************************
+static void
+TestCheckValues(void)
+{
+    const uint8_t *pui8Check;
+
+    pui8Check = (const uint8_t *)"123456789";
+    TEST_CHECK(CrcCtxBlock(CRC_CTX_CRC8_CCITT, pui8Check, 9) == 0xF4);
+    TEST_CHECK(CrcCtxBlock(CRC_CTX_CRC16, pui8Check, 9) == 0xBB3D);
+    TEST_CHECK(CrcCtxBlock(CRC_CTX_CRC32, pui8Check, 9) == 0xCBF43926);
+
+    //
+    // Twice the check string, so that the engine computes it.
+    //
+    pui8Check = (const uint8_t *)"123456789123456789";
+    TEST_CHECK(CrcCtxBlock(CRC_CTX_CRC16, pui8Check, 18) ==
+               Crc16(0, pui8Check, 18));
+    TEST_CHECK(CrcCtxBlock(CRC_CTX_CRC32, pui8Check, 18) ==
+               (Crc32(0xFFFFFFFF, pui8Check, 18) ^ 0xFFFFFFFF));
+}
+
+//*****************************************************************************
+//
+// Checks every CRC over every short length at every alignment, as a block
+// and in pieces of up to 40 bytes.
+//
+//*****************************************************************************
+static void
+TestLengths(void)
+{
+    tCrcCtx sCtx;
+    const uint8_t *pui8Data;
+    uint32_t ui32Type, ui32Align, ui32Len, ui32Ref, ui32Pos, ui32Piece;
+
+    for(ui32Type = CRC_CTX_CRC8_CCITT; ui32Type <= CRC_CTX_CRC32; ui32Type++)
+    {
+        for(ui32Align = 0; ui32Align < 4; ui32Align++)
+        {
+            for(ui32Len = 0; ui32Len <= 200; ui32Len++)
+            {
+                pui8Data = g_pui8Data + ui32Align;
+                ui32Ref = TestReference(ui32Type, pui8Data, ui32Len);
+
+                TEST_CHECK(CrcCtxBlock(ui32Type, pui8Data, ui32Len) ==
+                           ui32Ref);
+
+                CrcCtxInit(&sCtx, ui32Type);
+                for(ui32Pos = 0; ui32Pos < ui32Len; ui32Pos += ui32Piece)
+                {
+                    ui32Piece = 1 + (TestRand() % 40);
+                    if(ui32Piece > (ui32Len - ui32Pos))
+                    {
+                        ui32Piece = ui32Len - ui32Pos;
+                    }
+                    CrcCtxUpdate(&sCtx, pui8Data + ui32Pos, ui32Piece);
+                }
+                TEST_CHECK(CrcCtxFinal(&sCtx) == ui32Ref);
+            }
+        }
+    }
+}
+
+//*****************************************************************************
+//
+// Checks contexts that are updated in turn over a whole image.
+//
+//*****************************************************************************
+static void
+TestInterleaved(void)
+{
+    tCrcCtx sCrc32, sCrc16, sCrc8;
+    uint32_t ui32Pos, ui32Piece;
+
+    CrcCtxInit(&sCrc32, CRC_CTX_CRC32);
+    CrcCtxInit(&sCrc16, CRC_CTX_CRC16);
+    CrcCtxInit(&sCrc8, CRC_CTX_CRC8_CCITT);
+
+    for(ui32Pos = 0; ui32Pos < TEST_DATA_SIZE; ui32Pos += ui32Piece)
+    {
+        ui32Piece = 1 + (TestRand() % 1000);
+        if(ui32Piece > (TEST_DATA_SIZE - ui32Pos))
+        {
+            ui32Piece = TEST_DATA_SIZE - ui32Pos;
+        }
+        CrcCtxUpdate(&sCrc32, g_pui8Data + ui32Pos, ui32Piece);
+        CrcCtxUpdate(&sCrc16, g_pui8Data + ui32Pos + 3, ui32Piece);
+        CrcCtxUpdate(&sCrc8, g_pui8Data + ui32Pos + 1, ui32Piece);
+    }
+
+    TEST_CHECK(CrcCtxFinal(&sCrc32) ==
+               TestReference(CRC_CTX_CRC32, g_pui8Data, TEST_DATA_SIZE));
+    TEST_CHECK(CrcCtxFinal(&sCrc16) ==
+               TestReference(CRC_CTX_CRC16, g_pui8Data + 3, TEST_DATA_SIZE));
+    TEST_CHECK(CrcCtxFinal(&sCrc8) ==
+               TestReference(CRC_CTX_CRC8_CCITT, g_pui8Data + 1,
+                             TEST_DATA_SIZE));
+}
+
+#ifdef TARGET_IS_TM4C129_RA1
+//*****************************************************************************
+//
+// Checks which blocks the engine computes.
+//
+//*****************************************************************************
+static void
+TestEngine(void)
+{
+    uint32_t ui32Bytes;
+
+    ui32Bytes = FakeCCMBytes();
+    CrcCtxBlock(CRC_CTX_CRC32, g_pui8Data + 1, 15);
+    CrcCtxBlock(CRC_CTX_CRC8_CCITT, g_pui8Data + 1, 1000);
+    TEST_CHECK(FakeCCMBytes() == ui32Bytes);
+
+    CrcCtxBlock(CRC_CTX_CRC16, g_pui8Data + 1, 16);
+    TEST_CHECK(FakeCCMBytes() == (ui32Bytes + 16));
+    CrcCtxBlock(CRC_CTX_CRC32, g_pui8Data + 2, 1000);
+    TEST_CHECK(FakeCCMBytes() == (ui32Bytes + 1016));
+}
+#endif
+
+int
+main(void)
+{
+    TestFill(g_pui8Data, sizeof(g_pui8Data), 3);
+
+#ifdef TARGET_IS_TM4C129_RA1
+    FakeCCMReset();
+#endif
+
+    TestCheckValues();
+    TestLengths();
+    TestInterleaved();
+
+#ifdef TARGET_IS_TM4C129_RA1
+    TestEngine();
+    TEST_CHECK(FakeCCMFaults() == 0);
+#endif
+
+    return(TestReport(TEST_NAME));
+}
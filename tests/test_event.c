@@ -0,0 +1,485 @@
+//*****************************************************************************
+//
+// test_event.c - Host test of the event loop.
+//
+// event.c is built with EVENT_HOST, so that the interrupt mask and the cycle
+// counter are the ones below.  A fake interrupt posts console events; one
+// raised while interrupts are masked is held until they are restored, as the
+// NVIC would hold it.  The test checks that events are dispatched in the
+// order they were posted, what happens when the queue is full, when timers
+// expire, that a periodic timer cannot fill the queue while the main context
+// is busy, and the latencies that are measured.
+//
+//*****************************************************************************
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "event.h"
+#include "test.h"
+
+//*****************************************************************************
+//
+// The interrupt mask, whether the interrupt is running, the interrupts held
+// until it can run, and the time stamp.
+//
+//*****************************************************************************
+static bool g_bTestMasked;
+static bool g_bTestInIsr;
+static uint32_t g_ui32TestHeld;
+static uint32_t g_ui32TestNow;
+
+//*****************************************************************************
+//
+// The value the fake interrupt posts next, and the number of its posts that
+// failed.
+//
+//*****************************************************************************
+static uint32_t g_ui32TestNext;
+static uint32_t g_ui32TestLost;
+
+//*****************************************************************************
+//
+// What has been dispatched: the console values in order, the expiries of
+// each timer, and the number of idle hook calls.
+//
+//*****************************************************************************
+static uint32_t g_pui32TestSeen[256];
+static uint32_t g_ui32TestSeenCount;
+static uint32_t g_pui32TestExpiries[EVENT_MAX_TIMERS];
+static uint32_t g_ui32TestIdle;
+
+//*****************************************************************************
+//
+// The number of interrupts the console handler raises each time it runs, to
+// post from an interrupt while an event is being dispatched.
+//
+//*****************************************************************************
+static uint32_t g_ui32TestRaiseInHandler;
+
+//*****************************************************************************
+//
+// The fake interrupt, which posts the next console value.
+//
+//*****************************************************************************
+static void
+TestIsr(void)
+{
+    g_bTestInIsr = true;
+    if(!EventPost(EVENT_CONSOLE, 0, g_ui32TestNext))
+    {
+        g_ui32TestLost++;
+    }
+    g_ui32TestNext++;
+    g_bTestInIsr = false;
+}
+
+//*****************************************************************************
+//
+// Raises the fake interrupt a number of times.  It runs at once unless
+// interrupts are masked or it is running already.
+//
+//*****************************************************************************
+static void
+TestIsrRaise(uint32_t ui32Count)
+{
+    while(ui32Count--)
+    {
+        if(g_bTestMasked || g_bTestInIsr)
+        {
+            g_ui32TestHeld++;
+        }
+        else
+        {
+            TestIsr();
+        }
+    }
+}
+
+//*****************************************************************************
+//
+// The functions event.c calls in a host build.  Restoring the mask runs the
+// interrupts it held, unless it is restored by the interrupt itself.
+//
+//*****************************************************************************
+bool
+EventHostIntMask(void)
+{
+    bool bMasked;
+
+    bMasked = g_bTestMasked;
+    g_bTestMasked = true;
+
+    return(bMasked);
+}
+
+void
+EventHostIntRestore(bool bMasked)
+{
+    g_bTestMasked = bMasked;
+
+    while(!g_bTestMasked && !g_bTestInIsr && g_ui32TestHeld)
+    {
+        g_ui32TestHeld--;
+        TestIsr();
+    }
+}
+
+uint32_t
+EventHostTimestamp(void)
+{
+    return(g_ui32TestNow);
+}
+
+//*****************************************************************************
+//
+// The handlers.
+//
+//*****************************************************************************
+static void
+TestConsoleHandler(const tEvent *psEvent)
+{
+    if(g_ui32TestSeenCount < (sizeof(g_pui32TestSeen) /
+                              sizeof(g_pui32TestSeen[0])))
+    {
+        g_pui32TestSeen[g_ui32TestSeenCount] = psEvent->ui32Value;
+    }
+    g_ui32TestSeenCount++;
+
+    TestIsrRaise(g_ui32TestRaiseInHandler);
+}
+
+static void
+TestTimerHandler(const tEvent *psEvent)
+{
+    if(psEvent->ui32Param < EVENT_MAX_TIMERS)
+    {
+        g_pui32TestExpiries[psEvent->ui32Param]++;
+    }
+}
+
+static void
+TestIdleHook(void)
+{
+    g_ui32TestIdle++;
+}
+
+//*****************************************************************************
+//
+// Starts the loop again with nothing seen.
+//
+//*****************************************************************************
+static void
+TestStart(void)
+{
+    uint32_t ui32Idx;
+
+    EventInit();
+    EventHandlerSet(EVENT_CONSOLE, TestConsoleHandler);
+    EventHandlerSet(EVENT_TIMER, TestTimerHandler);
+    EventIdleHookAdd(TestIdleHook);
+
+    g_bTestMasked = false;
+    g_bTestInIsr = false;
+    g_ui32TestHeld = 0;
+    g_ui32TestNow = 0;
+    g_ui32TestNext = 0;
+    g_ui32TestLost = 0;
+    g_ui32TestSeenCount = 0;
+    g_ui32TestIdle = 0;
+    g_ui32TestRaiseInHandler = 0;
+    for(ui32Idx = 0; ui32Idx < EVENT_MAX_TIMERS; ui32Idx++)
+    {
+        g_pui32TestExpiries[ui32Idx] = 0;
+    }
+}
+
+//*****************************************************************************
+//
+// Dispatches everything that is queued, returning the number of events.
+//
+//*****************************************************************************
+static uint32_t
+TestDrain(void)
+{
+    uint32_t ui32Count;
+
+    ui32Count = 0;
+    while(EventDispatch())
+    {
+        ui32Count++;
+    }
+
+    return(ui32Count);
+}
+
+//*****************************************************************************
+//
+// Checks that the console values seen are 0, 1, 2 and so on.
+//
+//*****************************************************************************
+static bool
+TestInOrder(void)
+{
+    uint32_t ui32Idx;
+
+    for(ui32Idx = 0; ui32Idx < g_ui32TestSeenCount; ui32Idx++)
+    {
+        if(g_pui32TestSeen[ui32Idx] != ui32Idx)
+        {
+            return(false);
+        }
+    }
+
+    return(true);
+}
+
+//*****************************************************************************
+//
+// Checks that events posted from the interrupt, between dispatches, while
+// masked and while a handler runs, are dispatched first in, first out, and
+// that the idle hook runs only when the queue is empty.
+//
+//*****************************************************************************
+static void
+TestOrder(void)
+{
+    TestStart();
+
+    TEST_CHECK(!EventIsPending());
+    TEST_CHECK(!EventDispatch());
+    TEST_CHECK(g_ui32TestIdle == 1);
+
+    TestIsrRaise(5);
+    TEST_CHECK(EventIsPending());
+    TEST_CHECK(EventDispatch());
+    TEST_CHECK(EventDispatch());
+    TestIsrRaise(3);
+    TEST_CHECK(TestDrain() == 6);
+    TEST_CHECK(g_ui32TestIdle == 2);
+
+    //
+    // Interrupts held by the mask run when it is restored.
+    //
+    g_bTestMasked = true;
+    TestIsrRaise(4);
+    TEST_CHECK(!EventIsPending());
+    EventHostIntRestore(false);
+    TEST_CHECK(EventIsPending());
+
+    //
+    // Every dispatch raises the interrupt again from its handler, until 100
+    // values have been posted.
+    //
+    g_ui32TestRaiseInHandler = 1;
+    while(EventDispatch() && (g_ui32TestNext < 100))
+    {
+    }
+    g_ui32TestRaiseInHandler = 0;
+    TestDrain();
+
+    TEST_CHECK(g_ui32TestSeenCount == g_ui32TestNext);
+    TEST_CHECK(g_ui32TestNext >= 100);
+    TEST_CHECK(g_ui32TestLost == 0);
+    TEST_CHECK(TestInOrder());
+    TEST_CHECK(!g_bTestMasked && !g_ui32TestHeld);
+}
+
+//*****************************************************************************
+//
+// Checks that a full queue refuses and counts further posts without losing
+// what it holds, and takes posts again once there is room.
+//
+//*****************************************************************************
+static void
+TestFull(void)
+{
+    tEventStats sStats;
+
+    TestStart();
+
+    TestIsrRaise(EVENT_QUEUE_SIZE);
+    TEST_CHECK(g_ui32TestLost == 0);
+    TEST_CHECK(!EventPost(EVENT_CONSOLE, 0, 1000));
+    TEST_CHECK(!EventPost(EVENT_TIMER, 0, 0));
+    TEST_CHECK(!EventPost(EVENT_NUM_TYPES, 0, 0));
+
+    EventStatsGet(EVENT_CONSOLE, &sStats);
+    TEST_CHECK(sStats.ui32Dropped == 1);
+    EventStatsGet(EVENT_TIMER, &sStats);
+    TEST_CHECK(sStats.ui32Dropped == 1);
+
+    TEST_CHECK(EventDispatch());
+    TestIsrRaise(1);
+    TEST_CHECK(g_ui32TestLost == 0);
+    TestIsrRaise(1);
+    TEST_CHECK(g_ui32TestLost == 1);
+
+    //
+    // The value lost is the last one posted, and everything else arrives.
+    //
+    TEST_CHECK(TestDrain() == EVENT_QUEUE_SIZE);
+    TEST_CHECK(g_ui32TestSeenCount == (EVENT_QUEUE_SIZE + 1));
+    TEST_CHECK(TestInOrder());
+
+    EventStatsGet(EVENT_CONSOLE, &sStats);
+    TEST_CHECK(sStats.ui32Count == (EVENT_QUEUE_SIZE + 1));
+    TEST_CHECK(sStats.ui32Dropped == 2);
+}
+
+//*****************************************************************************
+//
+// Checks when one-shot and periodic timers expire, and that stopping and
+// restarting them takes effect.
+//
+//*****************************************************************************
+static void
+TestTimers(void)
+{
+    uint32_t ui32Tick;
+
+    TestStart();
+
+    EventTimerStart(0, 5, false);
+    EventTimerStart(1, 3, true);
+    EventTimerStart(2, 0, true);
+    EventTimerStart(EVENT_MAX_TIMERS, 1, true);
+
+    for(ui32Tick = 1; ui32Tick <= 30; ui32Tick++)
+    {
+        EventTick();
+        TestDrain();
+
+        TEST_CHECK(g_pui32TestExpiries[0] == ((ui32Tick >= 5) ? 1 : 0));
+        TEST_CHECK(g_pui32TestExpiries[1] == (ui32Tick / 3));
+    }
+    TEST_CHECK(g_pui32TestExpiries[2] == 0);
+
+    //
+    // A stopped timer posts nothing more; a restarted one counts from the
+    // restart.
+    //
+    EventTimerStop(1);
+    EventTick();
+    EventTick();
+    EventTick();
+    TestDrain();
+    TEST_CHECK(g_pui32TestExpiries[1] == 10);
+
+    EventTimerStart(0, 4, false);
+    EventTick();
+    EventTick();
+    EventTimerStart(0, 4, false);
+    EventTick();
+    EventTick();
+    EventTick();
+    TestDrain();
+    TEST_CHECK(g_pui32TestExpiries[0] == 1);
+    EventTick();
+    TestDrain();
+    TEST_CHECK(g_pui32TestExpiries[0] == 2);
+
+    //
+    // An expiry posted before the stop is still dispatched.
+    //
+    EventTimerStart(3, 1, true);
+    EventTick();
+    EventTimerStop(3);
+    TestDrain();
+    TEST_CHECK(g_pui32TestExpiries[3] == 1);
+}
+
+//*****************************************************************************
+//
+// Checks that a periodic timer that keeps expiring while nothing is
+// dispatched takes one slot of the queue, so that the interrupts still get
+// theirs, and that it posts again once its expiry has been dispatched.
+//
+//*****************************************************************************
+static void
+TestMerge(void)
+{
+    tEventStats sStats;
+    uint32_t ui32Tick;
+
+    TestStart();
+
+    EventTimerStart(0, 1, true);
+    EventTimerStart(1, 10, true);
+    for(ui32Tick = 0; ui32Tick < 1000; ui32Tick++)
+    {
+        EventTick();
+    }
+
+    TestIsrRaise(EVENT_QUEUE_SIZE - 2);
+    TEST_CHECK(g_ui32TestLost == 0);
+
+    EventStatsGet(EVENT_TIMER, &sStats);
+    TEST_CHECK(sStats.ui32Dropped == 0);
+
+    TEST_CHECK(TestDrain() == EVENT_QUEUE_SIZE);
+    TEST_CHECK(g_pui32TestExpiries[0] == 1);
+    TEST_CHECK(g_pui32TestExpiries[1] == 1);
+    TEST_CHECK(TestInOrder());
+
+    //
+    // Once dispatched, the timer posts at its next expiry.
+    //
+    EventTick();
+    TEST_CHECK(TestDrain() == 1);
+    TEST_CHECK(g_pui32TestExpiries[0] == 2);
+}
+
+//*****************************************************************************
+//
+// Checks the latencies measured from the post of an event to its dispatch.
+//
+//*****************************************************************************
+static void
+TestLatency(void)
+{
+    tEventStats sStats;
+
+    TestStart();
+
+    g_ui32TestNow = 100;
+    TestIsrRaise(1);
+    g_ui32TestNow = 150;
+    TestIsrRaise(1);
+    g_ui32TestNow = 350;
+    TEST_CHECK(EventDispatch());
+    g_ui32TestNow = 400;
+    TEST_CHECK(EventDispatch());
+
+    EventStatsGet(EVENT_CONSOLE, &sStats);
+    TEST_CHECK(sStats.ui32Count == 2);
+    TEST_CHECK(sStats.ui32MaxLatency == 250);
+    TEST_CHECK(sStats.ui64TotalLatency == (250 + 250));
+
+    //
+    // The cycle counter wraps.
+    //
+    g_ui32TestNow = 0xFFFFFFF0;
+    TestIsrRaise(1);
+    g_ui32TestNow = 0x10;
+    TEST_CHECK(EventDispatch());
+    EventStatsGet(EVENT_CONSOLE, &sStats);
+    TEST_CHECK(sStats.ui32MaxLatency == 250);
+    TEST_CHECK(sStats.ui64TotalLatency == (250 + 250 + 0x20));
+
+    EventStatsReset();
+    EventStatsGet(EVENT_CONSOLE, &sStats);
+    TEST_CHECK((sStats.ui32Count == 0) && (sStats.ui32MaxLatency == 0) &&
+               (sStats.ui64TotalLatency == 0));
+}
+
+int
+main(void)
+{
+    TestOrder();
+    TestFull();
+    TestTimers();
+    TestMerge();
+    TestLatency();
+
+    return(TestReport("event"));
+}
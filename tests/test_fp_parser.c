@@ -0,0 +1,219 @@
+//*****************************************************************************
+//
+// test_fp_parser.c - Host test of the sensor response parser.
+//
+// A recorded stream of responses, noise and an image is fed to the parser in
+// one piece, split in two at every position and one byte at a time, and the
+// events must be the same each time.
+//
+//*****************************************************************************
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include "fp_parser.h"
+#include "test.h"
+
+//*****************************************************************************
+//
+// An event that is expected, with the text it carries.
+//
+//*****************************************************************************
+typedef struct
+{
+    uint32_t ui32Type;
+    uint32_t ui32Value;
+    uint32_t ui32Width;
+    uint32_t ui32Height;
+    const char *pcText;
+}
+tTestEvent;
+
+//*****************************************************************************
+//
+// The stream, up to the image payload, and what comes after the payload.
+// The INFO response sets the image to 4 x 2, so the payload is 8 bytes; it
+// is made of marker characters, which must not be taken for markers.  A
+// response that is not closed before the next one opens ends there, so
+// "<R>2<R>" is reported as the number 2.
+//
+//*****************************************************************************
+static const char g_pcTestStream[] =
+    "hello<R>OK</R>put finger<R>PASS_3</R><R>FAIL</R><R>W=4, H=2</R>"
+    "<R>2<R><R>DS=2A</R><R>KEY=bn888</R><R>PASS</R><R>SUCC=hi</R><I>";
+static const char g_pcTestPayload[] = "</I><R>O";
+static const char g_pcTestTail[] = "<R>NG</R>";
+
+static const tTestEvent g_psTestEvents[] =
+{
+    { FP_EVENT_OK, 0, 0, 0, "" },
+    { FP_EVENT_PASS, 3, 0, 0, "" },
+    { FP_EVENT_FAIL, 0, 0, 0, "" },
+    { FP_EVENT_INFO, 8, 4, 2, "" },
+    { FP_EVENT_NUMBER, 2, 0, 0, "" },
+    { FP_EVENT_DS, 0x2A, 0, 0, "" },
+    { FP_EVENT_KEY, 0, 0, 0, "bn888" },
+    { FP_EVENT_PASS, FP_PASS_NO_INDEX, 0, 0, "" },
+    { FP_EVENT_TEXT, 0, 0, 0, "SUCC=hi" },
+    { FP_EVENT_IMAGE_START, 8, 0, 0, "" },
+    { FP_EVENT_IMAGE_END, 8, 0, 0, "" },
+    { FP_EVENT_NG, 0, 0, 0, "" }
+};
+
+#define TEST_NUM_EVENTS         (sizeof(g_psTestEvents) /                     \
+                                 sizeof(g_psTestEvents[0]))
+
+//*****************************************************************************
+//
+// The events seen so far, and the image payload they carried.
+//
+//*****************************************************************************
+static uint32_t g_ui32TestSeen;
+static bool g_bTestMismatch;
+static uint8_t g_pui8TestImage[64];
+static uint32_t g_ui32TestImageLen;
+
+//*****************************************************************************
+//
+// Checks each event against the next one expected.
+//
+//*****************************************************************************
+static void
+TestEventHandler(void *pvCBData, const tFpEvent *psEvent)
+{
+    const tTestEvent *psExpect;
+
+    if(psEvent->ui32Type == FP_EVENT_IMAGE_CHUNK)
+    {
+        if((g_ui32TestImageLen + psEvent->ui32Len) <=
+           sizeof(g_pui8TestImage))
+        {
+            memcpy(g_pui8TestImage + g_ui32TestImageLen, psEvent->pui8Data,
+                   psEvent->ui32Len);
+        }
+        g_ui32TestImageLen += psEvent->ui32Len;
+        return;
+    }
+
+    if(g_ui32TestSeen >= TEST_NUM_EVENTS)
+    {
+        g_bTestMismatch = true;
+        return;
+    }
+
+    psExpect = &g_psTestEvents[g_ui32TestSeen++];
+    if((psEvent->ui32Type != psExpect->ui32Type) ||
+       (psEvent->ui32Value != psExpect->ui32Value) ||
+       (psEvent->ui32Width != psExpect->ui32Width) ||
+       (psEvent->ui32Height != psExpect->ui32Height) ||
+       (psEvent->ui32Len != strlen(psExpect->pcText)) ||
+       (psEvent->ui32Len &&
+        memcmp(psEvent->pui8Data, psExpect->pcText, psEvent->ui32Len)))
+    {
+        g_bTestMismatch = true;
+    }
+}
+
+//*****************************************************************************
+//
+// Feeds the whole stream in pieces that end at the given positions, and
+// checks the events.
+//
+//*****************************************************************************
+static void
+TestFeed(const uint8_t *pui8Stream, uint32_t ui32Len, uint32_t ui32Split,
+         bool bBytewise)
+{
+    tFpParser sParser;
+    uint32_t ui32Pos;
+
+    g_ui32TestSeen = 0;
+    g_bTestMismatch = false;
+    g_ui32TestImageLen = 0;
+    FpParserInit(&sParser, TestEventHandler, 0);
+
+    if(bBytewise)
+    {
+        for(ui32Pos = 0; ui32Pos < ui32Len; ui32Pos++)
+        {
+            FpParserFeed(&sParser, pui8Stream + ui32Pos, 1);
+        }
+    }
+    else
+    {
+        FpParserFeed(&sParser, pui8Stream, ui32Split);
+        FpParserFeed(&sParser, pui8Stream + ui32Split, ui32Len - ui32Split);
+    }
+
+    TEST_CHECK(!g_bTestMismatch);
+    TEST_CHECK(g_ui32TestSeen == TEST_NUM_EVENTS);
+    TEST_CHECK(g_ui32TestImageLen == (sizeof(g_pcTestPayload) - 1));
+    TEST_CHECK(!memcmp(g_pui8TestImage, g_pcTestPayload,
+                       sizeof(g_pcTestPayload) - 1));
+}
+
+//*****************************************************************************
+//
+// Counts the events of a parser fed a long response, and keeps its text.
+//
+//*****************************************************************************
+static uint32_t g_ui32TestLongLen;
+static uint32_t g_ui32TestLongType;
+
+static void
+TestLongHandler(void *pvCBData, const tFpEvent *psEvent)
+{
+    g_ui32TestLongType = psEvent->ui32Type;
+    g_ui32TestLongLen = psEvent->ui32Len;
+}
+
+//*****************************************************************************
+//
+// Checks that a response longer than the text buffer is truncated.
+//
+//*****************************************************************************
+static void
+TestLong(void)
+{
+    tFpParser sParser;
+    uint8_t pui8Stream[FP_PARSER_TEXT_SIZE + 20];
+    uint32_t ui32Len;
+
+    memcpy(pui8Stream, "<R>", 3);
+    memset(pui8Stream + 3, 'x', FP_PARSER_TEXT_SIZE + 10);
+    ui32Len = FP_PARSER_TEXT_SIZE + 13;
+    memcpy(pui8Stream + ui32Len, "</R>", 4);
+    ui32Len += 4;
+
+    g_ui32TestLongLen = 0;
+    FpParserInit(&sParser, TestLongHandler, 0);
+    FpParserFeed(&sParser, pui8Stream, ui32Len);
+
+    TEST_CHECK(g_ui32TestLongType == FP_EVENT_TEXT);
+    TEST_CHECK(g_ui32TestLongLen == FP_PARSER_TEXT_SIZE);
+}
+
+int
+main(void)
+{
+    uint8_t pui8Stream[256];
+    uint32_t ui32Len, ui32Split;
+
+    ui32Len = 0;
+    memcpy(pui8Stream, g_pcTestStream, sizeof(g_pcTestStream) - 1);
+    ui32Len += sizeof(g_pcTestStream) - 1;
+    memcpy(pui8Stream + ui32Len, g_pcTestPayload, sizeof(g_pcTestPayload) - 1);
+    ui32Len += sizeof(g_pcTestPayload) - 1;
+    memcpy(pui8Stream + ui32Len, g_pcTestTail, sizeof(g_pcTestTail) - 1);
+    ui32Len += sizeof(g_pcTestTail) - 1;
+
+    for(ui32Split = 0; ui32Split <= ui32Len; ui32Split++)
+    {
+        TestFeed(pui8Stream, ui32Len, ui32Split, false);
+    }
+    TestFeed(pui8Stream, ui32Len, 0, true);
+
+    TestLong();
+
+    return(TestReport("fp_parser"));
+}
@@ -0,0 +1,621 @@
+//*****************************************************************************
+//
+// test_img_codec.c - Host test of the image encoders.
+//
+// Images are passed through the pipeline with a lossless and a lossy encoder
+// stage attached, and the streams they send are decoded here, following the
+// formats described in img_lossless.c and img_wavelet.c; only the Rice
+// models are shared with the encoders.  The lossless image must come back
+// bit-exact, for a ridge pattern like a fingerprint, for noise, which is
+// sent raw, and for widths that are not a whole number of bytes of code.
+// The lossy image must reach a given PSNR at each rate and improve as the
+// rate goes up, and once the step has settled, in the second half of the
+// image, the strips must stay near the rate asked for.
+//
+//*****************************************************************************
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <math.h>
+#include "fp_parser.h"
+#include "img_pipe.h"
+#include "rice.h"
+#include "img_lossless.h"
+#include "img_wavelet.h"
+#include "test.h"
+
+//*****************************************************************************
+//
+// The source image, the streams sent by the encoders and the decoded image.
+//
+//*****************************************************************************
+#define TEST_IMAGE_SIZE         (IMG_PIPE_MAX_WIDTH * FP_IMAGE_HEIGHT)
+#define TEST_PI                 3.14159265358979
+#define TEST_STREAM_SIZE        (TEST_IMAGE_SIZE * 2)
+
+static uint8_t g_pui8TestSource[TEST_IMAGE_SIZE];
+static uint8_t g_pui8TestDecoded[TEST_IMAGE_SIZE];
+static uint8_t g_pui8TestLossless[TEST_STREAM_SIZE];
+static uint8_t g_pui8TestLossy[TEST_STREAM_SIZE];
+static uint32_t g_ui32TestLosslessLen;
+static uint32_t g_ui32TestLossyLen;
+
+//*****************************************************************************
+//
+// The payload bytes and pixels of the lossy strips in the second half of the
+// image.
+//
+//*****************************************************************************
+static uint32_t g_ui32TestTailBytes;
+static uint32_t g_ui32TestTailPixels;
+
+//*****************************************************************************
+//
+// The encoder stages.
+//
+//*****************************************************************************
+static tImgStage g_sTestLosslessStage;
+static tImgStage g_sTestLossyStage;
+static tImgLossless g_sTestLossless;
+static tImgWavelet g_sTestLossy;
+
+//*****************************************************************************
+//
+// The sinks the encoders send to.
+//
+//*****************************************************************************
+static bool
+TestLosslessSink(const uint8_t *pui8Data, uint32_t ui32Len)
+{
+    if((g_ui32TestLosslessLen + ui32Len) > TEST_STREAM_SIZE)
+    {
+        return(false);
+    }
+
+    memcpy(g_pui8TestLossless + g_ui32TestLosslessLen, pui8Data, ui32Len);
+    g_ui32TestLosslessLen += ui32Len;
+
+    return(true);
+}
+
+static bool
+TestLossySink(const uint8_t *pui8Data, uint32_t ui32Len)
+{
+    if((g_ui32TestLossyLen + ui32Len) > TEST_STREAM_SIZE)
+    {
+        return(false);
+    }
+
+    memcpy(g_pui8TestLossy + g_ui32TestLossyLen, pui8Data, ui32Len);
+    g_ui32TestLossyLen += ui32Len;
+
+    return(true);
+}
+
+//*****************************************************************************
+//
+// A bit reader, the counterpart of the writer in rice.c.
+//
+//*****************************************************************************
+typedef struct
+{
+    const uint8_t *pui8Data;
+    uint32_t ui32Size;
+    uint32_t ui32Bit;
+    bool bOverrun;
+}
+tTestReader;
+
+static uint32_t
+TestBitsGet(tTestReader *psReader, uint32_t ui32Bits)
+{
+    uint32_t ui32Value;
+
+    ui32Value = 0;
+    while(ui32Bits--)
+    {
+        if((psReader->ui32Bit / 8) >= psReader->ui32Size)
+        {
+            psReader->bOverrun = true;
+            return(0);
+        }
+
+        ui32Value = ((ui32Value << 1) |
+                     ((psReader->pui8Data[psReader->ui32Bit / 8] >>
+                       (7 - (psReader->ui32Bit % 8))) & 1));
+        psReader->ui32Bit++;
+    }
+
+    return(ui32Value);
+}
+
+static uint32_t
+TestCodeGet(tTestReader *psReader, uint32_t ui32K, uint32_t ui32EscapeBits)
+{
+    uint32_t ui32Q;
+
+    for(ui32Q = 0; ui32Q < RICE_LIMIT; ui32Q++)
+    {
+        if(!TestBitsGet(psReader, 1))
+        {
+            return((ui32Q << ui32K) | TestBitsGet(psReader, ui32K));
+        }
+        if(psReader->bOverrun)
+        {
+            return(0);
+        }
+    }
+
+    return(TestBitsGet(psReader, ui32EscapeBits));
+}
+
+//*****************************************************************************
+//
+// Reads a two byte little endian number.
+//
+//*****************************************************************************
+static uint32_t
+TestGet16(const uint8_t *pui8Data)
+{
+    return(pui8Data[0] | (pui8Data[1] << 8));
+}
+
+//*****************************************************************************
+//
+// Decodes a lossless stream.  Returns false if it is not well formed.
+//
+//*****************************************************************************
+static bool
+TestLosslessDecode(uint32_t ui32Width, uint32_t ui32Height)
+{
+    tTestReader sReader;
+    tRiceModel sModel;
+    const uint8_t *pui8Data, *pui8Above;
+    uint8_t pui8Zero[IMG_PIPE_MAX_WIDTH];
+    uint8_t *pui8Row;
+    uint32_t ui32Len, ui32Row, ui32X, ui32A, ui32B, ui32C, ui32Min, ui32Max;
+    uint32_t ui32Pred, ui32Err;
+
+    pui8Data = g_pui8TestLossless;
+    ui32Len = g_ui32TestLosslessLen;
+    if((ui32Len < 7) || memcmp(pui8Data, IMG_LOSSLESS_START, 3) ||
+       (TestGet16(pui8Data + 3) != ui32Width) ||
+       (TestGet16(pui8Data + 5) != ui32Height))
+    {
+        return(false);
+    }
+    pui8Data += 7;
+    ui32Len -= 7;
+
+    memset(pui8Zero, 0, sizeof(pui8Zero));
+    for(ui32Row = 0; ui32Row < ui32Height; ui32Row++)
+    {
+        pui8Row = g_pui8TestDecoded + (ui32Row * ui32Width);
+        pui8Above = ui32Row ? (pui8Row - ui32Width) : pui8Zero;
+
+        if((ui32Len < IMG_LOSSLESS_ROW_HDR) ||
+           ((TestGet16(pui8Data + 1) + IMG_LOSSLESS_ROW_HDR) > ui32Len))
+        {
+            return(false);
+        }
+
+        sReader.pui8Data = pui8Data + IMG_LOSSLESS_ROW_HDR;
+        sReader.ui32Size = TestGet16(pui8Data + 1);
+        sReader.ui32Bit = 0;
+        sReader.bOverrun = false;
+
+        if(pui8Data[0] == IMG_LOSSLESS_ROW_RAW)
+        {
+            if(sReader.ui32Size != ui32Width)
+            {
+                return(false);
+            }
+            memcpy(pui8Row, sReader.pui8Data, ui32Width);
+        }
+        else if(pui8Data[0] == IMG_LOSSLESS_ROW_RICE)
+        {
+            //
+            // The median edge detector, and the folded error undone.
+            //
+            RiceModelInit(&sModel);
+            ui32A = pui8Above[0];
+            ui32C = pui8Above[0];
+            for(ui32X = 0; ui32X < ui32Width; ui32X++)
+            {
+                ui32B = pui8Above[ui32X];
+                ui32Min = (ui32A < ui32B) ? ui32A : ui32B;
+                ui32Max = (ui32A < ui32B) ? ui32B : ui32A;
+                ui32Pred = ((ui32C >= ui32Max) ? ui32Min :
+                            (ui32C <= ui32Min) ? ui32Max :
+                            (ui32A + ui32B - ui32C));
+
+                ui32Err = TestCodeGet(&sReader, RiceModelK(&sModel, 7), 8);
+                RiceModelUpdate(&sModel, ui32Err);
+                ui32Err = ((ui32Err & 1) ? (256 - ((ui32Err + 1) >> 1)) :
+                           (ui32Err >> 1));
+
+                pui8Row[ui32X] = (uint8_t)(ui32Pred + ui32Err);
+                ui32A = pui8Row[ui32X];
+                ui32C = ui32B;
+            }
+
+            //
+            // The code must fill the payload, less the padding.
+            //
+            if(sReader.bOverrun ||
+               (((sReader.ui32Bit + 7) / 8) != sReader.ui32Size))
+            {
+                return(false);
+            }
+        }
+        else
+        {
+            return(false);
+        }
+
+        pui8Data += IMG_LOSSLESS_ROW_HDR + sReader.ui32Size;
+        ui32Len -= IMG_LOSSLESS_ROW_HDR + sReader.ui32Size;
+    }
+
+    return((ui32Len == 4) && !memcmp(pui8Data, IMG_LOSSLESS_END, 4));
+}
+
+//*****************************************************************************
+//
+// Undoes the lifting of a line of n samples, spaced ui32Stride apart, as
+// img_wavelet.c lifts it.
+//
+//*****************************************************************************
+static void
+TestUnlift(int32_t *pi32Line, uint32_t ui32Stride, uint32_t ui32N)
+{
+    int32_t i32Left, i32Right;
+    uint32_t ui32Idx;
+
+    if(ui32N < 2)
+    {
+        return;
+    }
+
+    for(ui32Idx = 0; ui32Idx < ui32N; ui32Idx += 2)
+    {
+        i32Right = ((ui32Idx + 1) < ui32N) ?
+                   pi32Line[(ui32Idx + 1) * ui32Stride] :
+                   pi32Line[(ui32Idx - 1) * ui32Stride];
+        i32Left = ui32Idx ? pi32Line[(ui32Idx - 1) * ui32Stride] : i32Right;
+        pi32Line[ui32Idx * ui32Stride] -= (i32Left + i32Right + 2) >> 2;
+    }
+
+    for(ui32Idx = 1; ui32Idx < ui32N; ui32Idx += 2)
+    {
+        i32Left = pi32Line[(ui32Idx - 1) * ui32Stride];
+        i32Right = ((ui32Idx + 1) < ui32N) ?
+                   pi32Line[(ui32Idx + 1) * ui32Stride] : i32Left;
+        pi32Line[ui32Idx * ui32Stride] += (i32Left + i32Right) >> 1;
+    }
+}
+
+//*****************************************************************************
+//
+// Decodes a lossy stream.  Returns false if it is not well formed.
+//
+//*****************************************************************************
+static bool
+TestLossyDecode(uint32_t ui32Width, uint32_t ui32Height)
+{
+    static int32_t pi32Coef[IMG_PIPE_CHUNK_ROWS * IMG_PIPE_MAX_WIDTH];
+    tTestReader sReader;
+    tRiceModel sRuns, sValues;
+    const uint8_t *pui8Data;
+    uint32_t ui32Len, ui32Row, ui32Rows, ui32Step, ui32Pos, ui32Pixels;
+    uint32_t ui32Q, ui32Level, ui32LevelStep, ui32Idx, ui32X, ui32Y;
+    int32_t i32Pixel;
+
+    pui8Data = g_pui8TestLossy;
+    ui32Len = g_ui32TestLossyLen;
+    if((ui32Len < 7) || memcmp(pui8Data, IMG_WAVELET_START, 3) ||
+       (TestGet16(pui8Data + 3) != ui32Width) ||
+       (TestGet16(pui8Data + 5) != ui32Height))
+    {
+        return(false);
+    }
+    pui8Data += 7;
+    ui32Len -= 7;
+    g_ui32TestTailBytes = 0;
+    g_ui32TestTailPixels = 0;
+
+    for(ui32Row = 0; ui32Row < ui32Height; ui32Row += ui32Rows)
+    {
+        if((ui32Len < IMG_WAVELET_STRIP_HDR) ||
+           ((TestGet16(pui8Data + 3) + IMG_WAVELET_STRIP_HDR) > ui32Len) ||
+           (TestGet16(pui8Data + 3) > IMG_WAVELET_CODE_SIZE))
+        {
+            return(false);
+        }
+
+        ui32Rows = pui8Data[0];
+        ui32Step = TestGet16(pui8Data + 1);
+        if(!ui32Rows || (ui32Rows > IMG_PIPE_CHUNK_ROWS) ||
+           ((ui32Row + ui32Rows) > ui32Height))
+        {
+            return(false);
+        }
+
+        sReader.pui8Data = pui8Data + IMG_WAVELET_STRIP_HDR;
+        sReader.ui32Size = TestGet16(pui8Data + 3);
+        sReader.ui32Bit = 0;
+        sReader.bOverrun = false;
+
+        //
+        // Runs of zeros and the values between them.
+        //
+        RiceModelInit(&sRuns);
+        RiceModelInit(&sValues);
+        ui32Pixels = ui32Rows * ui32Width;
+        memset(pi32Coef, 0, sizeof(pi32Coef));
+        for(ui32Pos = 0; ui32Pos < ui32Pixels; ui32Pos++)
+        {
+            ui32Idx = TestCodeGet(&sReader, RiceModelK(&sRuns, 15), 16);
+            ui32Pos += ui32Idx;
+            if(ui32Pos >= ui32Pixels)
+            {
+                break;
+            }
+            ui32Q = TestCodeGet(&sReader, RiceModelK(&sValues, 15), 16) + 1;
+            RiceModelUpdate(&sRuns, ui32Idx);
+            RiceModelUpdate(&sValues, ui32Q - 1);
+
+            ui32X = ui32Pos % ui32Width;
+            ui32Y = ui32Pos / ui32Width;
+            for(ui32Level = 0; ui32Level < IMG_WAVELET_LEVELS; ui32Level++)
+            {
+                if((ui32X | ui32Y) & (1 << ui32Level))
+                {
+                    break;
+                }
+            }
+            ui32LevelStep = ui32Step >> ui32Level;
+            if(ui32LevelStep < 16)
+            {
+                ui32LevelStep = 16;
+            }
+
+            pi32Coef[ui32Pos] = ((2 * ui32Q) + 1) * ui32LevelStep / 32;
+            if(TestBitsGet(&sReader, 1))
+            {
+                pi32Coef[ui32Pos] = -pi32Coef[ui32Pos];
+            }
+        }
+        if(sReader.bOverrun || (ui32Pos != ui32Pixels) ||
+           (((sReader.ui32Bit + 7) / 8) != sReader.ui32Size))
+        {
+            return(false);
+        }
+
+        //
+        // The levels undone in the reverse order, columns before rows.
+        //
+        for(ui32Level = IMG_WAVELET_LEVELS; ui32Level--; )
+        {
+            ui32LevelStep = 1 << ui32Level;
+            for(ui32Idx = 0; ui32Idx < ui32Width; ui32Idx += ui32LevelStep)
+            {
+                TestUnlift(pi32Coef + ui32Idx, ui32LevelStep * ui32Width,
+                           (ui32Rows + ui32LevelStep - 1) / ui32LevelStep);
+            }
+            for(ui32Idx = 0; ui32Idx < ui32Rows; ui32Idx += ui32LevelStep)
+            {
+                TestUnlift(pi32Coef + (ui32Idx * ui32Width), ui32LevelStep,
+                           (ui32Width + ui32LevelStep - 1) / ui32LevelStep);
+            }
+        }
+
+        for(ui32Idx = 0; ui32Idx < ui32Pixels; ui32Idx++)
+        {
+            i32Pixel = pi32Coef[ui32Idx] + 128;
+            g_pui8TestDecoded[(ui32Row * ui32Width) + ui32Idx] =
+                (i32Pixel < 0) ? 0 : (i32Pixel > 255) ? 255 : i32Pixel;
+        }
+
+        if(ui32Row >= (ui32Height / 2))
+        {
+            g_ui32TestTailBytes += sReader.ui32Size;
+            g_ui32TestTailPixels += ui32Pixels;
+        }
+
+        pui8Data += IMG_WAVELET_STRIP_HDR + sReader.ui32Size;
+        ui32Len -= IMG_WAVELET_STRIP_HDR + sReader.ui32Size;
+    }
+
+    return((ui32Len == 4) && !memcmp(pui8Data, IMG_WAVELET_END, 4));
+}
+
+//*****************************************************************************
+//
+// Returns the PSNR of the decoded image in dB.
+//
+//*****************************************************************************
+static double
+TestPSNR(uint32_t ui32Pixels)
+{
+    double dError, dDiff;
+    uint32_t ui32Idx;
+
+    dError = 0;
+    for(ui32Idx = 0; ui32Idx < ui32Pixels; ui32Idx++)
+    {
+        dDiff = (double)g_pui8TestSource[ui32Idx] - g_pui8TestDecoded[ui32Idx];
+        dError += dDiff * dDiff;
+    }
+
+    if(dError == 0)
+    {
+        return(99.0);
+    }
+
+    return(10.0 * log10((255.0 * 255.0 * ui32Pixels) / dError));
+}
+
+//*****************************************************************************
+//
+// Fills the source with ridges that curl slowly across the image, as on a
+// finger, with a little noise.
+//
+//*****************************************************************************
+static void
+TestRidges(uint32_t ui32Width, uint32_t ui32Height)
+{
+    uint32_t ui32X, ui32Y, ui32Seed;
+    double dAngle, dPhase;
+
+    ui32Seed = 9;
+    for(ui32Y = 0; ui32Y < ui32Height; ui32Y++)
+    {
+        for(ui32X = 0; ui32X < ui32Width; ui32X++)
+        {
+            ui32Seed = (ui32Seed * 1664525) + 1013904223;
+            dAngle = (ui32X + ui32Y) / 150.0;
+            dPhase = ((ui32X * cos(dAngle)) + (ui32Y * sin(dAngle))) / 9.0;
+            g_pui8TestSource[(ui32Y * ui32Width) + ui32X] =
+                (uint8_t)(128 + (90 * sin(2 * TEST_PI * dPhase)) +
+                          ((ui32Seed >> 24) % 9) - 4);
+        }
+    }
+}
+
+//*****************************************************************************
+//
+// Passes the source through the pipeline and both encoders.
+//
+//*****************************************************************************
+static void
+TestEncode(uint32_t ui32Width, uint32_t ui32Height)
+{
+    tFpEvent sEvent;
+
+    memset(&sEvent, 0, sizeof(sEvent));
+    sEvent.ui32Type = FP_EVENT_INFO;
+    sEvent.ui32Width = ui32Width;
+    sEvent.ui32Height = ui32Height;
+    sEvent.ui32Value = ui32Width * ui32Height;
+    ImgPipeEventHandler(&sEvent);
+
+    g_ui32TestLosslessLen = 0;
+    g_ui32TestLossyLen = 0;
+    sEvent.ui32Type = FP_EVENT_IMAGE_START;
+    ImgPipeEventHandler(&sEvent);
+
+    sEvent.ui32Type = FP_EVENT_IMAGE_CHUNK;
+    sEvent.pui8Data = g_pui8TestSource;
+    sEvent.ui32Len = ui32Width * ui32Height;
+    ImgPipeEventHandler(&sEvent);
+
+    TEST_CHECK(!ImgPipeIsActive());
+}
+
+//*****************************************************************************
+//
+// Checks that an image comes back bit-exact from the lossless encoder.
+//
+//*****************************************************************************
+static void
+TestLossless(uint32_t ui32Width, uint32_t ui32Height, bool bRaw)
+{
+    ImgLosslessEnable(&g_sTestLossless, true);
+    ImgWaveletEnable(&g_sTestLossy, false);
+    TestEncode(ui32Width, ui32Height);
+
+    memset(g_pui8TestDecoded, 0, sizeof(g_pui8TestDecoded));
+    TEST_CHECK(TestLosslessDecode(ui32Width, ui32Height));
+    TEST_CHECK(!memcmp(g_pui8TestDecoded, g_pui8TestSource,
+                       ui32Width * ui32Height));
+    TEST_CHECK(g_sTestLossless.ui32OutBytes == g_ui32TestLosslessLen);
+    TEST_CHECK(g_sTestLossless.ui32Overflows == 0);
+    TEST_CHECK(bRaw ? (g_sTestLossless.ui32RawRows == ui32Height) :
+                      (g_ui32TestLosslessLen < (ui32Width * ui32Height)));
+}
+
+//*****************************************************************************
+//
+// Checks the lossy encoder at a rate, returning the PSNR.
+//
+//*****************************************************************************
+static double
+TestLossy(uint32_t ui32Width, uint32_t ui32Height, uint32_t ui32Rate,
+          double dMinPSNR)
+{
+    uint32_t ui32Pixels, ui32Budget;
+    double dPSNR;
+
+    ImgLosslessEnable(&g_sTestLossless, false);
+    ImgWaveletEnable(&g_sTestLossy, true);
+    ImgWaveletRateSet(&g_sTestLossy, ui32Rate);
+    TestEncode(ui32Width, ui32Height);
+
+    ui32Pixels = ui32Width * ui32Height;
+    memset(g_pui8TestDecoded, 0, sizeof(g_pui8TestDecoded));
+    TEST_CHECK(TestLossyDecode(ui32Width, ui32Height));
+    TEST_CHECK(g_sTestLossy.ui32OutBytes == g_ui32TestLossyLen);
+    TEST_CHECK(g_sTestLossy.ui32Overflows == 0);
+
+    dPSNR = TestPSNR(ui32Pixels);
+    TEST_CHECK(dPSNR >= dMinPSNR);
+
+    //
+    // The step is only raised by a quarter a strip, so the first strips may
+    // go over.  The settled strips go over by at most the quarter, and do
+    // not fall far short.
+    //
+    ui32Budget = (ui32Rate * g_ui32TestTailPixels) / 800;
+    TEST_CHECK(g_ui32TestTailBytes <= ((ui32Budget * 5) / 4));
+    TEST_CHECK(g_ui32TestTailBytes >= (ui32Budget / 2));
+
+    return(dPSNR);
+}
+
+int
+main(void)
+{
+    static const uint32_t pui32Rates[] = { 20, 40, 80, 160, 400 };
+    static const double pdMinPSNR[] = { 14.5, 16.5, 20.0, 25.0, 37.0 };
+    double dPSNR, dLast;
+    uint32_t ui32Idx;
+
+    ImgPipeInit();
+    ImgLosslessStageInit(&g_sTestLosslessStage, &g_sTestLossless,
+                         TestLosslessSink);
+    ImgWaveletStageInit(&g_sTestLossyStage, &g_sTestLossy, TestLossySink);
+    TEST_CHECK(ImgPipeStageAdd(&g_sTestLosslessStage));
+    TEST_CHECK(ImgPipeStageAdd(&g_sTestLossyStage));
+
+    //
+    // The rate is held to what a strip payload can carry.
+    //
+    ImgWaveletRateSet(&g_sTestLossy, 100000);
+    TEST_CHECK(g_sTestLossy.ui32Rate == IMG_WAVELET_RATE_MAX);
+    TEST_CHECK(((IMG_WAVELET_RATE_MAX * IMG_PIPE_CHUNK_ROWS *
+                 IMG_PIPE_MAX_WIDTH) / 800) <= IMG_WAVELET_CODE_SIZE);
+
+    TestRidges(FP_IMAGE_WIDTH, FP_IMAGE_HEIGHT);
+    TestLossless(FP_IMAGE_WIDTH, FP_IMAGE_HEIGHT, false);
+    TestRidges(IMG_PIPE_MAX_WIDTH, 30);
+    TestLossless(IMG_PIPE_MAX_WIDTH, 30, false);
+    TestRidges(37, 13);
+    TestLossless(37, 13, false);
+    TestFill(g_pui8TestSource, sizeof(g_pui8TestSource), 4);
+    TestLossless(FP_IMAGE_WIDTH, FP_IMAGE_HEIGHT, true);
+
+    TestRidges(FP_IMAGE_WIDTH, FP_IMAGE_HEIGHT);
+    dLast = 0;
+    for(ui32Idx = 0; ui32Idx < (sizeof(pui32Rates) / sizeof(pui32Rates[0]));
+        ui32Idx++)
+    {
+        dPSNR = TestLossy(FP_IMAGE_WIDTH, FP_IMAGE_HEIGHT, pui32Rates[ui32Idx],
+                          pdMinPSNR[ui32Idx]);
+        TEST_CHECK(dPSNR > dLast);
+        dLast = dPSNR;
+    }
+
+    return(TestReport("img_codec"));
+}
@@ -0,0 +1,308 @@
+//*****************************************************************************
+//
+// test_img_pipe.c - Host test of the row streaming image pipeline.
+//
+// Images are sent through the sensor parser and the pipeline as the sensor
+// sends them, an INFO response, <I>, the payload and a response after it,
+// split at random places into pieces of up to a given size.  A stage checks
+// every chunk it is handed against the source image: the rows must come in
+// order, hold the source rows, and have the source row above them in the line
+// buffer, or zeros above the first row.  Images whose height is not a whole
+// number of chunks, a payload holding the markers, an image too wide for the
+// line buffer and one abandoned by a stage are also checked.
+//
+//*****************************************************************************
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include "fp_parser.h"
+#include "img_pipe.h"
+#include "test.h"
+
+//*****************************************************************************
+//
+// The source image, the stream made from it and the image put back together
+// by the checking stage.
+//
+//*****************************************************************************
+#define TEST_IMAGE_SIZE         (FP_IMAGE_WIDTH * FP_IMAGE_HEIGHT)
+
+static uint8_t g_pui8TestSource[TEST_IMAGE_SIZE];
+static uint8_t g_pui8TestStream[TEST_IMAGE_SIZE + 64];
+static uint8_t g_pui8TestImage[TEST_IMAGE_SIZE];
+
+//*****************************************************************************
+//
+// The image being checked: its size, the next row expected, the row the
+// checking stage abandons it at, and what the stages and the parser saw.
+//
+//*****************************************************************************
+static uint32_t g_ui32TestWidth;
+static uint32_t g_ui32TestHeight;
+static uint32_t g_ui32TestNextRow;
+static uint32_t g_ui32TestAbortRow;
+static uint32_t g_ui32TestStarts;
+static uint32_t g_ui32TestEnds;
+static bool g_bTestComplete;
+static bool g_bTestBad;
+static uint32_t g_ui32TestLastRows;
+static uint32_t g_ui32TestResponses;
+
+//*****************************************************************************
+//
+// The state of the random number generator that splits the stream.
+//
+//*****************************************************************************
+static uint32_t g_ui32TestRand = 11;
+
+static uint32_t
+TestRand(void)
+{
+    g_ui32TestRand = (g_ui32TestRand * 1664525) + 1013904223;
+
+    return(g_ui32TestRand >> 8);
+}
+
+//*****************************************************************************
+//
+// The checking stage.
+//
+//*****************************************************************************
+static void
+TestStageStart(void *pvStage, uint32_t ui32Width, uint32_t ui32Height)
+{
+    g_ui32TestStarts++;
+    if((ui32Width != g_ui32TestWidth) || (ui32Height != g_ui32TestHeight))
+    {
+        g_bTestBad = true;
+    }
+}
+
+static void
+TestStageRows(void *pvStage, uint8_t *pui8Rows, uint32_t ui32Row,
+              uint32_t ui32Count)
+{
+    const uint8_t *pui8Source, *pui8Above;
+    uint32_t ui32Idx;
+
+    if((ui32Row != g_ui32TestNextRow) || !ui32Count ||
+       (ui32Count > IMG_PIPE_CHUNK_ROWS) ||
+       ((ui32Row + ui32Count) > g_ui32TestHeight))
+    {
+        g_bTestBad = true;
+        return;
+    }
+
+    //
+    // The rows, and the row above them.
+    //
+    pui8Source = g_pui8TestSource + (ui32Row * g_ui32TestWidth);
+    if(memcmp(pui8Rows, pui8Source, ui32Count * g_ui32TestWidth))
+    {
+        g_bTestBad = true;
+    }
+    pui8Above = pui8Rows - g_ui32TestWidth;
+    for(ui32Idx = 0; ui32Idx < g_ui32TestWidth; ui32Idx++)
+    {
+        if(pui8Above[ui32Idx] !=
+           (ui32Row ? (pui8Source - g_ui32TestWidth)[ui32Idx] : 0))
+        {
+            g_bTestBad = true;
+        }
+    }
+
+    memcpy(g_pui8TestImage + (ui32Row * g_ui32TestWidth), pui8Rows,
+           ui32Count * g_ui32TestWidth);
+    g_ui32TestNextRow = ui32Row + ui32Count;
+
+    if(g_ui32TestNextRow > g_ui32TestAbortRow)
+    {
+        ImgPipeAbort();
+    }
+}
+
+static void
+TestStageEnd(void *pvStage, bool bComplete)
+{
+    g_ui32TestEnds++;
+    g_bTestComplete = bComplete;
+}
+
+static const tImgStage g_sTestStage =
+{
+    TestStageStart, TestStageRows, TestStageEnd, 0
+};
+
+//*****************************************************************************
+//
+// A second stage, which notes the last row it was handed.
+//
+//*****************************************************************************
+static void
+TestLastRows(void *pvStage, uint8_t *pui8Rows, uint32_t ui32Row,
+             uint32_t ui32Count)
+{
+    g_ui32TestLastRows = ui32Row + ui32Count;
+}
+
+static const tImgStage g_sTestLastStage =
+{
+    0, TestLastRows, 0, 0
+};
+
+//*****************************************************************************
+//
+// Passes the parser events to the pipeline, and counts the responses.
+//
+//*****************************************************************************
+static void
+TestEventHandler(void *pvCBData, const tFpEvent *psEvent)
+{
+    if(psEvent->ui32Type == FP_EVENT_OK)
+    {
+        g_ui32TestResponses++;
+    }
+
+    ImgPipeEventHandler(psEvent);
+}
+
+//*****************************************************************************
+//
+// Sends an image of the given size through the parser and the pipeline in
+// pieces of up to ui32Piece bytes, and checks it.  The checking stage
+// abandons the image once it has been handed more than ui32AbortRow rows.
+// The INFO text must give the size.
+//
+//*****************************************************************************
+static void
+TestImage(const char *pcInfo, uint32_t ui32Width, uint32_t ui32Height,
+          uint32_t ui32Piece, uint32_t ui32AbortRow)
+{
+    tFpParser sParser;
+    tImgPipeStats sBefore, sAfter;
+    uint32_t ui32Len, ui32Pos, ui32Size, ui32Rows;
+    bool bFits;
+
+    ui32Len = strlen(pcInfo);
+    memcpy(g_pui8TestStream, pcInfo, ui32Len);
+    memcpy(g_pui8TestStream + ui32Len, "<I>", 3);
+    ui32Len += 3;
+    memcpy(g_pui8TestStream + ui32Len, g_pui8TestSource,
+           ui32Width * ui32Height);
+    ui32Len += ui32Width * ui32Height;
+    memcpy(g_pui8TestStream + ui32Len, "</I><R>OK</R>", 13);
+    ui32Len += 13;
+
+    g_ui32TestWidth = ui32Width;
+    g_ui32TestHeight = ui32Height;
+    g_ui32TestNextRow = 0;
+    g_ui32TestAbortRow = ui32AbortRow;
+    g_ui32TestStarts = 0;
+    g_ui32TestEnds = 0;
+    g_bTestComplete = false;
+    g_bTestBad = false;
+    g_ui32TestLastRows = 0;
+    g_ui32TestResponses = 0;
+    memset(g_pui8TestImage, 0, sizeof(g_pui8TestImage));
+    ImgPipeStatsGet(&sBefore);
+
+    FpParserInit(&sParser, TestEventHandler, 0);
+    for(ui32Pos = 0; ui32Pos < ui32Len; ui32Pos += ui32Size)
+    {
+        ui32Size = 1 + (TestRand() % ui32Piece);
+        if(ui32Size > (ui32Len - ui32Pos))
+        {
+            ui32Size = ui32Len - ui32Pos;
+        }
+        FpParserFeed(&sParser, g_pui8TestStream + ui32Pos, ui32Size);
+    }
+
+    ImgPipeStatsGet(&sAfter);
+    TEST_CHECK(!g_bTestBad);
+    TEST_CHECK(g_ui32TestResponses == 1);
+    TEST_CHECK(!ImgPipeIsActive());
+
+    bFits = ui32Width <= IMG_PIPE_MAX_WIDTH;
+    if(!bFits)
+    {
+        TEST_CHECK(g_ui32TestStarts == 0);
+        TEST_CHECK(g_ui32TestEnds == 0);
+        TEST_CHECK(sAfter.ui32Rejected == (sBefore.ui32Rejected + 1));
+        return;
+    }
+
+    TEST_CHECK(g_ui32TestStarts == 1);
+    TEST_CHECK(g_ui32TestEnds == 1);
+
+    if(ui32AbortRow < ui32Height)
+    {
+        //
+        // The chunk the image was abandoned in goes no further, and nothing
+        // after it is handed over.
+        //
+        ui32Rows = ((ui32AbortRow / IMG_PIPE_CHUNK_ROWS) + 1) *
+                   IMG_PIPE_CHUNK_ROWS;
+        TEST_CHECK(!g_bTestComplete);
+        TEST_CHECK(g_ui32TestNextRow == ui32Rows);
+        TEST_CHECK(g_ui32TestLastRows == (ui32Rows - IMG_PIPE_CHUNK_ROWS));
+        TEST_CHECK(sAfter.ui32Aborted == (sBefore.ui32Aborted + 1));
+        TEST_CHECK(sAfter.ui32Rows ==
+                   (sBefore.ui32Rows + ui32Rows - IMG_PIPE_CHUNK_ROWS));
+        return;
+    }
+
+    TEST_CHECK(g_bTestComplete);
+    TEST_CHECK(g_ui32TestNextRow == ui32Height);
+    TEST_CHECK(g_ui32TestLastRows == ui32Height);
+    TEST_CHECK(!memcmp(g_pui8TestImage, g_pui8TestSource,
+                       ui32Width * ui32Height));
+    TEST_CHECK(sAfter.ui32Images == (sBefore.ui32Images + 1));
+    TEST_CHECK(sAfter.ui32Rows == (sBefore.ui32Rows + ui32Height));
+}
+
+int
+main(void)
+{
+    static const uint32_t pui32Pieces[] = { 1, 3, 17, 64, 200, 1000, 40000 };
+    uint32_t ui32Idx, ui32Rep;
+
+    //
+    // The source has the markers in it, which must pass through as payload.
+    //
+    TestFill(g_pui8TestSource, sizeof(g_pui8TestSource), 5);
+    memcpy(g_pui8TestSource + 1000, "</I><R>OK</R><I>", 16);
+
+    ImgPipeInit();
+    TEST_CHECK(ImgPipeStageAdd(&g_sTestStage));
+    TEST_CHECK(ImgPipeStageAdd(&g_sTestLastStage));
+
+    for(ui32Idx = 0; ui32Idx < (sizeof(pui32Pieces) / sizeof(pui32Pieces[0]));
+        ui32Idx++)
+    {
+        for(ui32Rep = 0; ui32Rep < 4; ui32Rep++)
+        {
+            TestImage("<R>W=176, H=176</R>", 176, 176, pui32Pieces[ui32Idx],
+                      0xFFFFFFFF);
+            TestImage("<R>W=100, H=30</R>", 100, 30, pui32Pieces[ui32Idx],
+                      0xFFFFFFFF);
+            TestImage("<R>W=256, H=1</R>", 256, 1, pui32Pieces[ui32Idx],
+                      0xFFFFFFFF);
+        }
+    }
+
+    //
+    // An image too wide for the line buffer, and images abandoned part way.
+    //
+    TestImage("<R>W=300, H=2</R>", 300, 2, 50, 0xFFFFFFFF);
+    TestImage("<R>W=176, H=176</R>", 176, 176, 100, 0);
+    TestImage("<R>W=176, H=176</R>", 176, 176, 100, 53);
+    TestImage("<R>W=176, H=176</R>", 176, 176, 1, 171);
+
+    //
+    // The pipeline is ready for the next image.
+    //
+    TestImage("<R>W=176, H=176</R>", 176, 176, 500, 0xFFFFFFFF);
+
+    return(TestReport("img_pipe"));
+}
@@ -0,0 +1,338 @@
+//*****************************************************************************
+//
+// test_journal.c - Host test of the flash event journal.
+//
+// journal.c is built with JOURNAL_HOST against a simulated flash in which
+// programming can only clear bits and erasing sets a whole page.  The power
+// can be cut after a given number of flash operations: the word or page
+// being written is left half done and everything after it fails, until the
+// journal is started again as it would be after a reset.
+//
+//*****************************************************************************
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include "journal.h"
+#include "test.h"
+
+//*****************************************************************************
+//
+// The number of records a page holds, as journal.c lays them out.
+//
+//*****************************************************************************
+#define TEST_PAGE_RECORDS       ((JOURNAL_PAGE_SIZE / 16) - 1)
+
+//*****************************************************************************
+//
+// The simulated flash, and the number of words or pages that can still be
+// written before the power fails; -1 if it does not.
+//
+//*****************************************************************************
+static uint32_t g_pui32TestFlash[(JOURNAL_PAGES * JOURNAL_PAGE_SIZE) / 4];
+static int32_t g_i32TestPowerLeft = -1;
+static bool g_bTestPowerFailed;
+
+#define TestFlashIdx(a)         (((a) - JOURNAL_BASE) / 4)
+
+//*****************************************************************************
+//
+// Uses up one flash operation, returning false if the power fails on it.
+//
+//*****************************************************************************
+static bool
+TestPowerUse(void)
+{
+    if(g_bTestPowerFailed)
+    {
+        return(false);
+    }
+
+    if(g_i32TestPowerLeft == 0)
+    {
+        g_bTestPowerFailed = true;
+        return(false);
+    }
+
+    if(g_i32TestPowerLeft > 0)
+    {
+        g_i32TestPowerLeft--;
+    }
+
+    return(true);
+}
+
+//*****************************************************************************
+//
+// The flash operations journal.c calls in a host build.
+//
+//*****************************************************************************
+int32_t
+JournalHostProgram(uint32_t *pui32Data, uint32_t ui32Address,
+                   uint32_t ui32Count)
+{
+    uint32_t ui32Idx;
+
+    for(ui32Idx = 0; ui32Idx < (ui32Count / 4); ui32Idx++)
+    {
+        if(!TestPowerUse())
+        {
+            //
+            // Only the low half of the word was programmed.
+            //
+            g_pui32TestFlash[TestFlashIdx(ui32Address) + ui32Idx] &=
+                pui32Data[ui32Idx] | 0xFFFF0000;
+            return(-1);
+        }
+
+        g_pui32TestFlash[TestFlashIdx(ui32Address) + ui32Idx] &=
+            pui32Data[ui32Idx];
+    }
+
+    return(0);
+}
+
+int32_t
+JournalHostErase(uint32_t ui32Address)
+{
+    uint32_t ui32Words;
+
+    ui32Words = JOURNAL_PAGE_SIZE / 4;
+    if(!TestPowerUse())
+    {
+        //
+        // Only the first half of the page was erased.
+        //
+        ui32Words /= 2;
+    }
+
+    memset(&g_pui32TestFlash[TestFlashIdx(ui32Address)], 0xFF, ui32Words * 4);
+
+    return(g_bTestPowerFailed ? -1 : 0);
+}
+
+uint32_t
+JournalHostWord(uint32_t ui32Address)
+{
+    return(g_pui32TestFlash[TestFlashIdx(ui32Address)]);
+}
+
+//*****************************************************************************
+//
+// Erases the whole journal.
+//
+//*****************************************************************************
+static void
+TestFlashErase(void)
+{
+    memset(g_pui32TestFlash, 0xFF, sizeof(g_pui32TestFlash));
+    g_i32TestPowerLeft = -1;
+    g_bTestPowerFailed = false;
+}
+
+//*****************************************************************************
+//
+// Appends the record with a given time; the type and value follow from it.
+//
+//*****************************************************************************
+static bool
+TestAppend(uint32_t ui32Time)
+{
+    tJournalRecord sRecord;
+
+    sRecord.ui32Time = ui32Time;
+    sRecord.ui16Type = ui32Time % 8;
+    sRecord.ui16Result = ui32Time % 3;
+    sRecord.ui32Value = ui32Time * 7;
+
+    return(JournalAppend(&sRecord));
+}
+
+//*****************************************************************************
+//
+// Reads the journal and checks that it holds a run of records with
+// consecutive times ending at ui32Last, returning how many there are.
+//
+//*****************************************************************************
+static uint32_t
+TestRead(uint32_t ui32Last)
+{
+    tJournalCursor sCursor;
+    tJournalRecord sRecord;
+    uint32_t ui32Count, ui32Prev;
+    bool bGood;
+
+    bGood = true;
+    ui32Count = 0;
+    ui32Prev = 0;
+    JournalFirst(&sCursor);
+    while(JournalNext(&sCursor, &sRecord))
+    {
+        if((ui32Count && (sRecord.ui32Time != (ui32Prev + 1))) ||
+           (sRecord.ui16Type != (sRecord.ui32Time % 8)) ||
+           (sRecord.ui16Result != (sRecord.ui32Time % 3)) ||
+           (sRecord.ui32Value != (sRecord.ui32Time * 7)))
+        {
+            bGood = false;
+        }
+        ui32Prev = sRecord.ui32Time;
+        ui32Count++;
+    }
+
+    TEST_CHECK(bGood);
+    TEST_CHECK(!ui32Count || (ui32Prev == ui32Last));
+
+    return(ui32Count);
+}
+
+//*****************************************************************************
+//
+// Fills an empty journal, goes round it several times, and checks what is
+// kept, before and after a reset.
+//
+//*****************************************************************************
+static void
+TestRounds(void)
+{
+    tJournalStats sStats;
+    uint32_t ui32Time, ui32Count;
+
+    TestFlashErase();
+    JournalInit();
+    TEST_CHECK(TestRead(0) == 0);
+
+    for(ui32Time = 1; ui32Time <= 100; ui32Time++)
+    {
+        TEST_CHECK(TestAppend(ui32Time));
+    }
+    TEST_CHECK(TestRead(100) == 100);
+
+    JournalInit();
+    TEST_CHECK(TestRead(100) == 100);
+
+    for(; ui32Time <= 5000; ui32Time++)
+    {
+        TEST_CHECK(TestAppend(ui32Time));
+    }
+
+    JournalStatsGet(&sStats);
+    TEST_CHECK(sStats.ui32Capacity == (JOURNAL_PAGES * TEST_PAGE_RECORDS));
+    TEST_CHECK(sStats.ui32Appends == 4900);
+    TEST_CHECK(sStats.ui32Torn == 0);
+    TEST_CHECK(sStats.ui32Records <= sStats.ui32Capacity);
+    TEST_CHECK(sStats.ui32Records >
+               (sStats.ui32Capacity - TEST_PAGE_RECORDS));
+
+    ui32Count = TestRead(5000);
+    TEST_CHECK(ui32Count == sStats.ui32Records);
+
+    JournalInit();
+    TEST_CHECK(TestRead(5000) == ui32Count);
+    TEST_CHECK(TestAppend(5001));
+    TEST_CHECK(TestRead(5001) >= ui32Count);
+}
+
+//*****************************************************************************
+//
+// Cuts the power at every flash operation of appends that open, erase and
+// fill pages, and checks after each reset that the journal still holds an
+// unbroken run of records ending at the last one that was fully written.
+//
+//*****************************************************************************
+static void
+TestPowerFail(void)
+{
+    tJournalStats sStats;
+    uint32_t ui32Last, ui32Trial, ui32Torn;
+    int32_t i32Cut;
+
+    TestFlashErase();
+    JournalInit();
+
+    ui32Last = 0;
+    ui32Torn = 0;
+    for(ui32Trial = 0; ui32Trial < (3 * JOURNAL_PAGES * TEST_PAGE_RECORDS);
+        ui32Trial++)
+    {
+        //
+        // An append takes up to seven operations: an erase, the two header
+        // words and the four record words.
+        //
+        for(i32Cut = 0; i32Cut < 8; i32Cut++)
+        {
+            g_i32TestPowerLeft = i32Cut;
+            g_bTestPowerFailed = false;
+
+            if(TestAppend(ui32Last + 1) && !g_bTestPowerFailed)
+            {
+                ui32Last++;
+                g_i32TestPowerLeft = -1;
+                break;
+            }
+
+            ui32Torn++;
+            g_i32TestPowerLeft = -1;
+            g_bTestPowerFailed = false;
+            JournalInit();
+            TestRead(ui32Last);
+        }
+    }
+
+    JournalInit();
+    TEST_CHECK(TestRead(ui32Last) > 0);
+    TEST_CHECK(ui32Last == (3 * JOURNAL_PAGES * TEST_PAGE_RECORDS));
+    TEST_CHECK(ui32Torn > 0);
+
+    JournalStatsGet(&sStats);
+    TEST_CHECK(sStats.ui32Records <= sStats.ui32Capacity);
+}
+
+//*****************************************************************************
+//
+// Checks that a record damaged after it was written is skipped and counted
+// as torn, and that the records around it are still read.
+//
+//*****************************************************************************
+static void
+TestDamage(void)
+{
+    tJournalCursor sCursor;
+    tJournalRecord sRecord;
+    tJournalStats sStats;
+    uint32_t ui32Time, ui32Count;
+
+    TestFlashErase();
+    JournalInit();
+    for(ui32Time = 1; ui32Time <= 10; ui32Time++)
+    {
+        TestAppend(ui32Time);
+    }
+
+    //
+    // Clear a bit of the value of the fifth record.
+    //
+    g_pui32TestFlash[(16 + (4 * 16) + 8) / 4] &= ~0x1;
+
+    JournalStatsGet(&sStats);
+    TEST_CHECK(sStats.ui32Records == 9);
+    TEST_CHECK(sStats.ui32Torn == 1);
+
+    ui32Count = 0;
+    JournalFirst(&sCursor);
+    while(JournalNext(&sCursor, &sRecord))
+    {
+        TEST_CHECK(sRecord.ui32Time != 5);
+        ui32Count++;
+    }
+    TEST_CHECK(ui32Count == 9);
+}
+
+int
+main(void)
+{
+    TestRounds();
+    TestPowerFail();
+    TestDamage();
+
+    return(TestReport("journal"));
+}
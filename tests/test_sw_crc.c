@@ -0,0 +1,261 @@
+//*****************************************************************************
+//
+// test_sw_crc.c - Host test and benchmark of the CRC functions.
+//
+// Crc16() and Crc32(), which work a word at a time, are checked against a
+// byte at a time table and a bit at a time reference over every length up
+// to 300 bytes at every alignment, over random lengths up to 64 KB and with
+// the CRC carried over several calls.  The throughput of each is then
+// printed for the sizes BenchCrc() uses on the target.
+//
+//*****************************************************************************
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <time.h>
+#include "driverlib/sw_crc.h"
+#include "test.h"
+
+//*****************************************************************************
+//
+// The data the CRCs are computed over, with room for every alignment.
+//
+//*****************************************************************************
+static uint8_t g_pui8Data[65536 + 8];
+
+//*****************************************************************************
+//
+// The byte at a time tables.
+//
+//*****************************************************************************
+static uint16_t g_pui16TestTable16[256];
+static uint32_t g_pui32TestTable32[256];
+
+//*****************************************************************************
+//
+// The bit at a time references.
+//
+//*****************************************************************************
+static uint16_t
+TestCrc16Bitwise(uint16_t ui16Crc, const uint8_t *pui8Data,
+                 uint32_t ui32Count)
+{
+    uint32_t ui32Bit;
+
+    while(ui32Count--)
+    {
+        ui16Crc ^= *pui8Data++;
+        for(ui32Bit = 0; ui32Bit < 8; ui32Bit++)
+        {
+            ui16Crc = (ui16Crc >> 1) ^ ((ui16Crc & 1) ? 0xA001 : 0);
+        }
+    }
+
+    return(ui16Crc);
+}
+
+static uint32_t
+TestCrc32Bitwise(uint32_t ui32Crc, const uint8_t *pui8Data,
+                 uint32_t ui32Count)
+{
+    uint32_t ui32Bit;
+
+    while(ui32Count--)
+    {
+        ui32Crc ^= *pui8Data++;
+        for(ui32Bit = 0; ui32Bit < 8; ui32Bit++)
+        {
+            ui32Crc = (ui32Crc >> 1) ^ ((ui32Crc & 1) ? 0xEDB88320 : 0);
+        }
+    }
+
+    return(ui32Crc);
+}
+
+//*****************************************************************************
+//
+// The byte at a time references, as sw_crc.c computed them before it worked
+// a word at a time.
+//
+//*****************************************************************************
+static void
+TestTablesInit(void)
+{
+    uint32_t ui32Byte;
+    uint8_t ui8Byte;
+
+    for(ui32Byte = 0; ui32Byte < 256; ui32Byte++)
+    {
+        ui8Byte = (uint8_t)ui32Byte;
+        g_pui16TestTable16[ui32Byte] = TestCrc16Bitwise(0, &ui8Byte, 1);
+        g_pui32TestTable32[ui32Byte] = TestCrc32Bitwise(0, &ui8Byte, 1);
+    }
+}
+
+static uint16_t
+TestCrc16Table(uint16_t ui16Crc, const uint8_t *pui8Data, uint32_t ui32Count)
+{
+    while(ui32Count--)
+    {
+        ui16Crc = (ui16Crc >> 8) ^
+                  g_pui16TestTable16[(ui16Crc ^ *pui8Data++) & 0xFF];
+    }
+
+    return(ui16Crc);
+}
+
+static uint32_t
+TestCrc32Table(uint32_t ui32Crc, const uint8_t *pui8Data, uint32_t ui32Count)
+{
+    while(ui32Count--)
+    {
+        ui32Crc = (ui32Crc >> 8) ^
+                  g_pui32TestTable32[(ui32Crc ^ *pui8Data++) & 0xFF];
+    }
+
+    return(ui32Crc);
+}
+
+//*****************************************************************************
+//
+// Checks one length at one alignment from a given starting value.
+//
+//*****************************************************************************
+static void
+TestOne(uint32_t ui32Align, uint32_t ui32Len, uint32_t ui32Seed)
+{
+    const uint8_t *pui8Data;
+    uint16_t ui16Crc;
+    uint32_t ui32Crc;
+
+    pui8Data = g_pui8Data + ui32Align;
+
+    ui16Crc = Crc16((uint16_t)ui32Seed, pui8Data, ui32Len);
+    TEST_CHECK(ui16Crc == TestCrc16Table((uint16_t)ui32Seed, pui8Data,
+                                         ui32Len));
+    TEST_CHECK(ui16Crc == TestCrc16Bitwise((uint16_t)ui32Seed, pui8Data,
+                                           ui32Len));
+
+    ui32Crc = Crc32(ui32Seed, pui8Data, ui32Len);
+    TEST_CHECK(ui32Crc == TestCrc32Table(ui32Seed, pui8Data, ui32Len));
+    TEST_CHECK(ui32Crc == TestCrc32Bitwise(ui32Seed, pui8Data, ui32Len));
+}
+
+//*****************************************************************************
+//
+// Checks the results of the CRC functions.
+//
+//*****************************************************************************
+static void
+TestEquivalence(void)
+{
+    uint32_t ui32Align, ui32Len, ui32Idx, ui32Seed, ui32Crc;
+
+    //
+    // The standard check values.
+    //
+    TEST_CHECK(Crc16(0, (const uint8_t *)"123456789", 9) == 0xBB3D);
+    TEST_CHECK((Crc32(0xFFFFFFFF, (const uint8_t *)"123456789", 9) ^
+                0xFFFFFFFF) == 0xCBF43926);
+
+    //
+    // Every short length at every alignment, including empty buffers.
+    //
+    ui32Seed = 1;
+    for(ui32Align = 0; ui32Align < 8; ui32Align++)
+    {
+        for(ui32Len = 0; ui32Len <= 300; ui32Len++)
+        {
+            ui32Seed = (ui32Seed * 1664525) + 1013904223;
+            TestOne(ui32Align, ui32Len, ui32Seed);
+        }
+    }
+
+    //
+    // Random lengths up to 64 KB.
+    //
+    for(ui32Idx = 0; ui32Idx < 200; ui32Idx++)
+    {
+        ui32Seed = (ui32Seed * 1664525) + 1013904223;
+        TestOne(ui32Seed & 7, (ui32Seed >> 8) % 65000, ui32Seed);
+    }
+
+    //
+    // A CRC carried over calls that end at odd places.
+    //
+    ui32Crc = Crc32(0xFFFFFFFF, g_pui8Data, 13);
+    ui32Crc = Crc32(ui32Crc, g_pui8Data + 13, 1000);
+    ui32Crc = Crc32(ui32Crc, g_pui8Data + 1013, 30976 - 1013);
+    TEST_CHECK(ui32Crc == TestCrc32Table(0xFFFFFFFF, g_pui8Data, 30976));
+}
+
+//*****************************************************************************
+//
+// Prints the throughput of the word at a time and byte at a time CRCs in
+// bytes per microsecond.
+//
+//*****************************************************************************
+static void
+TestBenchmark(void)
+{
+    static const uint32_t pui32Sizes[] = { 16, 256, 4096, 30976 };
+    volatile uint32_t ui32Sink;
+    uint32_t ui32Size, ui32Idx, ui32Func, ui32Rep, ui32Reps;
+    clock_t sStart;
+    double pdRate[4];
+
+    printf("%6s %12s %12s %12s %12s  bytes/us\n", "bytes", "crc16 table",
+           "crc16", "crc32 table", "crc32");
+
+    ui32Sink = 0;
+    for(ui32Idx = 0; ui32Idx < (sizeof(pui32Sizes) / sizeof(pui32Sizes[0]));
+        ui32Idx++)
+    {
+        ui32Size = pui32Sizes[ui32Idx];
+        ui32Reps = (20000000 / ui32Size) + 1;
+
+        for(ui32Func = 0; ui32Func < 4; ui32Func++)
+        {
+            sStart = clock();
+            for(ui32Rep = 0; ui32Rep < ui32Reps; ui32Rep++)
+            {
+                switch(ui32Func)
+                {
+                case 0:
+                    ui32Sink += TestCrc16Table(ui32Rep, g_pui8Data + 1,
+                                               ui32Size);
+                    break;
+                case 1:
+                    ui32Sink += Crc16(ui32Rep, g_pui8Data + 1, ui32Size);
+                    break;
+                case 2:
+                    ui32Sink += TestCrc32Table(ui32Rep, g_pui8Data + 1,
+                                               ui32Size);
+                    break;
+                default:
+                    ui32Sink += Crc32(ui32Rep, g_pui8Data + 1, ui32Size);
+                    break;
+                }
+            }
+            pdRate[ui32Func] = ((double)ui32Size * ui32Reps) /
+                               ((double)(clock() - sStart) * 1000000 /
+                                CLOCKS_PER_SEC + 1);
+        }
+
+        printf("%6u %12.1f %12.1f %12.1f %12.1f\n", (unsigned)ui32Size,
+               pdRate[0], pdRate[1], pdRate[2], pdRate[3]);
+    }
+}
+
+int
+main(void)
+{
+    TestFill(g_pui8Data, sizeof(g_pui8Data), 1);
+    TestTablesInit();
+
+    TestEquivalence();
+    TestBenchmark();
+
+    return(TestReport("sw_crc"));
+}
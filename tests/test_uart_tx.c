@@ -0,0 +1,212 @@
+//*****************************************************************************
+//
+// test_uart_tx.c - Host test of the ring buffered UART transmit engine.
+//
+// uart_tx.c runs against the UART model in fake_uart.c.  The line is drained
+// a few bytes at a time, so the transmit interrupt refills the FIFO from the
+// ring as it would on the target.
+//
+//*****************************************************************************
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include "inc/hw_ints.h"
+#include "inc/hw_memmap.h"
+#include "driverlib/interrupt.h"
+#include "uart_tx.h"
+#include "fake_uart.h"
+#include "test.h"
+
+//*****************************************************************************
+//
+// The data that is queued.
+//
+//*****************************************************************************
+static uint8_t g_pui8Data[4096];
+
+//*****************************************************************************
+//
+// Sends everything from a UART, a few bytes at a time, and checks that the
+// line carried the given data.
+//
+//*****************************************************************************
+static void
+TestDrain(uint32_t ui32Base, const uint8_t *pui8Expect, uint32_t ui32Len)
+{
+    const uint8_t *pui8Wire;
+    uint32_t ui32WireLen, ui32Step;
+
+    for(ui32Step = 1; FakeUARTShift(ui32Base, (ui32Step % 5) + 1);
+        ui32Step++)
+    {
+    }
+
+    pui8Wire = FakeUARTWire(ui32Base, &ui32WireLen);
+    TEST_CHECK(ui32WireLen == ui32Len);
+    TEST_CHECK(!memcmp(pui8Wire, pui8Expect, ui32Len));
+    TEST_CHECK(UARTTxPending(ui32Base) == 0);
+}
+
+//*****************************************************************************
+//
+// Queues several writes while the line is draining and checks that they go
+// out whole and in order.
+//
+//*****************************************************************************
+static void
+TestOrder(void)
+{
+    tUARTTxStats sStats;
+    uint32_t ui32Len, ui32Total;
+
+    FakeUARTReset();
+    UARTTxInit(UART0_BASE);
+
+    ui32Total = 0;
+    for(ui32Len = 1; ui32Total + ui32Len <= 1000; ui32Len += 37)
+    {
+        TEST_CHECK(UARTTxQueue(UART0_BASE, g_pui8Data + ui32Total,
+                               ui32Len) == ui32Len);
+        ui32Total += ui32Len;
+        FakeUARTShift(UART0_BASE, 7);
+    }
+
+    TestDrain(UART0_BASE, g_pui8Data, ui32Total);
+
+    UARTTxStatsGet(UART0_BASE, &sStats);
+    TEST_CHECK(sStats.ui32Queued == ui32Total);
+    TEST_CHECK(sStats.ui32Sent == ui32Total);
+    TEST_CHECK(sStats.ui32Dropped == 0);
+    TEST_CHECK(sStats.ui32Interrupts > 0);
+    TEST_CHECK(sStats.ui32HighWater <= UART_TX_CONSOLE_RING_SIZE);
+}
+
+//*****************************************************************************
+//
+// Overfills a ring that is not draining and checks that the excess is
+// dropped and counted, and that what was taken is sent intact.
+//
+//*****************************************************************************
+static void
+TestFull(void)
+{
+    tUARTTxStats sStats;
+    uint32_t ui32Queued;
+
+    FakeUARTReset();
+    UARTTxInit(UART0_BASE);
+
+    ui32Queued = UARTTxQueue(UART0_BASE, g_pui8Data, 1100);
+    TEST_CHECK(ui32Queued == UART_TX_CONSOLE_RING_SIZE + 16);
+    TEST_CHECK(UARTTxSpaceAvail(UART0_BASE) == 0);
+    TEST_CHECK(UARTTxQueue(UART0_BASE, g_pui8Data, 1) == 0);
+
+    UARTTxStatsGet(UART0_BASE, &sStats);
+    TEST_CHECK(sStats.ui32Queued == ui32Queued);
+    TEST_CHECK(sStats.ui32Dropped == 1101 - ui32Queued);
+    TEST_CHECK(sStats.ui32HighWater == UART_TX_CONSOLE_RING_SIZE);
+
+    TestDrain(UART0_BASE, g_pui8Data, ui32Queued);
+    TEST_CHECK(UARTTxSpaceAvail(UART0_BASE) == UART_TX_CONSOLE_RING_SIZE);
+}
+
+//*****************************************************************************
+//
+// Checks that a held ring keeps what is queued and sends it once released.
+//
+//*****************************************************************************
+static void
+TestHold(void)
+{
+    FakeUARTReset();
+    UARTTxInit(UART0_BASE);
+
+    UARTTxHold(UART0_BASE, true);
+    TEST_CHECK(UARTTxQueue(UART0_BASE, g_pui8Data, 50) == 50);
+    TEST_CHECK(FakeUARTFifoLevel(UART0_BASE) == 0);
+    TEST_CHECK(UARTTxPending(UART0_BASE) == 50);
+
+    UARTTxHold(UART0_BASE, false);
+    TEST_CHECK(FakeUARTFifoLevel(UART0_BASE) == 16);
+    TestDrain(UART0_BASE, g_pui8Data, 50);
+}
+
+//*****************************************************************************
+//
+// Checks that the interrupt sharing a ring is masked whenever the
+// application touches the FIFO, in pieces of at most 32 bytes, and is left
+// enabled or disabled as it was found.
+//
+//*****************************************************************************
+static void
+TestShare(void)
+{
+    uint32_t ui32Disables;
+
+    FakeUARTReset();
+    UARTTxInit(UART0_BASE);
+    UARTTxShare(UART0_BASE, INT_UART5);
+    IntEnable(INT_UART5);
+    FakeUARTWatch(INT_UART5);
+
+    TEST_CHECK(UARTTxQueue(UART0_BASE, g_pui8Data, 100) == 100);
+    TEST_CHECK(FakeIntDisableCount(INT_UART5) == 4);
+    TEST_CHECK(IntIsEnabled(INT_UART5));
+
+    UARTTxHold(UART0_BASE, true);
+    UARTTxHold(UART0_BASE, false);
+    TEST_CHECK(FakeIntDisableCount(INT_UART5) == 6);
+    TEST_CHECK(IntIsEnabled(INT_UART5));
+
+    IntDisable(INT_UART5);
+    TEST_CHECK(UARTTxQueue(UART0_BASE, g_pui8Data + 100, 10) == 10);
+    TEST_CHECK(!IntIsEnabled(INT_UART5));
+
+    TestDrain(UART0_BASE, g_pui8Data, 110);
+    TEST_CHECK(FakeUARTUnmaskedWrites() == 0);
+
+    //
+    // Without sharing the interrupt is left alone.
+    //
+    UARTTxInit(UART0_BASE);
+    IntEnable(INT_UART5);
+    ui32Disables = FakeIntDisableCount(INT_UART5);
+    TEST_CHECK(UARTTxQueue(UART0_BASE, g_pui8Data, 10) == 10);
+    TEST_CHECK(FakeIntDisableCount(INT_UART5) == ui32Disables);
+}
+
+//*****************************************************************************
+//
+// Checks the edge cases of the arguments.
+//
+//*****************************************************************************
+static void
+TestEdges(void)
+{
+    FakeUARTReset();
+    UARTTxInit(UART5_BASE);
+
+    TEST_CHECK(UARTTxQueue(UART5_BASE, g_pui8Data, 0) == 0);
+    TEST_CHECK(UARTTxQueue(0x12345000, g_pui8Data, 10) == 0);
+    TEST_CHECK(UARTTxSpaceAvail(0x12345000) == 0);
+    TEST_CHECK(UARTTxSpaceAvail(UART5_BASE) == UART_TX_SENSOR_RING_SIZE);
+
+    TEST_CHECK(UARTTxQueue(UART5_BASE, g_pui8Data, 200) ==
+               UART_TX_SENSOR_RING_SIZE + 16);
+    TestDrain(UART5_BASE, g_pui8Data, UART_TX_SENSOR_RING_SIZE + 16);
+}
+
+int
+main(void)
+{
+    TestFill(g_pui8Data, sizeof(g_pui8Data), 1);
+
+    TestOrder();
+    TestFull();
+    TestHold();
+    TestShare();
+    TestEdges();
+
+    return(TestReport("uart_tx"));
+}